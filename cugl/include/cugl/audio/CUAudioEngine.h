@@ -42,6 +42,7 @@
 #include <cugl/audio/CUAudioDevices.h>
 #include <cugl/audio/CUSound.h>
 #include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUSPSCQueue.h>
 #include <unordered_map>
 #include <functional>
 #include <vector>
@@ -149,10 +150,77 @@ private:
     /** Active music queues */
     std::vector<std::shared_ptr<AudioQueue>> _queues;
     
-    /** Map keys to identifiers */
-    std::unordered_map<std::string,std::shared_ptr<audio::AudioFader>> _actives;
-    /** A queue for slot eviction if necessary */
-    std::deque<std::string> _evicts;
+    /** The key of each sound handle */
+    std::vector<std::string> _keys;
+    /** Map keys to sound handles */
+    std::unordered_map<std::string,Uint32> _handles;
+    /** The active effect for each handle (nullptr if the handle is inactive) */
+    std::vector<std::shared_ptr<audio::AudioFader>> _actives;
+    /** The active handles in play order, for slot eviction if necessary */
+    std::vector<Uint32> _evicts;
+
+    /**
+     * A request from the main thread to the fader of a sound effect slot
+     *
+     * Commands are run by the audio thread at the start of each mixer read,
+     * so that the main thread never contends with the mixer for a fader lock.
+     * The scheduler controls (skip, loops) are atomic, and so the main thread
+     * still sets those directly.
+     */
+    struct Command {
+        /** The command operations */
+        enum class Op : Uint8 {
+            /** Fade out the effect */
+            FADE_OUT,
+            /** Pause the fader (fading if the duration is positive) */
+            PAUSE,
+            /** Resume the fader */
+            RESUME
+        };
+        /** The operation to perform */
+        Op op;
+        /** The sound effect slot */
+        Uint32 slot;
+        /** The fader to act on (owned by the engine, so it outlives the command) */
+        audio::AudioFader* fader;
+        /** The fade duration in seconds */
+        float fade;
+    };
+
+    /**
+     * A sound effect completed by the audio thread
+     *
+     * Completions are collected by the main thread once an animation frame.
+     */
+    struct Completion {
+        /** The fader of the completed effect */
+        std::shared_ptr<audio::AudioNode> node;
+        /** True if the effect terminated normally, false otherwise */
+        bool status;
+    };
+
+    /** The free sound effect slots (used as a stack) */
+    std::vector<Uint32> _free;
+    /** The fader playing in each sound effect slot (nullptr if the slot is free) */
+    std::vector<std::shared_ptr<audio::AudioFader>> _voices;
+    /** The handle of the effect in each slot (UINT32_MAX if none) */
+    std::vector<Uint32> _owners;
+    /** Whether the effect in each slot has been told to fade out */
+    std::vector<bool> _fading;
+    /** Whether the effect in each slot plays a sound asset (and not an audio graph) */
+    std::vector<bool> _playback;
+    /** The handles of the effects that lost their slot before they completed */
+    std::vector<std::pair<const audio::AudioNode*,Uint32>> _retired;
+    /** The commands from the main thread to the audio thread */
+    SPSCQueue<Command> _commands;
+    /** The commands that did not fit in the queue, posted again next frame */
+    std::vector<Command> _deferred;
+    /** The effects handed to the mixer whose completions are not collected */
+    size_t _pending;
+    /** The completed effects from the audio thread to the main thread */
+    SPSCQueue<Completion> _completions;
+    /** The application callback that collects the completed effects */
+    Uint32 _collector;
 
     /** An object pool of faders for individual sound instances */
     std::deque<std::shared_ptr<audio::AudioFader>>  _fadePool;
@@ -215,14 +283,88 @@ private:
 #pragma mark -
 #pragma mark Internal Helpers
     /**
-     * Purges this key from the list of active effects.
+     * Purges this handle from the list of active effects.
      *
      * This method is not the same as stopping the channel. A channel may play a
-     * little longer after the key is removed.  This is simply a clean-up method.
+     * little longer after the handle is removed.  This is simply a clean-up method.
+     *
+     * @param handle    The handle to purge from the list of active effects.
+     */
+    void removeHandle(Uint32 handle);
+
+    /**
+     * Returns the active effect for the given key (or nullptr if none)
+     *
+     * This method does not intern the key, so it is safe to use for queries.
+     *
+     * @param key   The reference key for the sound effect
+     *
+     * @return the active effect for the given key (or nullptr if none)
+     */
+    std::shared_ptr<audio::AudioFader> findActive(const std::string& key) const;
+
+    /**
+     * Returns a free slot for a new sound effect (or -1 if none)
+     *
+     * Free slots are kept on a stack, so this is constant time in general.
+     * If there is no free slot, this method collects any completed effects,
+     * and then takes a slot that is fading out. If that fails and `force` is
+     * true, this method will evict the longest playing sound effect and
+     * return its slot.
+     *
+     * @param force     Whether to force another sound to stop.
+     *
+     * @return a free slot for a new sound effect (or -1 if none)
+     */
+    int acquireSlot(bool force);
+
+    /**
+     * Remembers the handle of the effect in the given slot, which is reused.
+     *
+     * The effect may still be fading out, and so its completion arrives after
+     * the slot belongs to another effect. This lets {@link #gcollect} find the
+     * handle of the effect without the slot.
+     *
+     * @param slot      The sound effect slot
+     */
+    void retireVoice(Uint32 slot);
+
+    /**
+     * Sends a command to a sound effect slot
+     *
+     * The command is run by the audio thread at the start of its next read.
+     * If the command queue is full, the command is posted again on the next
+     * collect, as the main thread may never touch a fader the mixer reads.
+     *
+     * @param op        The operation to perform
+     * @param slot      The sound effect slot
+     * @param fader     The fader to act on
+     * @param fade      The fade duration in seconds
+     */
+    void post(Command::Op op, Uint32 slot, audio::AudioFader* fader, float fade=0);
+
+    /**
+     * Runs a command on a sound effect slot
+     *
+     * A command for an effect is dropped if the effect is no longer playing
+     * in its slot, as the fader may have been recycled for another effect.
+     *
+     * @param command   The command to run
+     */
+    void execute(const Command& command);
+
+    /**
+     * Runs all pending commands (AUDIO THREAD ONLY)
+     */
+    void runCommands();
+
+    /**
+     * Garbage collects all completed sound effects (MAIN THREAD ONLY)
      *
-     * @remove key  The key to purge from the list of active effects.
+     * This method is called once an animation frame, and whenever the engine
+     * runs out of free slots. It also posts the deferred commands.
      */
-    void removeKey(const std::string key);
+    void collect();
 
     /**
      * Returns a playable audio node for a given audio instance
@@ -535,7 +677,72 @@ public:
      */
     bool play(const std::string key, const std::shared_ptr<audio::AudioNode>& graph,
               bool loop=false, float volume=1.0f, bool force=false);
+
+    /**
+     * Returns the handle for the given key.
+     *
+     * The handle is created the first time a key is used, and it stays valid
+     * for the lifetime of the engine. Looking up the handle once and playing
+     * with it afterwards avoids hashing the key on every call.
+     *
+     * @param  key  the reference key for the sound effect
+     *
+     * @return the handle for the given key.
+     */
+    Uint32 getHandle(const std::string key);
+
+    /**
+     * Returns the key for the given handle.
+     *
+     * @param  handle   the handle for the sound effect
+     *
+     * @return the key for the given handle.
+     */
+    const std::string& getKey(Uint32 handle) const { return _keys[handle]; }
+
+    /**
+     * Plays the given sound, and associates it with the specified handle.
+     *
+     * This is the same as playing with the key of the handle (see
+     * {@link #getHandle}), except that it does not hash the key.
+     *
+     * @param  handle   The handle for the sound effect
+     * @param  sound    The sound effect to play
+     * @param  loop     Whether to loop the sound effect continuously
+     * @param  volume   The music volume (relative to the default asset volume)
+     * @param  force    Whether to force another sound to stop.
+     *
+     * @return true if there was an available channel for the sound
+     */
+    bool play(Uint32 handle, const std::shared_ptr<Sound>& sound,
+              bool loop=false, float volume=1.0f, bool force=false);
+
+    /**
+     * Plays the given audio node, and associates it with the specified handle.
+     *
+     * This is the same as playing with the key of the handle (see
+     * {@link #getHandle}), except that it does not hash the key.
+     *
+     * @param  handle   The handle for the sound effect
+     * @param  graph    The audio graph to play
+     * @param  loop     Whether to loop the sound effect continuously
+     * @param  volume   The music volume (relative to the default instance volume)
+     * @param  force    Whether to force another sound to stop.
+     *
+     * @return true if there was an available channel for the sound
+     */
+    bool play(Uint32 handle, const std::shared_ptr<audio::AudioNode>& graph,
+              bool loop=false, float volume=1.0f, bool force=false);
     
+    /**
+     * Returns the total number of slots for sound effects.
+     *
+     * This is the capacity the engine was started with.
+     *
+     * @return the total number of slots for sound effects.
+     */
+    size_t getCapacity() const { return _capacity; }
+
     /**
      * Returns the number of slots available for sound effects.
      *
@@ -548,7 +755,7 @@ public:
      * @return the number of slots available for sound effects.
      */
     size_t getAvailableSlots() const {
-        return _capacity-_actives.size();
+        return _evicts.size() < _capacity ? _capacity-_evicts.size() : 0;
     }
 
     /**
@@ -571,7 +778,18 @@ public:
      * @return true if the key is associated with an active sound.
      */
     bool isActive(const std::string key) const {
-        return _actives.find(key) != _actives.end();
+        return findActive(key) != nullptr;
+    }
+
+    /**
+     * Returns true if the handle is associated with an active sound.
+     *
+     * @param  handle   the handle for the sound effect
+     *
+     * @return true if the handle is associated with an active sound.
+     */
+    bool isActive(Uint32 handle) const {
+        return handle < _actives.size() && _actives[handle] != nullptr;
     }
 
     /**
@@ -795,6 +1013,29 @@ public:
      */
     void clear(const std::string key,float fade=DEFAULT_FADE);
 
+    /**
+     * Removes the sound effect for the given handle, stopping it immediately
+     *
+     * This is the same as clearing the effect with the key of the handle (see
+     * {@link #getHandle}), except that it does not hash the key.
+     *
+     * @param handle    the handle for the sound effect
+     * @param fade      the number of seconds to fade out
+     */
+    void clear(Uint32 handle,float fade=DEFAULT_FADE);
+
+    /**
+     * Removes the sound effect for the given handle, and frees its slot at once
+     *
+     * Unlike {@link #clear}, the slot is free as soon as this method returns,
+     * so that the next play can take it while the old effect fades out. The
+     * handle is inactive afterwards.
+     *
+     * @param handle    the handle for the sound effect
+     * @param fade      the number of seconds to fade out
+     */
+    void evict(Uint32 handle,float fade=DEFAULT_FADE);
+
     /**
      * Pauses the sound effect for the given key.
      *
@@ -75,8 +75,27 @@ namespace  cugl {
  * interleaved.  We support up to 32 channels, though it is unlikely for that
  * many channels to be encoded in a sound file.  SDL itself only supports 8
  * channels for (7.1 surround) playback.
+ *
+ * An in-memory sample may be kept in a compact format instead of float (see
+ * {@link Format}). A 16-bit sample takes half the memory, and an IMA ADPCM
+ * sample takes about an eighth, at some loss of quality. The data is converted
+ * to float as it is played. A compact sample has no float buffer, and so
+ * {@link getBuffer} returns nullptr for it.
  */
 class AudioSample : public Sound {
+public:
+    /**
+     * The in-memory formats of an audio sample
+     */
+    enum class Format {
+        /** 32-bit float PCM (the decoder output) */
+        FLOAT,
+        /** 16-bit signed PCM */
+        PCM16,
+        /** 4-bit IMA ADPCM, in independently decodable blocks of frames */
+        ADPCM
+    };
+
 protected:
     /** The number of frames in this audio sample */
     Uint64 _frames;
@@ -89,6 +108,19 @@ protected:
 
     /** The in-memory sound buffer for this sound source (OPTIONAL) */
     float* _buffer;
+
+    /** The in-memory format of this sample */
+    Format _format;
+
+    /** The in-memory compact data for this sound source (OPTIONAL) */
+    Uint8* _packed;
+
+    /**
+     * Converts the decoded float buffer into the compact format
+     *
+     * This releases the float buffer.
+     */
+    void pack();
     
 public:
 #pragma mark Constructors
@@ -117,7 +149,25 @@ public:
      *
      * @return true if the sound source was initialized successfully
      */
-    bool init(const std::string file, bool stream=false);
+    bool init(const std::string file, bool stream=false) {
+        return init(file,stream,Format::FLOAT);
+    }
+
+    /**
+     * Initializes a new audio sample for the given file and format.
+     *
+     * The choice of buffered or streaming is independent of the file type.
+     * If the file is streamed, it will not be loaded into memory, and the
+     * format is ignored.  Otherwise, this initializer will allocate memory
+     * to read the asset into memory, and then store it in the given format.
+     *
+     * @param file      The source file for the audio sample
+     * @param stream    Wether to stream the audio from the file.
+     * @param format    The in-memory format of the sample
+     *
+     * @return true if the sound source was initialized successfully
+     */
+    bool init(const std::string file, bool stream, Format format);
     
     /**
      * Initializes an empty audio sample of the given size.
@@ -144,6 +194,7 @@ public:
 	 *      "file":     The path to the source, relative to the asset directory
 	 *      "stream":   A boolean, indicating whether to stream the sample
 	 *      "volume":   A float, representing the volume
+	 *      "format":   One of "float", "int16" or "adpcm" (in-memory only)
 	 *
 	 * All attributes are optional.  There are no required attributes. By default,
 	 * audio samples are not streamed, meaning they are fully loaded into memory.
@@ -209,6 +260,7 @@ public:
      *      "file":     The path to the source, relative to the asset directory
      *      "stream":   A boolean, indicating whether to stream the sample
      *      "volume":   A float, representing the volume
+     *      "format":   One of "float", "int16" or "adpcm" (in-memory only)
      *
      * All attributes are optional.  There are no required attributes. By default,
      * audio samples are not streamed, meaning they are fully loaded into memory.
@@ -260,18 +312,64 @@ public:
      * @return the length of this audio sample in seconds.
      */
     virtual double getDuration() const override { return (double)_frames/(double)_rate; }
+
+    /**
+     * Returns the in-memory format of this audio sample
+     *
+     * A streamed sample is always reported as FLOAT.
+     *
+     * @return the in-memory format of this audio sample
+     */
+    Format getFormat() const { return _format; }
+
+    /**
+     * Returns the number of bytes of audio data held in memory
+     *
+     * This is 0 for a streamed sample.
+     *
+     * @return the number of bytes of audio data held in memory
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Returns the number of bytes this sample would take as float data
+     *
+     * Comparing this to {@link getMemoryUsage} shows the savings of a
+     * compact format.
+     *
+     * @return the number of bytes this sample would take as float data
+     */
+    size_t getFloatSize() const { return (size_t)(_frames*_channels*sizeof(float)); }
     
 #pragma mark Playback Support
     /**
      * Returns the underlying PCM data buffer.
      *
-     * This pointer will be null if the sample is streamed.  Otherwise, the
-     * the buffer will contain channels * frames many elements. It is okay to
-     * write data to the buffer, but it cannot be resized or reassigned.
+     * This pointer will be null if the sample is streamed or compact.
+     * Otherwise, the buffer will contain channels * frames many elements.
+     * It is okay to write data to the buffer, but it cannot be resized or
+     * reassigned.
      *
      * @return the underlying PCM data buffer.
      */
     float* getBuffer() { return _buffer; }
+
+    /**
+     * Reads frames of an in-memory sample as float data, scaled by a gain
+     *
+     * This method converts compact data on the fly. It is safe to call from
+     * the audio thread, as it neither locks nor allocates. It returns the
+     * number of frames read, which is less than requested only at the end
+     * of the sample. It reads nothing from a streamed sample.
+     *
+     * @param offset    The first frame to read
+     * @param buffer    The buffer to store the frames (channels * frames)
+     * @param frames    The number of frames to read
+     * @param gain      The gain to apply to the frames
+     *
+     * @return the number of frames read
+     */
+    Uint32 read(Uint64 offset, float* buffer, Uint32 frames, float gain) const;
         
     /**
      * Returns a new decoder for this audio sample
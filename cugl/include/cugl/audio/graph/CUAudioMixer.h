@@ -91,7 +91,13 @@ private:
     /** The knee value for clamping */
     std::atomic<float>  _knee;
 
-    /** This class needs a proper lock guard; too many race conditions */
+    /**
+     * Serializes the delegated methods called from the main thread.
+     *
+     * This is never locked by {@link #read}, so the audio thread does not
+     * wait on the main thread. The inputs are thread safe on their own (as
+     * they must be for the {@link AudioEngine}, which controls them directly).
+     */
     std::mutex _mutex;
     /** The current read position */
     std::atomic<Uint64> _offset;
@@ -174,6 +174,8 @@ protected:
     Callback _callback;
     /** An atomic to mark that the callback is active (to give lock-free safety) */
     std::atomic<bool> _calling;
+    /** Whether the callback is invoked directly in the audio thread */
+    std::atomic<bool> _immediate;
 
     /** An identifying integer */
     Sint32 _tag;
@@ -213,6 +215,9 @@ protected:
      * might change during that delay.  This is a wrapper to ensure that this
      * potential race condition happens gracefully and does not have any
      * unexpected side effects.
+     *
+     * If the callback was set as immediate, it is called right away in the
+     * audio thread instead.
      */
     void notify(const std::shared_ptr<AudioNode>& node, Action action);
     
@@ -454,6 +459,24 @@ public:
      * @param callback  the callback function for this node
      */
     void setCallback(Callback callback);
+
+    /**
+     * Sets the callback function for this node
+     *
+     * If immediate is false, this is the same as {@link #setCallback}. If
+     * it is true, the callback is invoked directly in the audio thread when
+     * the action takes place, instead of being scheduled for the main
+     * thread. Scheduling a callback locks the application and allocates
+     * memory, which the audio thread should avoid. An immediate callback
+     * must be quick and must not lock or allocate either; typically it only
+     * pushes the action onto a {@link SPSCQueue} read by the main thread.
+     *
+     * The callback should be set before the node is attached to a graph.
+     *
+     * @param callback  the callback function for this node
+     * @param immediate whether to invoke the callback in the audio thread
+     */
+    void setCallback(Callback callback, bool immediate);
     
     /**
      * Returns true if this node is currently paused
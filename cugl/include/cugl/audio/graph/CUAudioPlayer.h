@@ -56,6 +56,7 @@
 #include <functional>
 #include <string>
 #include <atomic>
+#include <mutex>
 
 namespace  cugl {
 
@@ -92,6 +93,13 @@ namespace  cugl {
  * to this rule is by another (custom) audio graph node in its audio thread
  * methods.
  *
+ * A streamed sample is decoded ahead of playback by a shared background
+ * worker (see {@link #setPrefetch}), so the audio thread only copies frames
+ * out of a ring buffer. The first frames of the stream are decoded when the
+ * player is created, so a player made ahead of time (such as the next track
+ * of an {@link AudioQueue}) starts without waiting on the worker. If the
+ * worker falls behind, the player plays silence and counts an underrun.
+ *
  * This class does not support any actions for the {@link AudioNode#setCallback}.
  * Fade in/out and scheduling have been refactored into other nodes to provide
  * proper audio patch support.
@@ -108,9 +116,6 @@ protected:
     /** The last marked position (starts at 0) */
     std::atomic<Uint64> _marked;
     
-    /** A reference to the underlying data buffer (IN-MEMORY ACCESS) */
-    float* _buffer;
-    
     // Streaming support
     /** A buffer for storing each chunk as we need it */
     float* _chunker;
@@ -124,6 +129,35 @@ protected:
     /** Whether or not we need to reposition (STREAMING ACCESS) */
     std::atomic<bool> _dirty;
 
+    // Prefetch support
+    /** The first frames of the stream, decoded when the player is created */
+    float* _intro;
+    /** The number of frames in the intro */
+    Uint32 _introsize;
+    /** The frames decoded ahead by the stream worker */
+    float* _ring;
+    /** The number of frames in the ring (a power of two) */
+    Uint32 _ringsize;
+    /** The generation of the last reposition seen by the audio thread */
+    std::atomic<Uint32> _wantGen;
+    /** The frame of the last reposition seen by the audio thread */
+    std::atomic<Uint64> _wantFrame;
+    /** The generation of the reposition the ring was filled for */
+    std::atomic<Uint32> _fillGen;
+    /** The first frame held by the ring for its generation */
+    std::atomic<Uint64> _ringBase;
+    /** The frame after the last one written to the ring */
+    std::atomic<Uint64> _ringWrite;
+    /** The number of reads that ran out of decoded frames */
+    std::atomic<Uint32> _underruns;
+    /** Guards the decoder against disposal while the worker uses it */
+    std::mutex _prefetchMutex;
+
+    /** The number of seconds to decode ahead (0 to decode on the audio thread) */
+    static double _prefetch;
+    /** The number of underruns over all players */
+    static std::atomic<Uint64> _allUnderruns;
+
 public:
 #pragma mark Constructors
     /**
@@ -320,7 +354,62 @@ public:
      * @return the new remaining time in seconds.
      */
     virtual double setRemaining(double time) override;
-    
+
+#pragma mark -
+#pragma mark Prefetching
+    /**
+     * Sets the number of seconds a streamed player decodes ahead.
+     *
+     * Players created afterwards decode their stream on a background worker,
+     * keeping this much audio ready (and the same amount of the start of the
+     * stream for loops). A value of 0 decodes on the audio thread instead, as
+     * it is needed. This only affects players created after the call.
+     *
+     * @param seconds   The number of seconds to decode ahead
+     */
+    static void setPrefetch(double seconds) { _prefetch = seconds < 0 ? 0 : seconds; }
+
+    /**
+     * Returns the number of seconds a streamed player decodes ahead.
+     *
+     * @return the number of seconds a streamed player decodes ahead.
+     */
+    static double getPrefetch() { return _prefetch; }
+
+    /**
+     * Returns the number of underruns over all players.
+     *
+     * An underrun is a read that found the stream worker behind, and was
+     * padded with silence.
+     *
+     * @return the number of underruns over all players.
+     */
+    static Uint64 getAllUnderruns() { return _allUnderruns.load(std::memory_order_relaxed); }
+
+    /**
+     * Returns the number of underruns of this player.
+     *
+     * @return the number of underruns of this player.
+     */
+    Uint32 getUnderruns() const { return _underruns.load(std::memory_order_relaxed); }
+
+    /**
+     * Returns true if this player is decoded by the stream worker.
+     *
+     * @return true if this player is decoded by the stream worker.
+     */
+    bool isPrefetched() const { return _ring != nullptr; }
+
+    /**
+     * Decodes ahead of the read position, if there is room in the ring.
+     *
+     * WORKER THREAD ONLY: This is called by the stream worker, and should
+     * never be called by the user.
+     *
+     * @return true if any frames were decoded
+     */
+    bool prefetch();
+
 private:
 #pragma mark Stream Decoding
     /**
@@ -328,7 +417,8 @@ private:
      *
      * AUDIO THREAD ONLY: Users should never access this method directly.
      * The only exception is when the user needs to create a custom subclass
-     * of this AudioNode.
+     * of this AudioNode. A prefetched player calls this on the stream worker
+     * instead, as the audio thread never touches its decoder.
      *
      * If the frame is longer than the stream length, it goes to the end of
      * the stream.
@@ -336,6 +426,23 @@ private:
      * @param frame    The absolute frame to skip to
      */
     void scan(Uint64 frame);
+
+    /**
+     * Reads frames decoded by the stream worker into the given buffer
+     *
+     * AUDIO THREAD ONLY: Users should never access this method directly.
+     *
+     * The frames come from the intro or the ring. If the worker has not
+     * decoded them yet, the rest of the buffer is silence and the read
+     * position stays put, so playback resumes where it stopped.
+     *
+     * @param off       The current read position
+     * @param buffer    The read buffer to store the results
+     * @param frames    The maximum number of frames to read
+     *
+     * @return the actual number of frames read
+     */
+    Uint32 readAhead(Uint64 off, float* buffer, Uint32 frames);
 };
 
     }
@@ -48,7 +48,13 @@
 #include <box2d/b2_world_callbacks.h>
 #include <box2d/b2_world.h>
 #include <box2d/b2_joint.h>
+#include <box2d/b2_fixture.h>
+#include <box2d/b2_broad_phase.h>
 #include <cugl/math/cu_math.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -93,6 +99,64 @@ class Joint;
  * functions while the program is running.
  */
 class ObstacleWorld : public b2ContactListener, b2DestructionListener, b2ContactFilter {
+public:
+    /**
+     * The statistics of a single physics step.
+     *
+     * Timings are in milliseconds. The counts by category are indexed by
+     * the bit position of the category (so index 0 is category 0x0001).
+     * A body counts towards every category of its fixtures, and a contact
+     * towards every category of its two fixtures.
+     *
+     * The ray-cast and query counts cover the calls made since the previous
+     * step, which is usually the game logic of one frame.
+     */
+    struct Stats {
+        /** The Box2D profile of the step (step, collide, solve, solveTOI, broadphase, ...) */
+        b2Profile profile;
+        /** The wall-clock time of the Box2D step */
+        float stepTime;
+        /** The number of bodies in the world */
+        int bodies;
+        /** The number of awake bodies in the world */
+        int awakeBodies;
+        /** The number of contacts (including those not touching) */
+        int contacts;
+        /** The number of touching contacts */
+        int touching;
+        /** The number of broadphase proxies */
+        int proxies;
+        /** The number of bodies by category bit */
+        std::array<int,16> bodiesByCategory;
+        /** The number of touching contacts by category bit */
+        std::array<int,16> contactsByCategory;
+        /** The number of broadphase proxies by category bit */
+        std::array<int,16> proxiesByCategory;
+        /** The number of ray-casts (each ray of a fan counts once) */
+        int raycasts;
+        /** The number of AABB queries */
+        int queries;
+        /** The total wall-clock time of the ray-casts and queries */
+        float queryTime;
+        
+        /** Creates an empty set of statistics */
+        Stats();
+        
+        /**
+         * Returns the column names for {@link toCSV}.
+         *
+         * @return the column names for {@link toCSV}.
+         */
+        static std::string getCSVHeader();
+        
+        /**
+         * Returns these statistics as a single comma-separated row.
+         *
+         * @return these statistics as a single comma-separated row.
+         */
+        std::string toCSV() const;
+    };
+    
 protected:
     /** Reference to the Box2D world */
     b2World* _world;
@@ -125,6 +189,37 @@ protected:
     bool _filters;
     /** Whether or not to activate the destruction listener */
     bool _destroy;
+    
+    /** Whether or not to gather statistics */
+    bool _statsEnabled;
+    /** The statistics of the most recent step */
+    Stats _stats;
+    /** The number of ray-casts since the last step (queries may run on several threads) */
+    mutable std::atomic<int> _raycasts;
+    /** The number of AABB queries since the last step */
+    mutable std::atomic<int> _queries;
+    /** The time spent in ray-casts and queries since the last step, in nanoseconds */
+    mutable std::atomic<long long> _queryNanos;
+    
+    /**
+     * Records a ray-cast or query that started at the given time.
+     *
+     * @param start     the time the query started
+     * @param raycasts  the number of rays cast by the query
+     * @param queries   the number of AABB queries made by the query
+     */
+    void recordQuery(std::chrono::steady_clock::time_point start, int raycasts, int queries) const {
+        _raycasts += raycasts;
+        _queries += queries;
+        _queryNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count();
+    }
+    
+    /**
+     * Recomputes the statistics after a step that took the given time.
+     *
+     * @param stepTime  the wall-clock time of the step in milliseconds
+     */
+    void computeStats(float stepTime);
 
     
 #pragma mark -
@@ -355,6 +450,36 @@ public:
     bool inBounds(Obstacle* obj);
     
     
+#pragma mark -
+#pragma mark Statistics
+    /**
+     * Returns true if this world gathers statistics.
+     *
+     * @return true if this world gathers statistics.
+     */
+    bool isStatsEnabled() const { return _statsEnabled; }
+    
+    /**
+     * Sets whether this world gathers statistics.
+     *
+     * Gathering statistics costs a pass over the bodies and contacts after
+     * every step, plus a clock read around every ray-cast and query. It is
+     * off by default.
+     *
+     * @param  flag whether this world gathers statistics.
+     */
+    void setStatsEnabled(bool flag);
+    
+    /**
+     * Returns the statistics of the most recent step.
+     *
+     * The statistics are empty if they are not enabled.
+     *
+     * @return the statistics of the most recent step.
+     */
+    const Stats& getStats() const { return _stats; }
+    
+    
 #pragma mark -
 #pragma mark Object Management
     /**
@@ -764,6 +889,9 @@ public:
      * The callback controls whether you get the closest point, any point, or n-points.
      * The ray-cast ignores shapes that contain the starting point.
      *
+     * Ray-casts do not modify the world, so several threads may ray-cast at
+     * once as long as no thread steps or modifies the world in the meantime.
+     *
      * @param  callback a user implemented callback function.
      * @param  point1   The ray starting point
      * @param  point2   The ray ending point
@@ -772,7 +900,207 @@ public:
                                      const Vec2 normal, float fraction)> callback,
                  const Vec2 point1, const Vec2 point2) const;
     
+    /**
+     * Query the world for all fixtures that potentially overlap the provided AABB.
+     *
+     * This version inlines the callback instead of wrapping it in a
+     * std::function, so it does not allocate and costs one virtual call per
+     * fixture. It is selected automatically when the callback is a lambda.
+     *
+     * Fixtures whose category bits do not intersect categories are skipped
+     * before the callback is invoked.
+     *
+     * @param  callback     A callable bool(b2Fixture* fixture)
+     * @param  aabb         The axis-aligned bounding box
+     * @param  categories   The category bits of the fixtures to report
+     */
+    template <typename Callback>
+    void queryAABB(Callback&& callback, const Rect aabb, uint16 categories = 0xFFFF) const;
+    
+    /**
+     * Ray-cast the world for all fixtures in the path of the ray.
+     *
+     * This version inlines the callback instead of wrapping it in a
+     * std::function, so it does not allocate and costs one virtual call per
+     * fixture. It is selected automatically when the callback is a lambda.
+     * The callback has the same semantics as the std::function version.
+     *
+     * Fixtures whose category bits do not intersect categories are skipped
+     * (as if the callback returned -1) before the callback is invoked.
+     *
+     * @param  callback     A callable float(b2Fixture*, Vec2 point, Vec2 normal, float fraction)
+     * @param  point1       The ray starting point
+     * @param  point2       The ray ending point
+     * @param  categories   The category bits of the fixtures to report
+     */
+    template <typename Callback>
+    void rayCast(Callback&& callback, const Vec2 point1, const Vec2 point2, uint16 categories = 0xFFFF) const;
+    
+    /**
+     * Ray-casts a batch of rays that share a starting point, such as a sight fan.
+     *
+     * The broadphase is traversed once for the bounding box of all of the rays,
+     * and every candidate fixture is then tested against each ray. Rays are
+     * processed in order, and the candidates of a single ray are reported with
+     * the same semantics as {@link rayCast}: -1 filters the fixture, 0 ends
+     * this ray, and any other value clips the ray at that fraction. The order
+     * in which fixtures are reported for one ray may differ from {@link rayCast}.
+     *
+     * Fixtures whose category bits do not intersect categories are discarded
+     * before any ray is tested.
+     *
+     * @param  callback     A callable float(size_t ray, b2Fixture*, Vec2 point, Vec2 normal, float fraction)
+     * @param  origin       The starting point of every ray
+     * @param  ends         The ending point of each ray
+     * @param  count        The number of rays
+     * @param  categories   The category bits of the fixtures to report
+     */
+    template <typename Callback>
+    void rayCastFan(Callback&& callback, const Vec2 origin, const Vec2* ends, size_t count, uint16 categories = 0xFFFF) const;
+    
+};
+
+#pragma mark -
+#pragma mark Query Templates
+/**
+ * A b2QueryCallback that forwards to an inlined callable.
+ */
+template <typename Callback>
+class InlineQueryProxy : public b2QueryCallback {
+public:
+    /** The user callback */
+    Callback& onQuery;
+    /** The category bits of the fixtures to report */
+    uint16 categories;
+    
+    InlineQueryProxy(Callback& callback, uint16 mask) : onQuery(callback), categories(mask) {}
+    
+    bool ReportFixture(b2Fixture* fixture) override {
+        if ((fixture->GetFilterData().categoryBits & categories) == 0) {
+            return true;
+        }
+        return onQuery(fixture);
+    }
 };
+
+/**
+ * A b2RayCastCallback that forwards to an inlined callable.
+ */
+template <typename Callback>
+class InlineRaycastProxy : public b2RayCastCallback {
+public:
+    /** The user callback */
+    Callback& onQuery;
+    /** The category bits of the fixtures to report */
+    uint16 categories;
+    
+    InlineRaycastProxy(Callback& callback, uint16 mask) : onQuery(callback), categories(mask) {}
+    
+    float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override {
+        if ((fixture->GetFilterData().categoryBits & categories) == 0) {
+            return -1;
+        }
+        return onQuery(fixture,Vec2(point.x,point.y),Vec2(normal.x,normal.y),fraction);
+    }
+};
+
+template <typename Callback>
+void ObstacleWorld::queryAABB(Callback&& callback, const Rect aabb, uint16 categories) const {
+    b2AABB b2box;
+    b2box.lowerBound.Set(aabb.origin.x, aabb.origin.y);
+    b2box.upperBound.Set(aabb.origin.x+aabb.size.width, aabb.origin.y+aabb.size.height);
+    InlineQueryProxy<Callback> proxy(callback, categories);
+    if (_statsEnabled) {
+        auto start = std::chrono::steady_clock::now();
+        _world->QueryAABB(&proxy, b2box);
+        recordQuery(start, 0, 1);
+    } else {
+        _world->QueryAABB(&proxy, b2box);
+    }
+}
+
+template <typename Callback>
+void ObstacleWorld::rayCast(Callback&& callback, const Vec2 point1, const Vec2 point2, uint16 categories) const {
+    InlineRaycastProxy<Callback> proxy(callback, categories);
+    if (_statsEnabled) {
+        auto start = std::chrono::steady_clock::now();
+        _world->RayCast(&proxy, b2Vec2(point1.x,point1.y), b2Vec2(point2.x,point2.y));
+        recordQuery(start, 1, 0);
+    } else {
+        _world->RayCast(&proxy, b2Vec2(point1.x,point1.y), b2Vec2(point2.x,point2.y));
+    }
+}
+
+template <typename Callback>
+void ObstacleWorld::rayCastFan(Callback&& callback, const Vec2 origin, const Vec2* ends, size_t count, uint16 categories) const {
+    if (count == 0) {
+        return;
+    }
+    std::chrono::steady_clock::time_point start;
+    if (_statsEnabled) {
+        start = std::chrono::steady_clock::now();
+    }
+    
+    // Gather the candidates once for the whole fan
+    b2AABB bounds;
+    bounds.lowerBound.Set(origin.x, origin.y);
+    bounds.upperBound = bounds.lowerBound;
+    for (size_t ii = 0; ii < count; ii++) {
+        bounds.lowerBound = b2Min(bounds.lowerBound, b2Vec2(ends[ii].x, ends[ii].y));
+        bounds.upperBound = b2Max(bounds.upperBound, b2Vec2(ends[ii].x, ends[ii].y));
+    }
+    
+    // One scratch buffer per thread, so concurrent fans do not allocate
+    static thread_local std::vector<const b2FixtureProxy*> candidates;
+    candidates.clear();
+    const b2BroadPhase& broadphase = _world->GetContactManager().m_broadPhase;
+    struct Gather {
+        const b2BroadPhase* broadphase;
+        uint16 categories;
+        bool QueryCallback(int32 proxyId) {
+            const b2FixtureProxy* proxy = (const b2FixtureProxy*)broadphase->GetUserData(proxyId);
+            if ((proxy->fixture->GetFilterData().categoryBits & categories) != 0) {
+                candidates.push_back(proxy);
+            }
+            return true;
+        }
+    } gather = { &broadphase, categories };
+    broadphase.Query(&gather, bounds);
+    
+    b2RayCastInput input;
+    b2RayCastOutput output;
+    input.p1.Set(origin.x, origin.y);
+    for (size_t ray = 0; ray < count; ray++) {
+        input.p2.Set(ends[ray].x, ends[ray].y);
+        float maxFraction = 1.0f;
+        for (const b2FixtureProxy* proxy : candidates) {
+            // Cull against the segment box before the exact test
+            b2Vec2 end = input.p1 + maxFraction * (input.p2 - input.p1);
+            b2AABB segment;
+            segment.lowerBound = b2Min(input.p1, end);
+            segment.upperBound = b2Max(input.p1, end);
+            if (!b2TestOverlap(proxy->aabb, segment)) {
+                continue;
+            }
+            input.maxFraction = maxFraction;
+            if (!proxy->fixture->RayCast(&output, input, proxy->childIndex)) {
+                continue;
+            }
+            float fraction = output.fraction;
+            b2Vec2 point = (1.0f - fraction) * input.p1 + fraction * input.p2;
+            float value = callback(ray, proxy->fixture, Vec2(point.x,point.y),
+                                   Vec2(output.normal.x,output.normal.y), fraction);
+            if (value == 0) {
+                break;
+            } else if (value > 0) {
+                maxFraction = value;
+            }
+        }
+    }
+    if (_statsEnabled) {
+        recordQuery(start, (int)count, 0);
+    }
+}
     }
 }
 #endif /* __CU_PHYSICS_WORLD_H__ */
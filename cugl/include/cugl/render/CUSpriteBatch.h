@@ -47,6 +47,7 @@
 #ifndef __CU_SPRITE_BATCH_H__
 #define __CU_SPRITE_BATCH_H__
 #include <SDL.h>
+#include <unordered_map>
 #include <vector>
 #include "CUSpriteVertex.h"
 #include "CUStencilEffect.h"
@@ -72,6 +73,7 @@ class Texture;
 class Gradient;
 class Scissor;
 class Font;
+class GlyphRun;
 class Rect;
 class Poly2;
 class Path2;
@@ -104,7 +106,21 @@ class Path2;
  * called. Because loading vertices into a {@link VertexBuffer} is an expensive 
  * operation, this sprite batch attempts to minimize this as much as possible.
  * Even texture switches are batched.  However, it is still true that using a
- * single texture atlas can significantly improve drawing speed.
+ * single texture atlas can significantly improve drawing speed. With
+ * {@link #setStreaming}, the vertices of each flush are written to a ring in
+ * a buffer that is only specified once, instead of reloading the buffer.
+ *
+ * By default, shapes are drawn in the order they are submitted, so every
+ * texture or blend change between two shapes is a separate draw call. In
+ * deferred mode (see {@link #setDeferred}), each shape carries a sort key
+ * and the shapes are reordered on flush to group those with the same state.
+ * Shapes are never reordered past another shape they overlap.
+ *
+ * Textured rectangles (the sprites drawn by the {@link #draw} methods) are
+ * usually expanded into four vertices on the CPU. With {@link #setInstancing},
+ * each rectangle is instead a compact instance (an affine map, texture region
+ * and color) that the vertex shader expands. The CPU expansion remains as the
+ * fallback when the shader has no support for instances.
  *
  * A review of this class shows that there are a lot of redundant drawing methods.
  * The scene graphs only use the {@link Mesh} methods. This goal has been to make 
@@ -117,7 +133,9 @@ class Path2;
  * a new class.  It should also have a uniform for the perspective matrix,
  * texture, and drawing type (type 0). Support for gradients and scissors occur
  * via a uniform block that is provides the data in the order scissor, and then
- * gradient.  See SpriteShader.frag for more information.
+ * gradient.  See SpriteShader.frag for more information. A shader that supports
+ * instancing has the integer uniform uQuads and the quad instance attributes
+ * of SpriteShader.vert.
  *
  * This is an extremely heavy-weight class. There is rarely any need to have more
  * than one of these at a time. If you want to implement your own shader effects,
@@ -126,6 +144,21 @@ class Path2;
  */
 class SpriteBatch {
 #pragma mark Values
+public:
+    /**
+     * The upload and draw counters of a frame (see {@link #endFrame}).
+     */
+    struct FrameStats {
+        /** The number of bytes of vertices and indices uploaded */
+        size_t bytes = 0;
+        /** The number of times a buffer was (re)specified */
+        unsigned int respecs = 0;
+        /** The number of draw calls */
+        unsigned int calls = 0;
+        /** The number of vertices drawn */
+        unsigned int vertices = 0;
+    };
+
 private:
     
     /**
@@ -139,10 +172,69 @@ private:
      */
     class Context;
 
+    /**
+     * A textured rectangle drawn as an instance.
+     *
+     * The instance maps the unit square to the rectangle, so the vertex shader
+     * (or the CPU fallback) can expand it into the four corners of the quad.
+     */
+    struct QuadInstance;
+
+    /**
+     * A shape drawn in deferred mode.
+     *
+     * Each call to a drawing method is its own item, so that it can be moved
+     * to group it with other shapes of the same drawing state.
+     */
+    struct DrawItem {
+        /** The sort key (layer in bits 16-23, depth in bits 0-15) */
+        Uint32 key;
+        /** The position of the drawing context in the history */
+        Uint32 context;
+        /** The first index of the shape */
+        GLuint first;
+        /** The index after the last index of the shape */
+        GLuint last;
+        /** The bounding box of the shape (min x, min y, max x, max y) */
+        GLfloat bounds[4];
+        /** The next item in the same run (UINT32_MAX if none) */
+        Uint32 next;
+    };
+
+    /**
+     * A group of deferred items with the same drawing state.
+     */
+    struct DrawRun {
+        /** The position of the drawing context in the history */
+        Uint32 context;
+        /** The sort layer of the run */
+        Uint32 layer;
+        /** The first item of the run */
+        Uint32 head;
+        /** The last item of the run */
+        Uint32 tail;
+        /** The first index of the run in the sort buffer */
+        GLuint first;
+        /** The index after the last index of the run in the sort buffer */
+        GLuint last;
+        /** The bounding box of the items (min x, min y, max x, max y) */
+        GLfloat bounds[4];
+    };
+
     /** Whether this sprite batch has been initialized yet */
     bool _initialized;
     /** Whether this sprite batch is currently active */
     bool _active;
+    /** Whether this sprite batch has no OpenGL backing (see {@link #initHeadless}) */
+    bool _headless;
+    /** Whether the vertices are streamed through a ring (see {@link #setStreaming}) */
+    bool _streaming;
+    /** Whether the shapes are sorted before drawing (see {@link #setDeferred}) */
+    bool _deferred;
+    /** Whether rectangles are drawn as instances (see {@link #setInstancing}) */
+    bool _instancing;
+    /** Whether the shader supports quad instances */
+    bool _quadShader;
     
     /** The shader for this sprite batch */
     std::shared_ptr<Shader> _shader;
@@ -164,6 +256,19 @@ private:
     unsigned int _indxMax;
     /** The number of indices in the current mesh */
     unsigned int _indxSize;
+
+    /** The vertex buffer for the quad instances */
+    std::shared_ptr<VertexBuffer> _quadbuff;
+    /** The quad instances (each has one entry in the indices, its position here) */
+    QuadInstance* _quadData;
+    /** The quad instances in drawing order (in deferred mode) */
+    QuadInstance* _quadSort;
+    /** The capacity of the quad instances */
+    unsigned int _quadMax;
+    /** The number of quad instances in the current mesh */
+    unsigned int _quadSize;
+    /** Whether the quad buffer is bound (only during a flush) */
+    bool _quadsBound;
     
     /** The active drawing context */
     Context* _context;
@@ -171,6 +276,28 @@ private:
     bool _inflight;
     /** The drawing context history */
     std::vector<Context*> _history;
+    /** The released contexts available for reuse */
+    std::vector<Context*> _spare;
+
+    // Deferred mode
+    /** The active sort key */
+    Uint32 _sortKey;
+    /** The sort key of the open item */
+    Uint32 _itemKey;
+    /** The first index of the open item */
+    GLuint _itemFirst;
+    /** The first vertex of the open item */
+    GLuint _itemVert;
+    /** The deferred items in submission order */
+    std::vector<DrawItem> _items;
+    /** The deferred items in sorted order */
+    std::vector<Uint32> _order;
+    /** The scratch space for sorting the items */
+    std::vector<Uint32> _scratch;
+    /** The groups of items with the same drawing state */
+    std::vector<DrawRun> _runs;
+    /** The indices in drawing order */
+    GLuint* _sortData;
     
     /** The active color */
     Color4 _color;
@@ -179,12 +306,24 @@ private:
     std::shared_ptr<Gradient> _gradient;
     /** The active scissor mask */
     std::shared_ptr<Scissor>  _scissor;
+    /** The storage for the active scissor mask, reused by every setScissor */
+    std::shared_ptr<Scissor>  _scissorData;
+    /** The glyph runs of drawText, reused by every call */
+    std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> _textRuns;
 
     // Monitoring values
     /** The number of vertices drawn in this pass (so far) */
     unsigned int _vertTotal;
     /** The number of OpenGL calls in this pass (so far) */
     unsigned int _callTotal;
+    /** The number of bytes uploaded in this pass (so far) */
+    size_t _byteTotal;
+    /** The number of buffer respecifications in this pass (so far) */
+    unsigned int _specTotal;
+    /** The counters of the current frame (so far) */
+    FrameStats _frameStats;
+    /** The counters of the last completed frame */
+    FrameStats _lastFrame;
     
 
 #pragma mark -
@@ -304,6 +443,24 @@ public:
      */
     bool init(unsigned int capacity, const std::shared_ptr<Shader>& shader);
     
+    /**
+     * Initializes a sprite batch with the given vertex capacity and no OpenGL backing
+     *
+     * A headless sprite batch generates vertices and records its drawing
+     * contexts exactly like a normal sprite batch. However, flushing discards
+     * the vertices instead of drawing them. The counters {@link #getVerticesDrawn}
+     * and {@link #getCallsMade} are still updated.
+     *
+     * A headless sprite batch needs no OpenGL context, so it can measure the
+     * CPU cost of drawing in benchmarks and tools. Textures are never bound,
+     * and so they may be empty. A headless sprite batch cannot change shaders.
+     *
+     * @param capacity The vertex capacity of this spritebatch
+     *
+     * @return true if initialization was successful.
+     */
+    bool initHeadless(unsigned int capacity);
+    
     
 #pragma mark -
 #pragma mark Static Constructors
@@ -411,6 +568,22 @@ public:
         std::shared_ptr<SpriteBatch> result = std::make_shared<SpriteBatch>();
         return (result->init(capacity,shader) ? result : nullptr);
     }
+    
+    /**
+     * Returns a new sprite batch with the given vertex capacity and no OpenGL backing
+     *
+     * A headless sprite batch generates vertices and records its drawing
+     * contexts exactly like a normal sprite batch. However, flushing discards
+     * the vertices instead of drawing them. See {@link #initHeadless}.
+     *
+     * @param capacity The vertex capacity of this spritebatch
+     *
+     * @return a new sprite batch with the given vertex capacity and no OpenGL backing
+     */
+    static std::shared_ptr<SpriteBatch> allocHeadless(unsigned int capacity=DEFAULT_CAPACITY) {
+        std::shared_ptr<SpriteBatch> result = std::make_shared<SpriteBatch>();
+        return (result->initHeadless(capacity) ? result : nullptr);
+    }
 
 #pragma mark -
 #pragma mark Attributes
@@ -421,6 +594,15 @@ public:
      */
     bool isReady() const { return _initialized; }
     
+    /**
+     * Returns true if this sprite batch has no OpenGL backing.
+     *
+     * A headless sprite batch discards its vertices when flushed.
+     *
+     * @return true if this sprite batch has no OpenGL backing.
+     */
+    bool isHeadless() const { return _headless; }
+    
     /**
      * Returns whether this sprite batch is actively drawing.
      *
@@ -449,6 +631,148 @@ public:
      */
     unsigned int getCallsMade() const { return _callTotal; }
 
+    /**
+     * Returns the number of bytes uploaded in the latest pass (so far).
+     *
+     * This value will be reset to 0 whenever begin() is called.
+     *
+     * @return the number of bytes uploaded in the latest pass (so far).
+     */
+    size_t getBytesUploaded() const { return _byteTotal; }
+
+    /**
+     * Returns the number of buffer respecifications in the latest pass (so far).
+     *
+     * Without streaming, every flush respecifies both the vertex and index
+     * buffer. With streaming, a flush never does.
+     *
+     * This value will be reset to 0 whenever begin() is called.
+     *
+     * @return the number of buffer respecifications in the latest pass (so far).
+     */
+    unsigned int getRespecifications() const { return _specTotal; }
+
+    /**
+     * Completes the frame, saving the counters of every pass in it.
+     *
+     * A frame usually has several passes (one for each scene), so the pass
+     * counters do not show the cost of a frame. This should be called once
+     * at the end of each frame, outside of any pass.
+     */
+    void endFrame();
+
+    /**
+     * Returns the counters of the last completed frame.
+     *
+     * @return the counters of the last completed frame.
+     */
+    const FrameStats& getFrameStats() const { return _lastFrame; }
+
+    /**
+     * Sets whether this sprite batch streams its vertices through a ring.
+     *
+     * A streaming sprite batch writes the vertices of each flush after those
+     * of the previous one, in a vertex buffer that is specified once (see
+     * {@link VertexBuffer#setStreaming}). Otherwise every flush respecifies
+     * the buffers, which is expensive when texture or state switches force
+     * many flushes a frame.
+     *
+     * This may not be called during a pass.
+     *
+     * @param value Whether this sprite batch streams its vertices
+     */
+    void setStreaming(bool value);
+
+    /**
+     * Returns true if this sprite batch streams its vertices through a ring.
+     *
+     * @return true if this sprite batch streams its vertices through a ring.
+     */
+    bool isStreaming() const { return _streaming; }
+
+    /**
+     * Sets whether this sprite batch sorts its shapes before drawing.
+     *
+     * In deferred mode, the shapes of each flush are sorted by their sort
+     * key (see {@link #setSortKey}) and then grouped by drawing state
+     * (texture, blending, command, gradient and scissor), so the flush uses
+     * as few draw calls as possible. The order is preserved where it matters:
+     * shapes on different layers are always drawn in layer order, shapes of
+     * a layer are drawn in depth order, and a shape is never moved past a
+     * shape it overlaps. Shapes with the same key keep their submission order
+     * unless they do not overlap.
+     *
+     * Changing the perspective or the stencil in deferred mode flushes the
+     * shapes drawn so far.
+     *
+     * This may not be called during a pass.
+     *
+     * @param value Whether this sprite batch sorts its shapes before drawing
+     */
+    void setDeferred(bool value);
+
+    /**
+     * Returns true if this sprite batch sorts its shapes before drawing.
+     *
+     * @return true if this sprite batch sorts its shapes before drawing.
+     */
+    bool isDeferred() const { return _deferred; }
+
+    /**
+     * Sets whether this sprite batch draws rectangles as instances.
+     *
+     * When instancing, each filled rectangle (and so each sprite drawn by
+     * the {@link #draw} methods) is recorded as a single instance of an
+     * affine map, texture region and color, instead of four vertices and
+     * six indices. The vertex shader expands the instances, so there is
+     * less to compute and upload per sprite. The result is the same as
+     * drawing the rectangle as a polygon.
+     *
+     * If the shader has no support for instances (see the class description),
+     * the rectangles are expanded on the CPU as before. A headless sprite
+     * batch records the instances like any other.
+     *
+     * This may not be called during a pass.
+     *
+     * @param value Whether this sprite batch draws rectangles as instances
+     */
+    void setInstancing(bool value);
+
+    /**
+     * Returns true if this sprite batch draws rectangles as instances.
+     *
+     * This is false if instancing is on but the shader does not support it.
+     *
+     * @return true if this sprite batch draws rectangles as instances.
+     */
+    bool isInstancing() const { return _instancing && (_headless || _quadShader); }
+
+    /**
+     * Sets the sort key of the shapes drawn afterwards.
+     *
+     * The key only matters in deferred mode. Layers are drawn in increasing
+     * order, and shapes within a layer in increasing depth. The key is reset
+     * to (0,0) at the start of each pass.
+     *
+     * @param layer The sort layer
+     * @param depth The depth within the layer
+     */
+    void setSortKey(Uint8 layer, Uint16 depth) { _sortKey = ((Uint32)layer << 16) | depth; }
+
+    /**
+     * Returns the sort layer of the shapes drawn afterwards.
+     *
+     * @return the sort layer of the shapes drawn afterwards.
+     */
+    Uint8 getSortLayer() const { return (Uint8)(_sortKey >> 16); }
+
+    /**
+     * Returns the depth within the layer of the shapes drawn afterwards.
+     *
+     * @return the depth within the layer of the shapes drawn afterwards.
+     */
+    Uint16 getSortDepth() const { return (Uint16)(_sortKey & 0xffff); }
+
     /**
      * Sets the shader for this sprite batch
      *
@@ -608,6 +932,19 @@ public:
      * @return The active scissor mask for this sprite batch
      */
     std::shared_ptr<Scissor> getScissor() const;
+
+    /**
+     * Copies the active scissor mask of this sprite batch into dst
+     *
+     * This is the same as {@link #getScissor}, except that it copies into
+     * an existing scissor and so does not allocate. If no scissor mask is
+     * active, dst is unchanged.
+     *
+     * @param dst   The scissor to copy into
+     *
+     * @return true if a scissor mask is active
+     */
+    bool getScissor(Scissor& dst) const;
     
     /**
      * Sets the blending function for the source color
@@ -2105,6 +2442,25 @@ public:
 #pragma mark -
 #pragma mark Internal Helpers
 private:
+    /**
+     * Empties the glyph runs of drawText, keeping their storage.
+     */
+    void clearTextRuns();
+    
+    /**
+     * Draws the glyph runs of drawText at the given offset
+     *
+     * @param offset    The offset of the glyphs
+     */
+    void drawTextRuns(const Vec2 offset);
+    
+    /**
+     * Draws the glyph runs of drawText with the given coordinate transform
+     *
+     * @param transform The coordinate transform
+     */
+    void drawTextRuns(const Affine2& transform);
+    
     /**
      * Sets the current drawing command.
      *
@@ -2133,7 +2489,7 @@ private:
     void record();
     
     /**
-     * Deletes the recorded uniforms.
+     * Releases the recorded uniforms, keeping them for reuse.
      *
      * This method is called upon flushing or cleanup.
      */
@@ -2147,6 +2503,84 @@ private:
      * @param context   The current uniform context
      */
     void setUniformBlock(Context* context);
+
+    /**
+     * Applies the given parts of a drawing context to the shader.
+     *
+     * @param context   The drawing context
+     * @param dirty     The parts of the context to apply
+     */
+    void applyContext(Context* context, GLuint dirty);
+
+    /**
+     * Returns the parts of the drawing state that differ in the two contexts.
+     *
+     * @param a The first context
+     * @param b The second context
+     *
+     * @return the parts of the drawing state that differ (0 if they agree)
+     */
+    GLuint compare(const Context* a, const Context* b) const;
+
+    /**
+     * Draws the given range of the indices with the given command.
+     *
+     * A range of quad instances is drawn from the quad buffer, and any other
+     * range from the vertex buffer. The buffer is bound if it is not already.
+     *
+     * @param command   The drawing command
+     * @param indices   The indices of the flush
+     * @param first     The first index of the range
+     * @param last      The index after the last index of the range
+     * @param base      The offset of the indices in the vertex buffer
+     * @param quadbase  The offset of the instances in the quad buffer
+     */
+    void drawRange(GLenum command, const GLuint* indices, GLuint first, GLuint last,
+                   GLsizei base, GLsizei quadbase);
+
+    /**
+     * Attaches the shader to the quad buffer, if the shader supports instances.
+     *
+     * This leaves the vertex buffer bound.
+     */
+    void attachQuads();
+
+    /**
+     * Closes the open deferred item, and opens a new one.
+     *
+     * This is called before each shape is prepared and whenever the context
+     * is recorded, so an item never spans two shapes or two contexts.
+     */
+    void split();
+
+    /**
+     * Flushes the shapes drawn so far if in deferred mode.
+     *
+     * This is called before changes that the deferred items cannot be sorted
+     * across, such as the perspective or stencil.
+     */
+    void barrier();
+
+    /**
+     * Orders the deferred items into runs of the same drawing state.
+     *
+     * The indices of the runs are written to the sort buffer, which is
+     * drawn in place of the submitted indices.
+     */
+    void sortItems();
+
+    /**
+     * Returns true if the item overlaps any item in a run after the given one.
+     *
+     * To bound the cost, this also returns true if there are too many items
+     * to check.
+     *
+     * @param run   The run to start after
+     * @param item  The item to check
+     *
+     * @return true if the item overlaps any item in a run after the given one.
+     */
+    bool overlapsAfter(size_t run, const DrawItem& item) const;
     
     /**
      * Updates the shader with the current blur offsets
@@ -2198,6 +2632,31 @@ private:
      */
     unsigned int prepare(const Rect rect, const Affine2& mat);
 
+    /**
+     * Returns the number of vertices added to the drawing buffer.
+     *
+     * This method adds the given filled rectangle as a quad instance. If
+     * instancing is off, the instance is expanded into vertices instead
+     * (see {@link #expandQuad}). Either way, the quad is the same as the
+     * rectangle drawn as a polygon.
+     *
+     * @param rect  The rectangle to add to the buffer
+     * @param mat   The transform to apply to the vertices
+     *
+     * @return the number of vertices added to the drawing buffer.
+     */
+    unsigned int prepareQuad(const Rect rect, const Affine2& mat);
+
+    /**
+     * Adds the vertices and indices of the given quad instance to the buffer.
+     *
+     * This is the CPU fallback for instancing. It computes the same vertices
+     * as the vertex shader does for the instance.
+     *
+     * @param quad  The quad instance to expand
+     */
+    void expandQuad(const QuadInstance& quad);
+
     /**
      * Returns the number of vertices added to the drawing buffer.
      *
@@ -104,6 +104,13 @@ namespace scene2 {
  *
  * Finally, it is possible to disable all line breaking in a text layout
  * (including newlines). Simply set the width to a negative value.
+ *
+ * Laying out text is not free, so this class shares a cache of recent layouts
+ * (and their glyph runs) across all text layouts. A layout with the same font, 
+ * text, width, spacing and alignment as a cached one copies its rows instead
+ * of breaking the lines again. In addition, when the text changes but keeps 
+ * its leading paragraphs (e.g. text appended to a log), only the paragraphs 
+ * after the change are broken again. See {@link #setCacheCapacity}.
  */
 class TextLayout {
 private:
@@ -138,6 +145,11 @@ private:
         ~Row();
     };
 
+    /** An entry of the layout cache (defined in the source) */
+    class CacheEntry;
+    /** The layout cache (defined in the source) */
+    class Cache;
+    
     /** The rows of this text layout.  May be empty if no layout is performed. */
     std::vector<Row> _rows;
     /** The text stored in this text layout */
@@ -167,6 +179,15 @@ private:
     /** The vertical alignment of the text layout */
     VerticalAlign _valign;
     
+    /** The rows of the previous layout, for an incremental relayout */
+    std::vector<Row> _spare;
+    /** The number of rows of the previous layout still valid for this text */
+    size_t _reuse;
+    /** The position of the newline ending the last valid row of the previous layout */
+    size_t _resume;
+    /** The cache entry shared by this layout (nullptr if it is not cached) */
+    std::shared_ptr<CacheEntry> _entry;
+    
 public:
 #pragma mark -
 #pragma mark Constructors
@@ -359,7 +380,10 @@ public:
     /**
      * Sets the text associated with this layout.
      *
-     * Changing this value will {@link #invalidate} the layout.
+     * Changing this value will {@link #invalidate} the layout. However, the
+     * rows of any leading paragraphs the new text shares with the old one are
+     * kept, so that {@link #layout} only has to break the remaining ones. 
+     * Setting the same text again does nothing.
      *
      * @param text  The text associated with this layout.
      */
@@ -513,6 +537,56 @@ public:
      */
     void invalidate();
     
+#pragma mark -
+#pragma mark Layout Cache
+    /**
+     * Returns the number of layouts kept by the layout cache
+     *
+     * The cache is shared by all text layouts. It is keyed by the font, text,
+     * width, spacing and alignment of a layout, and stores both the rows of
+     * the layout and the glyph runs last generated for it. When the cache is
+     * full, the least recently used layout is evicted.
+     *
+     * @return the number of layouts kept by the layout cache
+     */
+    static size_t getCacheCapacity();
+    
+    /**
+     * Sets the number of layouts kept by the layout cache
+     *
+     * A capacity of 0 disables the cache. Shrinking the cache evicts the
+     * least recently used layouts immediately.
+     *
+     * @param capacity  The number of layouts kept by the layout cache
+     */
+    static void setCacheCapacity(size_t capacity);
+    
+    /**
+     * Removes every layout from the layout cache
+     *
+     * Text layouts sharing a cached layout keep it until they are invalidated.
+     */
+    static void clearCache();
+    
+    /**
+     * Returns the number of layouts copied from the cache
+     *
+     * @return the number of layouts copied from the cache
+     */
+    static Uint64 getCacheHits();
+    
+    /**
+     * Returns the number of layouts computed with the cache enabled
+     *
+     * @return the number of layouts computed with the cache enabled
+     */
+    static Uint64 getCacheMisses();
+    
+    /**
+     * Resets the layout cache hit and miss counters to zero
+     */
+    static void resetCacheCounters();
+    
     /**
      * Returns true if the layout has been successful.
      *
@@ -899,8 +973,70 @@ private:
      * more natural for editable text).
      *
      * This method will not be called if the width is negative.
+     *
+     * If start is positive, it is the position of a newline, and the rows
+     * before that newline are already in place. Only the text after it is
+     * broken into lines.
+     *
+     * @param start     The position to start breaking lines
+     */
+    void breakLines(size_t start);
+    
+    /**
+     * Returns the number of rows of the current layout that are valid for the given text
+     *
+     * These are the rows of the paragraphs before the last newline the two
+     * texts have in common. They are valid because lines never break across
+     * a newline.
+     *
+     * @param text      The new text of this layout
+     * @param resume    Storage for the position of the last common newline
+     *
+     * @return the number of rows of the current layout that are valid for the given text
+     */
+    size_t keepRows(const std::string& text, size_t& resume) const;
+    
+    /**
+     * Returns the cache key for the current attributes of this layout
+     *
+     * @return the cache key for the current attributes of this layout
+     */
+    size_t hashLayout() const;
+    
+    /**
+     * Copies the layout for the given key from the cache, if it is there
+     *
+     * @param hash      The cache key of this layout
+     *
+     * @return true if the layout was in the cache
+     */
+    bool fetchLayout(size_t hash);
+    
+    /**
+     * Stores the current layout in the cache for the given key
+     *
+     * @param hash      The cache key of this layout
+     */
+    void storeLayout(size_t hash);
+    
+    /**
+     * Generates the glyph runs for the rows of this layout
+     *
+     * This is the uncached version of {@link #getGlyphs}.
+     *
+     * @param runs      The map to store the glyph runs
+     * @param bounds    The bounding box for the quads
+     *
+     * @return the number of glyphs successfully processed
+     */
+    size_t generateGlyphs(std::unordered_map<GLuint,std::shared_ptr<GlyphRun>>& runs, const Rect bounds) const;
+    
+    /**
+     * Returns the layout cache shared by all text layouts
+     *
+     * @return the layout cache shared by all text layouts
      */
-    void breakLines();
+    static Cache* getCache();
     
     /**
      * Resets the horizontal alignment.
@@ -47,6 +47,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <cugl/render/CURenderBase.h>
 #include <cugl/math/CUMathBase.h>
 #include <cugl/math/CUMat4.h>
@@ -77,6 +78,13 @@ class Shader;
  * buffer has attributes lacking in the shader, they will be ignored. If it is missing
  * attributes that the shader expects, the shader will use the default value
  * for the type.
+ *
+ * A vertex buffer that is reloaded every draw (such as the one in a
+ * {@link SpriteBatch}) should use streaming instead of {@link #loadVertexData}.
+ * A streaming buffer is specified once, as a ring split into regions, and
+ * each upload is written after the last one. A region is only rewritten once
+ * a fence shows the GPU is done with it, so an upload never waits on (or
+ * reallocates) the buffer in use by earlier draws.
  */
 class VertexBuffer {
 private:
@@ -98,6 +106,10 @@ private:
         GLboolean norm;
         /** The offset of the attribute in the vertex buffer */
         GLsizeiptr offset;
+        /** The number of instances per value (0 if the attribute is per vertex) */
+        GLuint divisor;
+        /** The location of the attribute in the attached shader (-1 if none) */
+        GLint location;
     };
     
     /** The data stride of this buffer (0 if there is only one attribute) */
@@ -120,7 +132,48 @@ private:
     std::unordered_map<std::string, bool> _enabled;
     /** The settings for each attribute */
     std::unordered_map<std::string, AttribData> _attributes;
-    
+
+    // Streaming support
+    /** The number of vertices in a stream region (0 if not streaming) */
+    GLsizei _streamVerts;
+    /** The number of indices in a stream region */
+    GLsizei _streamIndxs;
+    /** The stream region currently written */
+    size_t _region;
+    /** The next free vertex in the current region */
+    GLsizei _vertHead;
+    /** The next free index in the current region */
+    GLsizei _indxHead;
+    /** The fence of each region, set when it is left (0 if none) */
+    std::vector<GLsync> _fences;
+
+    // Monitoring values
+    /** The number of bytes uploaded to the buffers */
+    size_t _uploaded;
+    /** The number of times a buffer was (re)specified */
+    size_t _respecs;
+
+    /**
+     * Moves the ring to the next region if the given upload does not fit.
+     *
+     * The region left is fenced. If the GPU is not done with the next region,
+     * this waits until it is.
+     *
+     * @param vsize     The number of vertices to write
+     * @param isize     The number of indices to write
+     */
+    void advance(GLsizei vsize, GLsizei isize);
+
+    /**
+     * Writes the given vertices at the head of the current region.
+     *
+     * @param vertices  The vertices to write
+     * @param size      The number of vertices to write
+     *
+     * @return the offset of the first vertex written
+     */
+    GLsizei writeVertices(const void* vertices, GLsizei size);
+
 public:
 #pragma mark Constructors
     /**
@@ -366,7 +419,92 @@ public:
      * @param offset    The initial index to start with
      */
     void drawInstanced(GLenum mode, GLsizei count, GLsizei instances, GLsizei offset=0);
-    
+
+
+#pragma mark -
+#pragma mark Streaming
+    /**
+     * Sets this vertex buffer to stream its data through a ring.
+     *
+     * Both buffers are specified once, large enough for the given number of
+     * regions of the given size. Each region must hold the largest upload
+     * made by {@link #streamData}. Passing 0 vertices turns streaming off.
+     * Passing 0 indices only streams the vertices, and leaves the index
+     * buffer as it was (e.g. the fixed indices of an instanced shape).
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param vertices  The number of vertices in a region
+     * @param indices   The number of indices in a region
+     * @param regions   The number of regions in the ring
+     */
+    void setStreaming(GLsizei vertices, GLsizei indices, size_t regions=3);
+
+    /**
+     * Returns true if this vertex buffer streams its data through a ring.
+     *
+     * @return true if this vertex buffer streams its data through a ring.
+     */
+    bool isStreaming() const { return _streamVerts > 0; }
+
+    /**
+     * Writes the given vertices and indices to the ring, after the last upload.
+     *
+     * The indices are relative to the given vertices, and are rebased as they
+     * are written, so draw commands only need the returned index offset. If
+     * the data does not fit in the current region, the ring moves on to the
+     * next region, waiting for the GPU to finish with it if necessary.
+     *
+     * This method will only succeed if this buffer is actively bound and
+     * streaming.
+     *
+     * @param vertices  The vertices to write
+     * @param vsize     The number of vertices to write
+     * @param indices   The indices to write
+     * @param isize     The number of indices to write
+     *
+     * @return the offset of the first index written, for {@link #draw}
+     */
+    GLsizei streamData(const void* vertices, GLsizei vsize, const GLuint* indices, GLsizei isize);
+
+    /**
+     * Writes the given vertices to the ring, after the last upload.
+     *
+     * This is the version of {@link #streamData} for a buffer that only
+     * streams its vertices, such as a buffer of instances.
+     *
+     * This method will only succeed if this buffer is actively bound and
+     * streaming.
+     *
+     * @param vertices  The vertices to write
+     * @param size      The number of vertices to write
+     *
+     * @return the offset of the first vertex written
+     */
+    GLsizei streamVertices(const void* vertices, GLsizei size);
+
+    /**
+     * Returns the number of bytes uploaded since the counters were reset.
+     *
+     * @return the number of bytes uploaded since the counters were reset.
+     */
+    size_t getBytesUploaded() const { return _uploaded; }
+
+    /**
+     * Returns the number of buffer (re)specifications since the counters were reset.
+     *
+     * Each call to {@link #loadVertexData} or {@link #loadIndexData} is a
+     * respecification. Streaming only specifies the buffers when it starts.
+     *
+     * @return the number of buffer (re)specifications since the counters were reset.
+     */
+    size_t getRespecifications() const { return _respecs; }
+
+    /**
+     * Resets the upload counters to 0.
+     */
+    void resetCounters() { _uploaded = 0; _respecs = 0; }
+
     
 #pragma mark -
 #pragma mark Attributes
@@ -395,14 +533,33 @@ public:
      * The attribute offset is measured in bytes from the start of the 
      * vertex data structure (for a single vertex).
      *
+     * An attribute with a nonzero divisor is an instance attribute. It
+     * advances once every divisor instances of {@link #drawInstanced},
+     * instead of once per vertex.
+     *
      * @param name      The attribute name
      * @param size      The attribute size in byte.
      * @param type      The attribute type
      * @param norm      Whether to normalize the value (floating point only)
      * @param offset    The attribute offset in the vertex data structure
+     * @param divisor   The number of instances per value (0 for per vertex)
      */
     void setupAttribute(const std::string name, GLint size, GLenum type,
-                        GLboolean norm, GLsizei offset);
+                        GLboolean norm, GLsizei offset, GLuint divisor=0);
+
+    /**
+     * Sets the instance attributes to start at the given instance.
+     *
+     * OpenGL ES has no base instance for instanced draws. Instead, this
+     * moves the instance attributes (those with a divisor) so that the
+     * next call to {@link #drawInstanced} starts at the given instance
+     * of the buffer.
+     *
+     * This method will only succeed if this buffer is actively bound.
+     *
+     * @param instance  The first instance to draw
+     */
+    void setBaseInstance(GLsizei instance);
     
     
     /**
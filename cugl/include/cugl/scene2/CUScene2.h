@@ -87,6 +87,8 @@ protected:
 
     /** Whether or note this scene is still active */
     bool _active;
+    /** Whether to skip the subtrees outside of the camera view */
+    bool _culling;
 
 #pragma mark -
 #pragma mark Constructors
@@ -325,6 +327,28 @@ public:
      */
     void setColor(Color4 color) { _color = color; }
     
+    /**
+     * Returns true if this scene skips subtrees outside of the camera view.
+     *
+     * See {@link #setCulling} for more information.
+     *
+     * @return true if this scene skips subtrees outside of the camera view.
+     */
+    bool isCulling() const { return _culling; }
+    
+    /**
+     * Sets whether this scene skips subtrees outside of the camera view.
+     *
+     * When culling is on, a node is not drawn (and neither are its children)
+     * if the bounds of its subtree do not intersect the camera view. See
+     * {@link scene2::SceneNode#getSubtreeBounds} for how these bounds are
+     * computed. Culling should be turned off if a node draws outside of its
+     * content bounds. It is on by default.
+     *
+     * @param value Whether this scene skips subtrees outside of the camera view.
+     */
+    void setCulling(bool value) { _culling = value; }
+    
     /**
      * Returns a string representation of this scene for debugging purposes.
      *
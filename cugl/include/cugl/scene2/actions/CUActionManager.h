@@ -46,6 +46,9 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
 
 namespace cugl {
     /**
@@ -61,14 +64,42 @@ namespace cugl {
  * This class provides an action manager for instantiating animations.
  *
  * To create an animation, the manager attaches an action to a scene graph node
- * via a key.  This key allows the user to pause an animation or query when it
- * is complete. Each update frame, the manager moves the animation further along 
- * until it is complete.
+ * and returns a handle to the animation.  This handle allows the user to pause 
+ * an animation or query when it is complete. Each update frame, the manager 
+ * moves the animation further along until it is complete.
+ *
+ * The animations are stored in a pool that only grows, and is reused as the 
+ * animations complete, so the manager does not allocate memory once it has 
+ * been running for a while. A handle is only an index into the pool with a 
+ * generation count, so a lookup is an array access. A handle outlives its
+ * animation; when the animation completes (or is removed) the handle simply
+ * becomes inactive, even if its pool slot is reused.
+ *
+ * Animations can also be attached via a string key, as in earlier versions of
+ * the manager.  The keyed methods look up the handle for the key and then
+ * behave as the handle methods do.  Prefer the handles for animations that 
+ * are queried every frame.
  *
  * An action manager is not implemented as a singleton.  However, you typically
  * only need one manager per application.
  */
 class ActionManager {
+public:
+    /** 
+     * A reference to an animation of this manager.
+     *
+     * The lower 32 bits are the pool slot and the upper 32 bits are the
+     * generation of the slot when the animation was activated.
+     */
+    typedef Uint64 Handle;
+    
+    /** The handle of no animation (it is never active) */
+    static constexpr Handle NONE = 0;
+
+private:
+    /** The index of an instance that is not in the active list */
+    static constexpr Uint32 INACTIVE = 0xffffffff;
+    
 #pragma mark ActionInstance
     /**
      * This internal class represents and action being actively animated.
@@ -78,8 +109,9 @@ class ActionManager {
      * internal state. This class is only meant to be used by ActionManager, not 
      * directly by the user.
      *
-     * Because this is an internal class, it is used as a struct.  There are
-     * no methods other than the constructor.
+     * Because this is an internal class, it is used as a struct.  The instances
+     * live in the pool of the manager and are reset, not deleted, when their
+     * animation is done.
      */
     class ActionInstance {
     public:
@@ -92,6 +124,9 @@ class ActionManager {
         /** The interpolation function on [0,1] to allow non-linear behavior */
         std::function<float(float)> interpolant;
         
+        /** The key of this animation (empty if it was activated by handle) */
+        std::string key;
+        
         /** Any internal state needed by this action */
         void* state;
         
@@ -104,6 +139,15 @@ class ActionManager {
         /** Whether or not this instance is currently paused */
         bool  paused;
         
+        /** Whether this instance reached its duration in the current update */
+        bool  done;
+        
+        /** The generation of this pool slot (incremented on every reuse) */
+        Uint32 generation;
+        
+        /** The position of this instance in the active list (or INACTIVE) */
+        Uint32 index;
+        
     public:
         /**
          * Creates a new degenerate ActionInstance on the stack.
@@ -111,22 +155,76 @@ class ActionManager {
          * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate an object on
          * the heap, use one of the static constructors instead.
          */
-        ActionInstance() : state(NULL), duration(0.0f), elapsed(0.0f), paused(false) {}
+        ActionInstance() : state(NULL), duration(0.0f), elapsed(0.0f), 
+        paused(false), done(false), generation(1), index(INACTIVE) {}
         
         /**
-         * Deletes this action instance, disposing all resources
+         * Resets this action instance, releasing all resources
+         *
+         * The generation is advanced, so that old handles to this instance
+         * are no longer active.
          */
-        ~ActionInstance();
+        void reset();
     };
     
 #pragma mark Values
 protected:
-    /** A map that associates nodes with their (multiple) animations */
-    std::unordered_map<SceneNode*, std::unordered_set<std::string>> _keys;
+    /** The pool of animation instances, active or not */
+    std::vector<ActionInstance> _instances;
+    
+    /** The pool slots of the active animations */
+    std::vector<Uint32> _active;
+    
+    /** The pool slots available for new animations */
+    std::vector<Uint32> _free;
+    
+    /** The pool slots of the animations completed in the current update */
+    std::vector<Uint32> _completed;
     
     /** A map that associates keys with animations */
-    std::unordered_map<std::string, ActionInstance*> _actions;
+    std::unordered_map<std::string, Handle> _handles;
+
+#pragma mark Internal Helpers
+    /**
+     * Returns the active instance for the given handle
+     *
+     * @param handle    The animation handle
+     *
+     * @return the active instance for the given handle (or nullptr if inactive)
+     */
+    ActionInstance* lookup(Handle handle);
+    
+    /**
+     * Returns the active instance for the given handle
+     *
+     * @param handle    The animation handle
+     *
+     * @return the active instance for the given handle (or nullptr if inactive)
+     */
+    const ActionInstance* lookup(Handle handle) const;
     
+    /**
+     * Returns a free pool slot, growing the pool if necessary
+     *
+     * @return a free pool slot
+     */
+    Uint32 acquire();
+    
+    /**
+     * Removes the instance in the given slot from the active list
+     *
+     * The instance is not reset.  That is the responsibility of the caller.
+     *
+     * @param slot      The pool slot
+     */
+    void detach(Uint32 slot);
+    
+    /**
+     * Resets the instance in the given slot and returns it to the pool
+     *
+     * @param slot      The pool slot
+     */
+    void release(Uint32 slot);
 
 public:
 #pragma mark Constructors
@@ -158,6 +256,18 @@ public:
      */
     bool init() { return true; }
     
+    /**
+     * Initializes an action manager with room for the given number of animations.
+     *
+     * The manager will not allocate memory until it has more active animations
+     * than the capacity (or a keyed animation is activated).
+     *
+     * @param capacity  The number of animations to reserve
+     *
+     * @return true if initialization was successful.
+     */
+    bool init(size_t capacity);
+    
 #pragma mark Static Constructors
     /**
      * Returns a newly allocated action manager.
@@ -171,6 +281,58 @@ public:
 
 #pragma mark -
 #pragma mark Action Management
+    /**
+     * Returns true if the given handle represents an active animation
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the given handle represents an active animation
+     */
+    bool isActive(Handle handle) const {
+        return lookup(handle) != nullptr;
+    }
+    
+    /**
+     * Actives an animation with the given target and action
+     *
+     * The easing function allows for effects like bouncing or elasticity in
+     * the linear interpolation. If null, the animation will use the standard 
+     * linear easing.
+     *
+     * @param action    The action to animate with
+     * @param target    The node to animate on
+     * @param easing    The easing (interpolation) function
+     *
+     * @return the handle of the new animation
+     */
+    Handle activate(const std::shared_ptr<Action>& action,
+                    const std::shared_ptr<SceneNode>& target,
+                    std::function<float(float)> easing = nullptr);
+    
+    /**
+     * Removes the animation for the given handle.
+     *
+     * This act will immediately stop the animation.  The animated node will
+     * continue to have whatever state it had when the animation stopped.
+     *
+     * If the handle is not active (e.g. the animation is complete) this method 
+     * will return false.
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the animation was successfully removed
+     */
+    bool remove(Handle handle);
+    
+    /**
+     * Returns the handle of the animation for the given key
+     *
+     * @param key       The identifying key
+     *
+     * @return the handle of the animation for the given key (or NONE)
+     */
+    Handle find(const std::string& key) const;
+    
     /**
      * Returns true if the given key represents an active animation
      *
@@ -178,7 +340,9 @@ public:
      *
      * @return true if the given key represents an active animation
      */
-    bool isActive(std::string key) const;
+    bool isActive(const std::string& key) const {
+        return isActive(find(key));
+    }
     
     /**
      * Actives an animation with the given target and action
@@ -191,7 +355,7 @@ public:
      *
      * @return true if the animation was successfully started
      */
-    bool activate(std::string key,
+    bool activate(const std::string& key,
                   const std::shared_ptr<Action>& action,
                   const std::shared_ptr<SceneNode>& target) {
         return activate(key,action,target, nullptr);
@@ -214,7 +378,7 @@ public:
      *
      * @return true if the animation was successfully started
      */
-    bool activate(std::string key,
+    bool activate(const std::string& key,
                   const std::shared_ptr<Action>& action,
                   const std::shared_ptr<SceneNode>& target,
                   std::function<float(float)> easing);
@@ -232,7 +396,9 @@ public:
      *
      * @return true if the animation was successfully removed
      */
-    bool remove(std::string key);
+    bool remove(const std::string& key) {
+        return remove(find(key));
+    }
 
     /**
      * Updates all non-paused animations by dt seconds
@@ -247,6 +413,37 @@ public:
 
 #pragma mark -
 #pragma mark Pausing
+    /**
+     * Returns true if the animation for the given handle is paused
+     *
+     * This method will return false if the handle is not active.
+     *
+     * @param handle    The animation handle
+     *
+     * @return true if the animation for the given handle is paused
+     */
+    bool isPaused(Handle handle) const;
+    
+    /** 
+     * Pauses the animation for the given handle.
+     *
+     * If the handle is not active, or if it is already paused, this method 
+     * does nothing.
+     *
+     * @param handle    The animation handle
+     */
+    void pause(Handle handle);
+    
+    /**
+     * Unpauses the animation for the given handle.
+     *
+     * If the handle is not active, or if it is not currently paused, this 
+     * method does nothing.
+     *
+     * @param handle    The animation handle
+     */
+    void unpause(Handle handle);
+    
     /**
      * Returns true if the animation for the given key is paused
      *
@@ -257,7 +454,9 @@ public:
      *
      * @return true if the animation for the given key is paused
      */
-    bool isPaused(std::string key);
+    bool isPaused(const std::string& key) const {
+        return isPaused(find(key));
+    }
 
     /** 
      * Pauses the animation for the given key.
@@ -267,7 +466,9 @@ public:
      *
      * @param key       The identifying key
      */
-    void pause(std::string key);
+    void pause(const std::string& key) {
+        pause(find(key));
+    }
 
     /**
      * Unpauses the animation for the given key.
@@ -277,7 +478,9 @@ public:
      *
      * @param key       The identifying key
      */
-    void unpause(std::string key);
+    void unpause(const std::string& key) {
+        unpause(find(key));
+    }
 
 #pragma mark -
 #pragma mark Node Management
@@ -314,7 +517,8 @@ public:
      * Returns the keys for all active animations of the given target
      *
      * The returned vector is a copy of the keys.  Modifying it has no affect
-     * on the underlying animation.
+     * on the underlying animation.  Animations activated by handle have no
+     * key and are not included.
      *
      * @param target    The node to query animations
      *
@@ -322,6 +526,13 @@ public:
      */
     std::vector<std::string> getAllActions(const std::shared_ptr<SceneNode>& target) const;
 
+    /**
+     * Returns the number of active animations
+     *
+     * @return the number of active animations
+     */
+    size_t getActiveCount() const { return _active.size(); }
+
 };
     }
 }
@@ -46,6 +46,7 @@
 #include <cugl/util/CUDebug.h>
 #include <cugl/render/CUSpriteBatch.h>
 #include <cugl/render/CUScissor.h>
+#include <cugl/render/CURenderTarget.h>
 #include <cugl/assets/CUJsonValue.h>
 #include <vector>
 #include <string>
@@ -218,6 +219,49 @@ protected:
 
     /** The defining JSON data for this node (if any) */
     std::shared_ptr<JsonValue> _json;
+
+    /** Whether this node renders its subtree through a cached render target */
+    bool _cached;
+    /** Whether the cached render target matches the subtree */
+    bool _cacheValid;
+    /** The render target holding the cached subtree (if any) */
+    std::shared_ptr<RenderTarget> _cache;
+    /** The tint the cached subtree was rendered with */
+    Color4 _cacheTint;
+    /** The size in pixels the cached subtree was rendered at */
+    Size _cacheSize;
+
+    /** The node to world transform, as of the last render */
+    Affine2 _worldTransform;
+    /** The parent transform the world transform was computed from */
+    Affine2 _worldParent;
+    /** Whether the local transform changed since the last render */
+    bool _worldDirty;
+    /** The bounds of this node and its descendants in parent space */
+    Rect _treeBounds;
+    /** Whether a transform, size or child changed since the bounds were computed */
+    bool _boundsDirty;
+    /** The bounds of this node and its descendants in world space */
+    Rect _worldBounds;
+    /** Whether the world bounds must be recomputed */
+    bool _worldBoundsDirty;
+    /** The scissor of this node in world space, reused every frame */
+    std::shared_ptr<Scissor> _worldScissor;
+    /** The scissor active before this node was rendered, reused every frame */
+    std::shared_ptr<Scissor> _savedScissor;
+
+    /** Whether a cached subtree is currently being rendered to its target */
+    static bool _caching;
+    /** The number of cached subtrees composited without rendering them */
+    static Uint64 _cacheHits;
+    /** The number of cached subtrees rendered to their target */
+    static Uint64 _cacheMisses;
+    /** Whether to skip the subtrees outside of the cull bounds */
+    static bool _culling;
+    /** The visible region of the scene being rendered, in world space */
+    static Rect _cullBounds;
+    /** The number of subtrees skipped for being outside of the cull bounds */
+    static Uint64 _culled;
     
 
 #pragma mark -
@@ -1048,7 +1092,12 @@ public:
      *
      * @param color the color tinting this node.
      */
-    virtual void setColor(Color4 color) { _tintColor = color; }
+    virtual void setColor(Color4 color) {
+        if (_tintColor != color) {
+            _tintColor = color;
+            invalidate();
+        }
+    }
 
     /**
      * Returns the absolute color tinting this node.
@@ -1081,7 +1130,12 @@ public:
      *
      * @param visible   true if the node is visible.
      */
-    void setVisible(bool visible) { _isVisible = visible; }
+    void setVisible(bool visible) {
+        if (_isVisible != visible) {
+            _isVisible = visible;
+            if (_parent) _parent->invalidate();
+        }
+    }
     
     /**
      * Returns true if this node is tinted by its parent.
@@ -1103,7 +1157,7 @@ public:
      *
      * @param flag  Whether this node is tinted by its parent.
      */
-    void setRelativeColor(bool flag) { _hasParentColor = flag; }
+    void setRelativeColor(bool flag) { _hasParentColor = flag; invalidate(); }
     
     /**
      * Returns the scissor associated with this node.
@@ -1159,7 +1213,7 @@ public:
      *
      * @param scissor   The scissor associated with this node.
      */
-    void setScissor(const std::shared_ptr<Scissor>& scissor) { _scissor = scissor;}
+    void setScissor(const std::shared_ptr<Scissor>& scissor) { _scissor = scissor; invalidate(); }
 
     /**
      * Sets a content-bounded scissor associated with this node.
@@ -1183,7 +1237,7 @@ public:
      * of the same orientation. The rule for this intersection will
      * be the same as {@link Scissor#intersect}.
      */
-    void setScissor() { _scissor = Scissor::alloc(getContentSize());}
+    void setScissor() { _scissor = Scissor::alloc(getContentSize()); invalidate(); }
 
     
 #pragma mark -
@@ -1928,7 +1982,105 @@ public:
      * @param tint      The tint to blend with the Node color.
      */
     virtual void draw(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {}
-    
+
+    /**
+     * Sets whether this node caches the rendering of its subtree.
+     *
+     * A cached node renders itself and its children to an offscreen
+     * {@link RenderTarget} once, and afterwards composites that texture as
+     * a single quad. The cache is rebuilt when the subtree is invalidated,
+     * when the tint of this node changes, or when the node is drawn at a
+     * different size on screen. Moving, rotating or scaling the cached node
+     * itself reuses the cache (though scaling rebuilds it at the new
+     * resolution).
+     *
+     * This is intended for HUD and overlay subtrees that rarely change.
+     * A subtree that changes every frame is slower cached than uncached.
+     *
+     * Only the content bounds of this node are cached. Any child drawn
+     * outside of those bounds is clipped. Translucent content is blended
+     * twice (once into the cache and once onto the screen), so its alpha
+     * is only approximate. Cached nodes inside of a cached subtree are
+     * drawn directly into the outer cache, as render targets cannot nest.
+     *
+     * @param cached    Whether this node caches the rendering of its subtree
+     */
+    void setCached(bool cached);
+
+    /**
+     * Returns true if this node caches the rendering of its subtree.
+     *
+     * See {@link #setCached} for more information.
+     *
+     * @return true if this node caches the rendering of its subtree.
+     */
+    bool isCached() const { return _cached; }
+
+    /**
+     * Marks the cached rendering of this node and its ancestors as stale.
+     *
+     * The attribute setters of SceneNode and its subclasses call this method
+     * whenever they change what is drawn. You only need to call it yourself
+     * if you write a subclass whose draw method depends on other state.
+     */
+    void invalidate();
+
+    /**
+     * Returns the number of cached subtrees composited without re-rendering.
+     *
+     * This counter is global to all scene graphs, and is only reset by
+     * {@link #resetCacheCounters}.
+     *
+     * @return the number of cached subtrees composited without re-rendering.
+     */
+    static Uint64 getCacheHits() { return _cacheHits; }
+
+    /**
+     * Returns the number of cached subtrees rendered to their target.
+     *
+     * This counter is global to all scene graphs, and is only reset by
+     * {@link #resetCacheCounters}.
+     *
+     * @return the number of cached subtrees rendered to their target.
+     */
+    static Uint64 getCacheMisses() { return _cacheMisses; }
+
+    /**
+     * Resets the cache hit and miss counters to zero.
+     */
+    static void resetCacheCounters() { _cacheHits = 0; _cacheMisses = 0; }
+
+    /**
+     * Returns the bounds of this node and all of its descendants.
+     *
+     * The bounds are the smallest axis-aligned rectangle in parent space that
+     * contains the content bounds of this node and of every descendant. They
+     * are cached, and only recomputed after a transform, content size, or
+     * child of this subtree changes.
+     *
+     * Content drawn outside of the content bounds of a node is not included.
+     * A {@link Scene2} skips any subtree whose bounds are outside of the view
+     * of its camera, so nodes should size their content to what they draw.
+     *
+     * @return the bounds of this node and all of its descendants.
+     */
+    const Rect& getSubtreeBounds();
+
+    /**
+     * Returns the number of subtrees skipped for being off screen.
+     *
+     * This counter is global to all scene graphs, and is only reset by
+     * {@link #resetCulledCount}.
+     *
+     * @return the number of subtrees skipped for being off screen.
+     */
+    static Uint64 getCulledCount() { return _culled; }
+
+    /**
+     * Resets the number of culled subtrees to zero.
+     */
+    static void resetCulledCount() { _culled = 0; }
+
     
 #pragma mark -
 #pragma mark Layout Automation
@@ -2010,6 +2162,31 @@ private:
      * transform, and positional translation, in that order.
      */
     void updateTransform();
+
+    /**
+     * Draws the cached subtree of this node with the given SpriteBatch.
+     *
+     * The subtree is first rendered to the render target if the cache is
+     * stale. The target is then drawn as a single quad.
+     *
+     * @param batch     The SpriteBatch to draw with.
+     * @param transform The global transformation matrix of this node.
+     * @param tint      The tint of this node.
+     */
+    void renderCache(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint);
+
+    /**
+     * Marks the bounds of this node and its ancestors for recomputation.
+     *
+     * This must be called whenever the transform, content size, or children
+     * of this node change.
+     */
+    void setBoundsDirty() {
+        _worldDirty = true;
+        for(SceneNode* node = this; node != nullptr && !node->_boundsDirty; node = node->_parent) {
+            node->_boundsDirty = true;
+        }
+    }
     
     // Copying is only allowed via shared pointer.
     CU_DISALLOW_COPY_AND_ASSIGN(SceneNode);
@@ -338,7 +338,7 @@ public:
      * @param srcFactor Specifies how the source blending factors are computed
      * @param dstFactor Specifies how the destination blending factors are computed.
      */
-    void setBlendFunc(GLenum srcFactor, GLenum dstFactor) { _srcFactor = srcFactor; _dstFactor = dstFactor; }
+    void setBlendFunc(GLenum srcFactor, GLenum dstFactor) { _srcFactor = srcFactor; _dstFactor = dstFactor; invalidate(); }
     
     /**
      * Returns the source blending factor
@@ -383,7 +383,7 @@ public:
      *
      * @param equation  Specifies how source and destination colors are combined
      */
-    void setBlendEquation(GLenum equation) { _blendEquation = equation; }
+    void setBlendEquation(GLenum equation) { _blendEquation = equation; invalidate(); }
     
     /**
      * Returns the blending equation for this textured node
@@ -408,7 +408,7 @@ public:
      *
      * @param  flag whether to flip the coordinates horizontally
      */
-    void flipHorizontal(bool flag) { _flipHorizontal = flag; updateTextureCoords(); }
+    void flipHorizontal(bool flag) { _flipHorizontal = flag; updateTextureCoords(); invalidate(); }
     
     /**
      * Returns true if the texture coordinates are flipped horizontally.
@@ -426,7 +426,7 @@ public:
      *
      * @param  flag whether to flip the coordinates vertically
      */
-    void flipVertical(bool flag) { _flipVertical = flag; updateTextureCoords(); }
+    void flipVertical(bool flag) { _flipVertical = flag; updateTextureCoords(); invalidate(); }
     
     /**
      * Returns true if the texture coordinates are flipped vertically.
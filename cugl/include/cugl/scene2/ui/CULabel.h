@@ -623,7 +623,8 @@ public:
      * font, then the text will not display at all.
      *
      * Changing this value will regenerate the render data, and is potentially
-     * expensive, particularly if the font is using a fallback atlas.
+     * expensive, particularly if the font is using a fallback atlas. Setting
+     * the same text again (without resizing) does nothing.
      *
      * @param text      The text for this label.
      * @param resize    Whether to resize the label to fit the new text.
@@ -1263,7 +1264,7 @@ public:
      * @param srcFactor Specifies how the source blending factors are computed
      * @param dstFactor Specifies how the destination blending factors are computed.
      */
-    void setBlendFunc(GLenum srcFactor, GLenum dstFactor) { _srcFactor = srcFactor; _dstFactor = dstFactor; }
+    void setBlendFunc(GLenum srcFactor, GLenum dstFactor) { _srcFactor = srcFactor; _dstFactor = dstFactor; invalidate(); }
     
     /**
      * Returns the source blending factor
@@ -1308,7 +1309,7 @@ public:
      *
      * @param equation  Specifies how source and destination colors are combined
      */
-    void setBlendEquation(GLenum equation) { _blendEquation = equation; }
+    void setBlendEquation(GLenum equation) { _blendEquation = equation; invalidate(); }
     
     /**
      * Returns the blending equation for this textured node
@@ -1359,6 +1360,9 @@ protected:
     
     /**
      * Clears the render data, releasing all vertices and indices.
+     *
+     * The glyph runs themselves are kept, so that regenerating the render
+     * data reuses their storage.
      */
     void clearRenderData();
     
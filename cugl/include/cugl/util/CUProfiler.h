@@ -0,0 +1,540 @@
+//
+//  CUProfiler.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a lightweight hierarchical profiler.  Code is marked
+//  with scoped zones (see CUProfileZone), which record their start and end
+//  times into a ring buffer owned by the calling thread.  The main thread
+//  marks the end of each animation frame, so that the zones of the last frame
+//  can be summarized as a hierarchy (for an on-screen overlay), and the
+//  contents of all ring buffers can be exported in the Chrome trace-event
+//  format (open chrome://tracing or https://ui.perfetto.dev to view them).
+//
+//  The zone macros compile to nothing unless CU_PROFILING is nonzero. By
+//  default this is only the case for builds with assertions enabled (i.e.
+//  debug builds).  Define CU_PROFILING explicitly to override this.
+//
+//  This class is header only so that it can be used by both the engine and
+//  the game without any changes to the platform project files.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/18/26
+//
+#ifndef __CU_PROFILER_H__
+#define __CU_PROFILER_H__
+#include <SDL.h>
+#include <cugl/io/CUTextWriter.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** Whether the profiler zones are compiled in */
+#ifndef CU_PROFILING
+    #if defined(SDL_ASSERT_LEVEL) && SDL_ASSERT_LEVEL >= 2
+        #define CU_PROFILING 1
+    #else
+        #define CU_PROFILING 0
+    #endif
+#endif
+
+#define __CU_PROFILE_CONCAT2__(a,b) a##b
+#define __CU_PROFILE_CONCAT__(a,b)  __CU_PROFILE_CONCAT2__(a,b)
+
+#if CU_PROFILING
+/**
+ * @def CUProfileZone(name)
+ *
+ * Records the time from this statement to the end of the enclosing scope.
+ *
+ * The name must be a string literal (or otherwise outlive the profiler).
+ * Zones nest, and the nesting is preserved in the frame summary.
+ */
+#define CUProfileZone(name)     cugl::ProfileZone __CU_PROFILE_CONCAT__(__cu_zone_,__LINE__)(name)
+/**
+ * @def CUProfileFrame()
+ *
+ * Marks the end of an animation frame. Call this once per frame on the main thread.
+ */
+#define CUProfileFrame()        cugl::Profiler::endFrame()
+/**
+ * @def CUProfileThread(name)
+ *
+ * Names the calling thread in the frame summary and the exported trace.
+ */
+#define CUProfileThread(name)   cugl::Profiler::setThreadName(name)
+#else
+#define CUProfileZone(name)     ((void)0)
+#define CUProfileFrame()        ((void)0)
+#define CUProfileThread(name)   ((void)0)
+#endif
+
+namespace cugl {
+
+#pragma mark -
+#pragma mark Profiler
+/**
+ * A static class gathering the profile zones of every thread.
+ *
+ * Each thread writes its zones into its own fixed-size ring buffer, so
+ * recording a zone never takes a lock or allocates memory (except for the
+ * first zone on a new thread, which registers its buffer). Older zones are
+ * overwritten once a buffer is full.
+ *
+ * The summary and export methods may be called from any thread. They read
+ * the buffers while other threads are writing, and discard any zone that was
+ * overwritten during the read.
+ */
+class Profiler {
+public:
+    /** The number of zones kept for each thread */
+    static constexpr size_t CAPACITY = 1 << 14;
+
+    /** A single completed zone */
+    struct Zone {
+        /** The zone name (not owned) */
+        const char* name;
+        /** The start time in nanoseconds */
+        Uint64 start;
+        /** The end time in nanoseconds */
+        Uint64 end;
+        /** The number of zones enclosing this one on the same thread */
+        Uint32 depth;
+    };
+
+    /** The ring buffer of a single thread */
+    struct ThreadLog {
+        /** The thread name */
+        std::string name;
+        /** A small integer identifying the thread in the trace */
+        Uint32 id;
+        /** The number of currently open zones */
+        Uint32 depth;
+        /** The number of zones ever written to this log */
+        std::atomic<Uint64> head;
+        /** The zones (indexed by count modulo CAPACITY) */
+        std::unique_ptr<Zone[]> zones;
+        /** The sequence number of each slot (0 while the slot is being written) */
+        std::unique_ptr<std::atomic<Uint64>[]> seqs;
+
+        ThreadLog() : id(0), depth(0), head(0),
+        zones(new Zone[CAPACITY]), seqs(new std::atomic<Uint64>[CAPACITY]) {
+            for(size_t ii = 0; ii < CAPACITY; ii++) {
+                seqs[ii] = 0;
+            }
+        }
+    };
+
+private:
+    /** The registered thread logs */
+    static inline std::vector<std::shared_ptr<ThreadLog>> _logs;
+    /** The lock for the list of thread logs */
+    static inline std::mutex _mutex;
+    /** Whether zones are currently recorded */
+    static inline std::atomic<bool> _enabled{true};
+    /** The log of the thread that marks frames */
+    static inline std::atomic<ThreadLog*> _main{nullptr};
+    /** The start of the most recent complete frame */
+    static inline std::atomic<Uint64> _frameStart{0};
+    /** The end of the most recent complete frame */
+    static inline std::atomic<Uint64> _frameEnd{0};
+
+    /**
+     * Returns a new log for the calling thread, registered with the profiler.
+     *
+     * @return a new log for the calling thread
+     */
+    static ThreadLog* registerThread() {
+        std::shared_ptr<ThreadLog> log = std::make_shared<ThreadLog>();
+        std::unique_lock<std::mutex> lk(_mutex);
+        log->id = (Uint32)_logs.size();
+        log->name = "thread " + std::to_string(log->id);
+        _logs.push_back(log);
+        return log.get();
+    }
+
+    /**
+     * Copies the intact zones of a log recorded since the given time.
+     *
+     * @param log   the thread log
+     * @param since the earliest end time to copy
+     * @param out   the vector to append the zones to
+     */
+    static void collect(ThreadLog* log, Uint64 since, std::vector<Zone>& out) {
+        Uint64 head = log->head.load(std::memory_order_acquire);
+        Uint64 first = head > CAPACITY ? head-CAPACITY : 0;
+        for(Uint64 ii = first; ii < head; ii++) {
+            size_t slot = (size_t)(ii % CAPACITY);
+            Uint64 before = log->seqs[slot].load(std::memory_order_acquire);
+            Zone zone = log->zones[slot];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            Uint64 after = log->seqs[slot].load(std::memory_order_relaxed);
+            if (before == ii+1 && after == before && zone.end >= since) {
+                out.push_back(zone);
+            }
+        }
+    }
+
+    /**
+     * Returns a copy of the registered logs.
+     *
+     * @return a copy of the registered logs.
+     */
+    static std::vector<std::shared_ptr<ThreadLog>> logs() {
+        std::unique_lock<std::mutex> lk(_mutex);
+        return _logs;
+    }
+
+    /**
+     * Returns the innermost open zone of the calling thread.
+     *
+     * This is constant initialized, so it never allocates or registers the
+     * thread (unlike {@link #local}).
+     *
+     * @return the innermost open zone of the calling thread
+     */
+    static const char*& currentZone() {
+        static thread_local const char* zone = nullptr;
+        return zone;
+    }
+
+    friend class ProfileZone;
+
+public:
+    /**
+     * Returns the current time in nanoseconds.
+     *
+     * @return the current time in nanoseconds.
+     */
+    static Uint64 now() {
+        return (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Returns the log of the calling thread, creating it if necessary.
+     *
+     * @return the log of the calling thread
+     */
+    static ThreadLog* local() {
+        thread_local ThreadLog* log = registerThread();
+        return log;
+    }
+
+    /**
+     * Returns the name of the innermost zone open on the calling thread.
+     *
+     * This never allocates, so it is safe to call from an allocator hook.
+     *
+     * @return the name of the innermost open zone (or nullptr if none)
+     */
+    static const char* getCurrentZone() { return currentZone(); }
+
+    /**
+     * Returns true if zones are currently recorded.
+     *
+     * @return true if zones are currently recorded.
+     */
+    static bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * Sets whether zones are currently recorded.
+     *
+     * @param value whether zones are currently recorded.
+     */
+    static void setEnabled(bool value) { _enabled = value; }
+
+    /**
+     * Names the calling thread in the frame summary and the exported trace.
+     *
+     * @param name  the thread name
+     */
+    static void setThreadName(const std::string name) {
+        ThreadLog* log = local();
+        std::unique_lock<std::mutex> lk(_mutex);
+        log->name = name;
+    }
+
+    /**
+     * Appends a completed zone to the log of the calling thread.
+     *
+     * @param log   the log of the calling thread
+     * @param zone  the completed zone
+     */
+    static void record(ThreadLog* log, const Zone& zone) {
+        Uint64 index = log->head.load(std::memory_order_relaxed);
+        size_t slot = (size_t)(index % CAPACITY);
+        log->seqs[slot].store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        log->zones[slot] = zone;
+        log->seqs[slot].store(index+1, std::memory_order_release);
+        log->head.store(index+1, std::memory_order_release);
+    }
+
+    /**
+     * Marks the end of an animation frame on the calling thread.
+     *
+     * The calling thread becomes the main thread of the frame summary.
+     */
+    static void endFrame() {
+        _main = local();
+        Uint64 time = now();
+        _frameStart = _frameEnd.load();
+        _frameEnd = time;
+    }
+
+    /**
+     * Returns a text summary of the most recent complete frame.
+     *
+     * The zones of the main thread are listed as a hierarchy in the order
+     * they started. Zones with the same name and parent are merged, showing
+     * their total time and number of calls. The zones of other threads that
+     * ended during the frame follow as a flat list per thread.
+     *
+     * @param maxLines  the maximum number of lines in the summary
+     *
+     * @return a text summary of the most recent complete frame.
+     */
+    static std::string getFrameReport(size_t maxLines = 24) {
+        struct Node {
+            const char* name;
+            Uint32 depth;
+            int parent;
+            Uint64 total;
+            Uint32 calls;
+        };
+        Uint64 start = _frameStart.load();
+        Uint64 end = _frameEnd.load();
+        std::stringstream ss;
+        ss.precision(2);
+        ss << std::fixed;
+        ss << "frame " << (end-start)/1000000.0 << " ms\n";
+        size_t lines = 1;
+
+        std::vector<std::shared_ptr<ThreadLog>> all = logs();
+        std::vector<Zone> zones;
+        for(auto& log : all) {
+            zones.clear();
+            collect(log.get(), start, zones);
+            std::vector<Node> nodes;
+            std::vector<int> stack;
+            if (log.get() == _main.load()) {
+                // Rebuild the hierarchy of the frame from start times and depths
+                std::sort(zones.begin(), zones.end(), [](const Zone& a, const Zone& b) {
+                    return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+                });
+                for(const Zone& zone : zones) {
+                    if (zone.start < start || zone.end > end) {
+                        continue;
+                    }
+                    while (stack.size() > zone.depth) {
+                        stack.pop_back();
+                    }
+                    int parent = stack.empty() ? -1 : stack.back();
+                    int found = -1;
+                    for(int ii = parent+1; ii < (int)nodes.size() && found < 0; ii++) {
+                        if (nodes[ii].parent == parent && nodes[ii].depth == zone.depth &&
+                            std::string(nodes[ii].name) == zone.name) {
+                            found = ii;
+                        }
+                    }
+                    if (found < 0) {
+                        nodes.push_back({zone.name, zone.depth, parent, 0, 0});
+                        found = (int)nodes.size()-1;
+                    }
+                    nodes[found].total += zone.end-zone.start;
+                    nodes[found].calls++;
+                    stack.push_back(found);
+                }
+            } else {
+                // Other threads are summarized by name only
+                for(const Zone& zone : zones) {
+                    if (zone.end > end || zone.depth > 0) {
+                        continue;
+                    }
+                    int found = -1;
+                    for(int ii = 0; ii < (int)nodes.size() && found < 0; ii++) {
+                        if (std::string(nodes[ii].name) == zone.name) {
+                            found = ii;
+                        }
+                    }
+                    if (found < 0) {
+                        nodes.push_back({zone.name, 1, -1, 0, 0});
+                        found = (int)nodes.size()-1;
+                    }
+                    nodes[found].total += zone.end-zone.start;
+                    nodes[found].calls++;
+                }
+                if (!nodes.empty() && lines < maxLines) {
+                    std::unique_lock<std::mutex> lk(_mutex);
+                    ss << "[" << log->name << "]\n";
+                    lines++;
+                }
+            }
+            for(const Node& node : nodes) {
+                if (lines >= maxLines) {
+                    break;
+                }
+                ss << std::string(2*node.depth, ' ') << node.name << " " << node.total/1000000.0 << " ms";
+                if (node.calls > 1) {
+                    ss << " (x" << node.calls << ")";
+                }
+                ss << "\n";
+                lines++;
+            }
+        }
+        return ss.str();
+    }
+
+    /**
+     * Writes the contents of every thread log as a Chrome trace-event file.
+     *
+     * The file contains one complete ("X") event per zone, plus the thread
+     * names as metadata events. Times are in microseconds (with nanosecond
+     * precision), measured from the start of the earliest zone in the file.
+     *
+     * @param path  the file to write
+     *
+     * @return true if the file was written
+     */
+    static bool exportTrace(const std::string path) {
+        std::shared_ptr<TextWriter> writer = TextWriter::alloc(path);
+        if (writer == nullptr) {
+            return false;
+        }
+        auto escape = [](const std::string& text) {
+            std::string result;
+            for(char c : text) {
+                if (c == '"' || c == '\\') {
+                    result += '\\';
+                }
+                result += c;
+            }
+            return result;
+        };
+
+        // Copy every log first, so that the times can be relative to the earliest zone
+        std::vector<std::shared_ptr<ThreadLog>> threads = logs();
+        std::vector<std::vector<Zone>> zones(threads.size());
+        Uint64 base = SDL_MAX_UINT64;
+        for(size_t ii = 0; ii < threads.size(); ii++) {
+            collect(threads[ii].get(), 0, zones[ii]);
+            for(const Zone& zone : zones[ii]) {
+                base = std::min(base, zone.start);
+            }
+        }
+
+        // Nanoseconds as microseconds, without the rounding of a float
+        auto micros = [](std::stringstream& ss, Uint64 nanos) {
+            ss << nanos/1000 << "." << std::setw(3) << std::setfill('0') << nanos % 1000;
+        };
+
+        writer->write("{\"traceEvents\":[");
+        bool first = true;
+        for(size_t ii = 0; ii < threads.size(); ii++) {
+            std::string name;
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                name = threads[ii]->name;
+            }
+            std::stringstream ss;
+            ss << (first ? "\n" : ",\n");
+            ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threads[ii]->id;
+            ss << ",\"args\":{\"name\":\"" << escape(name) << "\"}}";
+            writer->write(ss.str());
+            first = false;
+
+            for(const Zone& zone : zones[ii]) {
+                ss.str("");
+                ss << ",\n{\"name\":\"" << escape(zone.name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << threads[ii]->id;
+                ss << ",\"ts\":";
+                micros(ss, zone.start-base);
+                ss << ",\"dur\":";
+                micros(ss, zone.end-zone.start);
+                ss << "}";
+                writer->write(ss.str());
+            }
+        }
+        writer->write("\n]}\n");
+        writer->close();
+        return true;
+    }
+};
+
+#pragma mark -
+#pragma mark Profile Zone
+/**
+ * A scoped profile zone.
+ *
+ * Do not use this class directly. Use the CUProfileZone macro instead, so
+ * that the zone is compiled out when profiling is disabled.
+ */
+class ProfileZone {
+private:
+    /** The log of the calling thread (nullptr if not recording) */
+    Profiler::ThreadLog* _log;
+    /** The zone being recorded */
+    Profiler::Zone _zone;
+    /** The zone enclosing this one on the calling thread */
+    const char* _parent;
+
+public:
+    /**
+     * Opens a zone with the given name.
+     *
+     * @param name  the zone name (must outlive the profiler)
+     */
+    ProfileZone(const char* name) : _log(nullptr) {
+        _parent = Profiler::currentZone();
+        Profiler::currentZone() = name;
+        if (Profiler::isEnabled()) {
+            _log = Profiler::local();
+            _zone.name = name;
+            _zone.depth = _log->depth++;
+            _zone.start = Profiler::now();
+        }
+    }
+
+    /**
+     * Closes the zone, recording it to the log of the calling thread.
+     */
+    ~ProfileZone() {
+        Profiler::currentZone() = _parent;
+        if (_log != nullptr) {
+            _zone.end = Profiler::now();
+            _log->depth--;
+            Profiler::record(_log, _zone);
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+}
+
+#endif /* __CU_PROFILER_H__ */
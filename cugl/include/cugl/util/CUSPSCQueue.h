@@ -0,0 +1,203 @@
+//
+//  CUSPSCQueue.h
+//  Cornell University Game Library (CUGL)
+//
+//  This header provides a bounded, lock-free queue for exactly one producer
+//  thread and one consumer thread.  It is designed for passing commands and
+//  notifications between the main thread and the audio thread, where the
+//  audio thread must never block and must never allocate.  The storage is
+//  allocated once, when the queue is initialized, and pushing or popping is
+//  only a copy (or move) into a preallocated slot plus one atomic store.
+//
+//  This class is header only so that it can be used by both the engine and
+//  the game without any changes to the platform project files.
+//
+//  CUGL MIT License:
+//      This software is provided 'as-is', without any express or implied
+//      warranty.  In no event will the authors be held liable for any damages
+//      arising from the use of this software.
+//
+//      Permission is granted to anyone to use this software for any purpose,
+//      including commercial applications, and to alter it and redistribute it
+//      freely, subject to the following restrictions:
+//
+//      1. The origin of this software must not be misrepresented; you must not
+//      claim that you wrote the original software. If you use this software
+//      in a product, an acknowledgment in the product documentation would be
+//      appreciated but is not required.
+//
+//      2. Altered source versions must be plainly marked as such, and must not
+//      be misrepresented as being the original software.
+//
+//      3. This notice may not be removed or altered from any source distribution.
+//
+//  Version: 10/18/26
+//
+#ifndef __CU_SPSC_QUEUE_H__
+#define __CU_SPSC_QUEUE_H__
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cugl {
+
+/**
+ * Template for a bounded single-producer/single-consumer queue
+ *
+ * Only one thread may push to the queue, and only one (other) thread may pop
+ * from it. With that restriction, neither operation ever blocks or allocates.
+ * A push fails (returning false) if the queue is full, so the producer must
+ * decide what to do with the overflow.
+ *
+ * A popped slot is reset to a default value, so that resources held by the
+ * element (such as a shared pointer) are released by the consumer and not
+ * by a later push on the producer thread.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template <class T>
+class SPSCQueue {
+private:
+    /** The preallocated slots of the queue */
+    std::vector<T> _slots;
+    /** The mask to wrap a position into the slots (capacity-1) */
+    size_t _mask;
+    /** The next position to pop (written only by the consumer) */
+    alignas(64) std::atomic<size_t> _head;
+    /** The next position to push (written only by the producer) */
+    alignas(64) std::atomic<size_t> _tail;
+
+public:
+    /**
+     * Creates an empty queue with no capacity
+     *
+     * The queue must be initialized before it can be used.
+     */
+    SPSCQueue() : _mask(0), _head(0), _tail(0) {}
+
+    /**
+     * Creates an empty queue with the given capacity
+     *
+     * @param capacity  The maximum number of elements in the queue
+     */
+    SPSCQueue(size_t capacity) : SPSCQueue() { init(capacity); }
+
+    /**
+     * Initializes an empty queue with the given capacity
+     *
+     * This is not thread safe. It must be called before either thread uses
+     * the queue.
+     *
+     * @param capacity  The maximum number of elements in the queue
+     */
+    void init(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _slots.clear();
+        _slots.resize(size);
+        _mask = size-1;
+        _head.store(0,std::memory_order_relaxed);
+        _tail.store(0,std::memory_order_relaxed);
+    }
+
+    /**
+     * Releases the storage of this queue
+     *
+     * This is not thread safe. Neither thread may use the queue afterwards,
+     * unless it is initialized again.
+     */
+    void dispose() {
+        _slots.clear();
+        _slots.shrink_to_fit();
+        _mask = 0;
+        _head.store(0,std::memory_order_relaxed);
+        _tail.store(0,std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the maximum number of elements in the queue
+     *
+     * @return the maximum number of elements in the queue
+     */
+    size_t capacity() const { return _slots.size(); }
+
+    /**
+     * Returns the number of elements in the queue
+     *
+     * The value is only a snapshot when the other thread is active.
+     *
+     * @return the number of elements in the queue
+     */
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire)-_head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Returns true if the queue has no elements
+     *
+     * The value is only a snapshot when the other thread is active.
+     *
+     * @return true if the queue has no elements
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Pushes a copy of the element onto the queue (PRODUCER ONLY)
+     *
+     * @param value The element to push
+     *
+     * @return true if the element was pushed, false if the queue is full
+     */
+    bool push(const T& value) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail-_head.load(std::memory_order_acquire) >= _slots.size()) {
+            return false;
+        }
+        _slots[tail & _mask] = value;
+        _tail.store(tail+1,std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pushes the element onto the queue (PRODUCER ONLY)
+     *
+     * @param value The element to push
+     *
+     * @return true if the element was pushed, false if the queue is full
+     */
+    bool push(T&& value) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail-_head.load(std::memory_order_acquire) >= _slots.size()) {
+            return false;
+        }
+        _slots[tail & _mask] = std::move(value);
+        _tail.store(tail+1,std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pops the oldest element from the queue (CONSUMER ONLY)
+     *
+     * @param value Storage for the popped element
+     *
+     * @return true if an element was popped, false if the queue is empty
+     */
+    bool pop(T& value) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        T& slot = _slots[head & _mask];
+        value = std::move(slot);
+        slot = T();
+        _head.store(head+1,std::memory_order_release);
+        return true;
+    }
+};
+
+}
+
+#endif /* __CU_SPSC_QUEUE_H__ */
@@ -35,6 +35,7 @@
 #ifndef __CU_THREAD_POOL_H__
 #define __CU_THREAD_POOL_H__
 #include <cugl/base/CUBase.h>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <stdio.h>
@@ -94,6 +95,29 @@ private:
     /** The number of child threads that are completed */
     int _complete;
     
+    /** The body of the parallelFor in flight */
+    const std::function<void(size_t, size_t)>* _forBody;
+    /** The number of indices of the parallelFor in flight */
+    size_t _forCount;
+    /** The maximum number of indices per chunk of the parallelFor in flight */
+    size_t _forGrain;
+    /** The number of chunks of the parallelFor in flight */
+    size_t _forChunks;
+    /** The next unclaimed chunk of the parallelFor in flight */
+    std::atomic<size_t> _forNext;
+    /** The number of finished chunks of the parallelFor in flight */
+    std::atomic<size_t> _forDone;
+    /** The number of workers that may still join the parallelFor (guarded by _queueMutex) */
+    size_t _forWanted;
+    /** The number of workers that joined the parallelFor and have not yet left */
+    std::atomic<size_t> _forJoined;
+    /** Whether a parallelFor is in flight (they share the fields above) */
+    std::atomic<bool> _forBusy;
+    /** A mutex lock for the end of the parallelFor */
+    std::mutex _forMutex;
+    /** A condition variable signalling the end of the parallelFor */
+    std::condition_variable _forFinished;
+    
     /**
      * The body function of a single thread.
      *
@@ -112,6 +136,16 @@ private:
      * on Android and Windows, which have special thread requirements.
      */
     static int sdlThreadFunc(void* ptr);
+
+    /**
+     * Claims and runs chunks of the parallelFor in flight until none are left.
+     */
+    void runChunks();
+    
+    /**
+     * Runs chunks of the parallelFor in flight on a worker thread that joined it.
+     */
+    void helpChunks();
     
 
 #pragma mark Constructors
@@ -124,7 +158,8 @@ public:
      * NEVER USE A CONSTRUCTOR WITH NEW. If you want to allocate a thread pool 
      * on the heap, use one of the static constructors instead.
      */
-    ThreadPool() :_stop(false), _complete(0) { }
+    ThreadPool() :_stop(false), _complete(0), _forBody(nullptr), _forCount(0),
+    _forGrain(0), _forChunks(0), _forNext(0), _forDone(0), _forWanted(0), _forJoined(0), _forBusy(false) { }
     
     /**
      * Deletes this thread pool, destroying all resources.
@@ -191,6 +226,41 @@ public:
      */
     void addTask(const std::function<void()> &task);
     
+    /**
+     * Executes the function over the index range [0,count) and waits for it.
+     *
+     * The range is split into chunks of (at most) grain indices, and the body
+     * is invoked once per chunk with its begin and end indices. Chunks are not
+     * assigned up front. Instead, the worker threads and the calling thread
+     * repeatedly claim the next unclaimed chunk, so a thread that finishes
+     * early simply takes more of the work. This method does not return until
+     * every chunk has been processed.
+     *
+     * The body is called concurrently from several threads, so it must only
+     * write to state that is private to its chunk. If the pool has no worker
+     * threads, or is stopped, the whole range is run on the calling thread.
+     *
+     * Workers that are busy with other tasks (such as asset loading) are not
+     * waited on; the calling thread will process the chunks itself instead.
+     *
+     * This method does not allocate memory, so it may be called every frame.
+     * The pool runs a single parallelFor at a time. A call made while another
+     * is in flight (such as a nested call from the body) runs its whole range
+     * on the calling thread.
+     *
+     * @param count     the number of indices to process
+     * @param grain     the maximum number of indices per chunk
+     * @param body      the function to execute on each chunk
+     */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+    
+    /**
+     * Returns the number of worker threads in this pool.
+     *
+     * @return the number of worker threads in this pool.
+     */
+    size_t getThreadCount() const { return _workers.size(); }
+    
     /**
      * Stop the thread pool, marking it for shut down.
      *
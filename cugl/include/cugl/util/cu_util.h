@@ -36,5 +36,7 @@
 #include "CUGreedyFreeList.h"
 #include "CULogger.h"
 #include "CUThreadPool.h"
+#include "CUProfiler.h"
+#include "CUSPSCQueue.h"
 
 #endif /* __CU_UTIL_PKG_H__ */
@@ -131,6 +131,26 @@ def config_cmake(config,project):
 
     context['__SOURCELIST__'] = '\n    '.join(srclist)
 
+    # Set the console tools (built with the game sources, but not the entry point)
+    toolstr = ''
+    if 'cmake' in config and config['cmake'] and 'tools' in config['cmake'] and config['cmake']['tools']:
+        for name, items in config['cmake']['tools'].items():
+            if type(items) != list:
+                items = [items]
+            toollist = []
+            for item in items:
+                path = os.path.join(*prefix,config['build_to_root'],item)
+                toollist.append(util.path_to_posix(path))
+            toolstr += 'add_tool('+name+'\n    '+'\n    '.join(toollist)+')\n'
+    context['__TOOLS__'] = toolstr
+
+    # Set the checks (a console tool and its arguments, run by ctest)
+    checkstr = ''
+    if 'cmake' in config and config['cmake'] and 'checks' in config['cmake'] and config['cmake']['checks']:
+        for name, command in config['cmake']['checks'].items():
+            checkstr += 'add_check('+name+' '+command+')\n'
+    context['__CHECKS__'] = checkstr
+
     # Set the include directories
     inclist = []
     entries = config['include_dict']
@@ -53,6 +53,31 @@
 extern "C" {
 #endif
 
+#pragma mark -
+#pragma mark SIMD Dispatch
+/**
+ * Returns the name of the instruction set used by the vector kernels
+ *
+ * Some adjacent vector functions (such as {@link ATK_VecAdd} and
+ * {@link ATK_VecClip}) have SIMD versions, chosen on first use according
+ * to the CPU features. They produce the same results as the scalar versions.
+ * The name is one of "avx", "sse2", "neon" or "scalar".
+ *
+ * @return the name of the instruction set used by the vector kernels
+ */
+extern DECLSPEC const char* SDLCALL ATK_VecGetSIMD(void);
+
+/**
+ * Sets whether the vector kernels may use SIMD instructions
+ *
+ * The SIMD kernels are enabled by default, when the CPU supports them.
+ * Disabling them is only useful to compare against the scalar kernels,
+ * such as in benchmarks. This may be called from any thread.
+ *
+ * @param enable    Whether to allow SIMD kernels
+ */
+extern DECLSPEC void SDLCALL ATK_VecSetSIMD(SDL_bool enable);
+
 #pragma mark -
 #pragma mark Distance Utils
 /**
@@ -943,6 +968,20 @@ extern DECLSPEC void SDLCALL ATK_VecScale(const float* input, float scalar, floa
 extern DECLSPEC void SDLCALL ATK_VecScale_stride(const float* input, size_t istride, float scalar,
                                                  float* output, size_t ostride, size_t len);
 
+/**
+ * Scales a 16-bit integer input buffer, storing the float result in output
+ *
+ * This converts compact PCM data to float data. A scalar of 1/32768 maps
+ * the full range of the input to [-1,1), and the scalar can also include
+ * a gain, saving a second pass.
+ *
+ * @param input     The input buffer
+ * @param scalar    The scalar to mutliply by
+ * @param output    The output buffer
+ * @param len       The number of elements to convert
+ */
+extern DECLSPEC void SDLCALL ATK_VecScaleS16(const Sint16* input, float scalar, float* output, size_t len);
+
 /**
  * Scales an input buffer and adds it to another, storing the result in output
  *
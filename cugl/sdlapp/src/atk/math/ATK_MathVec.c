@@ -28,6 +28,25 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 #include <ATK_math.h>
+#include <SDL_atomic.h>
+#include <SDL_cpuinfo.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ATK_SIMD_SSE2 1
+    #include <emmintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define ATK_SIMD_AVX 1
+        #define ATK_TARGET_AVX __attribute__((target("avx")))
+        #include <immintrin.h>
+    #elif defined(_MSC_VER)
+        #define ATK_SIMD_AVX 1
+        #define ATK_TARGET_AVX
+        #include <immintrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define ATK_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
 
 /**
  * @file ATK_MathVec.c
@@ -41,7 +60,44 @@
  * performance difference between the two, possibly due to auto-vectorization
  * or other optimizations. Instead of trying to identify which functions best
  * benefit from the separation, we just went YOLO and separated them all.
+ *
+ * The adjacent versions of the kernels used by the audio mixer (add, mult,
+ * scale, clip and knee clip) and the 16-bit sample conversion also have SIMD
+ * versions. These are chosen the
+ * first time a kernel is called, according to the CPU features, and produce
+ * the same bits as the scalar versions. See the SIMD Dispatch section at the
+ * end of this file.
+ */
+
+/**
+ * The kernels of the adjacent vector functions that have SIMD versions
+ *
+ * Each SIMD version must produce the same bits as the scalar version, so
+ * choosing a table never changes the audio. The SIMD versions do every
+ * operation of the scalar expression separately (no fused multiply-add),
+ * which matches the scalar code as long as it is not compiled to contract
+ * floating point expressions.
  */
+typedef struct ATK_VecKernels {
+    /** The name of the instruction set */
+    const char* name;
+    /** The kernel of ATK_VecAdd */
+    void (*add)(const float* input1, const float* input2, float* output, size_t len);
+    /** The kernel of ATK_VecMult */
+    void (*mult)(const float* input1, const float* input2, float* output, size_t len);
+    /** The kernel of ATK_VecScale */
+    void (*scale)(const float* input, float scalar, float* output, size_t len);
+    /** The kernel of ATK_VecClip */
+    void (*clip)(const float* input, float min, float max, float* output, size_t len);
+    /** The kernel of ATK_VecClipKnee */
+    void (*clipknee)(const float* input, float bound, float knee, float* output, size_t len);
+    /** The kernel of ATK_VecScaleS16 */
+    void (*scales16)(const Sint16* input, float scalar, float* output, size_t len);
+} ATK_VecKernels;
+
+/** Returns the kernels chosen for this CPU (see the end of the file) */
+static const ATK_VecKernels* atk_GetVecKernels(void);
+
 #pragma mark -
 #pragma mark Distance Utils
 /**
@@ -1545,6 +1601,19 @@ void ATK_VecInv_stride(const float* input, size_t istride,
     }
 }
 
+/**
+ * The scalar version of {@link ATK_VecAdd}
+ */
+static void atk_VecAdd_scalar(const float* input1, const float* input2,
+                              float* output, size_t len) {
+    const float* src1 = input1;
+    const float* src2 = input2;
+    float* dst = output;
+    while(len--) {
+        *dst++ = *(src1++)+*(src2++);
+    }
+}
+
 /**
  * Adds two input buffers together, storing the result in output
  *
@@ -1557,12 +1626,7 @@ void ATK_VecInv_stride(const float* input, size_t istride,
  */
 void ATK_VecAdd(const float* input1, const float* input2,
                 float* output, size_t len) {
-    const float* src1 = input1;
-    const float* src2 = input2;
-    float* dst = output;
-    while(len--) {
-        *dst++ = *(src1++)+*(src2++);
-    }
+    atk_GetVecKernels()->add(input1,input2,output,len);
 }
 
 /**
@@ -1663,6 +1727,19 @@ void ATK_VecSub_stride(const float* input1, size_t istride1,
     }
 }
 
+/**
+ * The scalar version of {@link ATK_VecMult}
+ */
+static void atk_VecMult_scalar(const float* input1, const float* input2,
+                               float* output, size_t len) {
+    const float* src1 = input1;
+    const float* src2 = input2;
+    float* dst = output;
+    while(len--) {
+        *dst++ = *(src1++) * *(src2++);
+    }
+}
+
 /**
  * Multiplies two buffers together, storing the result in output
  *
@@ -1675,12 +1752,7 @@ void ATK_VecSub_stride(const float* input1, size_t istride1,
  */
 void ATK_VecMult(const float* input1, const float* input2,
                  float* output, size_t len) {
-    const float* src1 = input1;
-    const float* src2 = input2;
-    float* dst = output;
-    while(len--) {
-        *dst++ = *(src1++) * *(src2++);
-    }
+    atk_GetVecKernels()->mult(input1,input2,output,len);
 }
 
 /**
@@ -1795,6 +1867,17 @@ void ATK_VecDiv_stride(const float* input1, size_t istride1,
     }
 }
 
+/**
+ * The scalar version of {@link ATK_VecScale}
+ */
+static void atk_VecScale_scalar(const float* input, float scalar, float* output, size_t len) {
+    const float* src = input;
+    float* dst = output;
+    while(len--) {
+        *dst++ = *(src++) * scalar;
+    }
+}
+
 /**
  * Scales an input buffer, storing the result in output
  *
@@ -1806,13 +1889,36 @@ void ATK_VecDiv_stride(const float* input1, size_t istride1,
  * @param len       The number of elements to multiply
  */
 void ATK_VecScale(const float* input, float scalar, float* output, size_t len) {
-    const float* src = input;
+    atk_GetVecKernels()->scale(input,scalar,output,len);
+}
+
+/**
+ * The scalar version of {@link ATK_VecScaleS16}
+ */
+static void atk_VecScaleS16_scalar(const Sint16* input, float scalar, float* output, size_t len) {
+    const Sint16* src = input;
     float* dst = output;
     while(len--) {
-        *dst++ = *(src++) * scalar;
+        *dst++ = (float)*(src++) * scalar;
     }
 }
 
+/**
+ * Scales a 16-bit integer input buffer, storing the float result in output
+ *
+ * This converts compact PCM data to float data. A scalar of 1/32768 maps
+ * the full range of the input to [-1,1), and the scalar can also include
+ * a gain, saving a second pass.
+ *
+ * @param input     The input buffer
+ * @param scalar    The scalar to mutliply by
+ * @param output    The output buffer
+ * @param len       The number of elements to convert
+ */
+void ATK_VecScaleS16(const Sint16* input, float scalar, float* output, size_t len) {
+    atk_GetVecKernels()->scales16(input,scalar,output,len);
+}
+
 /**
  * Scales an input buffer, storing the result in output
  *
@@ -1909,6 +2015,26 @@ void ATK_VecScaleAdd_stride(const float* input1, size_t istride1,
 
 #pragma mark -
 #pragma mark Stream Clipping
+/**
+ * The scalar version of {@link ATK_VecClip}
+ */
+static void atk_VecClip_scalar(const float* input, float min, float max,
+                               float* output, size_t len) {
+    const float* left = input;
+    float* rght = output;
+    float temp;
+    while(len--) {
+        temp = *left++;
+        if (temp < min) {
+            *rght++ = min;
+        } else if (temp > max) {
+            *rght++ = max;
+        } else {
+            *rght++ = temp;
+        }
+    }
+}
+
 /**
  * Clips the input buffer to the range [min,max]
  *
@@ -1925,19 +2051,7 @@ void ATK_VecScaleAdd_stride(const float* input1, size_t istride1,
  */
 void ATK_VecClip(const float* input, float min, float max,
                  float* output, size_t len) {
-    const float* left = input;
-    float* rght = output;
-    float temp;
-    while(len--) {
-        temp = *left++;
-        if (temp < min) {
-            *rght++ = min;
-        } else if (temp > max) {
-            *rght++ = max;
-        } else {
-            *rght++ = temp;
-        }
-    }
+    atk_GetVecKernels()->clip(input,min,max,output,len);
 }
 
 /**
@@ -2154,6 +2268,27 @@ void ATK_VecClipCount_stride(const float* input, size_t istride,
     }
 }
 
+/**
+ * The scalar version of {@link ATK_VecClipKnee}
+ */
+static void atk_VecClipKnee_scalar(const float* input, float bound, float knee,
+                                   float* output, size_t len) {
+    float factor = bound*knee-knee*knee;
+    const float* left = input;
+    float* rght = output;
+    float temp;
+    while(len--) {
+        temp = *left++;
+        if (temp > knee) {
+            *rght++ = (bound*temp-factor)/temp;
+        } else if (temp < -knee) {
+            *rght++ = (bound*temp+factor)/temp;
+        } else {
+            *rght++ = temp;
+        }
+    }
+}
+
 /**
  * Soft clips the input buffer to the range [-bound,bound]
  *
@@ -2173,20 +2308,7 @@ void ATK_VecClipCount_stride(const float* input, size_t istride,
  */
 void ATK_VecClipKnee(const float* input, float bound, float knee,
                      float* output, size_t len) {
-    float factor = bound*knee-knee*knee;
-    const float* left = input;
-    float* rght = output;
-    float temp;
-    while(len--) {
-        temp = *left++;
-        if (temp > knee) {
-            *rght++ = (bound*temp-factor)/temp;
-        } else if (temp < -knee) {
-            *rght++ = (bound*temp+factor)/temp;
-        } else {
-            *rght++ = temp;
-        }
-    }
+    atk_GetVecKernels()->clipknee(input,bound,knee,output,len);
 }
 
 /**
@@ -3659,3 +3781,422 @@ void ATK_VecFlatten(const float* input, size_t stride, float* output, size_t len
         dst++;
     }
 }
+
+#pragma mark -
+#pragma mark SIMD Dispatch
+/** The scalar kernels (always available) */
+static const ATK_VecKernels atk_vec_scalar = {
+    "scalar",
+    atk_VecAdd_scalar,
+    atk_VecMult_scalar,
+    atk_VecScale_scalar,
+    atk_VecClip_scalar,
+    atk_VecClipKnee_scalar,
+    atk_VecScaleS16_scalar
+};
+
+#ifdef ATK_SIMD_SSE2
+/**
+ * The SSE2 version of {@link ATK_VecAdd}
+ */
+static void atk_VecAdd_sse2(const float* input1, const float* input2,
+                            float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        __m128 a = _mm_loadu_ps(input1+pos);
+        __m128 b = _mm_loadu_ps(input2+pos);
+        _mm_storeu_ps(output+pos,_mm_add_ps(a,b));
+    }
+    atk_VecAdd_scalar(input1+pos,input2+pos,output+pos,len-pos);
+}
+
+/**
+ * The SSE2 version of {@link ATK_VecMult}
+ */
+static void atk_VecMult_sse2(const float* input1, const float* input2,
+                             float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        __m128 a = _mm_loadu_ps(input1+pos);
+        __m128 b = _mm_loadu_ps(input2+pos);
+        _mm_storeu_ps(output+pos,_mm_mul_ps(a,b));
+    }
+    atk_VecMult_scalar(input1+pos,input2+pos,output+pos,len-pos);
+}
+
+/**
+ * The SSE2 version of {@link ATK_VecScale}
+ */
+static void atk_VecScale_sse2(const float* input, float scalar, float* output, size_t len) {
+    __m128 s = _mm_set1_ps(scalar);
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        _mm_storeu_ps(output+pos,_mm_mul_ps(_mm_loadu_ps(input+pos),s));
+    }
+    atk_VecScale_scalar(input+pos,scalar,output+pos,len-pos);
+}
+
+/**
+ * The SSE2 version of {@link ATK_VecClip}
+ *
+ * This uses comparison masks rather than min/max, so that NaN and the case
+ * min > max behave exactly as in the scalar version.
+ */
+static void atk_VecClip_sse2(const float* input, float min, float max,
+                             float* output, size_t len) {
+    __m128 lo = _mm_set1_ps(min);
+    __m128 hi = _mm_set1_ps(max);
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        __m128 x = _mm_loadu_ps(input+pos);
+        __m128 above = _mm_cmpgt_ps(x,hi);
+        __m128 below = _mm_cmplt_ps(x,lo);
+        x = _mm_or_ps(_mm_and_ps(above,hi),_mm_andnot_ps(above,x));
+        x = _mm_or_ps(_mm_and_ps(below,lo),_mm_andnot_ps(below,x));
+        _mm_storeu_ps(output+pos,x);
+    }
+    atk_VecClip_scalar(input+pos,min,max,output+pos,len-pos);
+}
+
+/**
+ * The SSE2 version of {@link ATK_VecClipKnee}
+ */
+static void atk_VecClipKnee_sse2(const float* input, float bound, float knee,
+                                 float* output, size_t len) {
+    float factor = bound*knee-knee*knee;
+    __m128 b = _mm_set1_ps(bound);
+    __m128 f = _mm_set1_ps(factor);
+    __m128 kp = _mm_set1_ps(knee);
+    __m128 kn = _mm_set1_ps(-knee);
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        __m128 x = _mm_loadu_ps(input+pos);
+        __m128 bx = _mm_mul_ps(b,x);
+        __m128 up = _mm_div_ps(_mm_sub_ps(bx,f),x);
+        __m128 dn = _mm_div_ps(_mm_add_ps(bx,f),x);
+        __m128 above = _mm_cmpgt_ps(x,kp);
+        __m128 below = _mm_cmplt_ps(x,kn);
+        x = _mm_or_ps(_mm_and_ps(below,dn),_mm_andnot_ps(below,x));
+        x = _mm_or_ps(_mm_and_ps(above,up),_mm_andnot_ps(above,x));
+        _mm_storeu_ps(output+pos,x);
+    }
+    atk_VecClipKnee_scalar(input+pos,bound,knee,output+pos,len-pos);
+}
+
+/**
+ * The SSE2 version of {@link ATK_VecScaleS16}
+ */
+static void atk_VecScaleS16_sse2(const Sint16* input, float scalar, float* output, size_t len) {
+    __m128 s = _mm_set1_ps(scalar);
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(input+pos));
+        // Sign extend by unpacking into the high half and shifting back
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x,x),16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x,x),16);
+        _mm_storeu_ps(output+pos,  _mm_mul_ps(_mm_cvtepi32_ps(lo),s));
+        _mm_storeu_ps(output+pos+4,_mm_mul_ps(_mm_cvtepi32_ps(hi),s));
+    }
+    atk_VecScaleS16_scalar(input+pos,scalar,output+pos,len-pos);
+}
+
+/** The SSE2 kernels */
+static const ATK_VecKernels atk_vec_sse2 = {
+    "sse2",
+    atk_VecAdd_sse2,
+    atk_VecMult_sse2,
+    atk_VecScale_sse2,
+    atk_VecClip_sse2,
+    atk_VecClipKnee_sse2,
+    atk_VecScaleS16_sse2
+};
+#endif
+
+#ifdef ATK_SIMD_AVX
+/**
+ * The AVX version of {@link ATK_VecAdd}
+ */
+ATK_TARGET_AVX
+static void atk_VecAdd_avx(const float* input1, const float* input2,
+                           float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        __m256 a = _mm256_loadu_ps(input1+pos);
+        __m256 b = _mm256_loadu_ps(input2+pos);
+        _mm256_storeu_ps(output+pos,_mm256_add_ps(a,b));
+    }
+    _mm256_zeroupper();
+    atk_VecAdd_scalar(input1+pos,input2+pos,output+pos,len-pos);
+}
+
+/**
+ * The AVX version of {@link ATK_VecMult}
+ */
+ATK_TARGET_AVX
+static void atk_VecMult_avx(const float* input1, const float* input2,
+                            float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        __m256 a = _mm256_loadu_ps(input1+pos);
+        __m256 b = _mm256_loadu_ps(input2+pos);
+        _mm256_storeu_ps(output+pos,_mm256_mul_ps(a,b));
+    }
+    _mm256_zeroupper();
+    atk_VecMult_scalar(input1+pos,input2+pos,output+pos,len-pos);
+}
+
+/**
+ * The AVX version of {@link ATK_VecScale}
+ */
+ATK_TARGET_AVX
+static void atk_VecScale_avx(const float* input, float scalar, float* output, size_t len) {
+    __m256 s = _mm256_set1_ps(scalar);
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        _mm256_storeu_ps(output+pos,_mm256_mul_ps(_mm256_loadu_ps(input+pos),s));
+    }
+    _mm256_zeroupper();
+    atk_VecScale_scalar(input+pos,scalar,output+pos,len-pos);
+}
+
+/**
+ * The AVX version of {@link ATK_VecClip}
+ *
+ * This uses comparison masks rather than min/max, so that NaN and the case
+ * min > max behave exactly as in the scalar version.
+ */
+ATK_TARGET_AVX
+static void atk_VecClip_avx(const float* input, float min, float max,
+                            float* output, size_t len) {
+    __m256 lo = _mm256_set1_ps(min);
+    __m256 hi = _mm256_set1_ps(max);
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        __m256 x = _mm256_loadu_ps(input+pos);
+        __m256 y = _mm256_blendv_ps(x,hi,_mm256_cmp_ps(x,hi,_CMP_GT_OQ));
+        y = _mm256_blendv_ps(y,lo,_mm256_cmp_ps(x,lo,_CMP_LT_OQ));
+        _mm256_storeu_ps(output+pos,y);
+    }
+    _mm256_zeroupper();
+    atk_VecClip_scalar(input+pos,min,max,output+pos,len-pos);
+}
+
+/**
+ * The AVX version of {@link ATK_VecClipKnee}
+ */
+ATK_TARGET_AVX
+static void atk_VecClipKnee_avx(const float* input, float bound, float knee,
+                                float* output, size_t len) {
+    float factor = bound*knee-knee*knee;
+    __m256 b = _mm256_set1_ps(bound);
+    __m256 f = _mm256_set1_ps(factor);
+    __m256 kp = _mm256_set1_ps(knee);
+    __m256 kn = _mm256_set1_ps(-knee);
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        __m256 x = _mm256_loadu_ps(input+pos);
+        __m256 bx = _mm256_mul_ps(b,x);
+        __m256 up = _mm256_div_ps(_mm256_sub_ps(bx,f),x);
+        __m256 dn = _mm256_div_ps(_mm256_add_ps(bx,f),x);
+        __m256 y = _mm256_blendv_ps(x,dn,_mm256_cmp_ps(x,kn,_CMP_LT_OQ));
+        y = _mm256_blendv_ps(y,up,_mm256_cmp_ps(x,kp,_CMP_GT_OQ));
+        _mm256_storeu_ps(output+pos,y);
+    }
+    _mm256_zeroupper();
+    atk_VecClipKnee_scalar(input+pos,bound,knee,output+pos,len-pos);
+}
+
+/**
+ * The AVX version of {@link ATK_VecScaleS16}
+ *
+ * AVX has no 256-bit integer unpacking (that is AVX2), so the sign extension
+ * is done in two SSE2 halves.
+ */
+ATK_TARGET_AVX
+static void atk_VecScaleS16_avx(const Sint16* input, float scalar, float* output, size_t len) {
+    __m256 s = _mm256_set1_ps(scalar);
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(input+pos));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x,x),16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x,x),16);
+        __m256i y = _mm256_insertf128_si256(_mm256_castsi128_si256(lo),hi,1);
+        _mm256_storeu_ps(output+pos,_mm256_mul_ps(_mm256_cvtepi32_ps(y),s));
+    }
+    _mm256_zeroupper();
+    atk_VecScaleS16_scalar(input+pos,scalar,output+pos,len-pos);
+}
+
+/** The AVX kernels */
+static const ATK_VecKernels atk_vec_avx = {
+    "avx",
+    atk_VecAdd_avx,
+    atk_VecMult_avx,
+    atk_VecScale_avx,
+    atk_VecClip_avx,
+    atk_VecClipKnee_avx,
+    atk_VecScaleS16_avx
+};
+#endif
+
+#ifdef ATK_SIMD_NEON
+/**
+ * The NEON version of {@link ATK_VecAdd}
+ */
+static void atk_VecAdd_neon(const float* input1, const float* input2,
+                            float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        vst1q_f32(output+pos,vaddq_f32(vld1q_f32(input1+pos),vld1q_f32(input2+pos)));
+    }
+    atk_VecAdd_scalar(input1+pos,input2+pos,output+pos,len-pos);
+}
+
+/**
+ * The NEON version of {@link ATK_VecMult}
+ */
+static void atk_VecMult_neon(const float* input1, const float* input2,
+                             float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        vst1q_f32(output+pos,vmulq_f32(vld1q_f32(input1+pos),vld1q_f32(input2+pos)));
+    }
+    atk_VecMult_scalar(input1+pos,input2+pos,output+pos,len-pos);
+}
+
+/**
+ * The NEON version of {@link ATK_VecScale}
+ */
+static void atk_VecScale_neon(const float* input, float scalar, float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        vst1q_f32(output+pos,vmulq_n_f32(vld1q_f32(input+pos),scalar));
+    }
+    atk_VecScale_scalar(input+pos,scalar,output+pos,len-pos);
+}
+
+/**
+ * The NEON version of {@link ATK_VecClip}
+ *
+ * This uses comparison masks rather than min/max, so that NaN and the case
+ * min > max behave exactly as in the scalar version.
+ */
+static void atk_VecClip_neon(const float* input, float min, float max,
+                             float* output, size_t len) {
+    float32x4_t lo = vdupq_n_f32(min);
+    float32x4_t hi = vdupq_n_f32(max);
+    size_t pos = 0;
+    for(; pos+4 <= len; pos += 4) {
+        float32x4_t x = vld1q_f32(input+pos);
+        float32x4_t y = vbslq_f32(vcgtq_f32(x,hi),hi,x);
+        y = vbslq_f32(vcltq_f32(x,lo),lo,y);
+        vst1q_f32(output+pos,y);
+    }
+    atk_VecClip_scalar(input+pos,min,max,output+pos,len-pos);
+}
+
+/**
+ * The NEON version of {@link ATK_VecScaleS16}
+ */
+static void atk_VecScaleS16_neon(const Sint16* input, float scalar, float* output, size_t len) {
+    size_t pos = 0;
+    for(; pos+8 <= len; pos += 8) {
+        int16x8_t x = vld1q_s16(input+pos);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+        vst1q_f32(output+pos,  vmulq_n_f32(lo,scalar));
+        vst1q_f32(output+pos+4,vmulq_n_f32(hi,scalar));
+    }
+    atk_VecScaleS16_scalar(input+pos,scalar,output+pos,len-pos);
+}
+
+/**
+ * The NEON kernels
+ *
+ * The knee clip stays scalar. ARM compilers contract its multiply-subtract
+ * into a fused instruction by default, which a NEON version could not match
+ * bit for bit on every toolchain.
+ */
+static const ATK_VecKernels atk_vec_neon = {
+    "neon",
+    atk_VecAdd_neon,
+    atk_VecMult_neon,
+    atk_VecScale_neon,
+    atk_VecClip_neon,
+    atk_VecClipKnee_scalar,
+    atk_VecScaleS16_neon
+};
+#endif
+
+/** The kernels in use (NULL until the first call) */
+static void* atk_vec_kernels = NULL;
+
+/**
+ * Returns the best kernels for this CPU
+ *
+ * @param simd  Whether to allow SIMD kernels
+ *
+ * @return the best kernels for this CPU
+ */
+static const ATK_VecKernels* atk_SelectVecKernels(SDL_bool simd) {
+    if (!simd) {
+        return &atk_vec_scalar;
+    }
+#ifdef ATK_SIMD_AVX
+    if (SDL_HasAVX()) {
+        return &atk_vec_avx;
+    }
+#endif
+#ifdef ATK_SIMD_SSE2
+    if (SDL_HasSSE2()) {
+        return &atk_vec_sse2;
+    }
+#endif
+#ifdef ATK_SIMD_NEON
+    if (SDL_HasNEON()) {
+        return &atk_vec_neon;
+    }
+#endif
+    return &atk_vec_scalar;
+}
+
+/**
+ * Returns the kernels in use, choosing them on the first call
+ *
+ * The first call may come from any thread (usually the audio thread). If
+ * two threads race, they both store the same table.
+ *
+ * @return the kernels in use
+ */
+static const ATK_VecKernels* atk_GetVecKernels(void) {
+    const ATK_VecKernels* kernels = (const ATK_VecKernels*)SDL_AtomicGetPtr(&atk_vec_kernels);
+    if (kernels == NULL) {
+        kernels = atk_SelectVecKernels(SDL_TRUE);
+        SDL_AtomicSetPtr(&atk_vec_kernels,(void*)kernels);
+    }
+    return kernels;
+}
+
+/**
+ * Returns the name of the instruction set used by the vector kernels
+ *
+ * The name is one of "avx", "sse2", "neon" or "scalar".
+ *
+ * @return the name of the instruction set used by the vector kernels
+ */
+const char* ATK_VecGetSIMD(void) {
+    return atk_GetVecKernels()->name;
+}
+
+/**
+ * Sets whether the vector kernels may use SIMD instructions
+ *
+ * The SIMD kernels are enabled by default, when the CPU supports them.
+ * Disabling them is only useful to compare against the scalar kernels,
+ * such as in benchmarks. This may be called from any thread.
+ *
+ * @param enable    Whether to allow SIMD kernels
+ */
+void ATK_VecSetSIMD(SDL_bool enable) {
+    SDL_AtomicSetPtr(&atk_vec_kernels,(void*)atk_SelectVecKernels(enable));
+}
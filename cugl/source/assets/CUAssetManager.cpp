@@ -48,6 +48,7 @@
 #include <cugl/assets/CUAssetManager.h>
 #include <cugl/base/CUApplication.h>
 #include <cugl/io/CUJsonReader.h>
+#include <cugl/util/CUProfiler.h>
 
 using namespace cugl;
 
@@ -107,6 +108,7 @@ void AssetManager::dispose() {
  * @return true if all assets of this type were successfully loaded.
  */
 bool AssetManager::readCategory(size_t hash, const std::shared_ptr<JsonValue>& json) {
+    CUProfileZone("AssetManager::readCategory");
     auto it = _handlers.find(hash);
     if (it == _handlers.end()) {
         return false;
@@ -162,6 +164,7 @@ bool AssetManager::readCategory(size_t hash, const std::shared_ptr<JsonValue>& j
  */
 void AssetManager::readCategory(size_t hash, const std::shared_ptr<JsonValue>& json,
                                 LoaderCallback callback) {
+    CUProfileZone("AssetManager::readCategory");
     auto it = _handlers.find(hash);
     std::shared_ptr<BaseLoader> loader = it->second;
     if (loader == nullptr) {
@@ -292,6 +295,7 @@ void AssetManager::resume() {
  * @return true if all assets specified in the directory were successfully loaded.
  */
 bool AssetManager::loadDirectory(const std::shared_ptr<JsonValue>& json) {
+    CUProfileZone("AssetManager::loadDirectory");
     bool success = true;
     size_t entries = json->size();
 
@@ -485,6 +489,7 @@ void AssetManager::loadDirectoryAsync(const std::string directory, LoaderCallbac
     }
     
     _workers->addTask([=](void) {
+        CUProfileZone("AssetManager::loadDirectoryAsync");
         std::shared_ptr<JsonValue> json = reader->readJson();
         loadDirectoryAsync(json,callback);
         _preload = false;
@@ -48,6 +48,31 @@ AudioEngine* AudioEngine::_gEngine = nullptr;
 /** The read size to use for the audio devices */
 Uint32 AudioEngine::_readsize = 0;
 
+/** Marks a slot with no sound effect handle */
+#define NO_HANDLE   UINT32_MAX
+
+namespace {
+/**
+ * The engine mixer, which runs the engine commands before each read
+ *
+ * The commands are run in the audio thread, at the start of the read, so
+ * that the main thread never has to lock the mixer (or the slots) to change
+ * a sound effect.
+ */
+class EngineMixer : public AudioMixer {
+public:
+    /** The function to run before each read */
+    std::function<void()> prepare;
+
+    Uint32 read(float* buffer, Uint32 frames) override {
+        if (prepare) {
+            prepare();
+        }
+        return AudioMixer::read(buffer,frames);
+    }
+};
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -57,7 +82,9 @@ Uint32 AudioEngine::_readsize = 0;
  */
 AudioEngine::AudioEngine() :
 _capacity(0),
-_primary(false) {
+_primary(false),
+_pending(0),
+_collector(0) {
     _output = nullptr;
     _mixer  = nullptr;
 }
@@ -82,7 +109,12 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
     
     _capacity = slots;
     _output = device;
-    _mixer  = AudioMixer::alloc(_capacity+1,_output->getChannels(),_output->getRate());
+    std::shared_ptr<EngineMixer> mixer = std::make_shared<EngineMixer>();
+    if (!mixer->init(_capacity+1,_output->getChannels(),_output->getRate())) {
+        return false;
+    }
+    mixer->prepare = [this]() { this->runCommands(); };
+    _mixer = mixer;
     
     for(int ii = 0; ii <= _capacity; ii++) {
         std::shared_ptr<AudioScheduler> channel;
@@ -96,13 +128,15 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
         _mixer->attach(ii,cover);
         
         if (ii < _capacity) {
+            // Runs in the audio thread, so hand the effect to the main thread.
+            // Play never hands out more effects than the queue holds, so this fits.
             channel->setCallback([=](const std::shared_ptr<cugl::audio::AudioNode>& node,
                                   cugl::audio::AudioNode::Action action) {
                 if (action != cugl::audio::AudioNode::Action::LOOPBACK) {
                     bool success = (action == cugl::audio::AudioNode::Action::COMPLETE);
-                    this->gcollect(node,success);
+                    this->_completions.push({node,success});
                 }
-            });
+            },true);
         } else {
             std::shared_ptr<AudioQueue> music = AudioQueue::alloc(cover);
             if (music != nullptr) {
@@ -117,6 +151,28 @@ bool AudioEngine::init(const std::shared_ptr<AudioOutput>& device, Uint32 slots)
         _panPool.push_back(AudioPanner::alloc(_mixer->getChannels(),2,_mixer->getRate()));
     }
     
+    // Forced plays may briefly exceed the slots, while old effects fade out
+    _evicts.reserve(2*_capacity);
+    _free.reserve(_capacity);
+    for(Uint32 ii = (Uint32)_capacity; ii > 0; ii--) {
+        _free.push_back(ii-1);
+    }
+    _voices.resize(_capacity,nullptr);
+    _owners.resize(_capacity,NO_HANDLE);
+    _fading.resize(_capacity,false);
+    _playback.resize(_capacity,false);
+    _retired.reserve(2*_capacity);
+    _commands.init(4*_capacity);
+    _deferred.reserve(4*_capacity);
+    _completions.init(4*_capacity);
+    _pending = 0;
+    if (Application::get() != nullptr) {
+        _collector = Application::get()->schedule([this]() {
+            this->collect();
+            return true;
+        },0,0);
+    }
+
     _output->attach(_mixer);
     return true;
 }
@@ -136,6 +192,11 @@ void AudioEngine::dispose() {
             _primary = false;
         }
 
+        if (_collector && Application::get() != nullptr) {
+            Application::get()->unschedule(_collector);
+        }
+        _collector = 0;
+
         _covers.clear();
         _slots.clear();
         
@@ -149,6 +210,19 @@ void AudioEngine::dispose() {
         _queues.clear();
 		_actives.clear();
         _evicts.clear();
+        _keys.clear();
+        _handles.clear();
+
+        _free.clear();
+        _voices.clear();
+        _owners.clear();
+        _fading.clear();
+        _playback.clear();
+        _retired.clear();
+        _commands.dispose();
+        _deferred.clear();
+        _completions.dispose();
+        _pending = 0;
 	}
 }
 
@@ -156,23 +230,182 @@ void AudioEngine::dispose() {
 #pragma mark -
 #pragma mark Internal Helpers
 /**
- * Purges this key from the list of active effects.
+ * Purges this handle from the list of active effects.
  *
  * This method is not the same as stopping the channel. A channel may play a
- * little longer after the key is removed.  This is simply a clean-up method.
+ * little longer after the handle is removed.  This is simply a clean-up method.
+ *
+ * @param handle    The handle to purge from the list of active effects.
+ */
+void AudioEngine::removeHandle(Uint32 handle) {
+    _actives[handle] = nullptr;
+    auto it = std::find(_evicts.begin(), _evicts.end(), handle);
+    if (it != _evicts.end()) {
+        _evicts.erase(it);
+    }
+}
+
+/**
+ * Returns the active effect for the given key (or nullptr if none)
+ *
+ * This method does not intern the key, so it is safe to use for queries.
+ *
+ * @param key   The reference key for the sound effect
+ *
+ * @return the active effect for the given key (or nullptr if none)
+ */
+std::shared_ptr<audio::AudioFader> AudioEngine::findActive(const std::string& key) const {
+    auto it = _handles.find(key);
+    if (it == _handles.end()) {
+        return nullptr;
+    }
+    return _actives[it->second];
+}
+
+/**
+ * Returns a free slot for a new sound effect (or -1 if none)
+ *
+ * If there is no free slot and `force` is true, this method will evict the
+ * longest playing sound effect and return its slot.
+ *
+ * @param force     Whether to force another sound to stop.
+ *
+ * @return a free slot for a new sound effect (or -1 if none)
+ */
+int AudioEngine::acquireSlot(bool force) {
+    if (_free.empty()) {
+        collect();
+    }
+    if (!_free.empty()) {
+        Uint32 slot = _free.back();
+        _free.pop_back();
+        return (int)slot;
+    }
+
+    // Try again for soon to be deleted.
+    for(Uint32 slot = 0; slot < _capacity; slot++) {
+        if (_fading[slot] && !_slots[slot]->getTailSize()) {
+            Uint32 owner = _owners[slot];
+            if (owner != NO_HANDLE && _actives[owner] == _voices[slot]) {
+                removeHandle(owner);
+            }
+            return (int)slot;
+        }
+    }
+
+    if (force && !_evicts.empty()) {
+        Uint32 handle = _evicts.front();
+        Uint32 slot = _actives[handle]->getTag();
+        clear(handle);
+        removeHandle(handle);
+        return (int)slot;
+    }
+
+    // Fail if nothing available
+    CULogError("No available sound channels");
+    return -1;
+}
+
+/**
+ * Remembers the handle of the effect in the given slot, which is reused.
+ *
+ * The effect may still be fading out, and so its completion arrives after
+ * the slot belongs to another effect. This lets {@link #gcollect} find the
+ * handle of the effect without the slot.
+ *
+ * @param slot      The sound effect slot
+ */
+void AudioEngine::retireVoice(Uint32 slot) {
+    _retired.push_back({_voices[slot].get(),_owners[slot]});
+}
+
+/**
+ * Sends a command to a sound effect slot
+ *
+ * The command is run by the audio thread at the start of its next read.
+ * If the command queue is full, the command is posted again on the next
+ * collect, as the main thread may never touch a fader the mixer reads.
  *
- * @remove key  The key to purge from the list of active effects.
+ * @param op        The operation to perform
+ * @param slot      The sound effect slot
+ * @param fader     The fader to act on
+ * @param fade      The fade duration in seconds
  */
-void AudioEngine::removeKey(const std::string key) {
-    _actives.erase(key);
-    for(auto it = _evicts.begin(); it != _evicts.end(); ) {
-        if (*it == key) {
-            it = _evicts.erase(it);
+void AudioEngine::post(Command::Op op, Uint32 slot, audio::AudioFader* fader, float fade) {
+    Command command = {op,slot,fader,fade};
+    // Keep the commands in order behind any that are already deferred
+    if (!_deferred.empty() || !_commands.push(command)) {
+        _deferred.push_back(command);
+    }
+}
+
+/**
+ * Runs a command on a sound effect slot
+ *
+ * A command for an effect is dropped if the effect is no longer playing
+ * in its slot, as the fader may have been recycled for another effect.
+ *
+ * @param command   The command to run
+ */
+void AudioEngine::execute(const Command& command) {
+    if (command.fader != _covers[command.slot].get() &&
+        command.fader != _slots[command.slot]->getCurrent().get()) {
+        return;
+    }
+    switch (command.op) {
+        case Command::Op::FADE_OUT:
+            command.fader->fadeOut(command.fade);
+            break;
+        case Command::Op::PAUSE:
+            if (command.fade > 0) {
+                command.fader->fadePause(command.fade);
+            } else {
+                command.fader->pause();
+            }
+            break;
+        case Command::Op::RESUME:
+            command.fader->resume();
+            break;
+    }
+}
+
+/**
+ * Runs all pending commands (AUDIO THREAD ONLY)
+ */
+void AudioEngine::runCommands() {
+    Command command;
+    while (_commands.pop(command)) {
+        execute(command);
+    }
+}
+
+/**
+ * Garbage collects all completed sound effects (MAIN THREAD ONLY)
+ *
+ * This method is called once an animation frame, and whenever the engine
+ * runs out of free slots. It also posts the deferred commands.
+ */
+void AudioEngine::collect() {
+    Completion completion;
+    while (_completions.pop(completion)) {
+        gcollect(completion.node,completion.status);
+    }
+
+    size_t posted = 0;
+    for(; posted < _deferred.size(); posted++) {
+        const Command& command = _deferred[posted];
+        // Drop commands for effects that are no longer in their slot (evicted
+        // effects keep fading in their slot after it is handed to a new one)
+        if (command.fader != _covers[command.slot].get() &&
+            command.fader != _voices[command.slot].get() &&
+            command.fader != _slots[command.slot]->getCurrent().get()) {
+            continue;
+        }
+        if (!_commands.push(command)) {
             break;
-        } else {
-            it++;
         }
     }
+    _deferred.erase(_deferred.begin(),_deferred.begin()+posted);
 }
 
 /**
@@ -306,11 +539,32 @@ std::shared_ptr<audio::AudioNode> AudioEngine::disposeWrapper(const std::shared_
  * @param status    True if the music terminated normally, false otherwise.
  */
 void AudioEngine::gcollect(const std::shared_ptr<audio::AudioNode>& sound, bool status) {
-    std::string key = sound->getName();
+    // The slot may already belong to another effect (if this one was evicted)
+    _pending--;
+    Uint32 owner = NO_HANDLE;
+    Sint32 slot = sound->getTag();
+    if (slot >= 0 && (size_t)slot < _capacity && _voices[slot] == sound) {
+        owner = _owners[slot];
+        if (owner != NO_HANDLE && _actives[owner] == sound) {
+            removeHandle(owner);
+        }
+        _voices[slot] = nullptr;
+        _owners[slot] = NO_HANDLE;
+        _fading[slot] = false;
+        _free.push_back(slot);
+    } else {
+        for(size_t ii = 0; ii < _retired.size(); ii++) {
+            if (_retired[ii].first == sound.get()) {
+                owner = _retired[ii].second;
+                _retired[ii] = _retired.back();
+                _retired.pop_back();
+                break;
+            }
+        }
+    }
     disposeWrapper(sound);
-    removeKey(key);
     if (_callback) {
-        _callback(key,status);
+        _callback(owner == NO_HANDLE ? std::string() : _keys[owner],status);
     }
 }
 
@@ -616,58 +870,69 @@ void AudioEngine::freeQueue(const std::shared_ptr<AudioQueue>& queue) {
  */
 bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& sound,
                        bool loop, float volume, bool force) {
+    return play(getHandle(key),sound,loop,volume,force);
+}
+
+/**
+ * Plays the given sound, and associates it with the specified handle.
+ *
+ * This is the same as playing the sound with the key of the handle (see
+ * {@link #getHandle}), except that it does not hash the key.
+ *
+ * @param  handle   The handle for the sound effect
+ * @param  sound    The sound effect to play
+ * @param  loop     Whether to loop the sound effect continuously
+ * @param  volume   The music volume (relative to the default asset volume)
+ * @param  force    Whether to force another sound to stop.
+ *
+ * @return true if there was an available channel for the sound
+ */
+bool AudioEngine::play(Uint32 handle, const std::shared_ptr<Sound>& sound,
+                       bool loop, float volume, bool force) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    CUAssertLog(handle < _keys.size(), "Sound handle %d is invalid", handle);
 
-    if (isActive(key)) {
+    if (isActive(handle)) {
         if (force) {
-            clear(key,0);
-            removeKey(key);
+            clear(handle,0);
+            removeHandle(handle);
         } else {
             CULogError("Sound effect key is in use");
             return false;
         }
     }
     
-    // Find an empty scheduler
-    int audioID = -1;
-    for(auto it = _slots.begin()+1; audioID == -1 && it != _slots.end(); ++it) {
-        if (!(*it)->isPlaying() && !(*it)->getTailSize()) {
-            audioID = (*it)->getTag();
-        }
-    }
-    
-    // Try again for soon to be deleted.
-    for(auto it = _actives.begin(); audioID == -1 && it != _actives.end(); ++it) {
-        if (it->second->isFadeOut()) {
-            Uint32 tag = it->second->getTag();
-            if (!_slots[tag]->getTailSize()) {
-                audioID = tag;
-            }
+    // Every effect in the mixer must have room for its completion
+    if (_pending >= _completions.capacity()) {
+        collect();
+        if (_pending >= _completions.capacity()) {
+            CULogError("Too many sound effects awaiting collection");
+            return false;
         }
     }
-    
+
+    int audioID = acquireSlot(force);
     if (audioID == -1) {
-        if (force && !_evicts.empty()) {
-            std::string altkey = _evicts.front();
-            audioID = _actives[altkey]->getTag();
-            clear(altkey);
-        } else {
-            // Fail if nothing available
-            CULogError("No available sound channels");
-            return false;
-        }
+        return false;
     }
     //CULog("Slot %d",audioID);
     std::shared_ptr<audio::AudioNode> player = sound->createNode();
-    player->setName("__engine_playback__");
 
+    // The handle is kept with the slot, so the nodes are never named
     std::shared_ptr<AudioFader> fader = wrapInstance(player);
     fader->setGain(volume);
     fader->setTag(audioID);
-    fader->setName(key);
     _slots[audioID]->play(fader, loop ? -1 : 0);
-    _actives.emplace(key,fader);
-    _evicts.push_back(key);
+    if (_voices[audioID] != nullptr) {
+        retireVoice(audioID);
+    }
+    _pending++;
+    _voices[audioID] = fader;
+    _owners[audioID] = handle;
+    _fading[audioID] = false;
+    _playback[audioID] = true;
+    _actives[handle] = fader;
+    _evicts.push_back(handle);
     return true;
 }
 
@@ -703,60 +968,92 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<Sound>& soun
  */
 bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::AudioNode>& graph,
                        bool loop, float volume, bool force) {
+    return play(getHandle(key),graph,loop,volume,force);
+}
+
+/**
+ * Plays the given audio node, and associates it with the specified handle.
+ *
+ * This is the same as playing the node with the key of the handle (see
+ * {@link #getHandle}), except that it does not hash the key.
+ *
+ * @param  handle   The handle for the sound effect
+ * @param  graph    The audio graph to play
+ * @param  loop     Whether to loop the sound effect continuously
+ * @param  volume   The music volume (relative to the default instance volume)
+ * @param  force    Whether to force another sound to stop.
+ *
+ * @return true if there was an available channel for the sound
+ */
+bool AudioEngine::play(Uint32 handle, const std::shared_ptr<audio::AudioNode>& graph,
+                       bool loop, float volume, bool force) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    CUAssertLog(graph->getName() != "__engine_playback__",  "Audio node uses reserved name '__engine_playback__'");
+    CUAssertLog(handle < _keys.size(), "Sound handle %d is invalid", handle);
     CUAssertLog(graph->getName() != "__engine_resampler__", "Audio node uses reserved name '__engine_resampler__'");
 
-    if (isActive(key)) {
+    if (isActive(handle)) {
         if (force) {
-            clear(key,0);
-            removeKey(key);
+            clear(handle,0);
+            removeHandle(handle);
         } else {
             CULogError("Sound effect key is in use");
             return false;
         }
     }
     
-    // Find an empty scheduler
-    int audioID = -1;
-    for(auto it = _slots.begin()+1; audioID == -1 && it != _slots.end(); ++it) {
-        if (!(*it)->isPlaying() && !(*it)->getTailSize()) {
-            audioID = (*it)->getTag();
-        }
-    }
-    
-    // Try again for soon to be deleted.
-    for(auto it = _actives.begin(); audioID == -1 && it != _actives.end(); ++it) {
-        if (it->second->isFadeOut()) {
-            Uint32 tag = it->second->getTag();
-            if (!_slots[tag]->getTailSize()) {
-                audioID = tag;
-            }
+    // Every effect in the mixer must have room for its completion
+    if (_pending >= _completions.capacity()) {
+        collect();
+        if (_pending >= _completions.capacity()) {
+            CULogError("Too many sound effects awaiting collection");
+            return false;
         }
     }
-    
+
+    int audioID = acquireSlot(force);
     if (audioID == -1) {
-        if (force && !_evicts.empty()) {
-            std::string altkey = _evicts.front();
-            audioID = _actives[altkey]->getTag();
-            clear(altkey);
-        } else {
-            // Fail if nothing available
-            CULogError("No available sound channels");
-            return false;
-        }
+        return false;
     }
 
     std::shared_ptr<AudioFader> fader = wrapInstance(graph);
     fader->setGain(volume);
     fader->setTag(audioID);
-    fader->setName(key);
     _slots[audioID]->play(fader, loop ? -1 : 0);
-    _actives.emplace(key,fader);
-    _evicts.push_back(key);
+    if (_voices[audioID] != nullptr) {
+        retireVoice(audioID);
+    }
+    _pending++;
+    _voices[audioID] = fader;
+    _owners[audioID] = handle;
+    _fading[audioID] = false;
+    _playback[audioID] = false;
+    _actives[handle] = fader;
+    _evicts.push_back(handle);
     return true;
 }
 
+/**
+ * Returns the handle for the given key.
+ *
+ * The handle is created the first time a key is used, and it stays valid
+ * for the lifetime of the engine. Looking up the handle once and playing
+ * with it afterwards avoids hashing the key on every call.
+ *
+ * @param  key  the reference key for the sound effect
+ *
+ * @return the handle for the given key.
+ */
+Uint32 AudioEngine::getHandle(const std::string key) {
+    auto it = _handles.find(key);
+    if (it != _handles.end()) {
+        return it->second;
+    }
+    Uint32 handle = (Uint32)_keys.size();
+    _keys.push_back(key);
+    _actives.push_back(nullptr);
+    _handles.emplace(key,handle);
+    return handle;
+}
 
 /**
  * Returns the current state of the sound effect for the given key.
@@ -770,11 +1067,11 @@ bool AudioEngine::play(const std::string key, const std::shared_ptr<audio::Audio
  */
 AudioEngine::State AudioEngine::getState(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) == _actives.end()) {
+    std::shared_ptr<AudioNode> node = findActive(key);
+    if (node == nullptr) {
         return State::INACTIVE;
     }
     
-    std::shared_ptr<AudioNode> node = _actives.at(key);
     std::shared_ptr<audio::AudioScheduler> slot = _slots.at(node->getTag());
     if (!slot->isPlaying()) {
         return State::INACTIVE;
@@ -798,18 +1095,18 @@ AudioEngine::State AudioEngine::getState(const std::string key) const {
  */
 const std::string AudioEngine::getSource(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) == _actives.end()) {
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active == nullptr) {
         return std::string();
     }
 
-    std::shared_ptr<AudioNode> source = accessInstance(_actives.at(key));
-    std::string id = source->getName();
+    std::shared_ptr<AudioNode> source = accessInstance(active);
     AudioPlayer* player = dynamic_cast<AudioPlayer*>(source.get());
-    if (player && id == "__engine_playback__") {
-        id = player->getSource()->getFile();
+    if (player && _playback[active->getTag()]) {
+        return player->getSource()->getFile();
     }
 
-    return id;
+    return source->getName();
 }
 
 /**
@@ -824,8 +1121,9 @@ const std::string AudioEngine::getSource(const std::string key) const {
  */
 bool AudioEngine::isLoop(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioNode> node = _actives.at(key);
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        std::shared_ptr<AudioNode> node = active;
         return _slots.at(node->getTag())->getLoops() != 0;
     }
     return false;
@@ -843,8 +1141,9 @@ bool AudioEngine::isLoop(const std::string key) const {
  */
 void AudioEngine::setLoop(const std::string key, bool loop) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioNode> node = _actives.at(key);
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        std::shared_ptr<AudioNode> node = active;
         _slots[node->getTag()]->setLoops(loop ? -1 : 0);
     }
 }
@@ -867,8 +1166,9 @@ void AudioEngine::setLoop(const std::string key, bool loop) {
  */
 float AudioEngine::getVolume(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        Uint32 tag = _actives.at(key)->getTag();
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        Uint32 tag = active->getTag();
         std::shared_ptr<AudioNode> node = _slots[tag]->getCurrent();
         return node->getGain();
     }
@@ -892,8 +1192,9 @@ float AudioEngine::getVolume(const std::string key) const {
  */
 void AudioEngine::setVolume(const std::string key, float volume) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        Uint32 tag = _actives.at(key)->getTag();
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        Uint32 tag = active->getTag();
         std::shared_ptr<AudioNode> node = _slots[tag]->getCurrent();
         node->setGain(volume);
     }
@@ -921,8 +1222,9 @@ void AudioEngine::setVolume(const std::string key, float volume) {
  */
 float AudioEngine::getPanFactor(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> fader = _actives.at(key);
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        std::shared_ptr<AudioFader> fader = active;
         std::shared_ptr<AudioPanner> panner = std::dynamic_pointer_cast<AudioPanner>(fader->getInput());
         if (panner->getField() == 1) {
             return panner->getPan(0,1)-panner->getPan(0,0);
@@ -955,8 +1257,9 @@ float AudioEngine::getPanFactor(const std::string key) const {
 void AudioEngine::setPanFactor(const std::string key, float pan) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
     CUAssertLog(pan >= -1 && pan <= 1, "Pan value %f is out of range",pan);
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> fader = _actives.at(key);
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        std::shared_ptr<AudioFader> fader = active;
         std::shared_ptr<AudioPanner> panner = std::dynamic_pointer_cast<AudioPanner>(fader->getInput());
         if (panner->getField() == 1) {
             panner->setPan(0,0,0.5-pan/2.0);
@@ -993,8 +1296,9 @@ void AudioEngine::setPanFactor(const std::string key, float pan) {
  */
 float AudioEngine::getDuration(const std::string key) const  {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<audio::AudioNode> source = accessInstance(_actives.at(key));
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        std::shared_ptr<audio::AudioNode> source = accessInstance(active);
         AudioPlayer* player = dynamic_cast<AudioPlayer*>(source.get());
         if (player && player->getName() == "__queue_playback__") {
             return player->getSource()->getDuration();
@@ -1029,8 +1333,9 @@ float AudioEngine::getDuration(const std::string key) const  {
  */
 float AudioEngine::getTimeElapsed(const std::string key) const {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        return _actives.at(key)->getElapsed();
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        return active->getElapsed();
     }
     return -1;
 }
@@ -1054,8 +1359,9 @@ float AudioEngine::getTimeElapsed(const std::string key) const {
  */
 void AudioEngine::setTimeElapsed(const std::string key, float time) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        _actives.at(key)->setElapsed(time);
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        active->setElapsed(time);
     }
 }
 
@@ -1077,8 +1383,9 @@ void AudioEngine::setTimeElapsed(const std::string key, float time) {
  */
 float AudioEngine::geTimeRemaining(const std::string key) const  {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        return _actives.at(key)->getRemaining();
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        return active->getRemaining();
     }
     return -1;
 }
@@ -1100,8 +1407,9 @@ float AudioEngine::geTimeRemaining(const std::string key) const  {
  */
 void AudioEngine::setTimeRemaining(const std::string key, float time) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        _actives.at(key)->setRemaining(time);
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        active->setRemaining(time);
     }
 }
 
@@ -1126,17 +1434,64 @@ void AudioEngine::setTimeRemaining(const std::string key, float time) {
  */
 void AudioEngine::clear(const std::string key,float fade) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> node = _actives.at(key);
+    auto it = _handles.find(key);
+    if (it != _handles.end()) {
+        clear(it->second,fade);
+    }
+}
+
+/**
+ * Removes the sound effect for the given handle, stopping it immediately
+ *
+ * This is the same as clearing the effect with the key of the handle (see
+ * {@link #getHandle}), except that it does not hash the key.
+ *
+ * @param handle    the handle for the sound effect
+ * @param fade      the number of seconds to fade out
+ */
+void AudioEngine::clear(Uint32 handle,float fade) {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    if (isActive(handle)) {
+        const std::shared_ptr<AudioFader>& node = _actives[handle];
+        Uint32 slot = node->getTag();
         // Act only if we are not already fading out
         if (fade == 0) {
-            _slots[node->getTag()]->skip();
-        } else if (!node->isFadeOut()) {
-            _slots[node->getTag()]->setLoops(0);
-            node->fadeOut(fade);
+            _slots[slot]->skip();
+        } else if (!_fading[slot]) {
+            _fading[slot] = true;
+            _slots[slot]->setLoops(0);
+            post(Command::Op::FADE_OUT,slot,node.get(),fade);
         }
     }
+}
 
+/**
+ * Removes the sound effect for the given handle, and frees its slot at once
+ *
+ * Unlike {@link #clear}, the slot is free as soon as this method returns,
+ * so that the next play can take it while the old effect fades out. The
+ * handle is inactive afterwards.
+ *
+ * @param handle    the handle for the sound effect
+ * @param fade      the number of seconds to fade out
+ */
+void AudioEngine::evict(Uint32 handle,float fade) {
+    CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
+    if (!isActive(handle)) {
+        return;
+    }
+    Uint32 slot = _actives[handle]->getTag();
+    bool owned = _voices[slot] == _actives[handle];
+    clear(handle,fade);
+    removeHandle(handle);
+    if (owned) {
+        // The completion of the old effect finds its handle in the retired list
+        retireVoice(slot);
+        _voices[slot] = nullptr;
+        _owners[slot] = NO_HANDLE;
+        _fading[slot] = false;
+        _free.push_back(slot);
+    }
 }
 
 
@@ -1157,9 +1512,9 @@ void AudioEngine::clear(const std::string key,float fade) {
  */
 void AudioEngine::pause(const std::string key,float fade) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> node = _actives.at(key);
-        node->fadePause(fade);
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        post(Command::Op::PAUSE,active->getTag(),active.get(),fade);
     }
 }
 
@@ -1172,9 +1527,9 @@ void AudioEngine::pause(const std::string key,float fade) {
  */
 void AudioEngine::resume(std::string key) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    if (_actives.find(key) != _actives.end()) {
-        std::shared_ptr<AudioFader> node = _actives.at(key);
-        node->resume();
+    std::shared_ptr<AudioFader> active = findActive(key);
+    if (active != nullptr) {
+        post(Command::Op::RESUME,active->getTag(),active.get());
     }
 }
 
@@ -1197,16 +1552,10 @@ void AudioEngine::resume(std::string key) {
  */
 void AudioEngine::clearEffects(float fade) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    for(auto it = _actives.begin(); it != _actives.end(); ++it) {
-        auto node = it->second;
-        if (fade == 0) {
-            _slots[node->getTag()]->skip();
-        } else if (!node->isFadeOut()) {
-            _slots[node->getTag()]->setLoops(0);
-            node->fadeOut(fade);
-        }
+    for(auto it = _evicts.begin(); it != _evicts.end(); ++it) {
+        clear(*it,fade);
+        _actives[*it] = nullptr;
     }
-    _actives.clear();
     _evicts.clear();
 }
 
@@ -1226,12 +1575,8 @@ void AudioEngine::clearEffects(float fade) {
  */
 void AudioEngine::pauseEffects(float fade) {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    for(size_t ii = 0; ii < _capacity; ii++) {
-        if (fade) {
-            _covers[ii]->fadePause(fade);
-        } else {
-            _covers[ii]->pause();
-        }
+    for(Uint32 ii = 0; ii < _capacity; ii++) {
+        post(Command::Op::PAUSE,ii,_covers[ii].get(),fade);
     }
 }
 
@@ -1243,8 +1588,8 @@ void AudioEngine::pauseEffects(float fade) {
  */
 void AudioEngine::resumeEffects() {
     CUAssertLog(_output != nullptr, "Attempt to use an unintiatialized audio engine");
-    for(size_t ii = 0; ii < _capacity; ii++) {
-        _covers[ii]->resume();
+    for(Uint32 ii = 0; ii < _capacity; ii++) {
+        post(Command::Op::RESUME,ii,_covers[ii].get());
     }
 }
 
@@ -50,9 +50,98 @@
 #include <cugl/audio/graph/CUAudioPlayer.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUFiletools.h>
+#include <ATK_math.h>
+#include <algorithm>
+#include <vector>
 
 using namespace cugl;
 
+/** The number of frames in an ADPCM block (each block decodes on its own) */
+#define ADPCM_BLOCK_FRAMES  256
+/** The bytes of a channel in an ADPCM block (a 4 byte header, then the nibbles) */
+#define ADPCM_CHANNEL_BYTES (4+ADPCM_BLOCK_FRAMES/2)
+/** The scale from 16-bit PCM to float */
+#define PCM16_SCALE         (1.0f/32768.0f)
+
+#pragma mark IMA ADPCM
+/** The IMA ADPCM step sizes */
+static const Sint16 ADPCM_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+/** The IMA ADPCM step index changes, indexed by the nibble magnitude */
+static const Sint8 ADPCM_INDICES[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+/**
+ * Decodes an ADPCM nibble, updating the predictor and step index
+ *
+ * @param nibble    The 4-bit code
+ * @param predictor The previous sample (updated to the new one)
+ * @param index     The step index (updated)
+ *
+ * @return the decoded sample
+ */
+static inline Sint16 adpcm_decode(Uint8 nibble, Sint32& predictor, Sint32& index) {
+    Sint32 step = ADPCM_STEPS[index];
+    Sint32 diff = step >> 3;
+    if (nibble & 4) { diff += step; }
+    if (nibble & 2) { diff += step >> 1; }
+    if (nibble & 1) { diff += step >> 2; }
+    predictor += (nibble & 8) ? -diff : diff;
+    predictor = std::min(std::max(predictor,(Sint32)-32768),(Sint32)32767);
+    index = std::min(std::max(index+ADPCM_INDICES[nibble & 7],(Sint32)0),(Sint32)88);
+    return (Sint16)predictor;
+}
+
+/**
+ * Encodes a sample as an ADPCM nibble, updating the predictor and step index
+ *
+ * The predictor tracks the decoder, so that the error does not accumulate.
+ *
+ * @param sample    The sample to encode
+ * @param predictor The previous decoded sample (updated to the new one)
+ * @param index     The step index (updated)
+ *
+ * @return the 4-bit code
+ */
+static inline Uint8 adpcm_encode(Sint16 sample, Sint32& predictor, Sint32& index) {
+    Sint32 step = ADPCM_STEPS[index];
+    Sint32 diff = sample-predictor;
+    Uint8 nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { nibble |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { nibble |= 1; }
+    adpcm_decode(nibble,predictor,index);
+    return nibble;
+}
+
+/**
+ * Returns the float sample as 16-bit PCM (clamped)
+ *
+ * @param value The float sample
+ *
+ * @return the float sample as 16-bit PCM
+ */
+static inline Sint16 pcm16_quantize(float value) {
+    float scaled = value*32768.0f;
+    scaled = std::min(std::max(scaled,-32768.0f),32767.0f);
+    return (Sint16)(scaled < 0 ? scaled-0.5f : scaled+0.5f);
+}
+
+#pragma mark -
+
 #pragma mark Constructors
 
 /**
@@ -64,23 +153,27 @@ using namespace cugl;
 AudioSample::AudioSample() : Sound(),
 _frames(0),
 _stream(false),
-_buffer(nullptr) {
+_buffer(nullptr),
+_format(Format::FLOAT),
+_packed(nullptr) {
     _type = AudioType::UNKNOWN;
 }
 
 /**
- * Initializes a new audio sample for the given file.
+ * Initializes a new audio sample for the given file and format.
  *
  * The choice of buffered or streaming is independent of the file type.
- * If the file is streamed, it will not be loaded into memory.  Otherwise,
- * this initializer will allocate memory to read the asset into memory.
+ * If the file is streamed, it will not be loaded into memory, and the
+ * format is ignored.  Otherwise, this initializer will allocate memory
+ * to read the asset into memory, and then store it in the given format.
  *
  * @param file      The source file for the audio sample
  * @param stream    Wether to stream the audio from the file.
+ * @param format    The in-memory format of the sample
  *
  * @return true if the sound source was initialized successfully
  */
-bool AudioSample::init(const std::string file, bool stream) {
+bool AudioSample::init(const std::string file, bool stream, Format format) {
     std::string path = filetool::normalize_path(file);
     if (!filetool::file_exists(path)) {
         CULogError("Cannot find file %s",path.c_str());
@@ -103,7 +196,13 @@ bool AudioSample::init(const std::string file, bool stream) {
     if (!_stream) {
         _buffer = (float*)SDL_malloc((size_t)(_frames*_channels*sizeof(float)));
         Sint64 size = decoder->decode(_buffer);
-        return size >= 0;
+        if (size < 0) {
+            return false;
+        }
+        _format = format;
+        if (_format != Format::FLOAT) {
+            pack();
+        }
     }
     return true;
 }
@@ -141,6 +240,7 @@ bool AudioSample::init(Uint8 channels, Uint32 rate, Uint32 frames) {
  *      "file":     The path to the source, relative to the asset directory
  *      "stream":   A boolean, indicating whether to stream the sample
  *      "volume":   A float, representing the volume
+ *      "format":   One of "float", "int16" or "adpcm" (in-memory only)
  *
  * All attributes are optional.  There are no required attributes. By default,
  * audio samples are not streamed, meaning they are fully loaded into memory.
@@ -153,7 +253,16 @@ bool AudioSample::init(Uint8 channels, Uint32 rate, Uint32 frames) {
 bool AudioSample::initWithData(const std::shared_ptr<JsonValue>& data) {
     std::string source = data->has("file") ? filetool::normalize_path(data->getString("file","")) : "";
     bool stream = data->getBool("stream",false);
-    if (init(source,stream)) {
+    std::string name = data->getString("format","float");
+    Format format = Format::FLOAT;
+    if (name == "int16") {
+        format = Format::PCM16;
+    } else if (name == "adpcm") {
+        format = Format::ADPCM;
+    } else if (name != "float") {
+        CULogError("Unknown sample format '%s'",name.c_str());
+    }
+    if (init(source,stream,format)) {
         _volume = data->getFloat("volume",1.0f);
         return true;
     }
@@ -175,9 +284,145 @@ void AudioSample::dispose() {
         SDL_free(_buffer);
         _buffer = nullptr;
     }
+    if (_packed != nullptr) {
+        SDL_free(_packed);
+        _packed = nullptr;
+    }
+    _format = Format::FLOAT;
     _type = AudioType::UNKNOWN;
 }
 
+#pragma mark -
+#pragma mark Compact Formats
+/**
+ * Converts the decoded float buffer into the compact format
+ *
+ * This releases the float buffer.
+ */
+void AudioSample::pack() {
+    size_t samples = (size_t)(_frames*_channels);
+    if (_format == Format::PCM16) {
+        Sint16* output = (Sint16*)SDL_malloc(samples*sizeof(Sint16));
+        for(size_t ii = 0; ii < samples; ii++) {
+            output[ii] = pcm16_quantize(_buffer[ii]);
+        }
+        _packed = (Uint8*)output;
+    } else if (_format == Format::ADPCM) {
+        // Each channel of a block starts from a stored sample and step index
+        size_t blocks = (size_t)((_frames+ADPCM_BLOCK_FRAMES-1)/ADPCM_BLOCK_FRAMES);
+        _packed = (Uint8*)SDL_calloc(blocks*_channels,ADPCM_CHANNEL_BYTES);
+        std::vector<Sint32> indices(_channels,0);
+        for(size_t block = 0; block < blocks; block++) {
+            Uint64 start = block*ADPCM_BLOCK_FRAMES;
+            Uint64 count = std::min((Uint64)ADPCM_BLOCK_FRAMES,_frames-start);
+            for(Uint32 ch = 0; ch < _channels; ch++) {
+                Uint8* chunk = _packed+(block*_channels+ch)*ADPCM_CHANNEL_BYTES;
+                Sint32 index = indices[ch];
+                Sint16 first = pcm16_quantize(_buffer[start*_channels+ch]);
+                Sint32 predictor = first;
+                chunk[0] = (Uint8)(first & 0xff);
+                chunk[1] = (Uint8)((first >> 8) & 0xff);
+                chunk[2] = (Uint8)index;
+                for(Uint64 ii = 1; ii < count; ii++) {
+                    Sint16 sample = pcm16_quantize(_buffer[(start+ii)*_channels+ch]);
+                    Uint8 nibble = adpcm_encode(sample,predictor,index);
+                    Uint8* code = chunk+4+(ii-1)/2;
+                    *code |= ((ii-1) & 1) ? (Uint8)(nibble << 4) : nibble;
+                }
+                indices[ch] = index;
+            }
+        }
+    }
+    SDL_free(_buffer);
+    _buffer = nullptr;
+}
+
+/**
+ * Returns the number of bytes of audio data held in memory
+ *
+ * This is 0 for a streamed sample.
+ *
+ * @return the number of bytes of audio data held in memory
+ */
+size_t AudioSample::getMemoryUsage() const {
+    if (_stream) {
+        return 0;
+    }
+    switch (_format) {
+        case Format::FLOAT:
+            return getFloatSize();
+        case Format::PCM16:
+            return (size_t)(_frames*_channels*sizeof(Sint16));
+        case Format::ADPCM:
+            return (size_t)((_frames+ADPCM_BLOCK_FRAMES-1)/ADPCM_BLOCK_FRAMES)*_channels*ADPCM_CHANNEL_BYTES;
+    }
+    return 0;
+}
+
+/**
+ * Reads frames of an in-memory sample as float data, scaled by a gain
+ *
+ * This method converts compact data on the fly. It is safe to call from
+ * the audio thread, as it neither locks nor allocates. It returns the
+ * number of frames read, which is less than requested only at the end
+ * of the sample. It reads nothing from a streamed sample.
+ *
+ * @param offset    The first frame to read
+ * @param buffer    The buffer to store the frames (channels * frames)
+ * @param frames    The number of frames to read
+ * @param gain      The gain to apply to the frames
+ *
+ * @return the number of frames read
+ */
+Uint32 AudioSample::read(Uint64 offset, float* buffer, Uint32 frames, float gain) const {
+    if (_stream || offset >= _frames) {
+        return 0;
+    }
+    Uint32 amt = (Uint32)std::min((Uint64)frames,_frames-offset);
+    switch (_format) {
+        case Format::FLOAT:
+            ATK_VecScale(_buffer+offset*_channels,gain,buffer,amt*_channels);
+            break;
+        case Format::PCM16:
+            ATK_VecScaleS16((const Sint16*)_packed+offset*_channels,gain*PCM16_SCALE,buffer,amt*_channels);
+            break;
+        case Format::ADPCM:
+        {
+            // Decode from the start of each block (reads of whole blocks skip nothing)
+            float scale = gain*PCM16_SCALE;
+            Uint64 frame = offset;
+            Uint64 last  = offset+amt;
+            while (frame < last) {
+                Uint64 block = frame/ADPCM_BLOCK_FRAMES;
+                Uint64 start = block*ADPCM_BLOCK_FRAMES;
+                Uint64 stop  = std::min(start+ADPCM_BLOCK_FRAMES,last);
+                for(Uint32 ch = 0; ch < _channels; ch++) {
+                    const Uint8* chunk = _packed+(block*_channels+ch)*ADPCM_CHANNEL_BYTES;
+                    Sint32 predictor = (Sint16)(chunk[0] | (chunk[1] << 8));
+                    Sint32 index = chunk[2];
+                    float* output = buffer+(frame-offset)*_channels+ch;
+                    if (frame == start) {
+                        *output = predictor*scale;
+                        output += _channels;
+                    }
+                    for(Uint64 ii = 1; ii < stop-start; ii++) {
+                        Uint8 code = chunk[4+(ii-1)/2];
+                        Uint8 nibble = ((ii-1) & 1) ? (code >> 4) : (code & 0xf);
+                        Sint16 sample = adpcm_decode(nibble,predictor,index);
+                        if (start+ii >= frame) {
+                            *output = sample*scale;
+                            output += _channels;
+                        }
+                    }
+                }
+                frame = stop;
+            }
+        }
+            break;
+    }
+    return amt;
+}
+
 #pragma mark -
 #pragma mark Decoder Supports
 /**
@@ -47,6 +47,7 @@
 #include <cugl/audio/graph/CUAudioMixer.h>
 #include <cugl/audio/CUAudioDevices.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUProfiler.h>
 #include <atomic>
 #include <SDL_atk.h>
 
@@ -294,10 +295,11 @@ bool AudioMixer::completed() {
  * @return the actual number of frames read
  */
 Uint32 AudioMixer::read(float* buffer, Uint32 frames) {
+    CUProfileZone("AudioMixer::read");
     std::memset(buffer,0,frames*_channels*sizeof(float));
     Uint32 actual = 0;
     if (!_paused.load(std::memory_order_relaxed)) {
-        std::lock_guard<std::mutex> lock(_mutex);
+        // No lock: the audio thread must never wait on the main thread
         std::shared_ptr<AudioNode> temp;
         Uint32 remain = frames;
         float* output = buffer;
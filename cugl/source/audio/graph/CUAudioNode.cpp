@@ -84,6 +84,7 @@ AudioNode::AudioNode() : _channels(0), _sampling(0) {
     _classname  = "AudioNode";
     _callback = nullptr;
     _calling  = false;
+    _immediate = false;
     _hashOfName = 0;
     _ndgain = 1.0f;
     _paused = false;
@@ -159,6 +160,7 @@ void AudioNode::dispose() {
     _readsize  = 0;
     _callback = nullptr;
     _calling.store(false);
+    _immediate.store(false);
     _ndgain.store(1.0f);
     _polling.store(false);
     _paused.store(false);
@@ -278,7 +280,28 @@ AudioNode::Callback AudioNode::getCallback() {
  * @param callback  the callback function for this node
  */
 void AudioNode::setCallback(Callback callback) {
+    setCallback(callback,false);
+}
+
+/**
+ * Sets the callback function for this node
+ *
+ * If immediate is false, this is the same as {@link #setCallback}. If
+ * it is true, the callback is invoked directly in the audio thread when
+ * the action takes place, instead of being scheduled for the main
+ * thread. Scheduling a callback locks the application and allocates
+ * memory, which the audio thread should avoid. An immediate callback
+ * must be quick and must not lock or allocate either; typically it only
+ * pushes the action onto a {@link SPSCQueue} read by the main thread.
+ *
+ * The callback should be set before the node is attached to a graph.
+ *
+ * @param callback  the callback function for this node
+ * @param immediate whether to invoke the callback in the audio thread
+ */
+void AudioNode::setCallback(Callback callback, bool immediate) {
     _callback = callback;
+    _immediate.store(immediate, std::memory_order_relaxed);
     _calling.store(callback != nullptr, std::memory_order_release);
 }
 
@@ -294,8 +317,17 @@ void AudioNode::setCallback(Callback callback) {
  * might change during that delay.  This is a wrapper to ensure that this
  * potential race condition happens gracefully and does not have any
  * unexpected side effects.
+ *
+ * If the callback was set as immediate, it is called right away in the
+ * audio thread instead.
  */
 void AudioNode::notify(const std::shared_ptr<AudioNode>& node, AudioNode::Action action) {
+    if (_immediate.load(std::memory_order_acquire)) {
+        if (_callback) {
+            _callback(node,action);
+        }
+        return;
+    }
     Application::get()->schedule([=] {
         if (_callback) {
             _callback(node,action);
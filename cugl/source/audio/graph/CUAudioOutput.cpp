@@ -50,6 +50,7 @@
 #include <cugl/audio/CUAudioDevices.h>
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUTimestamp.h>
+#include <cugl/util/CUProfiler.h>
 #include <atomic>
 #include <cstring>
 
@@ -864,6 +865,15 @@ Uint32 AudioOutput::read(float* buffer, Uint32 frames) {
 }
 
 Uint32 AudioOutput::poll(Uint8* stream, int len) {
+#if CU_PROFILING
+    // The device callback thread is not ours, so name it on first use
+    static thread_local bool named = false;
+    if (!named) {
+        CUProfileThread("audio");
+        named = true;
+    }
+#endif
+    CUProfileZone("AudioOutput::poll");
     Uint32 wordsize = SDL_AUDIO_BITSIZE(_audiospec.format)/8;
     Uint32 take = 0;
     Uint32 frames = len/(_audiospec.channels*wordsize);
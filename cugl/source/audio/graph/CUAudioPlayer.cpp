@@ -54,10 +54,123 @@
 #include <cugl/util/CUDebug.h>
 #include <cugl/util/CUTimestamp.h>
 #include <SDL_atk.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <vector>
 
 using namespace cugl::audio;
 using namespace cugl;
 
+/** The default number of seconds to decode ahead */
+#define PREFETCH_DEFAULT    0.5
+/** How long the stream worker sleeps when every ring is full (ms) */
+#define PREFETCH_POLL       5
+
+double AudioPlayer::_prefetch = PREFETCH_DEFAULT;
+std::atomic<Uint64> AudioPlayer::_allUnderruns(0);
+
+#pragma mark -
+#pragma mark Stream Worker
+namespace {
+/**
+ * The background thread decoding the prefetched players.
+ *
+ * There is one worker for all players, started with the first prefetched
+ * player. It only holds weak references, so a player is dropped from the
+ * worker once the audio graph releases it. The audio thread never touches
+ * the worker or its lock.
+ */
+class StreamWorker {
+private:
+    /** The lock for the player list */
+    std::mutex _mutex;
+    /** Wakes the worker when a player is added (or on shutdown) */
+    std::condition_variable _wakeup;
+    /** The worker thread */
+    std::thread _thread;
+    /** Whether the worker is running */
+    bool _running;
+    /** The players to decode */
+    std::vector<std::weak_ptr<AudioPlayer>> _players;
+
+    /**
+     * Decodes the players until shutdown.
+     */
+    void run() {
+        std::vector<std::shared_ptr<AudioPlayer>> active;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_running) {
+            for(auto it = _players.begin(); it != _players.end(); ) {
+                std::shared_ptr<AudioPlayer> player = it->lock();
+                if (player == nullptr) {
+                    it = _players.erase(it);
+                } else {
+                    active.push_back(player);
+                    ++it;
+                }
+            }
+            lock.unlock();
+            bool busy = false;
+            for(auto it = active.begin(); it != active.end(); ++it) {
+                busy = (*it)->prefetch() || busy;
+            }
+            // Release the players outside of the lock, as this may delete them
+            active.clear();
+            lock.lock();
+            if (!busy && _running) {
+                _wakeup.wait_for(lock,std::chrono::milliseconds(PREFETCH_POLL));
+            }
+        }
+    }
+
+public:
+    /** Creates an idle worker */
+    StreamWorker() : _running(false) {}
+
+    /** Stops and joins the worker thread */
+    ~StreamWorker() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _wakeup.notify_one();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    /**
+     * Adds a player to the worker, starting the thread if necessary.
+     *
+     * @param player    The player to decode
+     */
+    void add(const std::weak_ptr<AudioPlayer>& player) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _players.push_back(player);
+            if (!_running) {
+                _running = true;
+                _thread = std::thread([this] { run(); });
+            }
+        }
+        _wakeup.notify_one();
+    }
+
+    /**
+     * Returns the stream worker singleton
+     *
+     * @return the stream worker singleton
+     */
+    static StreamWorker& get() {
+        static StreamWorker worker;
+        return worker;
+    }
+};
+}
+
+#pragma mark -
 #pragma mark Constructors
 /**
  * Creates a degenerate audio player with no associated source.
@@ -68,14 +181,23 @@ using namespace cugl;
 AudioPlayer::AudioPlayer() : AudioNode(),
 _offset(0),
 _marked(0),
-_buffer(nullptr),
 _decoder(nullptr),
 _source(nullptr),
 _chunker(nullptr),
 _chklimt(0),
 _chklast(0),
 _chksize(0),
-_dirty(false) {
+_dirty(false),
+_intro(nullptr),
+_introsize(0),
+_ring(nullptr),
+_ringsize(0),
+_wantGen(0),
+_wantFrame(0),
+_fillGen(0),
+_ringBase(0),
+_ringWrite(0),
+_underruns(0) {
     _classname = "AudioPlayer";
 }
 
@@ -92,7 +214,6 @@ _dirty(false) {
 bool AudioPlayer::init(const std::shared_ptr<AudioSample>& source) {
     if (AudioNode::init(source->getChannels(),source->getRate())) {
         _source = source;
-        _buffer = source->getBuffer();
         _dirty  = false;
         
         if (source->isStreamed()) {
@@ -104,6 +225,40 @@ bool AudioPlayer::init(const std::shared_ptr<AudioSample>& source) {
                 _chklast  = _chksize;
                 _chunker  = (float*)malloc(_chksize*channels*sizeof(float));
                 std::memset(_chunker,0,_chksize*channels*sizeof(float));
+
+                // Only a player owned by a shared pointer can be handed to the worker
+                std::weak_ptr<AudioPlayer> self = std::static_pointer_cast<AudioPlayer>(weak_from_this().lock());
+                Uint32 ahead = (Uint32)(_prefetch*source->getRate());
+                if (ahead > 0 && !self.expired()) {
+                    // Decode the start now, so the player can start without the worker
+                    _introsize = (Uint32)std::min((Uint64)ahead,(Uint64)source->getLength());
+                    _intro = (float*)malloc(_introsize*channels*sizeof(float));
+                    Uint32 pos = 0;
+                    _decoder->setPage(0);
+                    while (pos < _introsize) {
+                        _chklimt = _decoder->pagein(_chunker);
+                        _chklast = 0;
+                        if (_chklimt == 0) {
+                            break;
+                        }
+                        Uint32 avail = std::min(_chklimt,_introsize-pos);
+                        std::memcpy(_intro+pos*channels,_chunker,avail*channels*sizeof(float));
+                        _chklast = avail;
+                        pos += avail;
+                    }
+                    _introsize = pos;
+
+                    _ringsize = 1;
+                    while (_ringsize < 2*std::max(ahead,_chksize)) {
+                        _ringsize <<= 1;
+                    }
+                    _ring = (float*)malloc(_ringsize*channels*sizeof(float));
+                    _ringBase.store(_introsize,std::memory_order_relaxed);
+                    _ringWrite.store(_introsize,std::memory_order_relaxed);
+                    _wantGen.store(0,std::memory_order_relaxed);
+                    _fillGen.store(0,std::memory_order_relaxed);
+                    StreamWorker::get().add(self);
+                }
             }
         }
         return true;
@@ -119,12 +274,12 @@ bool AudioPlayer::init(const std::shared_ptr<AudioSample>& source) {
  */
 void AudioPlayer::dispose() {
     if (_booted) {
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
         AudioNode::dispose();
         _source = nullptr;
         _decoder = nullptr;
         _offset.store(0);
         _marked.store(0);
-        _buffer  = nullptr;
         _calling.store(false);
         _callback = nullptr;
         _chksize = 0;
@@ -134,6 +289,22 @@ void AudioPlayer::dispose() {
             free(_chunker);
             _chunker = nullptr;
         }
+        if (_intro) {
+            free(_intro);
+            _intro = nullptr;
+        }
+        if (_ring) {
+            free(_ring);
+            _ring = nullptr;
+        }
+        _introsize = 0;
+        _ringsize  = 0;
+        _wantGen.store(0);
+        _wantFrame.store(0);
+        _fillGen.store(0);
+        _ringBase.store(0);
+        _ringWrite.store(0);
+        _underruns.store(0);
     }
 }
 
@@ -170,12 +341,16 @@ Uint32 AudioPlayer::read(float* buffer, Uint32 frames) {
     }
     
     Uint32 amt = frames;
-    if (_buffer) {
-        float* input  = _buffer;
-        input += off*_source->getChannels();
-    
-        amt = (Uint32)(off+amt > _source->getLength() ? _source->getLength()-off : amt);
-        std::memcpy(buffer,input,sizeof(float)*amt*_source->getChannels());
+    if (!_source->isStreamed()) {
+        // The sample converts its format and applies the gain in one pass
+        amt = _source->read(off,buffer,frames,_ndgain.load(std::memory_order_relaxed));
+        _offset.store(off+amt,std::memory_order_release);
+        _polling.store(false);
+        return amt;
+    } else if (_ring) {
+        amt = readAhead(off,buffer,frames);
+        _polling.store(false);
+        return amt;
     } else {
         if (_dirty.load(std::memory_order_acquire)) {
             scan(off);
@@ -209,6 +384,66 @@ Uint32 AudioPlayer::read(float* buffer, Uint32 frames) {
     return amt;
 }
 
+/**
+ * Reads frames decoded by the stream worker into the given buffer
+ *
+ * AUDIO THREAD ONLY: Users should never access this method directly.
+ *
+ * The frames come from the intro or the ring. If the worker has not decoded
+ * them yet, the rest of the buffer is silence and the read position stays
+ * put, so playback resumes where it stopped once the worker catches up.
+ *
+ * @param off       The current read position
+ * @param buffer    The read buffer to store the results
+ * @param frames    The maximum number of frames to read
+ *
+ * @return the actual number of frames read
+ */
+Uint32 AudioPlayer::readAhead(Uint64 off, float* buffer, Uint32 frames) {
+    if (_dirty.load(std::memory_order_acquire)) {
+        // Only this thread changes the generation, so the worker sees it whole
+        off = std::min(_offset.load(std::memory_order_acquire),(Uint64)_source->getLength());
+        _wantFrame.store(off,std::memory_order_relaxed);
+        _wantGen.store(_wantGen.load(std::memory_order_relaxed)+1,std::memory_order_release);
+        _dirty.store(false,std::memory_order_relaxed);
+    }
+
+    float gain = _ndgain.load(std::memory_order_relaxed);
+    Uint32 amt = (Uint32)std::min((Uint64)frames,(Uint64)_source->getLength()-off);
+    bool current = _fillGen.load(std::memory_order_acquire) == _wantGen.load(std::memory_order_relaxed);
+    Uint64 base  = _ringBase.load(std::memory_order_relaxed);
+    Uint64 write = _ringWrite.load(std::memory_order_acquire);
+    Uint32 mask  = _ringsize-1;
+
+    Uint32 done = 0;
+    while (done < amt) {
+        const float* src = nullptr;
+        Uint32 avail = 0;
+        if (off < _introsize) {
+            src = _intro+off*_channels;
+            avail = std::min(amt-done,(Uint32)(_introsize-off));
+        } else if (current && off >= base && off < write) {
+            Uint32 pos = (Uint32)(off & mask);
+            src = _ring+pos*_channels;
+            avail = std::min({amt-done,(Uint32)(write-off),_ringsize-pos});
+        } else {
+            break;
+        }
+        ATK_VecScale(src,gain,buffer+done*_channels,avail*_channels);
+        done += avail;
+        off  += avail;
+    }
+
+    if (done < amt) {
+        std::memset(buffer+done*_channels,0,(frames-done)*_channels*sizeof(float));
+        _underruns.fetch_add(1,std::memory_order_relaxed);
+        _allUnderruns.fetch_add(1,std::memory_order_relaxed);
+        amt = frames;
+    }
+    _offset.store(off,std::memory_order_release);
+    return amt;
+}
+
 /**
  * Returns true if this audio node has no more data.
  *
@@ -408,3 +643,59 @@ void AudioPlayer::scan(Uint64 frame) {
     _chklimt = (Uint32)_decoder->pagein(_chunker);
     _chklast = (Uint32)(_chklimt == 0 ? _chksize : frame % _chksize);
 }
+
+#pragma mark -
+#pragma mark Prefetching
+/**
+ * Decodes ahead of the read position, if there is room in the ring.
+ *
+ * WORKER THREAD ONLY: This is called by the stream worker, and should
+ * never be called by the user.
+ *
+ * @return true if any frames were decoded
+ */
+bool AudioPlayer::prefetch() {
+    std::lock_guard<std::mutex> lock(_prefetchMutex);
+    if (_ring == nullptr) {
+        return false;
+    }
+
+    bool busy = false;
+    Uint64 length = (Uint64)_source->getLength();
+    Uint32 gen = _wantGen.load(std::memory_order_acquire);
+    if (gen != _fillGen.load(std::memory_order_relaxed)) {
+        // Start over from the new position (the intro covers the start)
+        Uint64 start = std::max(_wantFrame.load(std::memory_order_relaxed),(Uint64)_introsize);
+        start = std::min(start,length);
+        scan(start);
+        _ringBase.store(start,std::memory_order_relaxed);
+        _ringWrite.store(start,std::memory_order_relaxed);
+        _fillGen.store(gen,std::memory_order_release);
+        busy = true;
+    }
+
+    Uint32 mask  = _ringsize-1;
+    Uint64 write = _ringWrite.load(std::memory_order_relaxed);
+    Uint64 read  = std::max(_offset.load(std::memory_order_acquire),_ringBase.load(std::memory_order_relaxed));
+    while (read <= write && write < length && write-read < _ringsize) {
+        if (_wantGen.load(std::memory_order_relaxed) != gen) {
+            break;
+        }
+        if (_chklast >= _chklimt) {
+            _chklimt = _decoder->pagein(_chunker);
+            _chklast = 0;
+            if (_chklimt == 0) {
+                break;
+            }
+        }
+        Uint32 pos = (Uint32)(write & mask);
+        Uint32 avail = std::min({_chklimt-_chklast,(Uint32)(_ringsize-(write-read)),_ringsize-pos});
+        std::memcpy(_ring+pos*_channels,_chunker+_chklast*_channels,avail*_channels*sizeof(float));
+        _chklast += avail;
+        write += avail;
+        _ringWrite.store(write,std::memory_order_release);
+        read = std::max(_offset.load(std::memory_order_acquire),_ringBase.load(std::memory_order_relaxed));
+        busy = true;
+    }
+    return busy;
+}
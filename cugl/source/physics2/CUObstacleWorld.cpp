@@ -49,6 +49,8 @@
 #include <cugl/physics2/CUObstacleWorld.h>
 #include <cugl/physics2/CUObstacle.h>
 #include <cugl/physics2/CUJoint.h>
+#include <cugl/util/CUProfiler.h>
+#include <sstream>
 
 using namespace cugl;
 using namespace cugl::physics2;
@@ -166,7 +168,11 @@ ObstacleWorld::ObstacleWorld() :
 _world(nullptr),
 _collide(false),
 _filters(false),
-_destroy(false)
+_destroy(false),
+_statsEnabled(false),
+_raycasts(0),
+_queries(0),
+_queryNanos(0)
 {
     _lockstep   = false;
     _stepssize  = DEFAULT_WORLD_STEP;
@@ -438,8 +444,16 @@ void ObstacleWorld::setGravity(const Vec2 gravity) {
  * @param dt    Number of seconds since last animation frame
  */
 void ObstacleWorld::update(float dt) {
+    CUProfileZone("ObstacleWorld::update");
     // Turn the physics engine crank.
-    _world->Step((_lockstep ? _stepssize : dt),_itvelocity,_itposition);
+    if (_statsEnabled) {
+        auto start = std::chrono::steady_clock::now();
+        _world->Step((_lockstep ? _stepssize : dt),_itvelocity,_itposition);
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now()-start;
+        computeStats(elapsed.count());
+    } else {
+        _world->Step((_lockstep ? _stepssize : dt),_itvelocity,_itposition);
+    }
     
     // Post process all objects after physics (this updates graphics)
     for(auto it = _obstacles.begin() ; it != _obstacles.end(); ++it) {
@@ -457,6 +471,136 @@ void ObstacleWorld::update(float dt) {
     }
 }
 
+
+#pragma mark -
+#pragma mark Statistics
+/**
+ * Creates an empty set of statistics
+ */
+ObstacleWorld::Stats::Stats() :
+stepTime(0),
+bodies(0),
+awakeBodies(0),
+contacts(0),
+touching(0),
+proxies(0),
+raycasts(0),
+queries(0),
+queryTime(0) {
+    profile = b2Profile();
+    bodiesByCategory.fill(0);
+    contactsByCategory.fill(0);
+    proxiesByCategory.fill(0);
+}
+
+/**
+ * Returns the column names for {@link toCSV}.
+ *
+ * @return the column names for {@link toCSV}.
+ */
+std::string ObstacleWorld::Stats::getCSVHeader() {
+    std::stringstream ss;
+    ss << "step,collide,solve,solveTOI,broadphase,stepTime,bodies,awakeBodies,contacts,touching,proxies,";
+    ss << "raycasts,queries,queryTime";
+    const char* groups[] = { "bodies", "contacts", "proxies" };
+    for (const char* group : groups) {
+        for (int ii = 0; ii < 16; ii++) {
+            ss << "," << group << "_0x" << std::hex << (1 << ii) << std::dec;
+        }
+    }
+    return ss.str();
+}
+
+/**
+ * Returns these statistics as a single comma-separated row.
+ *
+ * @return these statistics as a single comma-separated row.
+ */
+std::string ObstacleWorld::Stats::toCSV() const {
+    std::stringstream ss;
+    ss << profile.step << "," << profile.collide << "," << profile.solve << ",";
+    ss << profile.solveTOI << "," << profile.broadphase << "," << stepTime << ",";
+    ss << bodies << "," << awakeBodies << "," << contacts << "," << touching << "," << proxies << ",";
+    ss << raycasts << "," << queries << "," << queryTime;
+    const std::array<int,16>* groups[] = { &bodiesByCategory, &contactsByCategory, &proxiesByCategory };
+    for (const std::array<int,16>* group : groups) {
+        for (int ii = 0; ii < 16; ii++) {
+            ss << "," << (*group)[ii];
+        }
+    }
+    return ss.str();
+}
+
+/**
+ * Sets whether this world gathers statistics.
+ *
+ * Gathering statistics costs a pass over the bodies and contacts after
+ * every step, plus a clock read around every ray-cast and query. It is
+ * off by default.
+ *
+ * @param  flag whether this world gathers statistics.
+ */
+void ObstacleWorld::setStatsEnabled(bool flag) {
+    _statsEnabled = flag;
+    _stats = Stats();
+    _raycasts = 0;
+    _queries = 0;
+    _queryNanos = 0;
+}
+
+/**
+ * Recomputes the statistics after a step that took the given time.
+ *
+ * @param stepTime  the wall-clock time of the step in milliseconds
+ */
+void ObstacleWorld::computeStats(float stepTime) {
+    _stats = Stats();
+    _stats.profile = _world->GetProfile();
+    _stats.stepTime = stepTime;
+    _stats.bodies = _world->GetBodyCount();
+    _stats.contacts = _world->GetContactCount();
+    _stats.proxies = _world->GetProxyCount();
+    _stats.raycasts = _raycasts.exchange(0);
+    _stats.queries = _queries.exchange(0);
+    _stats.queryTime = _queryNanos.exchange(0)/1000000.0f;
+    
+    for (b2Body* body = _world->GetBodyList(); body; body = body->GetNext()) {
+        if (body->IsAwake()) {
+            _stats.awakeBodies++;
+        }
+        uint16 categories = 0;
+        for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext()) {
+            uint16 bits = f->GetFilterData().categoryBits;
+            categories |= bits;
+            if (body->IsEnabled()) {
+                int children = f->GetShape()->GetChildCount();
+                for (int ii = 0; ii < 16; ii++) {
+                    if (bits & (1 << ii)) {
+                        _stats.proxiesByCategory[ii] += children;
+                    }
+                }
+            }
+        }
+        for (int ii = 0; ii < 16; ii++) {
+            if (categories & (1 << ii)) {
+                _stats.bodiesByCategory[ii]++;
+            }
+        }
+    }
+    for (b2Contact* c = _world->GetContactList(); c; c = c->GetNext()) {
+        if (!c->IsTouching()) {
+            continue;
+        }
+        _stats.touching++;
+        uint16 bits = c->GetFixtureA()->GetFilterData().categoryBits | c->GetFixtureB()->GetFilterData().categoryBits;
+        for (int ii = 0; ii < 16; ii++) {
+            if (bits & (1 << ii)) {
+                _stats.contactsByCategory[ii]++;
+            }
+        }
+    }
+}
+
 /**
  * Returns true if the object is in bounds.
  *
@@ -564,7 +708,13 @@ void ObstacleWorld::queryAABB(std::function<bool(b2Fixture* fixture)> callback,
     b2box.upperBound.Set(aabb.origin.x+aabb.size.width, aabb.origin.y+aabb.size.height);
     QueryProxy proxy;
     proxy.onQuery = callback;
-    _world->QueryAABB(&proxy, b2box);
+    if (_statsEnabled) {
+        auto start = std::chrono::steady_clock::now();
+        _world->QueryAABB(&proxy, b2box);
+        recordQuery(start, 0, 1);
+    } else {
+        _world->QueryAABB(&proxy, b2box);
+    }
 }
 
 /** 
@@ -582,5 +732,11 @@ void ObstacleWorld::rayCast(std::function<float(b2Fixture* fixture, const Vec2 p
                             const Vec2 point1, const Vec2 point2) const {
     RaycastProxy proxy;
     proxy.onQuery = callback;
-    _world->RayCast(&proxy, b2Vec2(point1.x,point1.y), b2Vec2(point2.x,point2.y));
+    if (_statsEnabled) {
+        auto start = std::chrono::steady_clock::now();
+        _world->RayCast(&proxy, b2Vec2(point1.x,point1.y), b2Vec2(point2.x,point2.y));
+        recordQuery(start, 1, 0);
+    } else {
+        _world->RayCast(&proxy, b2Vec2(point1.x,point1.y), b2Vec2(point2.x,point2.y));
+    }
 }
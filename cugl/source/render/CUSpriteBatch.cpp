@@ -45,6 +45,7 @@
 //
 #include <cugl/math/cu_math.h>
 #include <cugl/util/CUDebug.h>
+#include <cugl/util/CUProfiler.h>
 #include <cugl/render/CUSpriteBatch.h>
 #include <cugl/render/CUVertexBuffer.h>
 #include <cugl/render/CUTexture.h>
@@ -120,6 +121,42 @@ using namespace cugl;
 /** All values have changed */
 #define DIRTY_ALL_VALS          0xFFF
 
+/** The number of full batches in a stream region */
+#define STREAM_BATCHES  2
+/** The number of regions in the stream ring */
+#define STREAM_REGIONS  3
+
+/** The number of runs a deferred item looks back through for a matching state */
+#define DEFER_LOOKBACK  16
+/** The most overlap tests for moving one deferred item into an earlier run */
+#define DEFER_TESTS     256
+/** Marks the end of a run of deferred items */
+#define DEFER_NONE      0xFFFFFFFF
+
+/** The drawing command of a context of quad instances (not an OpenGL command) */
+#define COMMAND_QUADS   0xFFFF
+/** The number of quad instances per vertex of capacity */
+#define QUAD_RATIO      4
+
+/** The corners of the unit square, in the order of the shader (gl_VertexID) */
+static const GLfloat QUAD_CORNERS[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+/** The indices of a quad instance */
+static const GLuint QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+
+/**
+ * Returns true if the two bounding boxes overlap
+ *
+ * Boxes that only share an edge do not overlap.
+ *
+ * @param a The first box (min x, min y, max x, max y)
+ * @param b The second box (min x, min y, max x, max y)
+ *
+ * @return true if the two bounding boxes overlap
+ */
+static inline bool overlaps(const GLfloat* a, const GLfloat* b) {
+    return a[0] < b[2] && b[0] < a[2] && a[1] < b[3] && b[1] < a[3];
+}
+
 /**
  * Fills poly with a mesh defining the given rectangle.
  *
@@ -201,23 +238,7 @@ public:
      * @param copy  The uniforms to copy
      */
     Context(Context* copy) {
-        first = copy->first;
-        last  = copy->last;
-        type  = copy->type;
-        command  = copy->command;
-        blendEq  = copy->blendEq;
-        srcRGB   = copy->srcRGB;
-        srcAlpha = copy->srcAlpha;
-        dstRGB   = copy->dstRGB;
-        dstAlpha = copy->dstAlpha;
-        perspective = copy->perspective;
-        stencil  = copy->stencil;
-        cleared  = STENCIL_NONE; // DO NOT COPY
-        texture  = copy->texture;
-        blockptr = copy->blockptr;
-        zDepth = copy->zDepth;
-        blur  = copy->blur;
-        dirty = 0;
+        set(copy);
     }
     
     /**
@@ -242,6 +263,33 @@ public:
         type = 0;
     }
     
+    /**
+     * Sets this context to a copy of the given uniforms
+     *
+     * This allows a spare context to be reused instead of allocated.
+     *
+     * @param copy  The uniforms to copy
+     */
+    void set(const Context* copy) {
+        first = copy->first;
+        last  = copy->last;
+        type  = copy->type;
+        command  = copy->command;
+        blendEq  = copy->blendEq;
+        srcRGB   = copy->srcRGB;
+        srcAlpha = copy->srcAlpha;
+        dstRGB   = copy->dstRGB;
+        dstAlpha = copy->dstAlpha;
+        perspective = copy->perspective;
+        stencil  = copy->stencil;
+        cleared  = STENCIL_NONE; // DO NOT COPY
+        texture  = copy->texture;
+        blockptr = copy->blockptr;
+        zDepth = copy->zDepth;
+        blur  = copy->blur;
+        dirty = 0;
+    }
+    
     /**
      *
      * Resets this context to its default values
@@ -258,7 +306,10 @@ public:
         srcAlpha = GL_SRC_ALPHA;
         dstRGB   = GL_ONE_MINUS_SRC_ALPHA;
         dstAlpha = GL_ONE_MINUS_SRC_ALPHA;
-        perspective = std::make_shared<Mat4>();
+        // Reuse the matrix unless a recorded context still shares it
+        if (perspective == nullptr || perspective.use_count() > 1) {
+            perspective = std::make_shared<Mat4>();
+        }
         perspective->setIdentity();
         stencil  = StencilEffect::NATIVE;
         cleared  = STENCIL_NONE;
@@ -306,6 +357,26 @@ public:
     GLuint dirty;
 };
 
+/**
+ * A textured rectangle drawn as an instance.
+ *
+ * The instance maps the unit square to the rectangle, so the vertex shader
+ * (or the CPU fallback) can expand it into the four corners of the quad.
+ * The corner (u,v) of the unit square is the point with coordinates
+ * x = xrow . (u,v,1) and y = yrow . (u,v,1), and texture coordinates
+ * (mix(minS,maxS,u),mix(maxT,minT,v)).
+ */
+struct SpriteBatch::QuadInstance {
+    /** The first row of the affine map */
+    GLfloat xrow[3];
+    /** The second row of the affine map */
+    GLfloat yrow[3];
+    /** The texture region (minS, maxS, maxT, minT) */
+    GLfloat texrect[4];
+    /** The packed color */
+    GLuint color;
+};
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -316,9 +387,19 @@ public:
 SpriteBatch::SpriteBatch() :
 _initialized(false),
 _active(false),
+_headless(false),
+_streaming(false),
+_deferred(false),
+_instancing(false),
+_quadShader(false),
 _inflight(false),
 _vertData(nullptr),
 _indxData(nullptr),
+_quadData(nullptr),
+_quadSort(nullptr),
+_quadMax(0),
+_quadSize(0),
+_quadsBound(false),
 _color(Color4f::WHITE),
 _context(nullptr),
 _vertMax(0),
@@ -326,9 +407,17 @@ _vertSize(0),
 _indxMax(0),
 _indxSize(0),
 _vertTotal(0),
-_callTotal(0) {
+_callTotal(0),
+_byteTotal(0),
+_specTotal(0),
+_sortKey(0),
+_itemKey(0),
+_itemFirst(0),
+_itemVert(0),
+_sortData(nullptr) {
     _shader = nullptr;
     _vertbuff = nullptr;
+    _quadbuff = nullptr;
     _unifbuff = nullptr;
     _gradient = nullptr;
     _scissor  = nullptr;
@@ -346,27 +435,63 @@ void SpriteBatch::dispose() {
     if (_indxData) {
         delete[] _indxData; _indxData = nullptr;
     }
+    if (_sortData) {
+        delete[] _sortData; _sortData = nullptr;
+    }
+    if (_quadData) {
+        delete[] _quadData; _quadData = nullptr;
+    }
+    if (_quadSort) {
+        delete[] _quadSort; _quadSort = nullptr;
+    }
+    _items.clear();
+    _order.clear();
+    _scratch.clear();
+    _runs.clear();
+    _sortKey = 0;
+    _itemKey = 0;
+    _itemFirst = 0;
+    _itemVert  = 0;
     if (_context != nullptr) {
         delete _context; _context = nullptr;
     }
+    unwind();
+    for(auto it = _spare.begin(); it != _spare.end(); ++it) {
+        delete *it;
+    }
+    _spare.clear();
     _shader = nullptr;
     _vertbuff = nullptr;
+    _quadbuff = nullptr;
     _unifbuff = nullptr;
     _gradient = nullptr;
     _scissor  = nullptr;
+    _scissorData = nullptr;
+    _textRuns.clear();
     
     _vertMax  = 0;
     _vertSize = 0;
     _indxMax  = 0;
     _indxSize = 0;
+    _quadMax  = 0;
+    _quadSize = 0;
     _color = Color4f::WHITE;
     
     _vertTotal = 0;
     _callTotal = 0;
+    _byteTotal = 0;
+    _specTotal = 0;
+    _frameStats = FrameStats();
+    _lastFrame  = FrameStats();
     
     _initialized = false;
     _inflight = false;
     _active = false;
+    _headless = false;
+    _streaming = false;
+    _deferred = false;
+    _instancing = false;
+    _quadShader = false;
 }
 
 /**
@@ -467,6 +592,21 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
     _vertData = new SpriteVertex2[_vertMax];
     _indxMax = capacity*3;
     _indxData = new GLuint[_indxMax];
+    _quadMax = capacity/QUAD_RATIO;
+    _quadData = new QuadInstance[_quadMax];
+    _quadSort = new QuadInstance[_quadMax];
+    
+    // The quad instances share the shader, but not the vertex layout
+    _quadbuff = VertexBuffer::alloc(sizeof(QuadInstance));
+    _quadbuff->setupAttribute("aQuadX",   3, GL_FLOAT, GL_FALSE,
+                              offsetof(QuadInstance,xrow), 1);
+    _quadbuff->setupAttribute("aQuadY",   3, GL_FLOAT, GL_FALSE,
+                              offsetof(QuadInstance,yrow), 1);
+    _quadbuff->setupAttribute("aQuadTex", 4, GL_FLOAT, GL_FALSE,
+                              offsetof(QuadInstance,texrect), 1);
+    _quadbuff->setupAttribute("aColor",   4, GL_UNSIGNED_BYTE, GL_TRUE,
+                              offsetof(QuadInstance,color), 1);
+    attachQuads();
     
     // Create uniform buffer (this has its own backing array)
     _unifbuff = UniformBuffer::alloc(40*sizeof(float),capacity/16);
@@ -489,6 +629,42 @@ bool SpriteBatch::init(unsigned int capacity, const std::shared_ptr<Shader>& sha
     return true;
 }
 
+/**
+ * Initializes a sprite batch with the given vertex capacity and no OpenGL backing
+ *
+ * A headless sprite batch generates vertices and records its drawing
+ * contexts exactly like a normal sprite batch. However, flushing discards
+ * the vertices instead of drawing them. The counters {@link #getVerticesDrawn}
+ * and {@link #getCallsMade} are still updated.
+ *
+ * A headless sprite batch needs no OpenGL context, so it can measure the
+ * CPU cost of drawing in benchmarks and tools. Textures are never bound,
+ * and so they may be empty. A headless sprite batch cannot change shaders.
+ *
+ * @param capacity The vertex capacity of this spritebatch
+ *
+ * @return true if initialization was successful.
+ */
+bool SpriteBatch::initHeadless(unsigned int capacity) {
+    if (_initialized) {
+        CUAssertLog(false, "SpriteBatch is already initialized");
+        return false; // If asserts are turned off.
+    }
+    
+    _headless = true;
+    _vertMax = capacity;
+    _vertData = new SpriteVertex2[_vertMax];
+    _indxMax = capacity*3;
+    _indxData = new GLuint[_indxMax];
+    _quadMax = capacity/QUAD_RATIO;
+    _quadData = new QuadInstance[_quadMax];
+    _quadSort = new QuadInstance[_quadMax];
+
+    _context = new Context();
+    _context->dirty = DIRTY_ALL_VALS;
+    return true;
+}
+
 
 #pragma mark -
 #pragma mark Attributes
@@ -517,10 +693,16 @@ void SpriteBatch::setColor(const Color4 color) {
 void SpriteBatch::setShader(const std::shared_ptr<Shader>& shader) {
     CUAssertLog(_active, "Attempt to reassign shader while drawing is active");
     CUAssertLog(shader != nullptr, "Shader cannot be null");
+    CUAssertLog(!_headless, "A headless SpriteBatch has no shader");
+    if (_headless) {
+        return;
+    }
     _vertbuff->detach();
+    _quadbuff->detach();
     _shader = shader;
     _vertbuff->attach(_shader);
     _shader->setUniformBlock("uContext", _unifbuff);
+    attachQuads();
 }
 
 
@@ -535,9 +717,14 @@ void SpriteBatch::setShader(const std::shared_ptr<Shader>& shader) {
  */
 void SpriteBatch::setPerspective(const Mat4& perspective) {
     if (_context->perspective.get() != &perspective) {
+        barrier();
         if (_inflight) { record(); }
-        auto matrix = std::make_shared<Mat4>(perspective);
-        _context->perspective = matrix;
+        // Reuse the matrix unless a recorded context still shares it
+        if (_context->perspective.use_count() == 1) {
+            _context->perspective->set(perspective);
+        } else {
+            _context->perspective = std::make_shared<Mat4>(perspective);
+        }
         _context->dirty = _context->dirty | DIRTY_PERSPECTIVE;
     }
 }
@@ -696,6 +883,25 @@ std::shared_ptr<Scissor> SpriteBatch::getScissor() const {
     return nullptr;
 }
 
+/**
+ * Copies the active scissor mask of this sprite batch into dst
+ *
+ * This is the same as {@link #getScissor}, except that it copies into
+ * an existing scissor and so does not allocate. If no scissor mask is
+ * active, dst is unchanged.
+ *
+ * @param dst   The scissor to copy into
+ *
+ * @return true if a scissor mask is active
+ */
+bool SpriteBatch::getScissor(Scissor& dst) const {
+    if (_scissor != nullptr) {
+        dst.set(*_scissor);
+        return true;
+    }
+    return false;
+}
+
 /**
  * Sets the active scissor mask of this sprite batch
  *
@@ -725,7 +931,14 @@ void SpriteBatch::setScissor(const std::shared_ptr<Scissor>& scissor) {
     } else {
         _context->dirty = _context->dirty | DIRTY_UNIBLOCK | DIRTY_DRAWTYPE;
         _context->type = _context->type | TYPE_SCISSOR;
-        _scissor = Scissor::alloc(scissor);
+        // The mask is only read when the uniform block is written, so the
+        // copy can be overwritten in place once the current batch is recorded
+        if (_scissorData == nullptr) {
+            _scissorData = Scissor::alloc(scissor);
+        } else {
+            _scissorData->set(*scissor);
+        }
+        _scissor = _scissorData;
     }
 }
 
@@ -896,7 +1109,8 @@ void SpriteBatch::setCommand(GLenum command) {
  * @return the current drawing command.
  */
 GLenum SpriteBatch::getCommand() const {
-    return _context->command;
+    // Quad instances are filled rectangles
+    return _context->command == COMMAND_QUADS ? GL_TRIANGLES : _context->command;
 }
 
 /**
@@ -1011,6 +1225,7 @@ GLfloat SpriteBatch::getBlur() const {
  */
 void SpriteBatch::setStencilEffect(StencilEffect effect) {
     if (_context->stencil != effect) {
+        barrier();
         if (_inflight) { record(); }
         _context->stencil = effect;
         _context->dirty = _context->dirty | DIRTY_STENCIL_EFFECT;
@@ -1045,6 +1260,7 @@ StencilEffect SpriteBatch::getStencilEffect() const {
  */
 void SpriteBatch::clearStencil() {
     if (_context->cleared != STENCIL_BOTH) {
+        barrier();
         if (_inflight) { record(); }
         _context->cleared = STENCIL_BOTH;
         _context->dirty = _context->dirty | DIRTY_STENCIL_CLEAR;
@@ -1063,6 +1279,7 @@ void SpriteBatch::clearStencil() {
 void SpriteBatch::clearHalfStencil(bool lower) {
     GLenum state = lower ? STENCIL_LOWER : STENCIL_UPPER;
     if (_context->cleared != state) {
+        barrier();
         if (_inflight) { record(); }
         _context->cleared = _context->cleared | state;
         _context->dirty = _context->dirty | DIRTY_STENCIL_CLEAR;
@@ -1080,18 +1297,24 @@ void SpriteBatch::clearHalfStencil(bool lower) {
  * Calling this method will reset the vertex and OpenGL call counters to 0.
  */
 void SpriteBatch::begin() {
-    _shader->enableCulling(false);
-    _shader->enableDepthWrite(true);
-    _shader->enableBlending(true);
+    if (!_headless) {
+        _shader->enableCulling(false);
+        _shader->enableDepthWrite(true);
+        _shader->enableBlending(true);
 
-    // DO NOT CLEAR.  This responsibility lies elsewhere
-    _shader->bind();
-    _vertbuff->bind();
-    _unifbuff->bind(false);
-    _unifbuff->deactivate();
+        // DO NOT CLEAR.  This responsibility lies elsewhere
+        _shader->bind();
+        _vertbuff->bind();
+        _unifbuff->bind(false);
+        _unifbuff->deactivate();
+    }
     _active = true;
     _callTotal = 0;
     _vertTotal = 0;
+    _byteTotal = 0;
+    _specTotal = 0;
+    _sortKey = 0;
+    _itemKey = 0;
 }
 
 /**
@@ -1103,13 +1326,18 @@ void SpriteBatch::begin() {
 void SpriteBatch::end() {
     CUAssertLog(_active,"SpriteBatch is not active");
     flush();
+    if (_headless) {
+        // Nothing was bound, so there is nothing to unbind
+        _context->texture = nullptr;
+    }
     _context->reset();
     _context->dirty = DIRTY_ALL_VALS;
 
-    // Undo any active stencil effects
-    cugl::stencil::applyEffect(StencilEffect::NONE, _shader);
-    
-    _shader->unbind();
+    if (!_headless) {
+        // Undo any active stencil effects
+        cugl::stencil::applyEffect(StencilEffect::NONE, _shader);
+        _shader->unbind();
+    }
     _active = false;
 }
 
@@ -1127,76 +1355,205 @@ void SpriteBatch::end() {
  * restoring the OpenGL state.
  */
 void SpriteBatch::flush() {
-    if (_indxSize == 0 || _vertSize == 0) {
+    if (_indxSize == 0) {
         return;
-    } else if (_context->first != _indxSize) {
+    }
+    CUProfileZone("SpriteBatch::flush");
+    if (_context->first != _indxSize) {
         record();
     }
     
-    // Load all the vertex data at once
-    _vertbuff->loadVertexData(_vertData, _vertSize);
-    _vertbuff->loadIndexData(_indxData, _indxSize);
-    _unifbuff->activate();
-    _unifbuff->flush();
-    
-    // Chunk the uniforms
-    std::shared_ptr<Texture> previous = _context->texture;
-    for(auto it = _history.begin(); it != _history.end(); ++it) {
-        Context* next = *it;
-        if (next->dirty & DIRTY_BLENDEQUATION) {
-            _shader->setBlendEquation(next->blendEq);
-        }
-        if (next->dirty & DIRTY_SRC_FUNCTION || next->dirty & DIRTY_DST_FUNCTION) {
-            if (next->srcRGB != next->srcAlpha || next->dstRGB != next->dstAlpha ) {
-                _shader->setBlendFuncSeperate(next->srcRGB, next->dstRGB,
-                                              next->srcAlpha, next->dstAlpha);
+    unsigned int calls = _callTotal;
+    size_t bytes = _vertSize*sizeof(SpriteVertex2)+_indxSize*sizeof(GLuint)+_quadSize*sizeof(QuadInstance);
+    unsigned int respecs = _streaming ? 0 : (_quadSize > 0 ? 3 : 2);
+    if (_deferred) {
+        sortItems();
+    }
+    const GLuint* indices = _deferred ? _sortData : _indxData;
+    if (_headless) {
+        // Count the calls that would have been made
+        _callTotal += (unsigned int)(_deferred ? _runs.size() : _history.size());
+    } else {
+        // Load all the vertex data at once
+        GLsizei base = 0;
+        GLsizei quadbase = 0;
+        const QuadInstance* quads = _deferred ? _quadSort : _quadData;
+        if (_quadSize > 0) {
+            _quadbuff->bind();
+            if (_streaming) {
+                quadbase = _quadbuff->streamVertices(quads, _quadSize);
             } else {
-                _shader->setBlendFunc(next->srcRGB, next->dstRGB);
+                _quadbuff->loadVertexData(quads, _quadSize);
             }
+            _vertbuff->bind();
         }
-        if (next->dirty & DIRTY_DEPTHVALUE) {
-            _shader->setUniform1f("uDepth", 0);
-        }
-        if (next->dirty & DIRTY_DRAWTYPE) {
-             _shader->setUniform1i("uType", next->type);
-        }
-        if (next->dirty & DIRTY_PERSPECTIVE) {
-            _shader->setUniformMat4("uPerspective",*(next->perspective.get()));
+        if (_streaming) {
+            base = _vertbuff->streamData(_vertData, _vertSize, indices, _indxSize);
+        } else {
+            _vertbuff->loadVertexData(_vertData, _vertSize);
+            _vertbuff->loadIndexData(indices, _indxSize);
         }
-        if (next->dirty & DIRTY_TEXTURE) {
-            previous = next->texture;
-            if (previous != nullptr) {
-                previous->bind();
+        _unifbuff->activate();
+        _unifbuff->flush();
+
+        if (_deferred) {
+            // Stencil changes are barriers, so any clear comes before every run
+            for(auto it = _history.begin(); it != _history.end(); ++it) {
+                if ((*it)->dirty & DIRTY_STENCIL_CLEAR) {
+                    cugl::stencil::clearBuffer((*it)->cleared);
+                }
+            }
+            // The runs are out of order, so the dirty bits are computed per run
+            Context* applied = nullptr;
+            for(auto it = _runs.begin(); it != _runs.end(); ++it) {
+                Context* next = _history[it->context];
+                GLuint dirty = applied ? compare(applied,next) : (DIRTY_ALL_VALS & ~DIRTY_STENCIL_CLEAR);
+                applyContext(next,dirty);
+                applied = next;
+                drawRange(next->command, indices, it->first, it->last, base, quadbase);
+            }
+        } else {
+            // Chunk the uniforms
+            for(auto it = _history.begin(); it != _history.end(); ++it) {
+                Context* next = *it;
+                applyContext(next,next->dirty);
+                drawRange(next->command, indices, next->first, next->last, base, quadbase);
             }
         }
-        if (next->dirty & DIRTY_UNIBLOCK) {
-            _unifbuff->setBlock(next->blockptr);
-        }
-        if (next->dirty & DIRTY_BLURSTEP) {
-            blurTexture(next->texture,next->blur);
-        }
-        if (next->dirty & DIRTY_STENCIL_CLEAR) {
-            cugl::stencil::clearBuffer(next->cleared);
-        }
-        if (next->dirty & DIRTY_STENCIL_EFFECT) {
-            cugl::stencil::applyEffect(next->stencil, _shader);
+        if (_quadsBound) {
+            _shader->setUniform1i("uQuads", 0);
+            _vertbuff->bind();
+            _quadsBound = false;
         }
-        
-        GLuint amt = next->last-next->first;
-        _vertbuff->draw(next->command, amt, next->first);
-        _callTotal++;
-    }
     
-    _unifbuff->deactivate();
+        _unifbuff->deactivate();
+    }
     
-    // Increment the counters
-    _vertTotal += _indxSize;
+    // Increment the counters (a quad is one index for six vertices)
+    unsigned int drawn = _indxSize+5*_quadSize;
+    _vertTotal += drawn;
+    _byteTotal += bytes;
+    _specTotal += respecs;
+    _frameStats.bytes += bytes;
+    _frameStats.respecs += respecs;
+    _frameStats.calls += _callTotal-calls;
+    _frameStats.vertices += drawn;
     
-    _vertSize = _indxSize = 0;
+    _vertSize = _indxSize = _quadSize = 0;
     unwind();
     _context->first = 0;
     _context->last  = 0;
     _context->blockptr = -1;
+    _itemFirst = 0;
+    _itemVert  = 0;
+    if (_deferred) {
+        // The shader holds the state of the last run, not the last context
+        _items.clear();
+        _context->dirty = DIRTY_ALL_VALS;
+    }
+}
+
+
+/**
+ * Completes the frame, saving the counters of every pass in it.
+ *
+ * A frame usually has several passes (one for each scene), so the pass
+ * counters do not show the cost of a frame. This should be called once
+ * at the end of each frame, outside of any pass.
+ */
+void SpriteBatch::endFrame() {
+    _lastFrame  = _frameStats;
+    _frameStats = FrameStats();
+}
+
+/**
+ * Sets whether this sprite batch streams its vertices through a ring.
+ *
+ * A streaming sprite batch writes the vertices of each flush after those
+ * of the previous one, in a vertex buffer that is specified once (see
+ * {@link VertexBuffer#setStreaming}). Otherwise every flush respecifies
+ * the buffers, which is expensive when texture or state switches force
+ * many flushes a frame.
+ *
+ * This may not be called during a pass.
+ *
+ * @param value Whether this sprite batch streams its vertices
+ */
+void SpriteBatch::setStreaming(bool value) {
+    CUAssertLog(!_active, "Cannot change streaming during a pass");
+    if (_streaming == value) {
+        return;
+    }
+    _streaming = value;
+    if (!_headless) {
+        _quadbuff->bind();
+        _quadbuff->setStreaming(value ? _quadMax*STREAM_BATCHES : 0, 0, STREAM_REGIONS);
+        _vertbuff->bind();
+        if (value) {
+            _vertbuff->setStreaming(_vertMax*STREAM_BATCHES, _indxMax*STREAM_BATCHES, STREAM_REGIONS);
+        } else {
+            _vertbuff->setStreaming(0, 0);
+        }
+        _vertbuff->unbind();
+    }
+}
+
+
+/**
+ * Sets whether this sprite batch sorts its shapes before drawing.
+ *
+ * In deferred mode, the shapes of each flush are sorted by their sort
+ * key (see {@link #setSortKey}) and then grouped by drawing state
+ * (texture, blending, command, gradient and scissor), so the flush uses
+ * as few draw calls as possible. The order is preserved where it matters:
+ * shapes on different layers are always drawn in layer order, shapes of
+ * a layer are drawn in depth order, and a shape is never moved past a
+ * shape it overlaps. Shapes with the same key keep their submission order
+ * unless they do not overlap.
+ *
+ * Changing the perspective or the stencil in deferred mode flushes the
+ * shapes drawn so far.
+ *
+ * This may not be called during a pass.
+ *
+ * @param value Whether this sprite batch sorts its shapes before drawing
+ */
+void SpriteBatch::setDeferred(bool value) {
+    CUAssertLog(!_active, "Cannot change deferred mode during a pass");
+    _deferred = value;
+    if (value && _sortData == nullptr) {
+        _sortData = new GLuint[_indxMax];
+        _items.reserve(_vertMax/4);
+        _order.reserve(_vertMax/4);
+        _scratch.reserve(_vertMax/4);
+        _runs.reserve(_vertMax/16);
+    }
+    _items.clear();
+    _itemFirst = 0;
+    _itemVert  = 0;
+}
+
+/**
+ * Sets whether this sprite batch draws rectangles as instances.
+ *
+ * When instancing, each filled rectangle (and so each sprite drawn by
+ * the {@link #draw} methods) is recorded as a single instance of an
+ * affine map, texture region and color, instead of four vertices and
+ * six indices. The vertex shader expands the instances, so there is
+ * less to compute and upload per sprite. The result is the same as
+ * drawing the rectangle as a polygon.
+ *
+ * If the shader has no support for instances (see the class description),
+ * the rectangles are expanded on the CPU as before. A headless sprite
+ * batch records the instances like any other.
+ *
+ * This may not be called during a pass.
+ *
+ * @param value Whether this sprite batch draws rectangles as instances
+ */
+void SpriteBatch::setInstancing(bool value) {
+    CUAssertLog(!_active, "Cannot change instancing during a pass");
+    _instancing = value;
 }
 
 
@@ -2464,12 +2821,9 @@ void SpriteBatch::drawMesh(const SpriteVertex2* vertices, size_t size,
 void SpriteBatch::drawText(const std::string text,
                            const std::shared_ptr<Font>& font,
                            const Vec2 position) {
-    std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
-    font->getGlyphs(runs, text, position);
-    for(auto it = runs.begin(); it != runs.end(); ++it) {
-        setTexture(it->second->texture);
-        drawMesh(it->second->mesh,Vec2::ZERO);
-    }
+    clearTextRuns();
+    font->getGlyphs(_textRuns, text, position);
+    drawTextRuns(Vec2::ZERO);
 }
 
 /**
@@ -2494,12 +2848,9 @@ void SpriteBatch::drawText(const std::string text,
 void SpriteBatch::drawText(const std::string text,
                            const std::shared_ptr<Font>& font,
                            const Vec2 origin, const Affine2& transform) {
-    std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
-    font->getGlyphs(runs, text, -origin);
-    for(auto it = runs.begin(); it != runs.end(); ++it) {
-        setTexture(it->second->texture);
-        drawMesh(it->second->mesh,transform);
-    }
+    clearTextRuns();
+    font->getGlyphs(_textRuns, text, -origin);
+    drawTextRuns(transform);
 }
 
 /**
@@ -2522,12 +2873,9 @@ void SpriteBatch::drawText(const std::string text,
  */
 void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text,
                            const Vec2 position) {
-    std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
-    text->getGlyphs(runs);
-    for(auto it = runs.begin(); it != runs.end(); ++it) {
-        setTexture(it->second->texture);
-        drawMesh(it->second->mesh,position);
-    }
+    clearTextRuns();
+    text->getGlyphs(_textRuns);
+    drawTextRuns(position);
 }
 
 /**
@@ -2549,16 +2897,51 @@ void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text,
  */
 void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text,
                            const Affine2& transform) {
-    std::unordered_map<GLuint, std::shared_ptr<GlyphRun>> runs;
-    text->getGlyphs(runs);
-    for(auto it = runs.begin(); it != runs.end(); ++it) {
-        setTexture(it->second->texture);
-        drawMesh(it->second->mesh,transform);
-    }
+    clearTextRuns();
+    text->getGlyphs(_textRuns);
+    drawTextRuns(transform);
 }
 
 #pragma mark -
 #pragma mark Internal Helpers
+/**
+ * Empties the glyph runs of drawText, keeping their storage.
+ */
+void SpriteBatch::clearTextRuns() {
+    for(auto it = _textRuns.begin(); it != _textRuns.end(); ++it) {
+        it->second->mesh.clear();
+        it->second->contents.clear();
+    }
+}
+
+/**
+ * Draws the glyph runs of drawText at the given offset
+ *
+ * @param offset    The offset of the glyphs
+ */
+void SpriteBatch::drawTextRuns(const Vec2 offset) {
+    for(auto it = _textRuns.begin(); it != _textRuns.end(); ++it) {
+        if (!it->second->mesh.vertices.empty()) {
+            setTexture(it->second->texture);
+            drawMesh(it->second->mesh,offset);
+        }
+    }
+}
+
+/**
+ * Draws the glyph runs of drawText with the given coordinate transform
+ *
+ * @param transform The coordinate transform
+ */
+void SpriteBatch::drawTextRuns(const Affine2& transform) {
+    for(auto it = _textRuns.begin(); it != _textRuns.end(); ++it) {
+        if (!it->second->mesh.vertices.empty()) {
+            setTexture(it->second->texture);
+            drawMesh(it->second->mesh,transform);
+        }
+    }
+}
+
 /**
  * Records the current set of uniforms, freezing them.
  *
@@ -2567,7 +2950,17 @@ void SpriteBatch::drawText(const std::shared_ptr<TextLayout>& text,
  * will use the correct set of uniforms.
  */
 void SpriteBatch::record() {
-    Context* next = new Context(_context);
+    if (_deferred) {
+        split();
+    }
+    Context* next;
+    if (_spare.empty()) {
+        next = new Context(_context);
+    } else {
+        next = _spare.back();
+        _spare.pop_back();
+        next->set(_context);
+    }
     _context->last = _indxSize;
     next->first = _indxSize;
     _history.push_back(_context);
@@ -2576,13 +2969,18 @@ void SpriteBatch::record() {
 }
 
 /**
- * Deletes the recorded uniforms.
+ * Releases the recorded uniforms.
+ *
+ * The contexts are kept as spares for the next batch, so that recording
+ * does not allocate once the batch has reached its usual size.
  *
  * This method is called upon flushing or cleanup.
  */
 void SpriteBatch::unwind() {
     for(auto it = _history.begin(); it != _history.end(); ++it) {
-        delete *it;
+        (*it)->perspective = nullptr;
+        (*it)->texture = nullptr;
+        _spare.push_back(*it);
     }
     _history.clear();
 }
@@ -2595,10 +2993,16 @@ void SpriteBatch::unwind() {
  * @param context   The current uniform context
  */
 void SpriteBatch::setUniformBlock(Context* context) {
+    if (_deferred) {
+        // Each shape is a separate deferred item
+        split();
+    }
     if (!(_context->dirty & DIRTY_UNIBLOCK)) {
         return;
     }
-    if (_context->blockptr+1 >= _unifbuff->getBlockCount()) {
+    // A headless batch has the same block capacity, so it flushes at the same times
+    size_t blocks = _headless ? _vertMax/16 : _unifbuff->getBlockCount();
+    if (_context->blockptr+1 >= blocks) {
         flush();
     }
     float data[40];
@@ -2613,7 +3017,9 @@ void SpriteBatch::setUniformBlock(Context* context) {
         std::memset(data+16,0,24*sizeof(float));
     }
     _context->blockptr++;
-    _unifbuff->setUniformfv(_context->blockptr,0,40,data);
+    if (!_headless) {
+        _unifbuff->setUniformfv(_context->blockptr,0,40,data);
+    }
 }
 
 /**
@@ -2639,6 +3045,358 @@ void SpriteBatch::blurTexture(const std::shared_ptr<Texture>& texture, GLfloat s
     _shader->setUniform2f("uBlur",size.width,size.height);
 }
 
+/**
+ * Applies the given parts of a drawing context to the shader.
+ *
+ * @param context   The drawing context
+ * @param dirty     The parts of the context to apply
+ */
+void SpriteBatch::applyContext(Context* context, GLuint dirty) {
+    if (dirty & DIRTY_BLENDEQUATION) {
+        _shader->setBlendEquation(context->blendEq);
+    }
+    if (dirty & DIRTY_SRC_FUNCTION || dirty & DIRTY_DST_FUNCTION) {
+        if (context->srcRGB != context->srcAlpha || context->dstRGB != context->dstAlpha ) {
+            _shader->setBlendFuncSeperate(context->srcRGB, context->dstRGB,
+                                          context->srcAlpha, context->dstAlpha);
+        } else {
+            _shader->setBlendFunc(context->srcRGB, context->dstRGB);
+        }
+    }
+    if (dirty & DIRTY_DEPTHVALUE) {
+        _shader->setUniform1f("uDepth", 0);
+    }
+    if (dirty & DIRTY_DRAWTYPE) {
+         _shader->setUniform1i("uType", context->type);
+    }
+    if (dirty & DIRTY_PERSPECTIVE) {
+        _shader->setUniformMat4("uPerspective",*(context->perspective.get()));
+    }
+    if (dirty & DIRTY_TEXTURE) {
+        if (context->texture != nullptr) {
+            context->texture->bind();
+        }
+    }
+    if (dirty & DIRTY_UNIBLOCK) {
+        _unifbuff->setBlock(context->blockptr);
+    }
+    if (dirty & DIRTY_BLURSTEP) {
+        blurTexture(context->texture,context->blur);
+    }
+    if (dirty & DIRTY_STENCIL_CLEAR) {
+        cugl::stencil::clearBuffer(context->cleared);
+    }
+    if (dirty & DIRTY_STENCIL_EFFECT) {
+        cugl::stencil::applyEffect(context->stencil, _shader);
+    }
+}
+
+/**
+ * Draws the given range of the indices with the given command.
+ *
+ * A range of quad instances is drawn from the quad buffer, and any other
+ * range from the vertex buffer. The buffer is bound if it is not already.
+ *
+ * @param command   The drawing command
+ * @param indices   The indices of the flush
+ * @param first     The first index of the range
+ * @param last      The index after the last index of the range
+ * @param base      The offset of the indices in the vertex buffer
+ * @param quadbase  The offset of the instances in the quad buffer
+ */
+void SpriteBatch::drawRange(GLenum command, const GLuint* indices, GLuint first, GLuint last,
+                            GLsizei base, GLsizei quadbase) {
+    if (command == COMMAND_QUADS) {
+        if (!_quadsBound) {
+            _quadbuff->bind();
+            _shader->setUniform1i("uQuads", 1);
+            _quadsBound = true;
+        }
+        // The instances of a range are consecutive
+        _quadbuff->setBaseInstance(quadbase+indices[first]);
+        _quadbuff->drawInstanced(GL_TRIANGLES, 6, last-first);
+    } else {
+        if (_quadsBound) {
+            _shader->setUniform1i("uQuads", 0);
+            _vertbuff->bind();
+            _quadsBound = false;
+        }
+        _vertbuff->draw(command, last-first, base+first);
+    }
+    _callTotal++;
+}
+
+/**
+ * Attaches the shader to the quad buffer, if the shader supports instances.
+ *
+ * This leaves the vertex buffer bound.
+ */
+void SpriteBatch::attachQuads() {
+    _quadShader = _shader->getUniformLocation("uQuads") != -1;
+    if (_quadShader) {
+        _quadbuff->attach(_shader);
+        _quadbuff->loadIndexData(QUAD_INDICES, 6, GL_STATIC_DRAW);
+        _shader->setUniform1i("uQuads", 0);
+    }
+    _vertbuff->bind();
+}
+
+/**
+ * Returns the parts of the drawing state that differ in the two contexts.
+ *
+ * @param a The first context
+ * @param b The second context
+ *
+ * @return the parts of the drawing state that differ (0 if they agree)
+ */
+GLuint SpriteBatch::compare(const Context* a, const Context* b) const {
+    if (a == b) {
+        return 0;
+    }
+    GLuint dirty = 0;
+    if (a->command != b->command) {
+        dirty |= DIRTY_COMMAND;
+    }
+    if (a->blendEq != b->blendEq) {
+        dirty |= DIRTY_BLENDEQUATION;
+    }
+    if (a->srcRGB != b->srcRGB || a->srcAlpha != b->srcAlpha) {
+        dirty |= DIRTY_SRC_FUNCTION;
+    }
+    if (a->dstRGB != b->dstRGB || a->dstAlpha != b->dstAlpha) {
+        dirty |= DIRTY_DST_FUNCTION;
+    }
+    if (a->zDepth != b->zDepth) {
+        dirty |= DIRTY_DEPTHVALUE;
+    }
+    if (a->type != b->type) {
+        dirty |= DIRTY_DRAWTYPE;
+    }
+    if (a->perspective != b->perspective && *(a->perspective) != *(b->perspective)) {
+        dirty |= DIRTY_PERSPECTIVE;
+    }
+    // Subtextures of the same texture share a binding
+    const Texture* ta = a->texture.get();
+    const Texture* tb = b->texture.get();
+    if (ta != tb && (ta == nullptr || tb == nullptr || ta->getBuffer() != tb->getBuffer())) {
+        dirty |= DIRTY_TEXTURE | DIRTY_BLURSTEP;
+    }
+    if (a->blur != b->blur) {
+        dirty |= DIRTY_BLURSTEP;
+    }
+    if (a->blockptr != b->blockptr) {
+        dirty |= DIRTY_UNIBLOCK;
+    }
+    if (a->stencil != b->stencil) {
+        dirty |= DIRTY_STENCIL_EFFECT;
+    }
+    return dirty;
+}
+
+#pragma mark -
+#pragma mark Deferred Drawing
+/**
+ * Closes the open deferred item, and opens a new one.
+ *
+ * This is called before each shape is prepared and whenever the context
+ * is recorded, so an item never spans two shapes or two contexts.
+ */
+void SpriteBatch::split() {
+    if (_indxSize > _itemFirst) {
+        DrawItem item;
+        item.key = _itemKey;
+        // The open item belongs to the active context, which is recorded next
+        item.context = (Uint32)_history.size();
+        item.first = _itemFirst;
+        item.last  = _indxSize;
+        item.next  = DEFER_NONE;
+        if (_context->command == COMMAND_QUADS) {
+            // The indices are quad instances, and the bounds are their corners
+            const QuadInstance& start = _quadData[_indxData[_itemFirst]];
+            item.bounds[0] = item.bounds[2] = start.xrow[2];
+            item.bounds[1] = item.bounds[3] = start.yrow[2];
+            for(GLuint ii = _itemFirst; ii < _indxSize; ii++) {
+                const QuadInstance& quad = _quadData[_indxData[ii]];
+                for(int jj = 0; jj < 4; jj++) {
+                    GLfloat x = quad.xrow[0]*QUAD_CORNERS[jj][0]+quad.xrow[1]*QUAD_CORNERS[jj][1]+quad.xrow[2];
+                    GLfloat y = quad.yrow[0]*QUAD_CORNERS[jj][0]+quad.yrow[1]*QUAD_CORNERS[jj][1]+quad.yrow[2];
+                    item.bounds[0] = std::min(item.bounds[0],x);
+                    item.bounds[1] = std::min(item.bounds[1],y);
+                    item.bounds[2] = std::max(item.bounds[2],x);
+                    item.bounds[3] = std::max(item.bounds[3],y);
+                }
+            }
+        } else {
+            const Vec2& start = _vertData[_itemVert].position;
+            item.bounds[0] = item.bounds[2] = start.x;
+            item.bounds[1] = item.bounds[3] = start.y;
+            for(GLuint ii = _itemVert+1; ii < _vertSize; ii++) {
+                const Vec2& point = _vertData[ii].position;
+                item.bounds[0] = std::min(item.bounds[0],point.x);
+                item.bounds[1] = std::min(item.bounds[1],point.y);
+                item.bounds[2] = std::max(item.bounds[2],point.x);
+                item.bounds[3] = std::max(item.bounds[3],point.y);
+            }
+        }
+        _items.push_back(item);
+    }
+    _itemFirst = _indxSize;
+    _itemVert  = _vertSize;
+    _itemKey   = _sortKey;
+}
+
+/**
+ * Flushes the shapes drawn so far if in deferred mode.
+ *
+ * This is called before changes that the deferred items cannot be sorted
+ * across, such as the perspective or stencil.
+ */
+void SpriteBatch::barrier() {
+    if (_deferred && _indxSize > 0) {
+        flush();
+    }
+}
+
+/**
+ * Orders the deferred items into runs of the same drawing state.
+ *
+ * The indices of the runs are written to the sort buffer, which is
+ * drawn in place of the submitted indices.
+ */
+void SpriteBatch::sortItems() {
+    size_t size = _items.size();
+    _order.resize(size);
+    _scratch.resize(size);
+    for(size_t ii = 0; ii < size; ii++) {
+        _order[ii] = (Uint32)ii;
+    }
+
+    // Radix sort on the key, one byte a pass. Each pass is stable.
+    size_t counts[257];
+    for(int shift = 0; shift < 24; shift += 8) {
+        std::memset(counts,0,sizeof(counts));
+        for(size_t ii = 0; ii < size; ii++) {
+            counts[((_items[ii].key >> shift) & 0xff)+1]++;
+        }
+        bool trivial = false;
+        for(int jj = 1; jj <= 256 && !trivial; jj++) {
+            trivial = counts[jj] == size;
+        }
+        if (trivial) {
+            continue;
+        }
+        for(int jj = 1; jj < 256; jj++) {
+            counts[jj] += counts[jj-1];
+        }
+        for(size_t ii = 0; ii < size; ii++) {
+            Uint32 item = _order[ii];
+            _scratch[counts[(_items[item].key >> shift) & 0xff]++] = item;
+        }
+        _order.swap(_scratch);
+    }
+
+    // Move each item into the last run of its layer with the same state,
+    // unless that would draw it before a shape it overlaps
+    _runs.clear();
+    size_t layer = 0;
+    for(auto it = _order.begin(); it != _order.end(); ++it) {
+        DrawItem& item = _items[*it];
+        Uint32 ilayer = item.key >> 16;
+        if (!_runs.empty() && _runs.back().layer != ilayer) {
+            layer = _runs.size();
+        }
+        const Context* context = _history[item.context];
+        size_t target = _runs.size();
+        size_t stop = _runs.size() > DEFER_LOOKBACK ? _runs.size()-DEFER_LOOKBACK : 0;
+        stop = std::max(stop,layer);
+        for(size_t rr = _runs.size(); rr > stop; rr--) {
+            if (compare(_history[_runs[rr-1].context],context) == 0) {
+                target = rr-1;
+                break;
+            }
+        }
+        
+        if (target < _runs.size() && !overlapsAfter(target,item)) {
+            DrawRun& run = _runs[target];
+            _items[run.tail].next = *it;
+            run.tail = *it;
+            run.bounds[0] = std::min(run.bounds[0],item.bounds[0]);
+            run.bounds[1] = std::min(run.bounds[1],item.bounds[1]);
+            run.bounds[2] = std::max(run.bounds[2],item.bounds[2]);
+            run.bounds[3] = std::max(run.bounds[3],item.bounds[3]);
+        } else {
+            DrawRun run;
+            run.context = item.context;
+            run.layer = ilayer;
+            run.head  = *it;
+            run.tail  = *it;
+            run.first = 0;
+            run.last  = 0;
+            std::memcpy(run.bounds,item.bounds,sizeof(run.bounds));
+            _runs.push_back(run);
+        }
+    }
+
+    // Write the indices in run order, merging neighbors with the same state
+    GLuint pos = 0;
+    GLuint quads = 0;
+    size_t count = 0;
+    for(size_t rr = 0; rr < _runs.size(); rr++) {
+        DrawRun run = _runs[rr];
+        GLuint start = pos;
+        bool instanced = _history[run.context]->command == COMMAND_QUADS;
+        for(Uint32 ii = run.head; ii != DEFER_NONE; ii = _items[ii].next) {
+            const DrawItem& item = _items[ii];
+            if (instanced) {
+                // The instances are moved too, so a run draws consecutive instances
+                for(GLuint jj = item.first; jj < item.last; jj++) {
+                    _quadSort[quads] = _quadData[_indxData[jj]];
+                    _sortData[pos++] = quads++;
+                }
+            } else {
+                std::memcpy(_sortData+pos,_indxData+item.first,(item.last-item.first)*sizeof(GLuint));
+                pos += item.last-item.first;
+            }
+        }
+        if (count > 0 && compare(_history[_runs[count-1].context],_history[run.context]) == 0) {
+            _runs[count-1].last = pos;
+        } else {
+            run.first = start;
+            run.last  = pos;
+            _runs[count++] = run;
+        }
+    }
+    _runs.resize(count);
+    CUAssertLog(pos == _indxSize, "Deferred items do not cover the mesh");
+}
+
+/**
+ * Returns true if the item overlaps any item in a run after the given one.
+ *
+ * To bound the cost, this also returns true if there are too many items
+ * to check.
+ *
+ * @param run   The run to start after
+ * @param item  The item to check
+ *
+ * @return true if the item overlaps any item in a run after the given one.
+ */
+bool SpriteBatch::overlapsAfter(size_t run, const DrawItem& item) const {
+    size_t tests = 0;
+    for(size_t rr = run+1; rr < _runs.size(); rr++) {
+        const DrawRun& later = _runs[rr];
+        if (!overlaps(later.bounds,item.bounds)) {
+            continue;
+        }
+        for(Uint32 ii = later.head; ii != DEFER_NONE; ii = _items[ii].next) {
+            if (overlaps(_items[ii].bounds,item.bounds) || ++tests > DEFER_TESTS) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 /**
  * Returns the number of vertices added to the drawing buffer.
  *
@@ -2655,7 +3413,9 @@ void SpriteBatch::blurTexture(const std::shared_ptr<Texture>& texture, GLfloat s
  * @return the number of vertices added to the drawing buffer.
  */
 unsigned int SpriteBatch::prepare(const Rect rect) {
-    if (_vertSize+4 >= _vertMax ||  _indxSize+8 >= _indxMax) {
+    if (_context->command != GL_LINES) {
+        return prepareQuad(rect,Affine2::IDENTITY);
+    } else if (_vertSize+4 >= _vertMax ||  _indxSize+8 >= _indxMax) {
         flush();
     }
     
@@ -2724,7 +3484,9 @@ unsigned int SpriteBatch::prepare(const Rect rect) {
  * @return the number of vertices added to the drawing buffer.
  */
 unsigned int SpriteBatch::prepare(const Rect rect, const Affine2& mat) {
-    if (_vertSize+4 > _vertMax ||  _indxSize+8 > _indxMax) {
+    if (_context->command != GL_LINES) {
+        return prepareQuad(rect,mat);
+    } else if (_vertSize+4 > _vertMax ||  _indxSize+8 > _indxMax) {
         flush();
     }
 
@@ -2776,6 +3538,91 @@ unsigned int SpriteBatch::prepare(const Rect rect, const Affine2& mat) {
     return ii;
 }
 
+/**
+ * Returns the number of vertices added to the drawing buffer.
+ *
+ * This method adds the given filled rectangle as a quad instance. If
+ * instancing is off, the instance is expanded into vertices instead
+ * (see {@link #expandQuad}). Either way, the quad is the same as the
+ * rectangle drawn as a polygon.
+ *
+ * @param rect  The rectangle to add to the buffer
+ * @param mat   The transform to apply to the vertices
+ *
+ * @return the number of vertices added to the drawing buffer.
+ */
+unsigned int SpriteBatch::prepareQuad(const Rect rect, const Affine2& mat) {
+    bool instanced = isInstancing();
+    if (instanced) {
+        if (_quadSize+1 > _quadMax || _indxSize+1 > _indxMax) {
+            flush();
+        }
+    } else if (_vertSize+4 > _vertMax || _indxSize+6 > _indxMax) {
+        flush();
+    }
+
+    QuadInstance quad;
+    Texture* texture = _context->texture.get();
+    if (texture != nullptr) {
+        quad.texrect[0] = texture->getMinS();
+        quad.texrect[1] = texture->getMaxS();
+        quad.texrect[2] = texture->getMaxT();
+        quad.texrect[3] = texture->getMinT();
+    } else {
+        quad.texrect[0] = 0.0f; quad.texrect[1] = 1.0f;
+        quad.texrect[2] = 1.0f; quad.texrect[3] = 0.0f;
+    }
+    
+    // Map the unit square to the rectangle, and then transform it
+    quad.xrow[0] = mat.m[0]*rect.size.width;
+    quad.xrow[1] = mat.m[2]*rect.size.height;
+    quad.xrow[2] = mat.m[0]*rect.origin.x+mat.m[2]*rect.origin.y+mat.m[4];
+    quad.yrow[0] = mat.m[1]*rect.size.width;
+    quad.yrow[1] = mat.m[3]*rect.size.height;
+    quad.yrow[2] = mat.m[1]*rect.origin.x+mat.m[3]*rect.origin.y+mat.m[5];
+    quad.color = _color.getPacked();
+    
+    if (instanced) {
+        setCommand(COMMAND_QUADS);
+        setUniformBlock(_context);
+        _quadData[_quadSize] = quad;
+        _indxData[_indxSize++] = _quadSize++;
+    } else {
+        setUniformBlock(_context);
+        expandQuad(quad);
+    }
+    _inflight = true;
+    return 4;
+}
+
+/**
+ * Adds the vertices and indices of the given quad instance to the buffer.
+ *
+ * This is the CPU fallback for instancing. It computes the same vertices
+ * as the vertex shader does for the instance.
+ *
+ * @param quad  The quad instance to expand
+ */
+void SpriteBatch::expandQuad(const QuadInstance& quad) {
+    SpriteVertex2* vertices = _vertData+_vertSize;
+    for(int ii = 0; ii < 4; ii++) {
+        GLfloat u = QUAD_CORNERS[ii][0];
+        GLfloat v = QUAD_CORNERS[ii][1];
+        vertices[ii].position.x = quad.xrow[0]*u+quad.xrow[1]*v+quad.xrow[2];
+        vertices[ii].position.y = quad.yrow[0]*u+quad.yrow[1]*v+quad.yrow[2];
+        vertices[ii].texcoord.x = quad.texrect[0]*(1-u)+quad.texrect[1]*u;
+        vertices[ii].texcoord.y = quad.texrect[2]*(1-v)+quad.texrect[3]*v;
+        vertices[ii].gradcoord.x = 1;
+        vertices[ii].gradcoord.y = 1;
+        vertices[ii].color = quad.color;
+    }
+    for(int ii = 0; ii < 6; ii++) {
+        _indxData[_indxSize+ii] = _vertSize+QUAD_INDICES[ii];
+    }
+    _vertSize += 4;
+    _indxSize += 6;
+}
+
 /**
  * Returns the number of vertices added to the drawing buffer.
  *
@@ -47,8 +47,13 @@
 #include <cugl/render/CUFont.h>
 #include <cugl/render/CUGlyphRun.h>
 #include <cugl/util/CUStrings.h>
+#include <functional>
+#include <list>
+#include <mutex>
 
 #define SHRINK 2
+/** The default number of layouts in the layout cache */
+#define CACHE_CAPACITY  64
 
 using namespace cugl;
 using namespace cugl::strtool;
@@ -99,6 +104,235 @@ TextLayout::Row::~Row() {
     end = 0;
 }
 
+#pragma mark -
+#pragma mark Layout Cache
+/**
+ * This inner class is a layout in the layout cache.
+ *
+ * It has the attributes that determine a layout, the rows and bounds
+ * computed for them, and the glyph runs last generated for the rows.
+ * The glyph runs are filled in by the first call to getGlyphs.
+ */
+class TextLayout::CacheEntry {
+public:
+    /** The key of this entry */
+    size_t hash;
+    /** The font of the layout (only compared, never dereferenced) */
+    const Font* font;
+    /** The font of the layout, to detect a new font at the same address */
+    std::weak_ptr<Font> owner;
+    /** The text of the layout */
+    std::string text;
+    /** The width of the layout */
+    float breakline;
+    /** The line spacing of the layout */
+    float spacing;
+    /** The horizontal alignment of the layout */
+    HorizontalAlign halign;
+    /** The vertical alignment of the layout */
+    VerticalAlign valign;
+    /** The rows of the layout */
+    std::vector<Row> rows;
+    /** The bounds of the layout */
+    Rect bounds;
+    /** Whether the glyph runs have been generated */
+    bool glyphs;
+    /** The bounding box the glyph runs were generated for */
+    Rect clip;
+    /** The number of glyphs in the glyph runs */
+    size_t count;
+    /** The glyph runs of the layout */
+    std::unordered_map<GLuint,std::shared_ptr<GlyphRun>> runs;
+    
+    /**
+     * Creates an entry for the attributes of the given layout
+     *
+     * @param layout    The text layout
+     */
+    CacheEntry(const TextLayout* layout) :
+    hash(0),
+    font(layout->_font.get()),
+    owner(layout->_font),
+    text(layout->_text),
+    breakline(layout->_breakline),
+    spacing(layout->_spacing),
+    halign(layout->_halign),
+    valign(layout->_valign),
+    rows(layout->_rows),
+    bounds(layout->_bounds),
+    glyphs(false),
+    count(0) {
+    }
+    
+    /**
+     * Returns true if this entry has the attributes of the given layout
+     *
+     * @param layout    The text layout
+     *
+     * @return true if this entry has the attributes of the given layout
+     */
+    bool matches(const TextLayout* layout) const {
+        return (font == layout->_font.get() && !owner.expired() &&
+                breakline == layout->_breakline && spacing == layout->_spacing &&
+                halign == layout->_halign && valign == layout->_valign &&
+                text == layout->_text);
+    }
+};
+
+/**
+ * This inner class is the layout cache shared by all text layouts.
+ *
+ * It is a least-recently-used list of entries, indexed by their keys. Two
+ * layouts with the same key (a hash collision) simply replace each other.
+ * The mutex allows layouts to be built outside of the main thread.
+ */
+class TextLayout::Cache {
+public:
+    /** The lock for the cache and the glyph runs of its entries */
+    std::mutex mutex;
+    /** The maximum number of entries */
+    size_t capacity;
+    /** The entries, most recently used first */
+    std::list<std::shared_ptr<CacheEntry>> entries;
+    /** The entries by key */
+    std::unordered_map<size_t,std::list<std::shared_ptr<CacheEntry>>::iterator> index;
+    /** The number of layouts copied from the cache */
+    Uint64 hits;
+    /** The number of layouts computed with the cache enabled */
+    Uint64 misses;
+    
+    /**
+     * Creates an empty cache with the default capacity
+     */
+    Cache() : capacity(CACHE_CAPACITY), hits(0), misses(0) {}
+    
+    /**
+     * Evicts the least recently used entries until the cache fits its capacity
+     */
+    void trim() {
+        while (entries.size() > capacity) {
+            auto item = index.find(entries.back()->hash);
+            if (item != index.end() && item->second == std::prev(entries.end())) {
+                index.erase(item);
+            }
+            entries.pop_back();
+        }
+    }
+};
+
+/**
+ * Appends copies of the given glyph runs to the given map
+ *
+ * The runs are copied so that the caller may modify them (a label shifts
+ * and colors the vertices) without affecting the cached runs.
+ *
+ * @param dst   The map to append to
+ * @param src   The glyph runs to copy
+ */
+static void append_runs(std::unordered_map<GLuint,std::shared_ptr<GlyphRun>>& dst,
+                        const std::unordered_map<GLuint,std::shared_ptr<GlyphRun>>& src) {
+    for(auto it = src.begin(); it != src.end(); ++it) {
+        std::shared_ptr<GlyphRun>& run = dst[it->first];
+        if (run == nullptr) {
+            run = GlyphRun::alloc();
+            run->texture = it->second->texture;
+        }
+        GLuint base = (GLuint)run->mesh.vertices.size();
+        const Mesh<SpriteVertex2>& mesh = it->second->mesh;
+        run->mesh.vertices.insert(run->mesh.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        run->mesh.indices.reserve(run->mesh.indices.size()+mesh.indices.size());
+        for(auto jt = mesh.indices.begin(); jt != mesh.indices.end(); ++jt) {
+            run->mesh.indices.push_back(base+*jt);
+        }
+        run->contents.insert(it->second->contents.begin(), it->second->contents.end());
+    }
+}
+
+/**
+ * Returns the layout cache shared by all text layouts
+ *
+ * @return the layout cache shared by all text layouts
+ */
+TextLayout::Cache* TextLayout::getCache() {
+    static Cache cache;
+    return &cache;
+}
+
+/**
+ * Returns the number of layouts kept by the layout cache
+ *
+ * The cache is shared by all text layouts. It is keyed by the font, text,
+ * width, spacing and alignment of a layout, and stores both the rows of
+ * the layout and the glyph runs last generated for it. When the cache is
+ * full, the least recently used layout is evicted.
+ *
+ * @return the number of layouts kept by the layout cache
+ */
+size_t TextLayout::getCacheCapacity() {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    return cache->capacity;
+}
+
+/**
+ * Sets the number of layouts kept by the layout cache
+ *
+ * A capacity of 0 disables the cache. Shrinking the cache evicts the
+ * least recently used layouts immediately.
+ *
+ * @param capacity  The number of layouts kept by the layout cache
+ */
+void TextLayout::setCacheCapacity(size_t capacity) {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    cache->capacity = capacity;
+    cache->trim();
+}
+
+/**
+ * Removes every layout from the layout cache
+ *
+ * Text layouts sharing a cached layout keep it until they are invalidated.
+ */
+void TextLayout::clearCache() {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    cache->entries.clear();
+    cache->index.clear();
+}
+
+/**
+ * Returns the number of layouts copied from the cache
+ *
+ * @return the number of layouts copied from the cache
+ */
+Uint64 TextLayout::getCacheHits() {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    return cache->hits;
+}
+
+/**
+ * Returns the number of layouts computed with the cache enabled
+ *
+ * @return the number of layouts computed with the cache enabled
+ */
+Uint64 TextLayout::getCacheMisses() {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    return cache->misses;
+}
+
+/**
+ * Resets the layout cache hit and miss counters to zero
+ */
+void TextLayout::resetCacheCounters() {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
 #pragma mark -
 #pragma mark Constructors
 /**
@@ -111,7 +345,9 @@ TextLayout::TextLayout() :
 _breakline(0),
 _spacing(1),
 _halign(HorizontalAlign::LEFT),
-_valign(VerticalAlign::BASELINE) {
+_valign(VerticalAlign::BASELINE),
+_reuse(0),
+_resume(0) {
 }
 
 /**
@@ -121,6 +357,10 @@ _valign(VerticalAlign::BASELINE) {
  */
 void TextLayout::dispose() {
     _rows.clear();
+    _spare.clear();
+    _reuse = 0;
+    _resume = 0;
+    _entry = nullptr;
     _text.clear();
     _font = nullptr;
     _breakline = 0;
@@ -238,7 +478,15 @@ bool TextLayout::initWithTextWidth(const std::string text, const std::shared_ptr
  * @param text  The text associated with this layout.
  */
 void TextLayout::setText(const std::string text) {
+    if (text == _text) {
+        return;
+    }
+    size_t resume = 0;
+    size_t reuse = keepRows(text, resume);
+    _spare.swap(_rows);
     invalidate();
+    _reuse = reuse;
+    _resume = resume;
     _text = text;
     std::string::iterator end_it = utf8::find_invalid(_text.begin(), _text.end());
     CUAssertLog(end_it == _text.end(),"String '%s' has an invalid UTF-8 encoding",text.c_str());
@@ -835,23 +1083,7 @@ std::unordered_map<GLuint,std::shared_ptr<GlyphRun>> TextLayout::getGlyphs(Rect
  * @return the number of glyphs successfully processed
  */
 size_t TextLayout::getGlyphs(std::unordered_map<GLuint,std::shared_ptr<GlyphRun>>& runs) const {
-    Rect bounds = getBounds();
-    size_t total = 0;
-    for(auto it = _rows.begin(); it != _rows.end(); ++it) {
-        float track = 0;
-        if (_halign == HorizontalAlign::JUSTIFY) {
-            auto jt = it+1;
-            if (jt != _rows.end() && !jt->paragraph) {
-                track = _breakline;
-            }
-        } else if (_breakline > 0 && it->exterior.size.width > _breakline) {
-            track = _breakline;
-        }
-        const char* begin = _text.c_str()+it->begin;
-        const char* end = _text.c_str()+it->end;
-        total += _font->getGlyphs(runs, begin, end, it->exterior.origin, bounds, track);
-    }
-    return total;
+    return getGlyphs(runs, getBounds());
 }
 
 /**
@@ -888,6 +1120,43 @@ size_t TextLayout::getGlyphs(std::unordered_map<GLuint,std::shared_ptr<GlyphRun>
 size_t TextLayout::getGlyphs(std::unordered_map<GLuint,std::shared_ptr<GlyphRun>>& runs, Rect rect) const {
     Rect bounds = getBounds();
     bounds.intersect(rect);
+    std::shared_ptr<CacheEntry> entry = _entry;
+    if (entry == nullptr) {
+        return generateGlyphs(runs, bounds);
+    }
+    
+    Cache* cache = getCache();
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (entry->glyphs && entry->clip == bounds) {
+            append_runs(runs, entry->runs);
+            return entry->count;
+        }
+    }
+    
+    // Generate outside of the lock, as a fallback atlas may be slow
+    std::unordered_map<GLuint,std::shared_ptr<GlyphRun>> fresh;
+    size_t total = generateGlyphs(fresh, bounds);
+    append_runs(runs, fresh);
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    entry->runs = std::move(fresh);
+    entry->clip = bounds;
+    entry->count = total;
+    entry->glyphs = true;
+    return total;
+}
+
+/**
+ * Generates the glyph runs for the rows of this layout
+ *
+ * This is the uncached version of {@link #getGlyphs}.
+ *
+ * @param runs      The map to store the glyph runs
+ * @param bounds    The bounding box for the quads
+ *
+ * @return the number of glyphs successfully processed
+ */
+size_t TextLayout::generateGlyphs(std::unordered_map<GLuint,std::shared_ptr<GlyphRun>>& runs, const Rect bounds) const {
     size_t total = 0;
     for(auto it = _rows.begin(); it != _rows.end(); ++it) {
         float track = 0;
@@ -1061,8 +1330,18 @@ void TextLayout::layout() {
         return;
     }
     
-    if (_breakline >= 0) {
-        breakLines();
+    size_t hash = hashLayout();
+    if (fetchLayout(hash)) {
+        _reuse = 0;
+        return;
+    }
+    
+    if (_breakline >= 0 && _reuse > 0 && _reuse <= _spare.size()) {
+        // Keep the rows of the unchanged paragraphs
+        _rows.assign(_spare.begin(), _spare.begin()+_reuse);
+        breakLines(_resume);
+    } else if (_breakline >= 0) {
+        breakLines(0);
     } else {
         // Will only have one line
         _rows.push_back(Row());
@@ -1074,6 +1353,8 @@ void TextLayout::layout() {
     resetHorizontal();
     resetVertical();
     computeBounds();
+    _reuse = 0;
+    storeLayout(hash);
 }
 
 /**
@@ -1085,6 +1366,117 @@ void TextLayout::layout() {
 void TextLayout::invalidate() {
     _rows.clear();
     _bounds.set(0,0,0,0);
+    _reuse = 0;
+    _entry = nullptr;
+}
+
+/**
+ * Returns the number of rows of the current layout that are valid for the given text
+ *
+ * These are the rows of the paragraphs before the last newline the two
+ * texts have in common. They are valid because lines never break across
+ * a newline.
+ *
+ * @param text      The new text of this layout
+ * @param resume    Storage for the position of the last common newline
+ *
+ * @return the number of rows of the current layout that are valid for the given text
+ */
+size_t TextLayout::keepRows(const std::string& text, size_t& resume) const {
+    if (_rows.empty() || _font == nullptr || _breakline < 0) {
+        return 0;
+    }
+    
+    // Find the last newline of the common prefix (as classify does, \r\n is one newline)
+    size_t limit = std::min(text.size(),_text.size());
+    size_t paragraphs = 0;
+    char prev = 0;
+    for(size_t ii = 0; ii < limit && text[ii] == _text[ii]; ii++) {
+        char curr = _text[ii];
+        if ((curr == '\n' && prev != '\r') || (curr == '\r' && prev != '\n')) {
+            paragraphs++;
+            resume = ii;
+        }
+        prev = curr;
+    }
+    if (paragraphs == 0) {
+        return 0;
+    }
+    
+    // Every newline starts a paragraph row
+    size_t found = 0;
+    for(size_t ii = 1; ii < _rows.size(); ii++) {
+        if (_rows[ii].paragraph && ++found == paragraphs) {
+            return ii;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Returns the cache key for the current attributes of this layout
+ *
+ * @return the cache key for the current attributes of this layout
+ */
+size_t TextLayout::hashLayout() const {
+    size_t hash = std::hash<std::string>()(_text);
+    size_t values[] = {
+        std::hash<const void*>()(_font.get()), std::hash<float>()(_breakline),
+        std::hash<float>()(_spacing), (size_t)_halign, (size_t)_valign
+    };
+    for(size_t ii = 0; ii < sizeof(values)/sizeof(size_t); ii++) {
+        hash ^= values[ii]+0x9e3779b9+(hash << 6)+(hash >> 2);
+    }
+    return hash;
+}
+
+/**
+ * Copies the layout for the given key from the cache, if it is there
+ *
+ * @param hash      The cache key of this layout
+ *
+ * @return true if the layout was in the cache
+ */
+bool TextLayout::fetchLayout(size_t hash) {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (cache->capacity == 0) {
+        return false;
+    }
+    auto item = cache->index.find(hash);
+    if (item == cache->index.end() || !(*(item->second))->matches(this)) {
+        cache->misses++;
+        return false;
+    }
+    cache->entries.splice(cache->entries.begin(), cache->entries, item->second);
+    _entry = cache->entries.front();
+    _rows = _entry->rows;
+    _bounds = _entry->bounds;
+    cache->hits++;
+    return true;
+}
+
+/**
+ * Stores the current layout in the cache for the given key
+ *
+ * @param hash      The cache key of this layout
+ */
+void TextLayout::storeLayout(size_t hash) {
+    Cache* cache = getCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (cache->capacity == 0) {
+        return;
+    }
+    std::shared_ptr<CacheEntry> entry = std::make_shared<CacheEntry>(this);
+    entry->hash = hash;
+    auto item = cache->index.find(hash);
+    if (item != cache->index.end()) {
+        cache->entries.erase(item->second);
+    }
+    cache->entries.push_front(entry);
+    cache->index[hash] = cache->entries.begin();
+    cache->trim();
+    _entry = entry;
 }
 
 /**
@@ -1329,12 +1721,12 @@ void TextLayout::computeBounds() {
  *
  * This method will not be called if the width is negative.
  */
-void TextLayout::breakLines() {
+void TextLayout::breakLines(size_t start) {
     // First thing we do is to break into lines
     _rows.push_back(Row());
     Row* row = &(_rows.back());
-    row->begin = 0;
-    row->end = 0;
+    row->begin = start;
+    row->end = start;
     row->paragraph = true;
     row->exterior.origin.y = _font->getDescent();
     row->exterior.size.height = _font->getAscent()-_font->getDescent();
@@ -1356,6 +1748,13 @@ void TextLayout::breakLines() {
     Uint32 pcode = 0;
     bool rowStart = true;
     UnicodeType ptype = UnicodeType::SPACE;
+    if (start > 0) {
+        // Resume just after the newline, as if we had just processed it
+        pcode = (Uint32)_text[start];
+        ptype = UnicodeType::NEWLINE;
+        next = _text.c_str()+start+1;
+        curr = next;
+    }
 
     while (curr != textEnd) {
         Uint32 code = utf8::next(next, textEnd);
@@ -1394,7 +1793,7 @@ void TextLayout::breakLines() {
             wordEnd = nullptr;
             lineWidth = 0;
             wordMinX  = wordMaxX  = 0;
-            wordMinY  = wordMaxX  = 0;
+            wordMinY  = wordMaxY  = 0;
             wordLeft  = wordRight = 0;
             pcode = code;
             ptype = type;
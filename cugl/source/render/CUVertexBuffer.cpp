@@ -33,6 +33,7 @@
 #include <cugl/render/CUVertexBuffer.h>
 #include <cugl/render/CUShader.h>
 #include <cugl/render/CUTexture.h>
+#include <cstring>
 
 using namespace cugl;
 
@@ -46,7 +47,14 @@ VertexBuffer::VertexBuffer() :
 _vertArray(0),
 _vertBuffer(0),
 _indxBuffer(0),
-_stride(0) {
+_stride(0),
+_streamVerts(0),
+_streamIndxs(0),
+_region(0),
+_vertHead(0),
+_indxHead(0),
+_uploaded(0),
+_respecs(0) {
     _shader = nullptr;
 }
 
@@ -116,6 +124,14 @@ void VertexBuffer::dispose() {
     }
     _enabled.clear();
     _attributes.clear();
+    for(auto it = _fences.begin(); it != _fences.end(); ++it) {
+        if (*it) {
+            glDeleteSync(*it);
+        }
+    }
+    _fences.clear();
+    _streamVerts = 0;
+    _streamIndxs = 0;
     glDeleteBuffers(1,&_indxBuffer);
     glDeleteBuffers(1,&_vertBuffer);
     glDeleteVertexArrays(1,&_vertArray);
@@ -189,6 +205,7 @@ void VertexBuffer::attach(const std::shared_ptr<Shader>& shader) {
         for(auto it = _attributes.begin(); it != _attributes.end(); ++it) {
             std::string name = it->first;
 			GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+			it->second.location = pos;
 			if (pos == -1) {
 				CUWarn("Active shader has no attribute %s", name.c_str());
 			} else if (_enabled[name]) {
@@ -196,6 +213,7 @@ void VertexBuffer::attach(const std::shared_ptr<Shader>& shader) {
 				glVertexAttribPointer(pos,it->second.size,it->second.type,
 									  it->second.norm,_stride,
 									  reinterpret_cast<void*>(it->second.offset));
+				glVertexAttribDivisor(pos,it->second.divisor);
 			} else {
 				glDisableVertexAttribArray(pos);
 			}
@@ -264,6 +282,8 @@ bool VertexBuffer::isBound() const {
 void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
     glBufferData( GL_ARRAY_BUFFER, _stride * size, data, usage );
+    _uploaded += _stride * size;
+    _respecs++;
     
     GLenum error = glGetError();
     CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
@@ -298,6 +318,8 @@ void VertexBuffer::loadVertexData(const void * data, GLsizei size, GLenum usage)
 void VertexBuffer::loadIndexData(const void * data, GLsizei size, GLenum usage) {
     //CUAssertLog(isBound(), "Vertex buffer is not bound"); // Problems on android emulator for now
     glBufferData( GL_ELEMENT_ARRAY_BUFFER, size * sizeof(GLuint), data, usage );
+    _uploaded += size * sizeof(GLuint);
+    _respecs++;
     GLenum error = glGetError();
     CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
 }
@@ -363,6 +385,185 @@ void VertexBuffer::drawInstanced(GLenum mode, GLsizei count, GLsizei instance, G
 }
 
 
+#pragma mark -
+#pragma mark Streaming
+/**
+ * Sets this vertex buffer to stream its data through a ring.
+ *
+ * Both buffers are specified once, large enough for the given number of
+ * regions of the given size. Each region must hold the largest upload
+ * made by {@link #streamData}. Passing 0 vertices turns streaming off.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param vertices  The number of vertices in a region
+ * @param indices   The number of indices in a region
+ * @param regions   The number of regions in the ring
+ */
+void VertexBuffer::setStreaming(GLsizei vertices, GLsizei indices, size_t regions) {
+    for(auto it = _fences.begin(); it != _fences.end(); ++it) {
+        if (*it) {
+            glDeleteSync(*it);
+        }
+    }
+    _fences.clear();
+    _region = 0;
+    _vertHead = 0;
+    _indxHead = 0;
+    if (vertices <= 0 || regions == 0) {
+        _streamVerts = 0;
+        _streamIndxs = 0;
+        return;
+    }
+    
+    _streamVerts = vertices;
+    _streamIndxs = indices;
+    _fences.resize(regions,0);
+    glBufferData( GL_ARRAY_BUFFER, _stride * vertices * regions, NULL, GL_STREAM_DRAW );
+    _respecs++;
+    if (indices > 0) {
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, indices * regions * sizeof(GLuint), NULL, GL_STREAM_DRAW );
+        _respecs++;
+    }
+
+    GLenum error = glGetError();
+    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+}
+
+/**
+ * Writes the given vertices and indices to the ring, after the last upload.
+ *
+ * The indices are relative to the given vertices, and are rebased as they
+ * are written, so draw commands only need the returned index offset. If
+ * the data does not fit in the current region, the ring moves on to the
+ * next region, waiting for the GPU to finish with it if necessary.
+ *
+ * This method will only succeed if this buffer is actively bound and
+ * streaming.
+ *
+ * @param vertices  The vertices to write
+ * @param vsize     The number of vertices to write
+ * @param indices   The indices to write
+ * @param isize     The number of indices to write
+ *
+ * @return the offset of the first index written, for {@link #draw}
+ */
+GLsizei VertexBuffer::streamData(const void* vertices, GLsizei vsize, const GLuint* indices, GLsizei isize) {
+    CUAssertLog(isStreaming(), "Vertex buffer is not streaming");
+    CUAssertLog(vsize <= _streamVerts && isize <= _streamIndxs, "Upload is larger than a stream region");
+    advance(vsize, isize);
+
+    GLsizei base  = writeVertices(vertices, vsize);
+    GLsizei first = (GLsizei)_region*_streamIndxs+_indxHead;
+
+    // The region is not in use by the GPU, so there is nothing to synchronize
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    GLsizeiptr ibytes = (GLsizeiptr)sizeof(GLuint)*isize;
+    if (ibytes > 0) {
+        GLuint* idst = (GLuint*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)sizeof(GLuint)*first, ibytes, access);
+        if (idst) {
+            for(GLsizei ii = 0; ii < isize; ii++) {
+                idst[ii] = indices[ii]+base;
+            }
+            glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        } else {
+            std::vector<GLuint> rebased(indices,indices+isize);
+            for(auto it = rebased.begin(); it != rebased.end(); ++it) {
+                *it += base;
+            }
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)sizeof(GLuint)*first, ibytes, rebased.data());
+        }
+    }
+
+    _indxHead += isize;
+    _uploaded += ibytes;
+    
+    GLenum error = glGetError();
+    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    return first;
+}
+
+/**
+ * Writes the given vertices to the ring, after the last upload.
+ *
+ * This is the version of {@link #streamData} for a buffer that only
+ * streams its vertices, such as a buffer of instances.
+ *
+ * This method will only succeed if this buffer is actively bound and
+ * streaming.
+ *
+ * @param vertices  The vertices to write
+ * @param size      The number of vertices to write
+ *
+ * @return the offset of the first vertex written
+ */
+GLsizei VertexBuffer::streamVertices(const void* vertices, GLsizei size) {
+    CUAssertLog(isStreaming(), "Vertex buffer is not streaming");
+    CUAssertLog(size <= _streamVerts, "Upload is larger than a stream region");
+    advance(size, 0);
+    GLsizei base = writeVertices(vertices, size);
+    
+    GLenum error = glGetError();
+    CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
+    return base;
+}
+
+/**
+ * Moves the ring to the next region if the given upload does not fit.
+ *
+ * The region left is fenced. If the GPU is not done with the next region,
+ * this waits until it is.
+ *
+ * @param vsize     The number of vertices to write
+ * @param isize     The number of indices to write
+ */
+void VertexBuffer::advance(GLsizei vsize, GLsizei isize) {
+    if (_vertHead+vsize > _streamVerts || _indxHead+isize > _streamIndxs) {
+        // Fence the region we are leaving, and make sure the next one is free
+        _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _region = (_region+1) % _fences.size();
+        GLsync fence = _fences[_region];
+        if (fence) {
+            GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            while (status == GL_TIMEOUT_EXPIRED) {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+            glDeleteSync(fence);
+            _fences[_region] = 0;
+        }
+        _vertHead = 0;
+        _indxHead = 0;
+    }
+}
+
+/**
+ * Writes the given vertices at the head of the current region.
+ *
+ * @param vertices  The vertices to write
+ * @param size      The number of vertices to write
+ *
+ * @return the offset of the first vertex written
+ */
+GLsizei VertexBuffer::writeVertices(const void* vertices, GLsizei size) {
+    GLsizei base = (GLsizei)_region*_streamVerts+_vertHead;
+    GLsizeiptr vbytes = (GLsizeiptr)_stride*size;
+    if (vbytes > 0) {
+        // The region is not in use by the GPU, so there is nothing to synchronize
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void* dst = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)_stride*base, vbytes, access);
+        if (dst) {
+            std::memcpy(dst, vertices, vbytes);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)_stride*base, vbytes, vertices);
+        }
+    }
+    _vertHead += size;
+    _uploaded += vbytes;
+    return base;
+}
+
+
 #pragma mark -
 #pragma mark Attributes
 /**
@@ -384,29 +585,56 @@ void VertexBuffer::drawInstanced(GLenum mode, GLsizei count, GLsizei instance, G
  *@param offset The offset of the first component in the buffer
  */
 void VertexBuffer::setupAttribute(const std::string name, GLint size, GLenum type,
-                                  GLboolean norm, GLsizei offset) {
+                                  GLboolean norm, GLsizei offset, GLuint divisor) {
     AttribData data;
     data.size = size;
     data.norm = norm;
     data.type = type;
     data.offset = offset;
-    _attributes[name] = data;
+    data.divisor = divisor;
+    data.location = -1;
     _enabled[name] = true;
     
     if (_shader != nullptr) {
         _shader->bind();
         GLint pos = glGetAttribLocation(_shader->getProgram(), name.c_str());
+        data.location = pos;
         if (pos == -1) {
             CUWarn("Active shader has no attribute %s", name.c_str());
         } else {
             glEnableVertexAttribArray(pos);
             glVertexAttribPointer(pos,data.size,data.type,data.norm,_stride,
                                   reinterpret_cast<void*>(data.offset));
+            glVertexAttribDivisor(pos,data.divisor);
         }
         
         GLenum error = glGetError();
         CUAssertLog(error == GL_NO_ERROR, "VertexBuffer: %s", gl_error_name(error).c_str());
     }
+    _attributes[name] = data;
+}
+
+/**
+ * Sets the instance attributes to start at the given instance.
+ *
+ * OpenGL ES has no base instance for instanced draws. Instead, this
+ * moves the instance attributes (those with a divisor) so that the
+ * next call to {@link #drawInstanced} starts at the given instance
+ * of the buffer.
+ *
+ * This method will only succeed if this buffer is actively bound.
+ *
+ * @param instance  The first instance to draw
+ */
+void VertexBuffer::setBaseInstance(GLsizei instance) {
+    for(auto it = _attributes.begin(); it != _attributes.end(); ++it) {
+        const AttribData& data = it->second;
+        if (data.divisor > 0 && data.location != -1 && _enabled[it->first]) {
+            GLsizeiptr offset = data.offset+(GLsizeiptr)_stride*(instance/data.divisor);
+            glVertexAttribPointer(data.location,data.size,data.type,data.norm,_stride,
+                                  reinterpret_cast<void*>(offset));
+        }
+    }
 }
 
 /**
@@ -9,6 +9,10 @@ R"(////////// SHADER BEGIN /////////
 //  coordinates. Finally, there is support for very simple blur effects, which
 //  are used for font labels.
 //
+//  Textured quads may also be drawn as instances (see SpriteBatch::setInstancing).
+//  Each instance is an affine map of the unit square, a texture rectangle, and a
+//  color, and this shader expands it into the vertices of the quad.
+//
 //  This shader was inspired by nanovg by Mikko Mononen (memon@inside.org).
 //
 //  CUGL MIT License:
@@ -31,7 +35,7 @@ R"(////////// SHADER BEGIN /////////
 //      3. This notice may not be removed or altered from any source distribution.
 //
 //  Author: Walker White
-//  Version: 3/20/20
+//  Version: 10/18/26
 
 // Positions
 in vec4 aPosition;
@@ -55,8 +59,27 @@ uniform mat4 uPerspective;
 // Depth value (this is a 2d pipeline)
 uniform float uDepth;
 
+// Quad instances (rows of the affine map, and the texture rectangle)
+in vec3 aQuadX;
+in vec3 aQuadY;
+in vec4 aQuadTex;
+
+// Whether to draw quad instances
+uniform int uQuads;
+
 // Transform and pass through                                                   
 void main(void) {
+    if (uQuads != 0) {
+        // The corners (0,0), (1,0), (1,1), (0,1) of the unit square
+        vec3 corner = vec3(float(((gl_VertexID+1)/2)%2),float(gl_VertexID/2),1);
+        vec2 position = vec2(dot(aQuadX,corner),dot(aQuadY,corner));
+        gl_Position = uPerspective*vec4(position,0,1);
+        outPosition = position;
+        outColor = aColor;
+        outTexCoord = vec2(mix(aQuadTex.x,aQuadTex.y,corner.x),mix(aQuadTex.z,aQuadTex.w,corner.y));
+        outGradCoord = vec2(1,1);
+        return;
+    }
     gl_Position = uPerspective*vec4(aPosition.xy,0,1);
     outPosition = aPosition.xy; // Need untransformed for scissor
     outColor = aColor;
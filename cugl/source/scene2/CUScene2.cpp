@@ -41,6 +41,7 @@
 
 #include <cugl/scene2/CUScene2.h>
 #include <cugl/util/CUStrings.h>
+#include <cugl/util/CUProfiler.h>
 #include <sstream>
 #include <algorithm>
 
@@ -61,7 +62,8 @@ _color(Color4::WHITE),
 _blendEquation(GL_FUNC_ADD),
 _srcFactor(GL_SRC_ALPHA),
 _dstFactor(GL_ONE_MINUS_SRC_ALPHA),
-_active(false)
+_active(false),
+_culling(true)
 {}
 
 /**
@@ -76,6 +78,7 @@ void Scene2::dispose() {
     _name = "";
     _color = Color4::WHITE;
     _active = false;
+    _culling = true;
 }
 
 /**
@@ -366,14 +369,32 @@ void Scene2::removeAllChildren() {
  * @param batch     The SpriteBatch to draw with.
  */
 void Scene2::render(const std::shared_ptr<SpriteBatch>& batch) {
+    CUProfileZone("Scene2::render");
     batch->begin(_camera->getCombined());
     batch->setSrcBlendFunc(_srcFactor);
     batch->setDstBlendFunc(_dstFactor);
     batch->setBlendEquation(_blendEquation);
 
+    // The camera view in world space is the image of the NDC box
+    if (_culling) {
+        const Mat4& inverse = _camera->getInverseProjectView();
+        Vec2 corner;
+        Mat4::transform(inverse,Vec2(-1,-1),&corner);
+        Rect bounds(corner,Size::ZERO);
+        Mat4::transform(inverse,Vec2(1,-1),&corner);
+        bounds.merge(Rect(corner,Size::ZERO));
+        Mat4::transform(inverse,Vec2(1,1),&corner);
+        bounds.merge(Rect(corner,Size::ZERO));
+        Mat4::transform(inverse,Vec2(-1,1),&corner);
+        bounds.merge(Rect(corner,Size::ZERO));
+        scene2::SceneNode::_cullBounds = bounds;
+        scene2::SceneNode::_culling = true;
+    }
+
     for(auto it = _children.begin(); it != _children.end(); ++it) {
         (*it)->render(batch, Affine2::IDENTITY, _color);
     }
 
+    scene2::SceneNode::_culling = false;
     batch->end();
 }
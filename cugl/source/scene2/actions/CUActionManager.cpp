@@ -43,6 +43,21 @@
 using namespace cugl;
 using namespace cugl::scene2;
 
+/** The bits of a handle holding the pool slot */
+#define SLOT_MASK   0xffffffffULL
+
+/**
+ * Returns the handle for the given pool slot and generation
+ *
+ * @param slot          The pool slot
+ * @param generation    The generation of the slot
+ *
+ * @return the handle for the given pool slot and generation
+ */
+static inline ActionManager::Handle make_handle(Uint32 slot, Uint32 generation) {
+    return ((ActionManager::Handle)generation << 32) | slot;
+}
+
 /**
  * Disposes all of the resources used by this action manager.
  *
@@ -50,37 +65,146 @@ using namespace cugl::scene2;
  * action manager will be released.They will be deleted if no other object owns them.
  */
 void ActionManager::dispose() {
-    _keys.clear();
-    for(auto it = _actions.begin(); it != _actions.end(); ++it) {
-        delete it->second;
-        it->second = nullptr;
-    }
-    _actions.clear();
+    _handles.clear();
+    _instances.clear();
+    _active.clear();
+    _free.clear();
+    _completed.clear();
 }
 
 /**
- * Deletes this action instance, disposing all resources
+ * Initializes an action manager with room for the given number of animations.
+ *
+ * The manager will not allocate memory until it has more active animations
+ * than the capacity (or a keyed animation is activated).
+ *
+ * @param capacity  The number of animations to reserve
+ *
+ * @return true if initialization was successful.
  */
-ActionManager::ActionInstance::~ActionInstance() {
+bool ActionManager::init(size_t capacity) {
+    _instances.reserve(capacity);
+    _active.reserve(capacity);
+    _free.reserve(capacity);
+    _completed.reserve(capacity);
+    _handles.reserve(capacity);
+    return true;
+}
+
+/**
+ * Resets this action instance, releasing all resources
+ *
+ * The generation is advanced, so that old handles to this instance
+ * are no longer active.
+ */
+void ActionManager::ActionInstance::reset() {
     interpolant = nullptr;
     action = nullptr;
     target = nullptr;
+    key.clear();
+    state = NULL;
+    duration = 0.0f;
+    elapsed = 0.0f;
+    paused = false;
+    done = false;
+    index = INACTIVE;
+    // zero is never a generation, so that NONE is never active
+    generation = generation == 0xffffffff ? 1 : generation+1;
 }
 
 #pragma mark -
-#pragma mark Action Management
+#pragma mark Internal Helpers
 /**
- * Returns true if the given key represents an active animation
+ * Returns the active instance for the given handle
  *
- * @param key       The identifying key
+ * @param handle    The animation handle
+ *
+ * @return the active instance for the given handle (or nullptr if inactive)
+ */
+ActionManager::ActionInstance* ActionManager::lookup(Handle handle) {
+    size_t slot = (size_t)(handle & SLOT_MASK);
+    if (slot >= _instances.size()) {
+        return nullptr;
+    }
+    ActionInstance* instance = &(_instances[slot]);
+    if (instance->generation != (Uint32)(handle >> 32) || instance->index == INACTIVE) {
+        return nullptr;
+    }
+    return instance;
+}
+
+/**
+ * Returns the active instance for the given handle
+ *
+ * @param handle    The animation handle
+ *
+ * @return the active instance for the given handle (or nullptr if inactive)
+ */
+const ActionManager::ActionInstance* ActionManager::lookup(Handle handle) const {
+    size_t slot = (size_t)(handle & SLOT_MASK);
+    if (slot >= _instances.size()) {
+        return nullptr;
+    }
+    const ActionInstance* instance = &(_instances[slot]);
+    if (instance->generation != (Uint32)(handle >> 32) || instance->index == INACTIVE) {
+        return nullptr;
+    }
+    return instance;
+}
+
+/**
+ * Returns a free pool slot, growing the pool if necessary
+ *
+ * @return a free pool slot
+ */
+Uint32 ActionManager::acquire() {
+    if (!_free.empty()) {
+        Uint32 slot = _free.back();
+        _free.pop_back();
+        return slot;
+    }
+    Uint32 slot = (Uint32)_instances.size();
+    _instances.emplace_back();
+    // Keep the lists as large as the pool, so releasing never allocates
+    size_t capacity = _instances.capacity();
+    _active.reserve(capacity);
+    _free.reserve(capacity);
+    _completed.reserve(capacity);
+    return slot;
+}
+
+/**
+ * Removes the instance in the given slot from the active list
+ *
+ * The instance is not reset.  That is the responsibility of the caller.
  *
- * @return true if the given key represents an active animation
+ * @param slot      The pool slot
  */
-bool ActionManager::isActive(std::string key) const {
-    auto action = _actions.find(key);
-    return (action != _actions.end());
+void ActionManager::detach(Uint32 slot) {
+    Uint32 index = _instances[slot].index;
+    Uint32 last  = _active.back();
+    _active[index] = last;
+    _instances[last].index = index;
+    _active.pop_back();
+    _instances[slot].index = INACTIVE;
 }
 
+/**
+ * Resets the instance in the given slot and returns it to the pool
+ *
+ * @param slot      The pool slot
+ */
+void ActionManager::release(Uint32 slot) {
+    ActionInstance& instance = _instances[slot];
+    if (!instance.key.empty()) {
+        _handles.erase(instance.key);
+    }
+    instance.reset();
+    _free.push_back(slot);
+}
+
+#pragma mark -
+#pragma mark Action Management
 /**
  * Actives an animation with the given target and action
  *
@@ -88,58 +212,90 @@ bool ActionManager::isActive(std::string key) const {
  * the linear interpolation. If null, the animation will use the standard
  * linear easing.
  *
- * This method will fail if the provided key is already in use.
- *
- * @param key       The identifying key
  * @param action    The action to animate with
  * @param target    The node to animate on
  * @param easing    The easing (interpolation) function
  *
- * @return true if the animation was successfully started
+ * @return the handle of the new animation
  */
-bool ActionManager::activate(std::string key,
-                             const std::shared_ptr<Action>& action,
-                             const std::shared_ptr<scene2::SceneNode>& target,
-                             std::function<float(float)>easing) {
-    auto item = _actions.find(key);
-    if (item != _actions.end()) {
-        return false;
-    }
-    
-    ActionInstance* instance = new ActionInstance();
-    instance->action = action;
-    instance->target = target;
-    instance->interpolant = easing;
-    action->start(target, &(instance->state));
-    _actions.emplace(key,instance);
-    _keys[target.get()].emplace(key);
-    return true;
+ActionManager::Handle ActionManager::activate(const std::shared_ptr<Action>& action,
+                                              const std::shared_ptr<scene2::SceneNode>& target,
+                                              std::function<float(float)> easing) {
+    Uint32 slot = acquire();
+    ActionInstance& instance = _instances[slot];
+    instance.action = action;
+    instance.target = target;
+    instance.interpolant = std::move(easing);
+    instance.index = (Uint32)_active.size();
+    _active.push_back(slot);
+    action->start(target, &(instance.state));
+    return make_handle(slot, instance.generation);
 }
 
 /**
- * Removes the animation for the given key.
+ * Removes the animation for the given handle.
  *
  * This act will immediately stop the animation.  The animated node will
  * continue to have whatever state it had when the animation stopped.
  *
- * If there is no animation for the give key (e.g. the animation is complete)
- * this method will return false.
+ * If the handle is not active (e.g. the animation is complete) this method
+ * will return false.
  *
- * @param key       The identifying key
+ * @param handle    The animation handle
  *
  * @return true if the animation was successfully removed
  */
-bool ActionManager::remove(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
+bool ActionManager::remove(Handle handle) {
+    ActionInstance* instance = lookup(handle);
+    if (instance == nullptr) {
         return false;
     }
-    ActionInstance* instance = action->second;
+    Uint32 slot = (Uint32)(handle & SLOT_MASK);
     instance->action->stop(instance->target, &(instance->state));
-    _keys[instance->target.get()].erase(key);
-    delete instance;
-    action->second = nullptr;
-    _actions.erase(action);
+    detach(slot);
+    release(slot);
+    return true;
+}
+
+/**
+ * Returns the handle of the animation for the given key
+ *
+ * @param key       The identifying key
+ *
+ * @return the handle of the animation for the given key (or NONE)
+ */
+ActionManager::Handle ActionManager::find(const std::string& key) const {
+    auto item = _handles.find(key);
+    return item == _handles.end() ? NONE : item->second;
+}
+
+/**
+ * Actives an animation with the given target and action
+ *
+ * The easing function allows for effects like bouncing or elasticity in
+ * the linear interpolation. If null, the animation will use the standard
+ * linear easing.
+ *
+ * This method will fail if the provided key is already in use.
+ *
+ * @param key       The identifying key
+ * @param action    The action to animate with
+ * @param target    The node to animate on
+ * @param easing    The easing (interpolation) function
+ *
+ * @return true if the animation was successfully started
+ */
+bool ActionManager::activate(const std::string& key,
+                             const std::shared_ptr<Action>& action,
+                             const std::shared_ptr<scene2::SceneNode>& target,
+                             std::function<float(float)>easing) {
+    if (_handles.find(key) != _handles.end()) {
+        return false;
+    }
+    
+    Handle handle = activate(action, target, std::move(easing));
+    _instances[(size_t)(handle & SLOT_MASK)].key = key;
+    _handles.emplace(key,handle);
     return true;
 }
 
@@ -153,15 +309,18 @@ bool ActionManager::remove(std::string key) {
  * @param dt    The number of seconds to animate
  */
 void ActionManager::update(float dt) {
-    auto completed = std::vector<std::unordered_map<std::string,ActionInstance*>::iterator>();
-    for(auto it = _actions.begin(); it != _actions.end(); ++it) {
-        ActionInstance* instance = it->second;
-        Action* action = instance->action.get();
+    _completed.clear();
+    for(auto it = _active.begin(); it != _active.end(); ++it) {
+        ActionInstance& instance = _instances[*it];
+        if (instance.paused) {
+            continue;
+        }
+        Action* action = instance.action.get();
         float current = 1.0;
         float future  = 1.0;
         if (action->getDuration() > 0) {
-            current = (instance->elapsed) / action->getDuration();
-            future  = (instance->elapsed+dt)/ action->getDuration();
+            current = (instance.elapsed) / action->getDuration();
+            future  = (instance.elapsed+dt)/ action->getDuration();
             // Clamp to end
             if (future > 1.0f) {
                 future = 1.0f;
@@ -170,25 +329,60 @@ void ActionManager::update(float dt) {
             current = 0.0f;
         }
         
-        if (instance->interpolant) {
-            current = instance->interpolant(current);
-            future  = instance->interpolant(future);
+        if (instance.interpolant) {
+            current = instance.interpolant(current);
+            future  = instance.interpolant(future);
         }
         
-        action->update(instance->target, instance->state, future-current);
-        instance->elapsed = instance->elapsed+dt;
-        if (instance->elapsed >= action->getDuration()) {
-            completed.push_back(it);
+        action->update(instance.target, instance.state, future-current);
+        instance.elapsed = instance.elapsed+dt;
+        if (instance.elapsed >= action->getDuration()) {
+            instance.done = true;
+            _completed.push_back(*it);
+        }
+    }
+    if (_completed.empty()) {
+        return;
+    }
+    
+    // Sweep the completed animations out of the active list in place
+    size_t next = 0;
+    for(size_t ii = 0; ii < _active.size(); ii++) {
+        Uint32 slot = _active[ii];
+        if (_instances[slot].done) {
+            _instances[slot].index = INACTIVE;
+        } else {
+            _instances[slot].index = (Uint32)next;
+            _active[next++] = slot;
         }
     }
+    _active.resize(next);
     
-    for (auto it = completed.begin(); it != completed.end(); ++it) {
-        ActionInstance* instance = (*it)->second;
-        instance->action->executeOnCompleteCallback();
-        instance->action->stop(instance->target, &(instance->state));
-        delete instance;
-        (*it)->second = nullptr;
-        _actions.erase(*it);
+    // The callbacks may activate or remove animations (growing the pool and
+    // the completed list), update again or even dispose the manager. So the
+    // completed list is swapped out, and each instance is released before its
+    // callback runs. A slot that is gone (or no longer done) was disposed by an
+    // earlier callback.
+    std::vector<Uint32> completed;
+    completed.swap(_completed);
+    for (size_t ii = 0; ii < completed.size(); ii++) {
+        Uint32 slot = completed[ii];
+        if (slot >= _instances.size() || !_instances[slot].done) {
+            continue;
+        }
+        ActionInstance& instance = _instances[slot];
+        std::shared_ptr<Action> action = std::move(instance.action);
+        std::shared_ptr<SceneNode> target = std::move(instance.target);
+        void* state = instance.state;
+        release(slot);
+        action->executeOnCompleteCallback();
+        action->stop(target, &state);
+    }
+    
+    // Keep the larger buffer, so the next update does not allocate
+    completed.clear();
+    if (_completed.empty() && _completed.capacity() < completed.capacity()) {
+        _completed.swap(completed);
     }
 }
 
@@ -196,54 +390,47 @@ void ActionManager::update(float dt) {
 #pragma mark -
 #pragma mark Pausing
 /**
- * Returns true if the animation for the given key is paused
+ * Returns true if the animation for the given handle is paused
  *
- * This method will return false if there is no active animation with the
- * given key.
+ * This method will return false if the handle is not active.
  *
- * @param key       The identifying key
+ * @param handle    The animation handle
  *
- * @return true if the animation for the given key is paused
+ * @return true if the animation for the given handle is paused
  */
-bool ActionManager::isPaused(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return false;
-    }
-    return action->second->paused;
+bool ActionManager::isPaused(Handle handle) const {
+    const ActionInstance* instance = lookup(handle);
+    return instance != nullptr && instance->paused;
 }
 
 /**
- * Pauses the animation for the given key.
+ * Pauses the animation for the given handle.
  *
- * If there is no active animation for the given key, or if it is already
- * paused, this method does nothing.
+ * If the handle is not active, or if it is already paused, this method
+ * does nothing.
  *
- * @param key       The identifying key
+ * @param handle    The animation handle
  */
-void ActionManager::pause(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return;
+void ActionManager::pause(Handle handle) {
+    ActionInstance* instance = lookup(handle);
+    if (instance != nullptr) {
+        instance->paused = true;
     }
-    action->second->paused = true;
 }
 
-
 /**
- * Unpauses the animation for the given key.
+ * Unpauses the animation for the given handle.
  *
- * If there is no active animation for the given key, or if it is not
- * currently paused, this method does nothing.
+ * If the handle is not active, or if it is not currently paused, this
+ * method does nothing.
  *
- * @param key       The identifying key
+ * @param handle    The animation handle
  */
-void ActionManager::unpause(std::string key) {
-    auto action = _actions.find(key);
-    if (action == _actions.end()) {
-        return;
+void ActionManager::unpause(Handle handle) {
+    ActionInstance* instance = lookup(handle);
+    if (instance != nullptr) {
+        instance->paused = false;
     }
-    action->second->paused = false;
 }
 
 
@@ -257,19 +444,16 @@ void ActionManager::unpause(std::string key) {
  * @param target    The node to stop animating
  */
 void ActionManager::clearAllActions(const std::shared_ptr<scene2::SceneNode>& target) {
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
-        return;
-    }
-    for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        auto action = _actions.find(*it);
-        if (action != _actions.end()) {
-            delete action->second;
-            action->second = nullptr;
-            _actions.erase(action);
+    // Backwards, as detaching moves the last animation into the gap
+    for(size_t ii = _active.size(); ii > 0; ii--) {
+        Uint32 slot = _active[ii-1];
+        ActionInstance& instance = _instances[slot];
+        if (instance.target == target) {
+            instance.action->stop(instance.target, &(instance.state));
+            detach(slot);
+            release(slot);
         }
     }
-    _keys.erase(target.get());
 }
 
 /**
@@ -281,14 +465,9 @@ void ActionManager::clearAllActions(const std::shared_ptr<scene2::SceneNode>& ta
  * @param target    The node to pause animating
  */
 void ActionManager::pauseAllActions(const std::shared_ptr<scene2::SceneNode>& target) {
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
-        return;
-    }
-    for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        auto action = _actions.find(*it);
-        if (action != _actions.end()) {
-            action->second->paused = true;
+    for(auto it = _active.begin(); it != _active.end(); ++it) {
+        if (_instances[*it].target == target) {
+            _instances[*it].paused = true;
         }
     }
 }
@@ -302,14 +481,9 @@ void ActionManager::pauseAllActions(const std::shared_ptr<scene2::SceneNode>& ta
  * @param target    The node to pause animating
  */
 void ActionManager::unpauseAllActions(const std::shared_ptr<scene2::SceneNode>& target) {
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
-        return;
-    }
-    for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        auto action = _actions.find(*it);
-        if (action != _actions.end()) {
-            action->second->paused = false;
+    for(auto it = _active.begin(); it != _active.end(); ++it) {
+        if (_instances[*it].target == target) {
+            _instances[*it].paused = false;
         }
     }
 }
@@ -318,7 +492,8 @@ void ActionManager::unpauseAllActions(const std::shared_ptr<scene2::SceneNode>&
  * Returns the keys for all active animations of the given target
  *
  * The returned vector is a copy of the keys.  Modifying it has no affect
- * on the underlying animation.
+ * on the underlying animation.  Animations activated by handle have no
+ * key and are not included.
  *
  * @param target    The node to query animations
  *
@@ -326,16 +501,11 @@ void ActionManager::unpauseAllActions(const std::shared_ptr<scene2::SceneNode>&
  */
 std::vector<std::string> ActionManager::getAllActions(const std::shared_ptr<scene2::SceneNode>& target) const {
     std::vector<std::string> result;
-    auto set = _keys.find(target.get());
-    if (set == _keys.end()) {
-        return std::vector<std::string>();
-    }
-    for(auto it = set->second.begin(); it != set->second.end(); ++it) {
-        result.push_back(*it);
+    for(auto it = _active.begin(); it != _active.end(); ++it) {
+        const ActionInstance& instance = _instances[*it];
+        if (instance.target == target && !instance.key.empty()) {
+            result.push_back(instance.key);
+        }
     }
     return result;
 }
-
-
-
-
@@ -46,6 +46,19 @@
 using namespace cugl;
 using namespace cugl::scene2;
 
+/** Whether a cached subtree is currently being rendered to its target */
+bool SceneNode::_caching = false;
+/** The number of cached subtrees composited without rendering them */
+Uint64 SceneNode::_cacheHits = 0;
+/** The number of cached subtrees rendered to their target */
+Uint64 SceneNode::_cacheMisses = 0;
+/** Whether to skip the subtrees outside of the cull bounds */
+bool SceneNode::_culling = false;
+/** The visible region of the scene being rendered, in world space */
+Rect SceneNode::_cullBounds;
+/** The number of subtrees skipped for being outside of the cull bounds */
+Uint64 SceneNode::_culled = 0;
+
 #pragma mark Constructors
 /**
  * Creates an uninitialized node.
@@ -69,7 +82,12 @@ _useTransform(false),
 _parent(nullptr),
 _graph(nullptr),
 _childOffset(-2),
-_priority(0) {
+_priority(0),
+_cached(false),
+_cacheValid(false),
+_worldDirty(true),
+_boundsDirty(true),
+_worldBoundsDirty(true) {
     _classname = "SceneNode";
 }
 
@@ -273,6 +291,14 @@ void SceneNode::dispose() {
     _hashOfName = 0;
     _priority = 0.0f;
     _json = nullptr;
+    _cached = false;
+    _cacheValid = false;
+    _cache = nullptr;
+    _worldDirty = true;
+    _boundsDirty = true;
+    _worldBoundsDirty = true;
+    _worldScissor = nullptr;
+    _savedScissor = nullptr;
 }
 
 /**
@@ -324,6 +350,8 @@ void SceneNode::setPosition(float x, float y) {
     _combined.m[4] += (x-_position.x);
     _combined.m[5] += (y-_position.y);
     _position.set(x,y);
+    setBoundsDirty();
+    if (_parent) _parent->invalidate();
 }
 
 /**
@@ -346,6 +374,8 @@ void SceneNode::setContentSize(const Size size) {
     if (_layout) {
         doLayout();
     }
+    setBoundsDirty();
+    invalidate();
 }
 
 /**
@@ -504,6 +534,8 @@ void SceneNode::updateTransform() {
         _combined.m[4] += _position.x-offset.x;
         _combined.m[5] += _position.y-offset.y;
      }
+    setBoundsDirty();
+    if (_parent) _parent->invalidate();
 }
 
 /**
@@ -629,7 +661,8 @@ void SceneNode::addChild(const std::shared_ptr<SceneNode>& child) {
     _children.push_back(child);
     child->setParent(this);
     child->pushScene(_graph);
-    
+    setBoundsDirty();
+    invalidate();
 }
 
 /**
@@ -662,6 +695,8 @@ void SceneNode::swapChild(const std::shared_ptr<SceneNode>& child1,
             child2->addChild(*it);
         }
     }
+    setBoundsDirty();
+    invalidate();
 }
 
 /**
@@ -683,6 +718,8 @@ void SceneNode::removeChild(unsigned int pos) {
         _children[ii]->_childOffset = ii;
     }
     _children.resize(_children.size()-1);
+    setBoundsDirty();
+    invalidate();
 }
 
 /**
@@ -746,6 +783,8 @@ void SceneNode::removeAllChildren() {
         (*it)->pushScene(nullptr);
     }
     _children.clear();
+    setBoundsDirty();
+    invalidate();
 }
 
 /**
@@ -798,30 +837,172 @@ void SceneNode::doLayout() {
 void SceneNode::render(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
     if (!_isVisible) { return; }
     
-    Affine2 matrix;
-    Affine2::multiply(_combined,transform,&matrix);
+    // The world transform only changes if this node or an ancestor moved
+    bool moved = _worldDirty || transform != _worldParent;
+    if (moved) {
+        Affine2::multiply(_combined,transform,&_worldTransform);
+        _worldParent = transform;
+        _worldDirty = false;
+    }
+    if (_culling && !_caching) {
+        if (moved || _boundsDirty || _worldBoundsDirty) {
+            Affine2::transform(transform,getSubtreeBounds(),&_worldBounds);
+            _worldBoundsDirty = false;
+        }
+        if (!_cullBounds.doesIntersect(_worldBounds)) {
+            _culled++;
+            return;
+        }
+    }
+    const Affine2& matrix = _worldTransform;
     Color4 color = _tintColor;
     if (_hasParentColor) {
         color *= tint;
     }
     
-    std::shared_ptr<Scissor> active = batch->getScissor();
+    bool active = false;
     if (_scissor) {
-        std::shared_ptr<Scissor> local = Scissor::alloc(_scissor);
-        local->multiply(matrix);
+        if (_worldScissor == nullptr) {
+            _worldScissor = Scissor::alloc(_scissor);
+            _savedScissor = std::make_shared<Scissor>();
+        } else {
+            _worldScissor->set(*_scissor);
+        }
+        _worldScissor->multiply(matrix);
+        active = batch->getScissor(*_savedScissor);
         if (active) {
-            local->intersect(active);
+            _worldScissor->intersect(*_savedScissor);
         }
-        batch->setScissor(local);
+        batch->setScissor(_worldScissor);
     }
 
-    draw(batch,matrix,color);
-    for(auto it = _children.begin(); it != _children.end(); ++it) {
-        (*it)->render(batch, matrix, color);
+    if (_cached && !_caching) {
+        renderCache(batch,matrix,color);
+    } else {
+        draw(batch,matrix,color);
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->render(batch, matrix, color);
+        }
     }
 
     if (_scissor) {
-        batch->setScissor(active);
+        batch->setScissor(active ? _savedScissor : nullptr);
+    }
+}
+
+/**
+ * Returns the bounds of this node and all of its descendants.
+ *
+ * The bounds are the smallest axis-aligned rectangle in parent space that
+ * contains the content bounds of this node and of every descendant. They
+ * are cached, and only recomputed after a transform, content size, or
+ * child of this subtree changes.
+ *
+ * @return the bounds of this node and all of its descendants.
+ */
+const Rect& SceneNode::getSubtreeBounds() {
+    if (_boundsDirty) {
+        Rect local(Vec2::ZERO,_contentSize);
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            local.merge((*it)->getSubtreeBounds());
+        }
+        Affine2::transform(_combined,local,&_treeBounds);
+        _boundsDirty = false;
+        _worldBoundsDirty = true;
+    }
+    return _treeBounds;
+}
+
+/**
+ * Draws the cached subtree of this node with the given SpriteBatch.
+ *
+ * The subtree is first rendered to the render target if the cache is
+ * stale. The target is then drawn as a single quad.
+ *
+ * @param batch     The SpriteBatch to draw with.
+ * @param transform The global transformation matrix of this node.
+ * @param tint      The tint of this node.
+ */
+void SceneNode::renderCache(const std::shared_ptr<SpriteBatch>& batch, const Affine2& transform, Color4 tint) {
+    // The size of the content box on screen, in pixels
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const Mat4& perspective = batch->getPerspective();
+    Vec2 xaxis = perspective.transformVector(Vec2(transform.m[0],transform.m[1]));
+    Vec2 yaxis = perspective.transformVector(Vec2(transform.m[2],transform.m[3]));
+    Size size(ceilf(_contentSize.width*xaxis.length()*viewport[2]*0.5f),
+              ceilf(_contentSize.height*yaxis.length()*viewport[3]*0.5f));
+    if (size.width < 1 || size.height < 1) {
+        return;
+    }
+
+    if (!_cacheValid || _cache == nullptr || tint != _cacheTint || size != _cacheSize) {
+        if (_cache == nullptr || _cache->getWidth() != (int)size.width || _cache->getHeight() != (int)size.height) {
+            _cache = RenderTarget::alloc((int)size.width,(int)size.height);
+            if (_cache == nullptr) {
+                _cached = false;
+                return;
+            }
+            _cache->setClearColor(Color4::CLEAR);
+        }
+
+        Mat4 saved = perspective;
+        std::shared_ptr<Scissor> scissor = batch->getScissor();
+        batch->setScissor(nullptr);
+        batch->flush();
+
+        // Render targets are bottom-up, so flip the content as we draw it
+        Mat4 flipped;
+        Mat4::createOrthographicOffCenter(0,_contentSize.width,_contentSize.height,0,-1,1,&flipped);
+        _caching = true;
+        _cache->begin();
+        batch->setPerspective(flipped);
+        draw(batch,Affine2::IDENTITY,tint);
+        for(auto it = _children.begin(); it != _children.end(); ++it) {
+            (*it)->render(batch, Affine2::IDENTITY, tint);
+        }
+        batch->flush();
+        _cache->end();
+        _caching = false;
+
+        batch->setPerspective(saved);
+        batch->setScissor(scissor);
+        _cacheTint = tint;
+        _cacheSize = size;
+        _cacheValid = true;
+        _cacheMisses++;
+    } else {
+        _cacheHits++;
+    }
+
+    std::shared_ptr<Texture> texture = batch->getTexture();
+    Color4 color = batch->getColor();
+    batch->setTexture(_cache->getTexture());
+    batch->setColor(Color4::WHITE);
+    batch->fill(Rect(Vec2::ZERO,_contentSize),Vec2::ZERO,transform);
+    batch->setTexture(texture);
+    batch->setColor(color);
+}
+
+/**
+ * Sets whether this node caches the rendering of its subtree.
+ *
+ * @param cached    Whether this node caches the rendering of its subtree
+ */
+void SceneNode::setCached(bool cached) {
+    _cached = cached;
+    _cacheValid = false;
+    if (!cached) {
+        _cache = nullptr;
+    }
+}
+
+/**
+ * Marks the cached rendering of this node and its ancestors as stale.
+ */
+void SceneNode::invalidate() {
+    for(SceneNode* node = this; node != nullptr; node = node->_parent) {
+        node->_cacheValid = false;
     }
 }
 
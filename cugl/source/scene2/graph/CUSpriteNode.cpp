@@ -204,7 +204,9 @@ void SpriteNode::setFrame(int frame) {
     float dx = x-_bounds.origin.x;
     float dy = y-_bounds.origin.y;
     _bounds.origin.set(x,y);
-    shiftTexture(dx, dy);
+    if (dx != 0 || dy != 0) {
+        shiftTexture(dx, dy);
+    }
 }
 
 /**
@@ -495,6 +495,7 @@ void Button::setColor(Color4 color) {
     if (!_down || _downnode) {
         _tintColor = color;
     }
+    invalidate();
 }
 
 /**
@@ -559,6 +560,7 @@ void Button::setDown(bool down) {
     } else if (!down) {
         _tintColor = _upcolor;
     }
+    invalidate();
     
     for(auto it = _listeners.begin(); it != _listeners.end(); ++it) {
         it->second(getName(),down);
@@ -92,6 +92,7 @@ _dstFactor(GL_ONE_MINUS_SRC_ALPHA) {
  */
 void Label::dispose() {
     clearRenderData();
+    _glyphrun.clear();
     _layout = nullptr;
     _font = nullptr;
     _foreground = Color4::BLACK;
@@ -502,12 +503,16 @@ const std::string Label::getText() const {
  * font, then the text will not display at all.
  *
  * Changing this value will regenerate the render data, and is potentially
- * expensive, particularly if the font is using a fallback atlas.
+ * expensive, particularly if the font is using a fallback atlas. Setting
+ * the same text again (without resizing) does nothing.
  *
  * @param text      The text for this label.
  * @param resize    Whether to resize the label to fit the new text.
  */
 void Label::setText(const std::string text, bool resize) {
+    if (!resize && text == _layout->getText()) {
+        return;
+    }
     _layout->setText(text);
     _layout->layout();
     if (resize) {
@@ -1074,11 +1079,17 @@ void Label::generateRenderData() {
     Rect legal = _bounds;
     legal.origin -= _offset;
     _layout->getGlyphs(_glyphrun,legal);
-    for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
+    for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ) {
+        if (it->second->mesh.vertices.empty()) {
+            // An atlas this text no longer uses
+            it = _glyphrun.erase(it);
+            continue;
+        }
         for(auto jt = it->second->mesh.vertices.begin(); jt != it->second->mesh.vertices.end(); ++jt) {
             jt->position += _offset;
             jt->color = _foreground.getPacked();
         }
+        ++it;
     }
 
     _rendered = true;
@@ -1086,10 +1097,17 @@ void Label::generateRenderData() {
 
 /**
  * Clears the render data, releasing all vertices and indices.
+ *
+ * The glyph runs themselves are kept, so that regenerating the render
+ * data reuses their storage.
  */
 void Label::clearRenderData() {
-    _glyphrun.clear();
+    for(auto it = _glyphrun.begin(); it != _glyphrun.end(); ++it) {
+        it->second->mesh.clear();
+        it->second->contents.clear();
+    }
     _rendered = false;
+    invalidate();
 }
 
 /**
@@ -1099,6 +1117,7 @@ void Label::clearRenderData() {
  * colors.
  */
 void Label::updateColor() {
+    invalidate();
     if (!_rendered) {
         return;
     }
@@ -33,6 +33,7 @@
 //  Version: 11/29/16
 //
 #include <cugl/util/CUThreadPool.h>
+#include <cugl/util/CUProfiler.h>
 
 using namespace cugl;
 
@@ -85,15 +86,21 @@ bool ThreadPool::init(int threads) {
  * This implementation is safe to use with std::thread.
  */
 void ThreadPool::threadFunc() {
+    CUProfileThread("worker");
     while (!_stop) {
         std::function<void()> task = nullptr;
+        bool helping = false;
         {   // Lock for save queue access
             std::unique_lock<std::mutex> lk(_queueMutex);
             if (_stop) {
                 break;
             }
-            // Pull the next task off the queue
-            if (!_taskQueue.empty()) {
+            // Help with the parallelFor in flight before any queued task
+            if (_forWanted > 0) {
+                _forWanted--;
+                _forJoined++;
+                helping = true;
+            } else if (!_taskQueue.empty()) {
                 task = std::move(_taskQueue.front());
                 _taskQueue.pop();
             } else {
@@ -102,7 +109,11 @@ void ThreadPool::threadFunc() {
             }
         }
         // Perform the current task
-        task();
+        if (helping) {
+            helpChunks();
+        } else {
+            task();
+        }
     }
     _complete++;
 }
@@ -117,15 +128,21 @@ void ThreadPool::threadFunc() {
  */
 int ThreadPool::sdlThreadFunc(void* ptr) {
     ThreadPool* self = (ThreadPool*)ptr;
+    CUProfileThread("worker");
     while (!self->_stop) {
         std::function<void()> task = nullptr;
+        bool helping = false;
         {   // Lock for save queue access
             std::unique_lock<std::mutex> lk(self->_queueMutex);
             if (self->_stop) {
                 break;
             }
-            // Pull the next task off the queue
-            if (!self->_taskQueue.empty()) {
+            // Help with the parallelFor in flight before any queued task
+            if (self->_forWanted > 0) {
+                self->_forWanted--;
+                self->_forJoined++;
+                helping = true;
+            } else if (!self->_taskQueue.empty()) {
                 task = std::move(self->_taskQueue.front());
                 self->_taskQueue.pop();
             } else {
@@ -134,7 +151,11 @@ int ThreadPool::sdlThreadFunc(void* ptr) {
             }
         }
         // Perform the current task
-        task();
+        if (helping) {
+            self->helpChunks();
+        } else {
+            task();
+        }
     }
     self->_complete++;
     return 0;
@@ -160,6 +181,82 @@ void ThreadPool::addTask(const std::function<void()> &task){
     _taskCondition.notify_one();
 }
 
+/**
+ * Executes the function over the index range [0,count) and waits for it.
+ *
+ * The range is split into chunks of (at most) grain indices, and the body
+ * is invoked once per chunk with its begin and end indices. Chunks are not
+ * assigned up front. Instead, the worker threads and the calling thread
+ * repeatedly claim the next unclaimed chunk, so a thread that finishes
+ * early simply takes more of the work. This method does not return until
+ * every chunk has been processed.
+ *
+ * @param count     the number of indices to process
+ * @param grain     the maximum number of indices per chunk
+ * @param body      the function to execute on each chunk
+ */
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body) {
+    if (count == 0) {
+        return;
+    }
+    grain = grain == 0 ? 1 : grain;
+    size_t chunks = (count+grain-1)/grain;
+    if (_workers.empty() || _stop || chunks == 1) {
+        body(0,count);
+        return;
+    }
+    
+    // The fields of the batch are shared, so only one parallelFor runs at a time
+    if (_forBusy.exchange(true)) {
+        body(0,count);
+        return;
+    }
+    _forBody  = &body;
+    _forCount = count;
+    _forGrain = grain;
+    _forChunks = chunks;
+    _forNext = 0;
+    _forDone = 0;
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _forWanted = std::min(_workers.size(), chunks-1);
+    }
+    _taskCondition.notify_all();
+    runChunks();
+    
+    // Every chunk is claimed, so workers that have not joined yet are not needed
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _forWanted = 0;
+    }
+    std::unique_lock<std::mutex> lk(_forMutex);
+    _forFinished.wait(lk, [&]() { return _forDone.load() == _forChunks && _forJoined.load() == 0; });
+    _forBody = nullptr;
+    _forBusy = false;
+}
+
+/**
+ * Claims and runs chunks of the parallelFor in flight until none are left.
+ */
+void ThreadPool::runChunks() {
+    size_t chunk;
+    while ((chunk = _forNext.fetch_add(1)) < _forChunks) {
+        size_t begin = chunk*_forGrain;
+        (*_forBody)(begin, std::min(begin+_forGrain,_forCount));
+        _forDone.fetch_add(1);
+    }
+}
+
+/**
+ * Runs chunks of the parallelFor in flight on a worker thread that joined it.
+ */
+void ThreadPool::helpChunks() {
+    runChunks();
+    std::unique_lock<std::mutex> lk(_forMutex);
+    _forJoined--;
+    _forFinished.notify_all();
+}
+
 /**
  * Stop the thread pool, marking it for shut down.
  *
@@ -1,6 +1,8 @@
 #include "App.hpp"
 #include "models/LevelConstants.hpp"
 #include "utility/SaveData.hpp"
+#include "utility/AllocationTracker.hpp"
+#include "utility/FrameArena.hpp"
 
 using namespace cugl;
 
@@ -9,8 +11,15 @@ using namespace cugl;
 #pragma mark Application State
 
 void App::onStartup() {
+    CUProfileThread("main");
+    _startTime.mark();
+    _interactive = false;
     _assets = AssetManager::alloc();
     _batch  = SpriteBatch::alloc();
+    // texture switches flush often, so write every flush to one ring buffer
+    _batch->setStreaming(true);
+    // the tiles and sprites are textured quads, so let the vertex shader expand them
+    _batch->setInstancing(true);
     
     // Start-up basic input
 #ifdef CU_TOUCH_SCREEN
@@ -30,24 +39,10 @@ void App::onStartup() {
     _scene = State::LOAD;
     _loading.init(_assets);
     
-    // Queue the other assets
+    // Queue the title assets; the other scenes are loaded once they can be reached
     AudioEngine::start(24);
-    // must ensure assets are loaded in order of being used in scene graphs!
-    _assets->loadDirectoryAsync("json/assets.json",nullptr);
-    _assets->loadDirectoryAsync("json/scenes/textures.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/title.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/gameplay.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/hud.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/pause.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/upgrades.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/tutorial.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/gestures.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/settings.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/death.json", nullptr);
-    _assets->loadDirectoryAsync("json/scenes/win.json", nullptr);
-    _assets->loadDirectoryAsync("json/animations/player.json", nullptr);
-    _assets->loadDirectoryAsync("json/animations/enemy.json", nullptr);
-    _assets->loadDirectoryAsync("json/assets-tileset.json", nullptr);
+    registerScenes();
+    requestAssets(TITLE);
 
     SaveData::hasPreferences();
     AudioController::init(_assets, SaveData::getPreferences());
@@ -57,13 +52,19 @@ void App::onStartup() {
 
 void App::onShutdown() {
     _loading.dispose();
-    _gameplay.dispose();
-    _pause.dispose();
-    _settings.dispose();
-    _title.dispose();
-    _death.dispose();
-    _win.dispose();
+    // scenes that were never built have nothing to dispose
+    if (_lazyScenes[GAME].built) _gameplay.dispose();
+    if (_lazyScenes[PAUSE].built) _pause.dispose();
+    if (_lazyScenes[SETTINGS].built) _settings.dispose();
+    if (_lazyScenes[TITLE].built) _title.dispose();
+    if (_lazyScenes[DEATH].built) _death.dispose();
+    if (_lazyScenes[VICTORY].built) _win.dispose();
+    for (LazyScene& scene : _lazyScenes) {
+        scene.built = false;
+    }
+    _requested.clear();
     AudioController::dispose();
+    FrameArena::dispose();
     _assets = nullptr;
     _batch = nullptr;
     
@@ -93,26 +94,74 @@ void App::onResume() {
 #pragma mark Application Loop
 
 void App::update(float dt){
+    CUProfileZone("App::update");
     if (_loading.isActive()) {
         _loading.update(0.01f);
     } else {
         _loading.dispose(); // Disables the input listeners in this mode
-        _gameplay.init(_assets); // this makes GameScene active
-        if (SaveData::hasPreferences()) _gameplay.getInput().setInverted(SaveData::getPreferences().inverted);
-        _pause.init(_assets);
-        _settings.init(_assets);
-        _title.init(_assets);
-        _death.init(_assets);
-        _win.init(_assets);
-        _tutorial.init(_assets);
+        AudioController::loadCues();
+        AudioController::logMemoryReport();
         // finish loading -> go to title/main menu
+        prepareScene(TITLE);
         _scene = State::TITLE;
         setTitleScene();
         setDeterministic(true);
     }
 }
 
+#pragma mark -
+#pragma mark Scene Loading
+
+void App::registerScenes() {
+    // must ensure assets are loaded in order of being used in scene graphs!
+    // (the textures shared by the menus are part of the title assets)
+    _lazyScenes[TITLE] = { {"json/assets.json", "json/scenes/textures.json", "json/scenes/title.json"},
+        {GAME, TUTORIAL, SETTINGS}, [this]{ _title.init(_assets); } };
+    _lazyScenes[GAME] = { {"json/scenes/gameplay.json", "json/scenes/hud.json", "json/scenes/upgrades.json",
+        "json/scenes/gestures.json", "json/animations/player.json", "json/animations/enemy.json",
+        "json/assets-tileset.json"},
+        {PAUSE, DEATH, VICTORY}, [this]{
+            _gameplay.init(_assets); // this makes GameScene active
+            if (SaveData::hasPreferences()) _gameplay.getInput().setInverted(SaveData::getPreferences().inverted);
+        } };
+    _lazyScenes[PAUSE] = { {"json/scenes/pause.json"}, {SETTINGS}, [this]{ _pause.init(_assets); } };
+    _lazyScenes[SETTINGS] = { {"json/scenes/settings.json"}, {}, [this]{ _settings.init(_assets); } };
+    _lazyScenes[TUTORIAL] = { {"json/scenes/tutorial.json"}, {GAME}, [this]{ _tutorial.init(_assets); } };
+    _lazyScenes[DEATH] = { {"json/scenes/death.json"}, {}, [this]{ _death.init(_assets); } };
+    _lazyScenes[VICTORY] = { {"json/scenes/win.json"}, {}, [this]{ _win.init(_assets); } };
+}
+
+void App::requestAssets(State state) {
+    for (const std::string& directory : _lazyScenes[state].directories) {
+        if (_requested.insert(directory).second) {
+            _assets->loadDirectoryAsync(directory, nullptr);
+        }
+    }
+}
+
+bool App::prepareScene(State state) {
+    LazyScene& scene = _lazyScenes[state];
+    if (scene.built) {
+        return true;
+    }
+    // the directories load in the order they were queued, so the scene is ready
+    // once nothing is pending (anything queued before it was more likely anyway)
+    requestAssets(state);
+    if (!_assets->complete()) {
+        return false;
+    }
+    Timestamp start;
+    scene.build();
+    scene.built = true;
+    CULog("Built scene %d in %llu ms", (int)state, (unsigned long long)Timestamp().ellapsedMillis(start));
+    for (State next : scene.next) {
+        requestAssets(next);
+    }
+    return true;
+}
+
 void App::preUpdate(float dt) {
+    CUProfileZone("App::preUpdate");
     switch (_scene) {
         case LOAD:
             // only for intermediate loading screens
@@ -136,20 +185,25 @@ void App::preUpdate(float dt) {
             break;
         case GAME:
             if (_gameplay.getExitCode() == GameScene::ExitCode::DEATH){
+                // the next scenes were queued when the game was built, so this wait is rare
+                if (!prepareScene(DEATH)) break;
                 _scene = State::DEATH;
                 _gameplay.setActive(false);
                 _death.setActive(true);
             } else if (_gameplay.getExitCode() == GameScene::ExitCode::VICTORY){
+                if (!prepareScene(VICTORY)) break;
                 _scene = State::VICTORY;
                 _gameplay.setActive(false);
                 _win.setActive(true);
             }
             else if(_gameplay.getRenderer().getPaused()){
+                if (!prepareScene(PAUSE)) break;
                 _scene = State::PAUSE;
                 _pause.setLabels(_gameplay.getPlayerLevels());
                 _pause.setConfirmationAlert(!_gameplay.isUpgradeRoom() && !_gameplay.isTutorial());
                 _gameplay.setActive(false);
             } else if(_gameplay.isTutorialComplete()){
+                if (!prepareScene(TUTORIAL)) break;
                 _scene = State::TUTORIAL;
                 _gameplay.setActive(false);
                 _gameplay.setTutorialActive(false);
@@ -171,6 +225,7 @@ void App::preUpdate(float dt) {
 
 
 void App::fixedUpdate() {
+    CUProfileZone("App::fixedUpdate");
     switch (_scene) {
         case GAME:
             // Compute time to report to game scene version of fixedUpdate
@@ -183,6 +238,7 @@ void App::fixedUpdate() {
 
 
 void App::postUpdate(float dt) {
+    CUProfileZone("App::postUpdate");
     switch (_scene) {
         case GAME:
             // Compute time to report to game scene version of postUpdate
@@ -216,6 +272,7 @@ void App::updatePauseScene(float dt) {
             _scene = State::GAME;
             break;
         case PauseScene::Choice::SETTINGS:
+            if (!prepareScene(SETTINGS)) break;
             _pause.setActive(false);
             _settings.setActive(true);
             _scene = SETTINGS;
@@ -242,6 +299,8 @@ void App::updateTitleScene(float dt){
         case TitleScene::NONE:
             break;
         case TitleScene::NEW:
+            // the choice is kept until the scene is built, so just try again next frame
+            if (!prepareScene(GAME)) break;
             _title.setActive(false);
             _gameplay.setTutorialActive(false);
             _gameplay.setActive(true);
@@ -250,6 +309,7 @@ void App::updateTitleScene(float dt){
             _gamePrevScene = TITLE;
             break;
         case TitleScene::CONTINUE:
+            if (!prepareScene(GAME)) break;
             _title.setActive(false);
             _gameplay.setActive(true);
 //            CULog("loading lv %d", save.level);
@@ -259,12 +319,14 @@ void App::updateTitleScene(float dt){
             _gamePrevScene = TITLE;
             break;
         case TitleScene::SETTINGS:
+            if (!prepareScene(SETTINGS)) break;
             _title.setActive(false);
             _settings.setActive(true);
             _scene = SETTINGS; // switch to settings scene
             _prevScene = TITLE;
             break;
         case TitleScene::TUTORIAL:
+            if (!prepareScene(TUTORIAL)) break;
             _title.setActive(false);
             _tutorial.setActive(true);
             _scene = TUTORIAL;
@@ -282,6 +344,7 @@ void App::updateTutorialScene(float dt){
             _scene = TITLE;
             break;
         case TutorialScene::LEVEL:
+            if (!prepareScene(GAME)) break;
             _tutorial.setActive(false);
             _gameplay.activateTutorial(_tutorial.getSelectedLevel());
             _gamePrevScene = TUTORIAL;
@@ -352,46 +415,57 @@ void App::updateVictoryScene(float dt){
 
 
 void App::draw() {
-    switch (_scene) {
-        case LOAD:
-            _loading.render(_batch);
-            break;
-        case PAUSE:
-            _gameplay.render(_batch);
-            _pause.render(_batch);
-            break;
-        case GAME:
-            _gameplay.render(_batch);
-            break;
-        case TITLE:
-            _title.render(_batch);
-            break;
-        case TUTORIAL:
-            _tutorial.render(_batch);
-            break;
-        case SETTINGS:
-            switch (_prevScene) {
+    // The draw zone must close before the frame ends, or it lands in the next frame
+    {
+        CUProfileZone("App::draw");
+        switch (_scene) {
+            case LOAD:
+                _loading.render(_batch);
+                break;
             case PAUSE:
                 _gameplay.render(_batch);
                 _pause.render(_batch);
                 break;
+            case GAME:
+                _gameplay.render(_batch);
+                break;
             case TITLE:
                 _title.render(_batch);
+                if (!_interactive) {
+                    _interactive = true;
+                    CULog("Title screen interactive after %llu ms", (unsigned long long)Timestamp().ellapsedMillis(_startTime));
+                }
                 break;
             case TUTORIAL:
                 _tutorial.render(_batch);
                 break;
-            default: //should never be here since you can only access settings from pause and title scenes
+            case SETTINGS:
+                switch (_prevScene) {
+                case PAUSE:
+                    _gameplay.render(_batch);
+                    _pause.render(_batch);
+                    break;
+                case TITLE:
+                    _title.render(_batch);
+                    break;
+                case TUTORIAL:
+                    _tutorial.render(_batch);
+                    break;
+                default: //should never be here since you can only access settings from pause and title scenes
+                    break;
+                }
+                _settings.render(_batch);
                 break;
-            }
-            _settings.render(_batch);
-            break;
-        case DEATH:
-            _gameplay.render(_batch);
-            _death.render(_batch);
-            break;
-        case VICTORY:
-            _win.render(_batch);            
+            case DEATH:
+                _gameplay.render(_batch);
+                _death.render(_batch);
+                break;
+            case VICTORY:
+                _win.render(_batch);            
+        }
     }
+    _batch->endFrame();
+    CUProfileFrame();
+    AllocationTracker::endFrame();
 }
 
@@ -18,6 +18,9 @@
 #include "scenes/WinScene.hpp"
 #include "scenes/TutorialScene.hpp"
 #include "controllers/AudioController.hpp"
+#include <array>
+#include <functional>
+#include <unordered_set>
 
 /**
  * This class represents the application root for the ship demo.
@@ -44,6 +47,24 @@ protected:
         VICTORY
     };
     
+    /**
+     * A scene that is only built when it is first needed.
+     *
+     * The asset directories of a scene are queued in the background as soon as
+     * a scene that can lead to it is built, and the scene itself is built on
+     * its first activation. Scenes the player never reaches cost nothing.
+     */
+    struct LazyScene {
+        /** The asset directories of the scene, in load order */
+        std::vector<std::string> directories;
+        /** The scenes that can follow this one, from most to least likely */
+        std::vector<State> next;
+        /** Initializes the scene once its assets are loaded */
+        std::function<void()> build;
+        /** Whether the scene has been built */
+        bool built = false;
+    };
+    
     /** The global sprite batch for drawing (only want one of these) */
     std::shared_ptr<cugl::SpriteBatch> _batch;
     /** The global asset manager */
@@ -73,6 +94,15 @@ protected:
     /** The previously active scene - this is only used to know where
     to go if the user exits the settings scene */
     State _prevScene;
+    
+    /** The lazily built scenes, indexed by state (LOAD has no entry) */
+    std::array<LazyScene,VICTORY+1> _lazyScenes;
+    /** The asset directories queued so far */
+    std::unordered_set<std::string> _requested;
+    /** The time the application started, to measure the time to an interactive title */
+    cugl::Timestamp _startTime;
+    /** Whether the title screen has been drawn yet */
+    bool _interactive;
 
     
 public:
@@ -248,6 +278,34 @@ public:
     virtual void draw() override;
 
 private:
+    /**
+     * Registers the asset directories and the factory of each scene.
+     */
+    void registerScenes();
+    
+    /**
+     * Queues the asset directories of the given scene that are not yet queued.
+     *
+     * Directories are loaded in the order they are queued, so the scenes
+     * requested first are ready first.
+     *
+     * @param state the scene to load the assets of
+     */
+    void requestAssets(State state);
+    
+    /**
+     * Builds the given scene if its assets are loaded.
+     *
+     * If the assets are still loading, this queues them (if necessary) and
+     * returns false, so the caller can try again on a later frame. Building a
+     * scene queues the assets of the scenes likely to follow it.
+     *
+     * @param state the scene to build
+     *
+     * @return true if the scene is built and can be activated
+     */
+    bool prepareScene(State state);
+    
     /**
      * Inidividualized update method for the pause scene.
      *
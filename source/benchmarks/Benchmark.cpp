@@ -0,0 +1,120 @@
+//
+//  Benchmark.cpp
+//  RS
+//
+//  Version: 10/18/26
+//
+
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+/** The largest batch size tried while calibrating */
+#define MAX_BATCH   (1ULL << 30)
+
+/** Returns the nanoseconds taken by the given number of iterations of the body */
+static Uint64 timeBatch(const Benchmark::Body& body, Uint64 iterations) {
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+}
+
+/** Returns the given percentile of the sorted samples (nearest rank) */
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = (size_t)(p*(sorted.size()-1)+0.5);
+    return sorted[std::min(rank, sorted.size()-1)];
+}
+
+#pragma mark -
+#pragma mark Results
+
+std::string Benchmark::Result::getHeader() {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%-40s %7s %10s %12s %12s %12s %12s %12s %12s",
+             "benchmark", "samples", "batch", "min_ns", "median_ns", "p90_ns", "p99_ns", "max_ns", "mean_ns");
+    return buffer;
+}
+
+std::string Benchmark::Result::toString() const {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%-40s %7d %10llu %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f",
+             name.c_str(), samples, (unsigned long long)batch, minNs, medianNs, p90Ns, p99Ns, maxNs, meanNs);
+    return buffer;
+}
+
+std::shared_ptr<JsonValue> Benchmark::Result::toJson() const {
+    std::shared_ptr<JsonValue> json = JsonValue::allocObject();
+    json->appendValue("name", name);
+    json->appendValue("samples", (long)samples);
+    json->appendValue("batch", (long)batch);
+    json->appendValue("min_ns", minNs);
+    json->appendValue("median_ns", medianNs);
+    json->appendValue("p90_ns", p90Ns);
+    json->appendValue("p99_ns", p99Ns);
+    json->appendValue("max_ns", maxNs);
+    json->appendValue("mean_ns", meanNs);
+    return json;
+}
+
+#pragma mark -
+#pragma mark Harness
+
+bool Benchmark::isSelected(const std::string name) const {
+    if (_filters.empty()) {
+        return true;
+    }
+    for (auto& filter : _filters) {
+        if (name.find(filter) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Benchmark::run(const std::string name, const Body& body) {
+    if (!isSelected(name)) {
+        return false;
+    }
+
+    // Calibrate (and warm up) by doubling the batch until it fills a sample
+    Uint64 batch = 1;
+    Uint64 elapsed = timeBatch(body, batch);
+    while (elapsed < _sampleNanos && batch < MAX_BATCH) {
+        batch *= 2;
+        elapsed = timeBatch(body, batch);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(_samples);
+    double total = 0;
+    for (int ii = 0; ii < _samples; ii++) {
+        double nanos = (double)timeBatch(body, batch)/batch;
+        samples.push_back(nanos);
+        total += nanos;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.samples = _samples;
+    result.batch = batch;
+    result.minNs = samples.front();
+    result.medianNs = percentile(samples, 0.5);
+    result.p90Ns = percentile(samples, 0.9);
+    result.p99Ns = percentile(samples, 0.99);
+    result.maxNs = samples.back();
+    result.meanNs = total/_samples;
+    _results.push_back(result);
+    std::cout << result.toString() << std::endl;
+    return true;
+}
+
+std::shared_ptr<JsonValue> Benchmark::toJson() const {
+    std::shared_ptr<JsonValue> json = JsonValue::allocArray();
+    for (auto& result : _results) {
+        json->appendChild(result.toJson());
+    }
+    return json;
+}
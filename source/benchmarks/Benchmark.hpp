@@ -0,0 +1,200 @@
+//
+//  Benchmark.hpp
+//  RS
+//
+//  A small microbenchmark harness for the benchmarks tool. Each benchmark is a body
+//  that runs a given number of iterations of the measured operation. The harness warms
+//  the body up while calibrating a batch size that takes at least the target sample
+//  time, then times a fixed number of batches. The per-iteration times of the batches
+//  are reported as min, median, p90, p99, max and mean, so runs can be compared across
+//  commits and machines.
+//
+//  Version: 10/18/26
+//
+
+#ifndef __BENCHMARK_HPP__
+#define __BENCHMARK_HPP__
+
+#include <cugl/cugl.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace cugl;
+
+/**
+ * Prevents the compiler from removing the computation of the given value.
+ *
+ * @param value the value to keep
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+class Benchmark {
+public:
+    /** The timings of a single benchmark */
+    struct Result {
+        /** the name of the benchmark */
+        std::string name;
+        /** the number of timed samples */
+        int samples = 0;
+        /** the number of iterations in each sample */
+        Uint64 batch = 0;
+        /** the fastest iteration time in nanoseconds */
+        double minNs = 0;
+        /** the median iteration time in nanoseconds */
+        double medianNs = 0;
+        /** the 90th percentile iteration time in nanoseconds */
+        double p90Ns = 0;
+        /** the 99th percentile iteration time in nanoseconds */
+        double p99Ns = 0;
+        /** the slowest iteration time in nanoseconds */
+        double maxNs = 0;
+        /** the mean iteration time in nanoseconds */
+        double meanNs = 0;
+
+        /**
+         * Returns the column names matching {@link #toString}.
+         *
+         * @return the column names matching {@link #toString}.
+         */
+        static std::string getHeader();
+
+        /**
+         * Returns the timings as a single row of text.
+         *
+         * @return the timings as a single row of text.
+         */
+        std::string toString() const;
+
+        /**
+         * Returns the timings as a JSON object.
+         *
+         * @return the timings as a JSON object.
+         */
+        std::shared_ptr<JsonValue> toJson() const;
+    };
+
+    /** The body of a benchmark, running the given number of iterations */
+    typedef std::function<void(Uint64 iterations)> Body;
+
+protected:
+    /** The substrings selecting the benchmarks to run (all if empty) */
+    std::vector<std::string> _filters;
+    /** The number of timed samples per benchmark */
+    int _samples;
+    /** The minimum duration of a sample, in nanoseconds */
+    Uint64 _sampleNanos;
+    /** The results of the benchmarks run so far */
+    std::vector<Result> _results;
+
+public:
+    /**
+     * Creates a harness with 50 samples of at least 2 milliseconds each.
+     */
+    Benchmark() : _samples(50), _sampleNanos(2000000) {}
+
+    /**
+     * Sets the number of timed samples per benchmark.
+     *
+     * @param samples   the number of timed samples per benchmark
+     */
+    void setSamples(int samples) { _samples = samples > 0 ? samples : 1; }
+
+    /**
+     * Sets the minimum duration of a sample, in milliseconds.
+     *
+     * @param millis    the minimum duration of a sample, in milliseconds
+     */
+    void setSampleTime(double millis) { _sampleNanos = (Uint64)(millis*1000000); }
+
+    /**
+     * Adds a substring selecting the benchmarks to run.
+     *
+     * A benchmark runs if its name contains any of the filters. With no
+     * filters, every benchmark runs.
+     *
+     * @param filter    a substring of the benchmark names to run
+     */
+    void addFilter(const std::string filter) { _filters.push_back(filter); }
+
+    /**
+     * Returns true if the benchmark with the given name should run.
+     *
+     * Use this to skip expensive setup for filtered benchmarks.
+     *
+     * @param name  the benchmark name
+     *
+     * @return true if the benchmark with the given name should run.
+     */
+    bool isSelected(const std::string name) const;
+
+    /**
+     * Runs the given benchmark (if selected) and prints its timings.
+     *
+     * @param name  the benchmark name, as group/case
+     * @param body  the body running the given number of iterations
+     *
+     * @return true if the benchmark ran
+     */
+    bool run(const std::string name, const Body& body);
+
+    /**
+     * Returns the results of the benchmarks run so far.
+     *
+     * @return the results of the benchmarks run so far.
+     */
+    const std::vector<Result>& getResults() const { return _results; }
+
+    /**
+     * Returns the results of the benchmarks run so far as a JSON array.
+     *
+     * @return the results of the benchmarks run so far as a JSON array.
+     */
+    std::shared_ptr<JsonValue> toJson() const;
+};
+
+#pragma mark -
+#pragma mark Suites
+
+/**
+ * Runs the benchmarks of the game code: the level grid, path finding, the
+ * sight fan, level parsing and animations.
+ *
+ * @param bench     the benchmark harness
+ * @param assets    the json and (stub) texture assets
+ * @param levels    the keys of the Tiled maps
+ */
+void runGameBenchmarks(Benchmark& bench, const std::shared_ptr<AssetManager>& assets,
+                       const std::vector<std::string>& levels);
+
+/**
+ * Runs the benchmarks of the engine code: JSON, triangulation, sprite batch
+ * vertex generation and audio mixing.
+ *
+ * @param bench     the benchmark harness
+ * @param assets    the json and (stub) texture assets
+ * @param levels    the keys of the Tiled maps
+ * @param root      the asset root
+ */
+void runEngineBenchmarks(Benchmark& bench, const std::shared_ptr<AssetManager>& assets,
+                         const std::vector<std::string>& levels, const std::string root);
+
+/**
+ * Checks that the SIMD ATK vector kernels match the scalar kernels bit for bit.
+ *
+ * The kernels are compared on a seeded signal with the special float values
+ * (signed zeros, infinities and NaN) and on every short tail length.
+ *
+ * @return true if every kernel matches
+ */
+bool checkVecKernels();
+
+#endif /* __BENCHMARK_HPP__ */
@@ -0,0 +1,555 @@
+//
+//  EngineBenchmarks.cpp
+//  RS
+//
+//  The benchmarks of the engine code, measured on the data of the game where there is
+//  any: the Tiled maps for JSON, the wall colliders for triangulation, the menu and HUD
+//  layouts for the scene graph. The sprite batch is headless, so only the CPU-side vertex
+//  generation is measured, and the audio mixer is read directly without an output
+//  device. The audio benchmarks run with both the SIMD and the scalar ATK vector kernels.
+//  The action manager benchmarks also log the heap allocations of an update. The text
+//  benchmarks lay out the menu text with the fonts of the game (glyph quads need the
+//  font atlas textures, so only the layout is measured).
+//
+//  Version: 10/18/26
+//
+
+#include "Benchmark.hpp"
+#include "../models/LevelConstants.hpp"
+#include "../utility/LevelParser.hpp"
+#include "../utility/GameRandom.hpp"
+#include "../utility/AllocationTracker.hpp"
+#include <ATK_math.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+/** The number of sprites drawn per iteration (a busy frame) */
+#define SPRITES         1000
+/** The number of textures the sprites alternate between */
+#define SPRITE_TEXTURES 4
+/** The number of frames read from the mixer per iteration (one device buffer) */
+#define MIXER_FRAMES    512
+/** The output rate of the audio mixer */
+#define MIXER_RATE      48000
+/** The length of the vectors of the ATK kernel benchmarks and checks (not a multiple of 8) */
+#define VEC_LENGTH      1027
+/** The size of the scenes of the scene graph benchmarks (the design size of the layouts) */
+#define SCENE_WIDTH     1280
+#define SCENE_HEIGHT    720
+/** The number of animations of the action manager benchmarks */
+#define ACTIONS         64
+/** The number of updates the action manager allocations are averaged over */
+#define ACTION_UPDATES  1000
+/** The line width of the text layout benchmarks (a menu panel) */
+#define TEXT_WIDTH      400
+/** The number of lines of the relayout benchmarks (the debug overlay) */
+#define TEXT_LINES      12
+/** The number of versions of the changing line of the relayout benchmarks */
+#define TEXT_VERSIONS   16
+
+/**
+ * Collects the collider polygon of every wall in the given parsed level.
+ *
+ * Every option of a randomized layer is included.
+ */
+static void collectWalls(const std::shared_ptr<JsonValue>& json, std::vector<std::vector<Vec2>>& walls) {
+    if (json == nullptr) {
+        return;
+    }
+    if (json->isObject() && json->getString(CLASS) == CLASS_WALL && json->has("collider")) {
+        std::vector<float> vertices = json->get("collider")->get("vertices")->asFloatArray();
+        if (vertices.size() >= 6 && vertices.size() % 2 == 0) {
+            std::vector<Vec2> polygon;
+            for (size_t ii = 0; ii < vertices.size(); ii += 2) {
+                polygon.push_back(Vec2(vertices[ii], vertices[ii+1]));
+            }
+            walls.push_back(polygon);
+        }
+        return;
+    }
+    for (int ii = 0; ii < json->size(); ii++) {
+        collectWalls(json->get(ii), walls);
+    }
+}
+
+/**
+ * Returns a scene graph with the shape of the given scene2 node.
+ *
+ * The console tools cannot load fonts or widgets, so every node with a size is a
+ * textured rectangle (as the images, buttons and labels of the game are, roughly) and
+ * the others are plain nodes. The positions, anchors and sizes are those of the game.
+ */
+static std::shared_ptr<scene2::SceneNode> buildShape(const std::shared_ptr<JsonValue>& json,
+                                                     const std::shared_ptr<Texture>& texture) {
+    std::shared_ptr<JsonValue> data = json->get("data");
+    Rect bounds = Rect::ZERO;
+    std::shared_ptr<JsonValue> size = data == nullptr ? nullptr : data->get("size");
+    if (size != nullptr && size->size() >= 2) {
+        // a polygon (as in the sprites) is a list of coordinates
+        std::vector<float> coords = size->asFloatArray();
+        if (coords.size() == 2) {
+            bounds.size.set(coords[0], coords[1]);
+        } else {
+            for (size_t ii = 0; ii+1 < coords.size(); ii += 2) {
+                bounds.merge(Rect(coords[ii], coords[ii+1], 0, 0));
+            }
+        }
+    }
+    std::shared_ptr<scene2::SceneNode> node;
+    if (bounds.size.width > 0 && bounds.size.height > 0) {
+        node = scene2::PolygonNode::allocWithTexture(texture, bounds);
+    } else {
+        node = scene2::SceneNode::alloc();
+    }
+    if (data != nullptr) {
+        std::shared_ptr<JsonValue> anchor = data->get("anchor");
+        if (anchor != nullptr && anchor->size() == 2) {
+            node->setAnchor(anchor->get(0)->asFloat(), anchor->get(1)->asFloat());
+        }
+        std::shared_ptr<JsonValue> position = data->get("position");
+        if (position != nullptr && position->size() == 2) {
+            node->setPosition(position->get(0)->asFloat(), position->get(1)->asFloat());
+        }
+        node->setAngle(data->getFloat("angle", 0));
+    }
+    std::shared_ptr<JsonValue> children = json->get("children");
+    for (int ii = 0; children != nullptr && ii < children->size(); ii++) {
+        node->addChild(buildShape(children->get(ii), texture));
+    }
+    return node;
+}
+
+/**
+ * Collects the text of every label in the given scene2 node.
+ *
+ * @param json  the scene2 node
+ * @param texts the list to append the text to
+ */
+static void collectText(const std::shared_ptr<JsonValue>& json, std::vector<std::string>& texts) {
+    if (json == nullptr) {
+        return;
+    }
+    std::shared_ptr<JsonValue> data = json->get("data");
+    if (data != nullptr && data->has("text") && data->get("text")->isString()) {
+        texts.push_back(data->getString("text"));
+    }
+    for (int ii = 0; ii < json->size(); ii++) {
+        if (json->get(ii)->isObject()) {
+            collectText(json->get(ii), texts);
+        }
+    }
+}
+
+/**
+ * Looks up the fields LevelParser reads from every layer and object of a map.
+ *
+ * @return the number of fields found
+ */
+static size_t lookupFields(const std::shared_ptr<JsonValue>& map) {
+    size_t found = 0;
+    std::shared_ptr<JsonValue> layers = map->get(LAYERS_KEY);
+    if (layers == nullptr) {
+        return found;
+    }
+    found += map->has(WIDTH_FIELD) + map->has(HEIGHT_FIELD);
+    for (int ii = 0; ii < layers->size(); ii++) {
+        std::shared_ptr<JsonValue> layer = layers->get(ii);
+        found += layer->getString(TYPE) == OBJECT_LAYER;
+        found += layer->getBool(VISIBLE, true);
+        std::shared_ptr<JsonValue> objects = layer->get("objects");
+        if (objects == nullptr) {
+            continue;
+        }
+        for (int jj = 0; jj < objects->size(); jj++) {
+            std::shared_ptr<JsonValue> object = objects->get(jj);
+            found += object->getInt("id") != 0;
+            found += object->getFloat("x") != 0 || object->getFloat("y") != 0;
+            found += object->has("polygon") + object->has("properties");
+        }
+    }
+    return found;
+}
+
+/**
+ * Fills the given vector with a seeded signal in [-2,2], plus the special values.
+ */
+static void fillSignal(std::vector<float>& data, Uint32 seed) {
+    std::mt19937 random(seed);
+    for (size_t ii = 0; ii < data.size(); ii++) {
+        data[ii] = 4.0f*((float)random()/(float)random.max())-2.0f;
+    }
+    const float special[] = { 0.0f, -0.0f, 1.0f, -1.0f, INFINITY, -INFINITY, NAN };
+    for (size_t ii = 0; ii < sizeof(special)/sizeof(float) && ii < data.size(); ii++) {
+        data[3*ii+1] = special[ii];
+    }
+}
+
+/**
+ * Runs the given kernel call with the scalar and the SIMD kernels.
+ *
+ * @return true if both outputs have the same bits
+ */
+static bool compareKernel(const char* name, std::vector<float>& output,
+                          const std::function<void(float*)>& call) {
+    std::vector<float> expected(output.size());
+    ATK_VecSetSIMD(SDL_FALSE);
+    call(expected.data());
+    ATK_VecSetSIMD(SDL_TRUE);
+    call(output.data());
+    if (std::memcmp(expected.data(), output.data(), output.size()*sizeof(float)) != 0) {
+        std::cerr << "ATK_Vec" << name << " (" << ATK_VecGetSIMD() << ") differs from the scalar kernel\n";
+        return false;
+    }
+    return true;
+}
+
+#pragma mark -
+#pragma mark Suite
+
+bool checkVecKernels() {
+    std::vector<float> input1(VEC_LENGTH), input2(VEC_LENGTH), output(VEC_LENGTH);
+    fillSignal(input1, 1);
+    fillSignal(input2, 2);
+    bool exact = true;
+    exact = compareKernel("Add", output, [&](float* out) { ATK_VecAdd(input1.data(), input2.data(), out, VEC_LENGTH); }) && exact;
+    exact = compareKernel("Mult", output, [&](float* out) { ATK_VecMult(input1.data(), input2.data(), out, VEC_LENGTH); }) && exact;
+    exact = compareKernel("Scale", output, [&](float* out) { ATK_VecScale(input1.data(), 0.37f, out, VEC_LENGTH); }) && exact;
+    exact = compareKernel("Clip", output, [&](float* out) { ATK_VecClip(input1.data(), -1, 1, out, VEC_LENGTH); }) && exact;
+    exact = compareKernel("Clip", output, [&](float* out) { ATK_VecClip(input1.data(), 1, -1, out, VEC_LENGTH); }) && exact;
+    exact = compareKernel("ClipKnee", output, [&](float* out) { ATK_VecClipKnee(input1.data(), 1, 0.9f, out, VEC_LENGTH); }) && exact;
+    // the short tails, and the kernels in place
+    for (size_t len = 0; len < 17; len++) {
+        std::vector<float> tail(input1.begin(), input1.begin()+len);
+        exact = compareKernel("Add", tail, [&](float* out) {
+            std::copy(input1.begin(), input1.begin()+len, out);
+            ATK_VecAdd(out, input2.data(), out, len);
+        }) && exact;
+    }
+    std::cout << "vector kernels: " << ATK_VecGetSIMD() << (exact ? ", bit-exact" : ", MISMATCH") << "\n";
+    return exact;
+}
+
+
+void runEngineBenchmarks(Benchmark& bench, const std::shared_ptr<AssetManager>& assets,
+                         const std::vector<std::string>& levels, const std::string root) {
+    // the source files of the maps, to parse the raw text
+    std::shared_ptr<JsonValue> sources = nullptr;
+    std::shared_ptr<JsonReader> reader = JsonReader::alloc(root+"json/assets.json");
+    if (reader != nullptr) {
+        std::shared_ptr<JsonValue> directory = reader->readJson();
+        sources = directory == nullptr ? nullptr : directory->get("jsons");
+    }
+
+    LevelParser parser;
+    parser.loadTilesets(assets);
+    std::vector<std::vector<Vec2>> walls;
+    for (auto& key : levels) {
+        std::shared_ptr<JsonValue> map = assets->get<JsonValue>(key);
+        std::string file = sources == nullptr ? "" : sources->getString(key);
+        std::shared_ptr<TextReader> text = file.empty() ? nullptr : TextReader::alloc(root+file);
+        if (text != nullptr) {
+            std::string contents = text->readAll();
+            text->close();
+            bench.run("json/parse/"+key, [&](Uint64 iterations) {
+                for (Uint64 ii = 0; ii < iterations; ii++) {
+                    doNotOptimize(JsonValue::allocWithJson(contents));
+                }
+            });
+        }
+        bench.run("json/get/"+key, [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                doNotOptimize(lookupFields(map));
+            }
+        });
+        GameRandom::seed(0);
+        collectWalls(parser.parseTiled(map), walls);
+    }
+
+    // every wall polygon of the game, triangulated as in LevelModel::loadWall
+    if (!walls.empty()) {
+        EarclipTriangulator triangulator;
+        bench.run("earclip/walls_x"+std::to_string(walls.size()), [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                for (auto& wall : walls) {
+                    triangulator.set(wall);
+                    triangulator.calculate();
+                    doNotOptimize(triangulator.getTriangulation());
+                    triangulator.clear();
+                }
+            }
+        });
+    }
+
+    // a frame of sprites alternating between textures, on the CPU only
+    std::shared_ptr<SpriteBatch> batch = SpriteBatch::allocHeadless();
+    std::shared_ptr<Texture> textures[SPRITE_TEXTURES];
+    for (int ii = 0; ii < SPRITE_TEXTURES; ii++) {
+        textures[ii] = std::make_shared<Texture>();
+    }
+    bench.run("sprite_batch/quads_x1000", [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            batch->begin();
+            for (int jj = 0; jj < SPRITES; jj++) {
+                batch->draw(textures[jj*SPRITE_TEXTURES/SPRITES], Rect((float)(jj % 40)*32, (float)(jj/40)*32, 32, 32));
+            }
+            batch->end();
+        }
+    });
+    auto transformed = [&](Uint64 iterations) {
+        Rect bounds(0, 0, 64, 64);
+        Vec2 origin(32, 32);
+        Vec2 scale(0.5f, 0.5f);
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            batch->begin();
+            for (int jj = 0; jj < SPRITES; jj++) {
+                batch->draw(textures[jj*SPRITE_TEXTURES/SPRITES], bounds, origin, scale, 0.01f*jj,
+                            Vec2((float)(jj % 40)*32, (float)(jj/40)*32));
+            }
+            batch->end();
+        }
+    };
+    bench.run("sprite_batch/transformed_x1000", transformed);
+    // the same sprites as quad instances, expanded by the vertex shader instead
+    batch->setInstancing(true);
+    bench.run("sprite_batch/transformed_x1000/instanced", transformed);
+    batch->setInstancing(false);
+
+    // the scene graphs of the HUD and the menus, redrawn as every frame does
+    const std::pair<std::string, std::string> graphs[] = {
+        {"HUD", "json/scenes/hud.json"}, {"upgrades", "json/scenes/upgrades.json"},
+        {"tutorial", "json/scenes/tutorial.json"}
+    };
+    for (auto& graph : graphs) {
+        std::shared_ptr<JsonReader> scenes = JsonReader::alloc(root+graph.second);
+        std::shared_ptr<JsonValue> json = scenes == nullptr ? nullptr : scenes->readJson();
+        json = json == nullptr || json->get("scene2s") == nullptr ? nullptr : json->get("scene2s")->get(graph.first);
+        if (json == nullptr) {
+            CULogError("Could not read the scene graph '%s'", graph.first.c_str());
+            continue;
+        }
+        std::shared_ptr<scene2::SceneNode> node = buildShape(json, textures[0]);
+        std::shared_ptr<Scene2> scene = Scene2::alloc(SCENE_WIDTH, SCENE_HEIGHT);
+        scene->addChild(node);
+        auto render = [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                scene->render(batch);
+            }
+        };
+        bench.run("scene2/render/"+graph.first, render);
+        scene->setCulling(false);
+        bench.run("scene2/render/"+graph.first+"/unculled", render);
+        scene->setCulling(true);
+        // one child moving every frame, as the joysticks of the HUD do
+        std::shared_ptr<scene2::SceneNode> moving = node->getChildCount() > 0 ? node->getChild(0) : node;
+        Vec2 origin = moving->getPosition();
+        bench.run("scene2/render/"+graph.first+"/moving", [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                moving->setPosition(origin.x+(ii % 16), origin.y);
+                scene->render(batch);
+            }
+        });
+        moving->setPosition(origin);
+        // the whole graph off screen, as the menus are before they slide in
+        node->setPosition(node->getPosition().x-2*SCENE_WIDTH, node->getPosition().y);
+        bench.run("scene2/render/"+graph.first+"/offscreen", render);
+        scene->dispose();
+    }
+    batch = nullptr;
+
+    // the action manager, with animations that run on and animations that end at once
+    std::vector<std::shared_ptr<scene2::SceneNode>> targets;
+    std::vector<scene2::ActionManager::Handle> handles;
+    std::vector<std::string> keys;
+    for (int ii = 0; ii < ACTIONS; ii++) {
+        targets.push_back(scene2::SceneNode::alloc());
+        keys.push_back("action_"+std::to_string(ii));
+    }
+    std::shared_ptr<scene2::MoveBy> drift = scene2::MoveBy::alloc(Vec2(1, 0), 1.0e6f);
+    std::shared_ptr<scene2::MoveBy> blink = scene2::MoveBy::alloc(Vec2(1, 0), 0.0f);
+    scene2::ActionManager actions;
+    actions.init(ACTIONS);
+    for (int ii = 0; ii < ACTIONS; ii++) {
+        handles.push_back(actions.activate(drift, targets[ii]));
+    }
+    bench.run("actions/update_x64", [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            actions.update(1.0f/60.0f);
+        }
+    });
+    bench.run("actions/lookup_x64/handle", [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            int active = 0;
+            for (auto& handle : handles) {
+                active += actions.isActive(handle) ? 1 : 0;
+            }
+            doNotOptimize(active);
+        }
+    });
+    actions.dispose();
+    actions.init(ACTIONS);
+    for (int ii = 0; ii < ACTIONS; ii++) {
+        actions.activate(keys[ii], drift, targets[ii]);
+    }
+    bench.run("actions/lookup_x64/key", [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            int active = 0;
+            for (auto& key : keys) {
+                active += actions.isActive(key) ? 1 : 0;
+            }
+            doNotOptimize(active);
+        }
+    });
+    actions.dispose();
+    actions.init(ACTIONS);
+    auto complete = [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            for (int jj = 0; jj < ACTIONS; jj++) {
+                actions.activate(blink, targets[jj]);
+            }
+            actions.update(1.0f/60.0f);
+        }
+    };
+    bench.run("actions/complete_x64", complete);
+    AllocationTracker::Counters before = AllocationTracker::getTotals();
+    complete(ACTION_UPDATES);
+    AllocationTracker::Counters after = AllocationTracker::getTotals();
+    CULog("actions/complete_x64: %.2f allocations per update",
+          (double)(after.allocs-before.allocs)/ACTION_UPDATES);
+    actions.dispose();
+
+    // the text of the menus, laid out with the fonts of the game
+    std::vector<std::string> menuText;
+    const std::string menus[] = {"title", "pause", "settings", "death", "win", "upgrades", "tutorial"};
+    for (auto& menu : menus) {
+        std::shared_ptr<JsonReader> scenes = JsonReader::alloc(root+"json/scenes/"+menu+".json");
+        collectText(scenes == nullptr ? nullptr : scenes->readJson(), menuText);
+    }
+    // a debug overlay whose last (or first) line changes every frame
+    std::string overlay;
+    for (int ii = 1; ii < TEXT_LINES; ii++) {
+        overlay += "counter "+std::to_string(ii)+": "+std::to_string(ii*1237 % 1000)+" ms\n";
+    }
+    std::vector<std::string> appended, edited;
+    for (int ii = 0; ii < TEXT_VERSIONS; ii++) {
+        std::string line = "frame "+std::to_string(ii)+": "+std::to_string(16+ii % 3)+".6 ms";
+        appended.push_back(overlay+line);
+        edited.push_back(line+"\n"+overlay);
+    }
+    std::shared_ptr<JsonValue> fonts = nullptr;
+    reader = JsonReader::alloc(root+"json/assets.json");
+    if (reader != nullptr) {
+        std::shared_ptr<JsonValue> directory = reader->readJson();
+        fonts = directory == nullptr ? nullptr : directory->get("fonts");
+    }
+    if (fonts != nullptr && !TTF_WasInit() && TTF_Init() < 0) {
+        CULogError("Could not initialize SDL_ttf: %s", TTF_GetError());
+        fonts = nullptr;
+    }
+    size_t capacity = TextLayout::getCacheCapacity();
+    std::vector<std::string> files;
+    for (int ii = 0; fonts != nullptr && ii < fonts->size(); ii++) {
+        // one size of every font file is enough
+        std::shared_ptr<JsonValue> entry = fonts->get(ii);
+        std::string file = entry->getString("file");
+        if (std::find(files.begin(), files.end(), file) != files.end()) {
+            continue;
+        }
+        files.push_back(file);
+        std::shared_ptr<Font> font = Font::alloc(root+file, entry->getInt("size"));
+        if (font == nullptr) {
+            CULogError("Could not load the font '%s'", file.c_str());
+            continue;
+        }
+        std::string key = entry->key();
+        std::shared_ptr<TextLayout> layout = TextLayout::allocWithTextWidth("", font, TEXT_WIDTH);
+        auto menu = [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                for (auto& text : menuText) {
+                    layout->setText(text);
+                    layout->layout();
+                    doNotOptimize(layout->getBounds());
+                }
+            }
+        };
+        TextLayout::setCacheCapacity(0);
+        bench.run("text/layout/"+key, menu);
+        TextLayout::setCacheCapacity(capacity);
+        bench.run("text/layout/"+key+"/cached", menu);
+
+        // uncached, so only the kept paragraphs make the difference
+        TextLayout::setCacheCapacity(0);
+        layout->setWidth(0);
+        auto relayout = [&](const std::vector<std::string>& versions) {
+            return [&](Uint64 iterations) {
+                for (Uint64 ii = 0; ii < iterations; ii++) {
+                    layout->setText(versions[ii % TEXT_VERSIONS]);
+                    layout->layout();
+                    doNotOptimize(layout->getBounds());
+                }
+            };
+        };
+        bench.run("text/relayout/"+key+"/last_line", relayout(appended));
+        bench.run("text/relayout/"+key+"/first_line", relayout(edited));
+        TextLayout::setCacheCapacity(capacity);
+        TextLayout::clearCache();
+    }
+
+    // a one second tone per voice, rewound whenever it completes
+    std::shared_ptr<AudioSample> sample = AudioSample::alloc(2, MIXER_RATE, MIXER_RATE);
+    float* data = sample->getBuffer();
+    for (Uint32 ii = 0; ii < MIXER_RATE; ii++) {
+        data[2*ii] = data[2*ii+1] = 0.25f*sinf(2*M_PI*440*ii/MIXER_RATE);
+    }
+    std::vector<float> input1(VEC_LENGTH), input2(VEC_LENGTH), result(VEC_LENGTH);
+    fillSignal(input1, 1);
+    fillSignal(input2, 2);
+    const std::string simd = ATK_VecGetSIMD();
+    for (const std::string& kernels : {simd, std::string("scalar")}) {
+        ATK_VecSetSIMD(kernels == simd ? SDL_TRUE : SDL_FALSE);
+        bench.run("atk/vec_add/"+kernels, [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                ATK_VecAdd(input1.data(), input2.data(), result.data(), VEC_LENGTH);
+                doNotOptimize(result[0]);
+            }
+        });
+        bench.run("atk/vec_clip_knee/"+kernels, [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                ATK_VecClipKnee(input1.data(), 1, 0.9f, result.data(), VEC_LENGTH);
+                doNotOptimize(result[0]);
+            }
+        });
+    }
+    ATK_VecSetSIMD(SDL_TRUE);
+
+    std::vector<float> output(MIXER_FRAMES*2);
+    for (int voices : {1, 8, 24}) {
+        std::shared_ptr<audio::AudioMixer> mixer = audio::AudioMixer::alloc(voices, 2, MIXER_RATE);
+        std::vector<std::shared_ptr<audio::AudioNode>> players;
+        for (int ii = 0; ii < voices; ii++) {
+            std::shared_ptr<audio::AudioNode> player = sample->createNode();
+            player->setPosition((ii*MIXER_RATE/voices) % MIXER_RATE);
+            mixer->attach(ii, player);
+            players.push_back(player);
+        }
+        auto body = [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                mixer->read(output.data(), MIXER_FRAMES);
+                for (auto& player : players) {
+                    if (player->completed()) {
+                        player->setPosition(0);
+                    }
+                }
+            }
+        };
+        bench.run("audio/mixer_read_x"+std::to_string(voices), body);
+        ATK_VecSetSIMD(SDL_FALSE);
+        bench.run("audio/mixer_read_x"+std::to_string(voices)+"/scalar", body);
+        ATK_VecSetSIMD(SDL_TRUE);
+        for (int ii = 0; ii < voices; ii++) {
+            mixer->detach(ii);
+        }
+    }
+}
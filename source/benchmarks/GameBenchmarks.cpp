@@ -0,0 +1,261 @@
+//
+//  GameBenchmarks.cpp
+//  RS
+//
+//  The benchmarks of the game code. The levels are built from the real Tiled maps,
+//  as in the headless runner, so the grid, walls and enemies are those of the game.
+//
+//  Version: 10/18/26
+//
+
+#include "Benchmark.hpp"
+#include "../models/LevelModel.hpp"
+#include "../models/LevelGrid.hpp"
+#include "../models/Player.hpp"
+#include "../models/Enemy.hpp"
+#include "../models/CollisionConstants.hpp"
+#include "../controllers/AIController.hpp"
+#include "../controllers/CollisionController.hpp"
+#include "../components/Animation.hpp"
+#include "../utility/LevelParser.hpp"
+#include "../utility/GameRandom.hpp"
+#include <random>
+
+/** The number of rays in an enemy sight fan (see AIController::lineOfSight) */
+#define FAN_RAYS        13
+/** The number of animations updated per iteration (a crowded room) */
+#define ANIMATIONS      64
+/** The number of sample points for the grid conversions */
+#define GRID_POINTS     1024
+/** The fixed time step of the game */
+#define FIXED_STEP      (1.0f/60.0f)
+
+/**
+ * Returns the level for the given key, built as in the game.
+ *
+ * The random streams are reseeded first, so the randomized layers are the
+ * same on every run.
+ */
+static std::shared_ptr<LevelModel> buildLevel(const std::shared_ptr<AssetManager>& assets,
+                                              LevelParser& parser, const std::string key) {
+    std::shared_ptr<JsonValue> map = assets->get<JsonValue>(key);
+    if (map == nullptr) {
+        return nullptr;
+    }
+    GameRandom::seed(0);
+    std::shared_ptr<LevelModel> level = LevelModel::alloc(assets->get<JsonValue>("constants"), parser.parseTiled(map));
+    if (level == nullptr) {
+        return nullptr;
+    }
+    level->setAssets(assets);
+    // the draw scale of the default 1024x576 window, as in GameScene::setLevel
+    float scale = 1024/level->getViewBounds().width;
+    level->setDrawScale(Vec2(scale, scale));
+    return level;
+}
+
+#pragma mark -
+#pragma mark Level Benchmarks
+
+/** Benchmarks the grid conversions on random points of the level */
+static void benchGrid(Benchmark& bench, const std::string key, const std::shared_ptr<LevelModel>& level) {
+    std::shared_ptr<LevelGrid> grid = level->getGrid();
+    const Rect& bounds = level->getBounds();
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> unit(0, 1);
+    std::vector<Vec2> points;
+    points.reserve(GRID_POINTS);
+    for (int ii = 0; ii < GRID_POINTS; ii++) {
+        points.push_back(bounds.origin+Vec2(unit(random)*bounds.size.width, unit(random)*bounds.size.height));
+    }
+    std::vector<Vec2> tiles;
+    tiles.reserve(GRID_POINTS);
+    for (auto& point : points) {
+        tiles.push_back(grid->worldToTile(point));
+    }
+
+    bench.run("grid/world_to_tile/"+key, [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            doNotOptimize(grid->worldToTile(points[ii % GRID_POINTS]));
+        }
+    });
+    bench.run("grid/tile_to_world/"+key, [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            doNotOptimize(grid->tileToWorld(tiles[ii % GRID_POINTS]));
+        }
+    });
+}
+
+/** Benchmarks the path step of every enemy towards the player */
+static void benchPathing(Benchmark& bench, const std::string key, const std::shared_ptr<LevelModel>& level) {
+    auto& enemies = level->getEnemies();
+    if (enemies.empty()) {
+        return;
+    }
+    AIController ai;
+    ai.init(level);
+    Vec2 goal = level->getPlayer()->getPosition();
+    bench.run("ai/move_to_goal/"+key, [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            doNotOptimize(ai.moveToGoal(enemies[ii % enemies.size()]->getPosition(), goal));
+        }
+    });
+}
+
+/**
+ * Benchmarks the sight fan of every enemy, aimed at the player.
+ *
+ * The fan is cast as one ObstacleWorld::rayCastFan, as 13 filtered calls to
+ * ObstacleWorld::rayCast, and as 13 unfiltered calls through std::function
+ * (the original line of sight).
+ */
+static void benchSightFan(Benchmark& bench, const std::string key, const std::shared_ptr<LevelModel>& level) {
+    auto& enemies = level->getEnemies();
+    if (enemies.empty()) {
+        return;
+    }
+    auto& world = level->getWorld();
+    Vec2 target = level->getPlayer()->getPosition();
+
+    // one fan per enemy, as in AIController::lineOfSight
+    std::vector<Vec2> origins;
+    std::vector<Vec2> ends;
+    for (auto& enemy : enemies) {
+        Vec2 origin = enemy->getPosition();
+        float angle = (target-origin).getAngle();
+        origins.push_back(origin);
+        for (int ii = 0; ii < FAN_RAYS; ii++) {
+            float rayAngle = angle + (M_PI/180)*(5*ii - 30);
+            ends.push_back(origin + enemy->getSightRange() * Vec2(cosf(rayAngle), sinf(rayAngle)));
+        }
+    }
+    const uint16 categories = CATEGORY_PLAYER | CATEGORY_TALL_WALL;
+    float nearest[FAN_RAYS];
+
+    bench.run("sight/ray_cast_fan/"+key, [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            size_t fan = ii % origins.size();
+            std::fill(nearest, nearest+FAN_RAYS, 2.0f);
+            world->rayCastFan([&](size_t ray, b2Fixture* fixture, const Vec2 point, const Vec2 normal, float fraction) {
+                nearest[ray] = std::min(nearest[ray], fraction);
+                return 1.0f;
+            }, origins[fan], &ends[fan*FAN_RAYS], FAN_RAYS, categories);
+            doNotOptimize(nearest);
+        }
+    });
+    bench.run("sight/ray_cast_x13/"+key, [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            size_t fan = ii % origins.size();
+            for (int ray = 0; ray < FAN_RAYS; ray++) {
+                nearest[ray] = 2.0f;
+                world->rayCast([&](b2Fixture* fixture, const Vec2 point, const Vec2 normal, float fraction) {
+                    nearest[ray] = std::min(nearest[ray], fraction);
+                    return 1.0f;
+                }, origins[fan], ends[fan*FAN_RAYS+ray], categories);
+            }
+            doNotOptimize(nearest);
+        }
+    });
+    bench.run("sight/ray_cast_x13_unfiltered/"+key, [&](Uint64 iterations) {
+        int ray = 0;
+        std::function<float(b2Fixture*, const Vec2, const Vec2, float)> callback =
+            [&](b2Fixture* fixture, const Vec2 point, const Vec2 normal, float fraction) {
+                uint16 bits = fixture->GetFilterData().categoryBits;
+                if ((bits & categories) != 0) {
+                    nearest[ray] = std::min(nearest[ray], fraction);
+                }
+                return 1.0f;
+            };
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            size_t fan = ii % origins.size();
+            for (ray = 0; ray < FAN_RAYS; ray++) {
+                nearest[ray] = 2.0f;
+                world->rayCast(callback, origins[fan], ends[fan*FAN_RAYS+ray]);
+            }
+            doNotOptimize(nearest);
+        }
+    });
+}
+
+/**
+ * Benchmarks a physics step of the level, with the collision callbacks of the game.
+ *
+ * The level is stepped as loaded, where resting bodies may fall asleep, and
+ * with every body woken before each step (a room where everything moves).
+ * This steps the world, so it must be the last benchmark of the level.
+ */
+static void benchPhysics(Benchmark& bench, const std::string key, const std::shared_ptr<LevelModel>& level,
+                         const std::shared_ptr<AssetManager>& assets) {
+    CollisionController collisions;
+    collisions.setLevel(level);
+    collisions.setAssets(assets);
+    auto& world = level->getWorld();
+    bench.run("physics/step/"+key, [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            world->update(FIXED_STEP);
+        }
+    });
+    bench.run("physics/step/"+key+"/awake", [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            for (b2Body* body = world->getWorld()->GetBodyList(); body != nullptr; body = body->GetNext()) {
+                body->SetAwake(true);
+            }
+            world->update(FIXED_STEP);
+        }
+    });
+    CULog("physics/step/%s: %d bodies, %d broadphase proxies", key.c_str(),
+          world->getWorld()->GetBodyCount(), world->getWorld()->GetProxyCount());
+}
+
+#pragma mark -
+#pragma mark Suite
+
+void runGameBenchmarks(Benchmark& bench, const std::shared_ptr<AssetManager>& assets,
+                       const std::vector<std::string>& levels) {
+    LevelParser parser;
+    parser.loadTilesets(assets);
+
+    for (auto& key : levels) {
+        std::shared_ptr<JsonValue> map = assets->get<JsonValue>(key);
+        bench.run("level/parse_tiled/"+key, [&](Uint64 iterations) {
+            for (Uint64 ii = 0; ii < iterations; ii++) {
+                doNotOptimize(parser.parseTiled(map));
+            }
+        });
+
+        if (!bench.isSelected("grid/") && !bench.isSelected("ai/") && !bench.isSelected("sight/")
+            && !bench.isSelected("physics/")) {
+            continue;
+        }
+        std::shared_ptr<LevelModel> level = buildLevel(assets, parser, key);
+        if (level == nullptr) {
+            CULogError("Could not build level '%s'", key.c_str());
+            continue;
+        }
+        benchGrid(bench, key, level);
+        benchPathing(bench, key, level);
+        benchSightFan(bench, key, level);
+        benchPhysics(bench, key, level, assets);
+    }
+
+    // the animations of a crowded room, on an empty sprite sheet
+    std::shared_ptr<Texture> texture = assets->get<Texture>("player-idle");
+    if (texture == nullptr) {
+        texture = std::make_shared<Texture>();
+    }
+    std::vector<std::shared_ptr<Animation>> animations;
+    for (int ii = 0; ii < ANIMATIONS; ii++) {
+        std::shared_ptr<SpriteSheet> sheet = SpriteSheet::alloc(texture, 1, 8);
+        std::shared_ptr<Animation> animation = Animation::alloc(sheet, 0.5f+0.01f*ii, true);
+        animation->addCallback(0.25f, [](){});
+        animation->start();
+        animations.push_back(animation);
+    }
+    bench.run("animation/update_x64", [&](Uint64 iterations) {
+        for (Uint64 ii = 0; ii < iterations; ii++) {
+            for (auto& animation : animations) {
+                animation->update(1.0f/60.0f);
+            }
+        }
+    });
+}
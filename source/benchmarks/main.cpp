@@ -0,0 +1,82 @@
+//
+//  main.cpp
+//  RS
+//
+//  The entry point of the benchmarks tool. It runs repeatable microbenchmarks of the
+//  hot paths of the game and engine on the game assets, and prints the median and
+//  percentile time of each one. The JSON report can be kept to compare commits.
+//
+//  Usage: benchmarks [--assets DIR] [--samples N] [--sample-ms MS] [--json FILE]
+//                    [--check-simd] [filter ...]
+//
+//  A benchmark runs if its name contains any filter (e.g. "sight/" or "level1").
+//  With --check-simd, the tool only checks that the SIMD audio kernels match the
+//  scalar ones, and fails if they do not.
+//
+//  Version: 10/18/26
+//
+#define SDL_MAIN_HANDLED
+#include "Benchmark.hpp"
+#include "../headless/HeadlessAssets.hpp"
+#include <cstdlib>
+#include <iostream>
+
+using namespace cugl;
+
+int main(int argc, char * argv[]) {
+    std::string root;
+    std::string output;
+    bool checkSimd = false;
+    Benchmark bench;
+    for (int ii = 1; ii < argc; ii++) {
+        std::string arg = argv[ii];
+        if (arg == "--assets" && ii+1 < argc) {
+            root = argv[++ii];
+        } else if (arg == "--samples" && ii+1 < argc) {
+            bench.setSamples(std::atoi(argv[++ii]));
+        } else if (arg == "--sample-ms" && ii+1 < argc) {
+            bench.setSampleTime(std::atof(argv[++ii]));
+        } else if (arg == "--json" && ii+1 < argc) {
+            output = argv[++ii];
+        } else if (arg == "--check-simd") {
+            checkSimd = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "usage: " << argv[0] << " [--assets DIR] [--samples N] [--sample-ms MS] [--json FILE] [--check-simd] [filter ...]\n";
+            return 1;
+        } else {
+            bench.addFilter(arg);
+        }
+    }
+    if (checkSimd) {
+        return checkVecKernels() ? 0 : 1;
+    }
+
+    // the cmake build copies the assets next to the executable
+    if (root.empty()) {
+        char* base = SDL_GetBasePath();
+        root = base == nullptr ? "" : base;
+        SDL_free(base);
+    }
+    root = HeadlessAssets::normalize(root);
+    std::shared_ptr<AssetManager> assets = HeadlessAssets::alloc(root);
+    if (assets == nullptr) {
+        return 1;
+    }
+    std::vector<std::string> levels = HeadlessAssets::getLevelKeys(assets, root);
+
+    std::cout << Benchmark::Result::getHeader() << "\n";
+    runGameBenchmarks(bench, assets, levels);
+    runEngineBenchmarks(bench, assets, levels, root);
+    assets->dispose();
+
+    if (!output.empty()) {
+        std::shared_ptr<JsonWriter> writer = JsonWriter::alloc(output);
+        if (writer == nullptr) {
+            std::cerr << "Could not write " << output << "\n";
+            return 1;
+        }
+        writer->writeJson(bench.toJson());
+        writer->close();
+    }
+    return bench.getResults().empty() ? 1 : 0;
+}
@@ -6,6 +6,10 @@
 //
 
 #include "Collider.hpp"
+#include <box2d/b2_body.h>
+#include <box2d/b2_fixture.h>
+#include <box2d/b2_polygon_shape.h>
+#include <box2d/b2_circle_shape.h>
 
 
 std::shared_ptr<physics2::Obstacle> Collider::makePolygon(std::shared_ptr<JsonValue> colliderData, b2BodyType type, std::string name, bool is_sensor){
@@ -60,3 +64,44 @@ std::shared_ptr<physics2::Obstacle> Collider::makeCollider(std::shared_ptr<JsonV
     CULogError("unsupported shape or missing shape information");
     return nullptr;
 }
+
+int Collider::attachFixtures(const std::shared_ptr<physics2::ObstacleWorld>& world, const std::shared_ptr<physics2::Obstacle>& owner, const std::shared_ptr<physics2::Obstacle>& part){
+    // activate the part just long enough to build its fixtures, then copy them over
+    world->addObstacle(part);
+    b2Body* source = part->getBody();
+    b2Body* target = owner->getBody();
+    b2Vec2 offset = source->GetPosition() - target->GetPosition();
+    int count = 0;
+    for (b2Fixture* f = source->GetFixtureList(); f; f = f->GetNext()){
+        b2FixtureDef def;
+        def.friction = f->GetFriction();
+        def.restitution = f->GetRestitution();
+        def.density = 0.0f;
+        def.isSensor = f->IsSensor();
+        def.filter = f->GetFilterData();
+        b2PolygonShape polygon;
+        b2CircleShape circle;
+        if (f->GetType() == b2Shape::e_polygon){
+            const b2PolygonShape* shape = static_cast<const b2PolygonShape*>(f->GetShape());
+            b2Vec2 vertices[b2_maxPolygonVertices];
+            for (int ii = 0; ii < shape->m_count; ii++){
+                vertices[ii] = shape->m_vertices[ii] + offset;
+            }
+            polygon.Set(vertices, shape->m_count);
+            def.shape = &polygon;
+        }
+        else if (f->GetType() == b2Shape::e_circle){
+            circle = *static_cast<const b2CircleShape*>(f->GetShape());
+            circle.m_p += offset;
+            def.shape = &circle;
+        }
+        else {
+            CULogError("unsupported fixture shape in compound collider");
+            continue;
+        }
+        target->CreateFixture(&def);
+        count++;
+    }
+    world->removeObstacle(part);
+    return count;
+}
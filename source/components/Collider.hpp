@@ -67,6 +67,20 @@ public:
      * }
      */
     static std::shared_ptr<physics2::Obstacle> makeCollider(std::shared_ptr<JsonValue> colliderData, b2BodyType type, std::string name, bool is_sensor = false);
+    
+#pragma mark Compound Box2D bodies
+    
+    /**
+     * attaches the shape of `part` to the body of `owner` as extra fixtures, so the two share a single Box2D body.
+     *
+     * Each attached fixture keeps the filter data and sensor flag of `part` but adds no mass to `owner`. The fixtures
+     * move with `owner` for free and are destroyed along with its body. `part` itself is only used as a shape template
+     * and is not left in the world.
+     *
+     * @pre `owner` is in the world, `part` is not, and neither is rotated
+     * @return the number of fixtures attached
+     */
+    static int attachFixtures(const std::shared_ptr<physics2::ObstacleWorld>& world, const std::shared_ptr<physics2::Obstacle>& owner, const std::shared_ptr<physics2::Obstacle>& part);
 };
 
 #endif /* Collider_hpp */
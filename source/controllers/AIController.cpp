@@ -11,6 +11,10 @@
 #include "../models/BossEnemy.hpp"
 #include "../models/Player.hpp"
 #include "../models/CollisionConstants.hpp"
+#include "../models/GameConstants.hpp"
+#include "../utility/GameRandom.hpp"
+#include "../utility/FrameArena.hpp"
+#include <algorithm>
 
 using namespace cugl;
 
@@ -19,244 +23,244 @@ void AIController::init(std::shared_ptr<LevelModel> level) {
     _enemies = level->getEnemies();
     _player = level->getPlayer();
     _grid = level->getGrid();
+    _frame = 0;
+    _cursor = 0;
+    _lastUpdate.clear();
+    _stats = FrameStats();
+    // one random stream per enemy, so draws do not depend on which thread decides first
+    unsigned int seed = GameRandom::next(GameRandom::AI);
+    _random.clear();
+    for (size_t ii = 0; ii < _enemies.size(); ii++) {
+        std::seed_seq seq{seed, (unsigned int)ii};
+        _random.emplace_back(seq);
+    }
+    if (_threads < 0) {
+        setWorkerThreads(GameConstants::AI_WORKER_THREADS);
+    }
 }
 
 AIController::~AIController(){
     _world = nullptr;
     _enemies.clear();
+    _workers = nullptr;
 }
 
-cugl::Vec2 AIController::lineOfSight(std::shared_ptr<Enemy> e, std::shared_ptr<Player> p) {
-    // use raycasting for LOS
-    float rayLength = e->getSightRange();
-    Vec2 rayStart = e->getPosition();
-    Vec2 player = Vec2::ZERO;
-    float playerFraction;
-    float obstacleFraction;
-    float angle = e->getFacingDir().getAngle();
-    Vec2 rayEnd = Vec2();
+void AIController::setWorkerThreads(int threads) {
+    _threads = threads;
+    _workers = threads > 0 ? ThreadPool::alloc(threads) : nullptr;
+}
+
+cugl::Vec2 AIController::lineOfSight(Decision& d) const {
+    // use raycasting for LOS: a fan of rays from -30 to 30 degrees around the facing direction
+    const int rays = 13;
+    float rayLength = d.sightRange;
+    Vec2 rayStart = d.position;
+    Vec2 player[rays];
+    float playerFraction[rays];
+    float obstacleFraction[rays];
+    Vec2 rayEnd[rays];
+    float angle = d.facing.getAngle();
+    for (int i = 0; i < rays; i++) {
+        player[i] = Vec2::ZERO;
+        playerFraction[i] = 2;
+        obstacleFraction[i] = 2;
+        float rayAngle = angle + (M_PI/180)*(5*i - 30);
+        rayEnd[i] = rayStart + rayLength * Vec2(cosf(rayAngle), sinf(rayAngle));
+    }
     
-    // callback function for ObstacleWorld rayCast()
-    std::function<float(b2Fixture *, const Vec2, const Vec2, float)> callback;
-    callback = [&player, &playerFraction, &obstacleFraction](b2Fixture *fixture, const Vec2 point, const Vec2 normal, float fraction) {
+    // the fan only reports the player and tall walls, so everything else is filtered before the callback
+    auto callback = [&player, &playerFraction, &obstacleFraction](size_t ray, b2Fixture *fixture, const Vec2 point, const Vec2 normal, float fraction) {
         // track if we see the player
         if (fixture->GetFilterData().categoryBits == CATEGORY_PLAYER) {
-            player = point;
-            playerFraction = fraction;
+            player[ray] = point;
+            playerFraction[ray] = fraction;
             return 1.0f;
         }
         // track if we see an obstacle
-        else if (fixture->GetFilterData().categoryBits == CATEGORY_TALL_WALL) {
-            if (fraction < obstacleFraction) {
-                obstacleFraction = fraction;
-            }
-            return 1.0f;
+        if (fraction < obstacleFraction[ray]) {
+            obstacleFraction[ray] = fraction;
         }
-        else return -1.0f;
+        return 1.0f;
     };
+    _world->rayCastFan(callback, rayStart, rayEnd, rays, CATEGORY_PLAYER | CATEGORY_TALL_WALL);
     
     // find an intersection not interrupted by a wall
-    for (int i = -30; i <= 30; i+=5) {
-        player = Vec2::ZERO;
-        playerFraction = 2;
-        obstacleFraction = 2;
-        float rayAngle = angle + (M_PI/180)*i;
-        rayEnd = rayStart + rayLength * Vec2(cosf(rayAngle), sinf(rayAngle));
-        
-        _world->rayCast(callback, rayStart, rayEnd);
-        
+    for (int i = 0; i < rays; i++) {
         // did ray hit player before hitting any obstacle?
-        if (!player.isZero() && playerFraction < obstacleFraction) {
-            e->setPlayerInSight(true);
-            e->setAggroLoc(player);
-            return player;
+        if (!player[i].isZero() && playerFraction[i] < obstacleFraction[i]) {
+            d.playerInSight = true;
+            d.aggroLoc = player[i];
+            return player[i];
         }
     }
     
     // no valid player intersections found
-    e->setPlayerInSight(false);
+    d.playerInSight = false;
     return Vec2::ZERO;
 }
 
-cugl::Vec2 AIController::moveToGoal(std::shared_ptr<Enemy> e, cugl::Vec2 goal) {
+/**
+ * The reusable storage of a path search. Searches run on the worker threads, so
+ * each thread keeps its own copy. Tiles are indexed by tx*height+ty.
+ */
+struct SearchScratch {
+    /** the search that last reached each tile */
+    std::vector<Uint32> reached;
+    /** the tile each tile was reached from */
+    std::vector<int> parents;
+    /** the tiles in the order they were reached */
+    std::vector<int> frontier;
+    /** the current search (0 is never used, so cleared tiles are unreached) */
+    Uint32 search = 0;
+};
+
+cugl::Vec2 AIController::moveToGoal(cugl::Vec2 start, cugl::Vec2 goal) const {
     Vec2 goalTile = _grid->worldToTile(goal);
-    std::queue<Vec2> frontier = std::queue<Vec2>();
-    Vec2 startTile =_grid->worldToTile(e->getPosition());
+    Vec2 startTile =_grid->worldToTile(start);
     if (startTile == goalTile) {
         return (_grid->tileToWorld(startTile));
     }
-    frontier.push(startTile);
-    std::set<Vec2> visited = std::set<Vec2>();
-    std::map<Vec2, Vec2> parents = std::map<Vec2, Vec2>();
+    int width = _grid->getWidth();
+    int height = _grid->getHeight();
+    static thread_local SearchScratch scratch;
+    size_t size = (size_t)width*height;
+    if (scratch.reached.size() < size) {
+        scratch.reached.resize(size, 0);
+        scratch.parents.resize(size);
+        scratch.frontier.reserve(size);
+    }
+    if (++scratch.search == 0) {
+        std::fill(scratch.reached.begin(), scratch.reached.end(), 0);
+        scratch.search = 1;
+    }
+    const Uint32 search = scratch.search;
+    auto inBounds = [width, height](int tx, int ty) {
+        return tx >= 0 && tx < width && ty >= 0 && ty < height;
+    };
+    int sx = (int)startTile.x;
+    int sy = (int)startTile.y;
+    int gx = (int)goalTile.x;
+    int gy = (int)goalTile.y;
+    int startIndex = inBounds(sx, sy) ? sx*height+sy : -1;
+    int goalIndex = inBounds(gx, gy) ? gx*height+gy : -2;
+    if (startIndex >= 0) {
+        scratch.reached[startIndex] = search;
+    }
     
-    // BFS loop
-    while (!frontier.empty()) {
-        Vec2 tile = frontier.front();
-        frontier.pop();
-        std::set<Vec2>::const_iterator val = visited.find(tile);
-        // mark tile as visited if it hasn't been marked already
-        if (val == visited.end()) {
-            visited.insert(tile);
+    // add the tile to the frontier if it is in bounds, walkable, and not yet visited
+    std::vector<int>& frontier = scratch.frontier;
+    frontier.clear();
+    auto visit = [&](int tx, int ty, int parent) {
+        int index = tx*height+ty;
+        if (scratch.reached[index] != search) {
+            scratch.reached[index] = search;
+            scratch.parents[index] = parent;
+            frontier.push_back(index);
         }
-        if (tile == goalTile) {
-            Vec2 newGoal = tile;
-            while (parents[newGoal] != startTile) {
-                newGoal = parents[newGoal];
+    };
+    
+    // BFS loop (the start tile is expanded by position, since it may be out of bounds)
+    size_t head = 0;
+    int tx = sx, ty = sy, index = startIndex;
+    while (true) {
+        if (index == goalIndex) {
+            while (scratch.parents[index] != startIndex) {
+                index = scratch.parents[index];
             }
-            return (_grid->tileToWorld(newGoal));
-        }
-        Vec2 left = Vec2(tile.x - 1, tile.y);
-        Vec2 down = Vec2(tile.x, tile.y - 2);
-        Vec2 right = Vec2(tile.x + 1, tile.y);
-        Vec2 up = Vec2(tile.x, tile.y + 2);
-        Vec2 bottomLeft, bottomRight, topRight, topLeft;
-        if ((int)tile.y % 2 == 0) {
-            bottomLeft = Vec2(tile.x - 1, tile.y - 1);
-            bottomRight = Vec2(tile.x, tile.y - 1);
-            topRight = Vec2(tile.x, tile.y + 1);
-            topLeft = Vec2(tile.x - 1, tile.y + 1);
-        }
-        else {
-            bottomLeft = Vec2(tile.x, tile.y - 1);
-            bottomRight = Vec2(tile.x + 1, tile.y - 1);
-            topRight = Vec2(tile.x + 1, tile.y + 1);
-            topLeft = Vec2(tile.x, tile.y + 1);
+            return (_grid->tileToWorld(index/height, index%height));
         }
+        int left = _grid->getNode(tx - 1, ty);
+        int down = _grid->getNode(tx, ty - 2);
+        int right = _grid->getNode(tx + 1, ty);
+        int up = _grid->getNode(tx, ty + 2);
+        // odd rows are shifted half a tile to the right
+        int shift = ty % 2 == 0 ? 0 : 1;
+        int bottomLeft = _grid->getNode(tx - 1 + shift, ty - 1);
+        int bottomRight = _grid->getNode(tx + shift, ty - 1);
+        int topRight = _grid->getNode(tx + shift, ty + 1);
+        int topLeft = _grid->getNode(tx - 1 + shift, ty + 1);
         
-        val = visited.find(bottomLeft);
-        // add bottom left tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(bottomLeft) != 0 && val == visited.end()) {
-            frontier.push(bottomLeft);
-            parents[bottomLeft] = tile;
-            visited.insert(bottomLeft);
+        if (bottomLeft != 0) {
+            visit(tx - 1 + shift, ty - 1, index);
+        }
+        if (bottomRight != 0) {
+            visit(tx + shift, ty - 1, index);
         }
-        val = visited.find(bottomRight);
-        // add bottom right tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(bottomRight) != 0 && val == visited.end()) {
-            frontier.push(bottomRight);
-            parents[bottomRight] = tile;
-            visited.insert(bottomRight);
+        if (topRight != 0) {
+            visit(tx + shift, ty + 1, index);
         }
-        val = visited.find(topRight);
-        // add top right tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(topRight) != 0 && val == visited.end()) {
-            frontier.push(topRight);
-            parents[topRight] = tile;
-            visited.insert(topRight);
+        if (topLeft != 0) {
+            visit(tx - 1 + shift, ty + 1, index);
         }
-        val = visited.find(topLeft);
-        // add top left tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(topLeft) != 0 && val == visited.end()) {
-            frontier.push(topLeft);
-            parents[topLeft] = tile;
-            visited.insert(topLeft);
+        // straight moves must not cut the corners of the diagonals
+        if (left != 0 && topLeft != 0 && bottomLeft != 0) {
+            visit(tx - 1, ty, index);
         }
-        val = visited.find(left);
-        // add left tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(left) != 0 && _grid->getNode(topLeft) != 0 && _grid->getNode(bottomLeft) != 0 && val == visited.end()) {
-            frontier.push(left);
-            parents[left] = tile;
-            visited.insert(left);
+        if (down != 0 && bottomLeft != 0 && bottomRight != 0) {
+            visit(tx, ty - 2, index);
         }
-        val = visited.find(down);
-        // add down tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(down) != 0 && _grid->getNode(bottomLeft) != 0 && _grid->getNode(bottomRight) != 0 && val == visited.end()) {
-            frontier.push(down);
-            parents[down] = tile;
-            visited.insert(down);
+        if (right != 0 && topRight != 0 && bottomRight != 0) {
+            visit(tx + 1, ty, index);
         }
-        val = visited.find(right);
-        // add right tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(right) != 0 && _grid->getNode(topRight) != 0 && _grid->getNode(bottomRight) != 0 && val == visited.end()) {
-            frontier.push(right);
-            parents[right] = tile;
-            visited.insert(right);
+        if (up != 0 && topLeft != 0 && topRight != 0) {
+            visit(tx, ty + 2, index);
         }
-        val = visited.find(up);
-        // add up tile to frontier if it is in bounds, walkable, and not yet visited
-        if (_grid->getNode(up) != 0 && _grid->getNode(topLeft) != 0 && _grid->getNode(topRight) != 0 && val == visited.end()) {
-            frontier.push(up);
-            parents[up] = tile;
-            visited.insert(up);
+        
+        if (head == frontier.size()) {
+            break;
         }
+        index = frontier[head++];
+        tx = index/height;
+        ty = index%height;
     }
     return (_grid->tileToWorld(startTile));
 }
 
-void AIController::changeState(std::shared_ptr<Enemy> e, std::shared_ptr<Player> p) {
-    Vec2 intersection = lineOfSight(e, p);
-    std::shared_ptr<MeleeEnemy> m;
-    std::shared_ptr<BossEnemy> boss;
-    switch (e->getBehaviorState()) {
+void AIController::changeState(Decision& d) const {
+    Vec2 intersection = lineOfSight(d);
+    bool near = !intersection.isZero() || _playerPos.distance(d.position) <= d.proximityRange;
+    switch (d.state) {
         case Enemy::BehaviorState::DEFAULT:
             // if we see or are close to the player, chase them
-            if (!intersection.isZero() || p->getPosition().distance(e->getPosition()) <= e->getProximityRange()) {
-                AudioController::playAggroEnemy(e->getType());
-                e->setChasing();
+            if (near) {
+                d.aggro = true;
+                d.state = Enemy::BehaviorState::CHASING;
             }
             // if we take damage from the player, search where the damage came from
-            else if (!e->_hitCounter.isZero()) {
-                e->setSeeking();
-                e->setAggroLoc(p->getPosition());
+            else if (d.hit) {
+                d.state = Enemy::BehaviorState::SEEKING;
+                d.aggroLoc = _playerPos;
             }
             break;
         case Enemy::BehaviorState::SEEKING:
             // if we find the player, chase them
-            if (!intersection.isZero() || p->getPosition().distance(e->getPosition()) <= e->getProximityRange()) {
-                AudioController::playAggroEnemy(e->getType());
-                e->setChasing();
+            if (near) {
+                d.aggro = true;
+                d.state = Enemy::BehaviorState::CHASING;
             }
             // if we reach the aggro location without finding the player, return to default
-            else if (e->getPosition() == _grid->tileToWorld(_grid->worldToTile(e->getAggroLoc()))) {
-                e->setDefault();
+            else if (d.position == _grid->tileToWorld(_grid->worldToTile(d.aggroLoc))) {
+                d.state = Enemy::BehaviorState::DEFAULT;
             }
             break;
         case Enemy::BehaviorState::CHASING:
             // if we are out of range of the player, search their last known position
-            if (intersection.isZero() && p->getPosition().distance(e->getPosition()) > e->getProximityRange()) {
-                e->setSeeking();
+            if (!near) {
+                d.state = Enemy::BehaviorState::SEEKING;
             }
             break;
         case Enemy::BehaviorState::ATTACKING:
             // change state if we're no longer attacking
-            if (e->getType() == "boss enemy") {
-                boss = std::dynamic_pointer_cast<BossEnemy>(e);
-                if (!boss->isAttacking()) {
-                    // if we're still close to the player, chase them
-                    if (!intersection.isZero() || p->getPosition().distance(e->getPosition()) <= e->getProximityRange()) {
-                        e->setChasing();
-                    }
-                    // if we're no longer close to the player, search their last known position
-                    else {
-                        e->setSeeking();
-                    }
-                }
-            }
-            else {
-                if (!e->isAttacking()) {
-                    // if we're still close to the player, chase them
-                    if (!intersection.isZero() || p->getPosition().distance(e->getPosition()) <= e->getProximityRange()) {
-                        e->setChasing();
-                    }
-                    // if we're no longer close to the player, search their last known position
-                    else {
-                        e->setSeeking();
-                    }
-                }
+            if (!d.attacking) {
+                // if we're still close to the player, chase them, otherwise search their last known position
+                d.state = near ? Enemy::BehaviorState::CHASING : Enemy::BehaviorState::SEEKING;
             }
             break;
         case Enemy::BehaviorState::STUNNED:
-            m = std::dynamic_pointer_cast<MeleeEnemy>(e);
             // change state if we're no longer stunned
-            if (!m->isStunned()) {
-                // if we're still close to the player, chase them
-                if (!intersection.isZero() || p->getPosition().distance(e->getPosition()) <= e->getProximityRange()) {
-                    e->setChasing();
-                }
-                // if we're no longer close to the player, search their last known position
-                else {
-                    e->setSeeking();
-                }
+            if (!d.stunned) {
+                // if we're still close to the player, chase them, otherwise search their last known position
+                d.state = near ? Enemy::BehaviorState::CHASING : Enemy::BehaviorState::SEEKING;
             }
             break;
         default:
@@ -264,171 +268,332 @@ void AIController::changeState(std::shared_ptr<Enemy> e, std::shared_ptr<Player>
     }
 }
 
-void AIController::update(float dt) {
-    for (auto it = _enemies.begin(); it != _enemies.end(); ++it) {
-        std::shared_ptr<Enemy> enemy = *it;
-        // skip AI updates for dying/dead enemies and for dummies
-        if (enemy->isDying() || !enemy->isEnabled()
-            || enemy->getType() == "melee dummy" || enemy->getType() == "ranged dummy") {
-            continue;
-        }
-        if (enemy->getType() == "boss enemy") {
-            std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(enemy);
-            if (boss->getStormState() == BossEnemy::StormState::CHARGING ||
-                boss->getStormState() == BossEnemy::StormState::CHARGED ||
-                boss->getStormState() == BossEnemy::StormState::STARTING) {
-                enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
-                continue;
+void AIController::gather(Decision& d, const std::shared_ptr<Enemy>& enemy, size_t index) {
+    d = Decision();
+    d.enemy = enemy;
+    d.index = index;
+    d.path = &enemy->getPath();
+    std::string type = enemy->getType();
+    d.sentry = enemy->getDefaultState() == "sentry";
+    d.patrols = enemy->getDefaultState() == "patrol";
+    d.boss = type == "boss enemy";
+    if (d.boss) {
+        std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(enemy);
+        d.storm = boss->getStormState() == BossEnemy::StormState::CHARGING ||
+                  boss->getStormState() == BossEnemy::StormState::CHARGED ||
+                  boss->getStormState() == BossEnemy::StormState::STARTING;
+        d.attacking = boss->isAttacking();
+    }
+    else {
+        d.attacking = enemy->isAttacking();
+    }
+    std::shared_ptr<MeleeEnemy> m = std::dynamic_pointer_cast<MeleeEnemy>(enemy);
+    d.stunned = m != nullptr ? m->isStunned() : enemy->isStunned();
+    if (type == "ranged lizard" || type == "mage alien") {
+        d.aiming = std::dynamic_pointer_cast<RangedEnemy>(enemy)->getAiming();
+    }
+    d.alive = enemy->getHealth() > 0;
+    d.hit = !enemy->_hitCounter.isZero();
+    d.recovered = enemy->_hitCounter.getCount() < enemy->_hitCounter.getMaxCount() - 5;
+    d.sentryReady = enemy->_sentryCD.isZero();
+    d.sightRange = enemy->getSightRange();
+    d.proximityRange = enemy->getProximityRange();
+    d.attackRange = enemy->getAttackRange();
+    d.moveSpeed = enemy->getMoveSpeed();
+    d.position = enemy->getPosition();
+    d.state = enemy->getBehaviorState();
+    d.facing = enemy->getFacingDir();
+    d.goal = enemy->getGoal();
+    d.aggroLoc = enemy->getAggroLoc();
+    d.pathIndex = enemy->getPathIndex();
+    d.aligned = enemy->getAligned();
+    d.playerInSight = enemy->getPlayerInSight();
+}
+
+void AIController::steer(Decision& d, cugl::Vec2 target) const {
+    Vec2 dir = target - d.position;
+    dir.normalize();
+    d.facing = dir;
+    d.turned = true;
+    d.velocity = d.moveSpeed*dir;
+    d.moved = true;
+}
+
+void AIController::snap(Decision& d) const {
+    d.position = d.goal;
+    d.snapped = true;
+    d.velocity = Vec2::ZERO;
+    d.moved = true;
+}
+
+void AIController::decide(Decision& d, std::minstd_rand& random) const {
+    if (d.boss && d.storm) {
+        d.velocity = Vec2::ZERO;
+        d.moved = true;
+        return;
+    }
+    if (d.alive) changeState(d);
+    // pass while taking damage to allow for knockback
+    if (d.hit) {
+        return;
+    }
+    const std::vector<Vec2>& path = *d.path;
+    Vec2 dir;
+    switch (d.state) {
+        case Enemy::BehaviorState::DEFAULT:
+            // make sentries rotate 45 degrees counterclockwise at set intervals
+            if (d.sentry) {
+                if (d.sentryReady) {
+                    d.resetSentry = true;
+                    d.facing = d.facing.rotate(M_PI_4);
+                    d.turned = true;
+                }
+                if (d.recovered) {
+                    d.velocity = Vec2::ZERO;
+                    d.moved = true;
+                }
             }
-        }
-        if (enemy->getHealth() > 0) changeState(enemy, _player);
-        // pass while taking damage to allow for knockback
-        if (!enemy->_hitCounter.isZero()) {
-            continue;
-        }
-        Vec2 goal;
-        Vec2 dir;
-        switch (enemy->getBehaviorState()) {
-            case Enemy::BehaviorState::DEFAULT:
-                // make sentries rotate 45 degrees counterclockwise at set intervals
-                if (enemy->getDefaultState() == "sentry") {
-                    if (enemy->_sentryCD.isZero()) {
-                        enemy->_sentryCD.reset();
-                        enemy->setFacingDir(enemy->getFacingDir().rotate(M_PI_4));
+            // make patrolling enemies go to the next location on their patrol route
+            if (d.patrols) {
+                // enemy is at the center of its tile — we can proceed as normal!
+                if (d.aligned) {
+                    if (d.position == d.goal) {
+                        d.pathIndex = (d.pathIndex + 1) % path.size();
+                        d.goal = moveToGoal(d.position, path[d.pathIndex]);
+                        steer(d, d.goal);
                     }
-                    if (enemy->_hitCounter.getCount() < enemy->_hitCounter.getMaxCount() - 5) enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
-                }
-                // make patrolling enemies go to the next location on their patrol route
-                if (enemy->getDefaultState() == "patrol") {
-                    // enemy is at the center of its tile — we can proceed as normal!
-                    if (enemy->getAligned()) {
-                        if (enemy->getPosition() == enemy->getGoal()) {
-                            enemy->setPathIndex((enemy->getPathIndex() + 1) % enemy->getPath().size());
-                            goal = moveToGoal(enemy, enemy->getPath()[enemy->getPathIndex()]);
-                            enemy->setGoal(goal);
-                            dir = enemy->getGoal() - enemy->getPosition();
-                            dir.normalize();
-                            enemy->setFacingDir(dir);
-                            enemy->getCollider()->setLinearVelocity(enemy->getMoveSpeed()*dir);
-                        }
-                        else if (enemy->getPosition().distance(enemy->getGoal()) <= 0.1) {
-                            enemy->getCollider()->setPosition(enemy->getGoal());
-                            enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
-                        }
-                        else if (enemy->_hitCounter.getCount() < enemy->_hitCounter.getMaxCount() - 5) {
-                            int newGoalChance = rand() % 10 + 1; // in case enemy gets stuck
-                            if (newGoalChance == 1) {
-                                goal = moveToGoal(enemy, enemy->getPath()[enemy->getPathIndex()]);
-                                enemy->setGoal(goal);
-                            }
-                            else {
-                                goal = enemy->getGoal();
-                            }
-                            dir = goal - enemy->getPosition();
-                            dir.normalize();
-                            enemy->setFacingDir(dir);
-                            enemy->getCollider()->setLinearVelocity(enemy->getMoveSpeed()*dir);
-                        }
+                    else if (d.position.distance(d.goal) <= 0.1) {
+                        snap(d);
                     }
-                    // enemy is not aligned — we have to fix that!
-                    else {
-                        goal = moveToGoal(enemy, enemy->getPosition());
-                        enemy->setGoal(goal);
-                        if (enemy->getPosition().distance(goal) <= 0.1) {
-                            enemy->setAligned(true);
-                            enemy->getCollider()->setPosition(goal);
-                            enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
-                            enemy->setGoal(enemy->getPath()[0]);
-                        }
-                        else {
-                            dir = goal - enemy->getPosition();
-                            dir.normalize();
-                            enemy->setFacingDir(dir);
-                            enemy->getCollider()->setLinearVelocity(enemy->getMoveSpeed()*dir);
+                    else if (d.recovered) {
+                        int newGoalChance = random() % 10 + 1; // in case enemy gets stuck
+                        if (newGoalChance == 1) {
+                            d.goal = moveToGoal(d.position, path[d.pathIndex]);
                         }
+                        steer(d, d.goal);
                     }
                 }
-                break;
-            case Enemy::BehaviorState::SEEKING:
-                if (enemy->getPosition() == enemy->getGoal()) {
-                    goal = moveToGoal(enemy, enemy->getAggroLoc());
-                    enemy->setGoal(goal);
-                    dir = goal - enemy->getPosition();
-                    dir.normalize();
-                    enemy->setFacingDir(dir);
-                    enemy->getCollider()->setLinearVelocity(enemy->getMoveSpeed()*dir);
-                }
-                if (enemy->getPosition().distance(enemy->getGoal()) <= 0.1) {
-                        enemy->getCollider()->setPosition(enemy->getGoal());
-                        enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
-                    }
+                // enemy is not aligned — we have to fix that!
                 else {
-                    int newGoalChance = rand() % 10 + 1; // in case enemy gets stuck
-                    if (newGoalChance == 1) {
-                        goal = moveToGoal(enemy, enemy->getAggroLoc());
-                        enemy->setGoal(goal);
+                    d.goal = moveToGoal(d.position, d.position);
+                    if (d.position.distance(d.goal) <= 0.1) {
+                        d.aligned = true;
+                        snap(d);
+                        d.goal = path[0];
                     }
                     else {
-                        goal = enemy->getGoal();
+                        steer(d, d.goal);
                     }
-                    dir = goal - enemy->getPosition();
-                    dir.normalize();
-                    enemy->setFacingDir(dir);
-                    enemy->getCollider()->setLinearVelocity(enemy->getMoveSpeed()*dir);
                 }
-                break;
-            case Enemy::BehaviorState::CHASING:
-                if (enemy->getPosition().distance(_player->getPosition()) <= enemy->getAttackRange() && enemy->getPlayerInSight()) {
-                    dir = _player->getPosition() - enemy->getPosition();
-                    dir.normalize();
-                    enemy->setFacingDir(dir);
-                    enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
+            }
+            break;
+        case Enemy::BehaviorState::SEEKING:
+            if (d.position == d.goal) {
+                d.goal = moveToGoal(d.position, d.aggroLoc);
+                steer(d, d.goal);
+            }
+            if (d.position.distance(d.goal) <= 0.1) {
+                snap(d);
+            }
+            else {
+                int newGoalChance = random() % 10 + 1; // in case enemy gets stuck
+                if (newGoalChance == 1) {
+                    d.goal = moveToGoal(d.position, d.aggroLoc);
+                }
+                steer(d, d.goal);
+            }
+            break;
+        case Enemy::BehaviorState::CHASING:
+            if (d.position.distance(_playerPos) <= d.attackRange && d.playerInSight) {
+                dir = _playerPos - d.position;
+                dir.normalize();
+                d.facing = dir;
+                d.turned = true;
+                d.velocity = Vec2::ZERO;
+                d.moved = true;
+            }
+            else {
+                if (d.position == d.goal) {
+                    d.goal = moveToGoal(d.position, _playerPos);
+                    steer(d, d.goal);
+                }
+                if (d.position.distance(d.goal) <= 0.1) {
+                    snap(d);
                 }
                 else {
-                    if (enemy->getPosition() == enemy->getGoal()) {
-                        goal = moveToGoal(enemy, _player->getPosition());
-                        enemy->setGoal(goal);
-                        dir = goal - enemy->getPosition();
-                        dir.normalize();
-                        enemy->setFacingDir(dir);
-                        enemy->getCollider()->setLinearVelocity(enemy->getMoveSpeed()*dir);
-                    }
-                    if (enemy->getPosition().distance(enemy->getGoal()) <= 0.1) {
-                        enemy->getCollider()->setPosition(enemy->getGoal());
-                        enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
-                    }
-                    else {
-                        int newGoalChance = rand() % 10 + 1; // in case enemy gets stuck
-                        if (newGoalChance == 1) {
-                            goal = moveToGoal(enemy, _player->getPosition());
-                            enemy->setGoal(goal);
-                        }
-                        else {
-                            goal = enemy->getGoal();
-                        }
-                        dir = goal - enemy->getPosition();
-                        dir.normalize();
-                        enemy->setFacingDir(dir);
-                        enemy->getCollider()->setLinearVelocity(enemy->getMoveSpeed()*dir);
+                    int newGoalChance = random() % 10 + 1; // in case enemy gets stuck
+                    if (newGoalChance == 1) {
+                        d.goal = moveToGoal(d.position, _playerPos);
                     }
+                    steer(d, d.goal);
                 }
+            }
+            break;
+        case Enemy::BehaviorState::ATTACKING:
+            if (d.aiming) {
+                dir = _playerPos - d.position;
+                dir.normalize();
+                d.facing = dir;
+                d.turned = true;
+            }
+            d.velocity = Vec2::ZERO;
+            d.moved = true;
+            break;
+        case Enemy::BehaviorState::STUNNED:
+            d.velocity = Vec2::ZERO;
+            d.moved = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void AIController::apply(const Decision& d) {
+    const std::shared_ptr<Enemy>& enemy = d.enemy;
+    if (d.aggro) {
+        AudioController::Cue cue = AudioController::getAggroCue(enemy->getType());
+        if (cue != AudioController::CUE_COUNT) AudioController::play(cue, 0, enemy->getPosition());
+    }
+    if (d.state != enemy->getBehaviorState()) {
+        switch (d.state) {
+            case Enemy::BehaviorState::DEFAULT:
+                enemy->setDefault();
                 break;
-            case Enemy::BehaviorState::ATTACKING:
-                if ((enemy->getType() == "ranged lizard" || enemy->getType() == "mage alien")) {
-                    std::shared_ptr<RangedEnemy> r = std::dynamic_pointer_cast<RangedEnemy>(enemy);
-                    if (r->getAiming()) {
-                        dir = _player->getPosition() - enemy->getPosition();
-                        dir.normalize();
-                        enemy->setFacingDir(dir);
-                    }
-                }
-                enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
+            case Enemy::BehaviorState::SEEKING:
+                enemy->setSeeking();
                 break;
-            case Enemy::BehaviorState::STUNNED:
-                enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
+            case Enemy::BehaviorState::CHASING:
+                enemy->setChasing();
                 break;
             default:
                 break;
         }
     }
+    enemy->setPlayerInSight(d.playerInSight);
+    enemy->setAggroLoc(d.aggroLoc);
+    enemy->setPathIndex(d.pathIndex);
+    enemy->setGoal(d.goal);
+    enemy->setAligned(d.aligned);
+    if (d.resetSentry) {
+        enemy->_sentryCD.reset();
+    }
+    if (d.turned) {
+        enemy->setFacingDir(d.facing);
+    }
+    // position changes touch the broadphase, so they must stay on this thread
+    if (d.snapped) {
+        enemy->getCollider()->setPosition(d.position);
+    }
+    if (d.moved) {
+        enemy->getCollider()->setLinearVelocity(d.velocity);
+    }
+}
+
+AIController::UpdateBand AIController::getUpdateBand(const std::shared_ptr<Enemy>& e) {
+    float distance = e->getPosition().distance(_player->getPosition());
+    // enemies the player can see or reach soon must react immediately
+    if (distance <= GameConstants::AI_FULL_RATE_RANGE || _viewBounds.doesIntersect(e->getPosition(), 1.0f)
+        || !e->_hitCounter.isZero()) {
+        return UpdateBand::FULL;
+    }
+    // idle sentries and patrollers far away from the player cannot notice them
+    if (distance > GameConstants::AI_ACTIVATION_RANGE && e->getBehaviorState() == Enemy::BehaviorState::DEFAULT) {
+        return UpdateBand::PAUSED;
+    }
+    return UpdateBand::REDUCED;
+}
+
+bool AIController::isNearGoal(const std::shared_ptr<Enemy>& e, float dt) {
+    float travel = e->getCollider()->getLinearVelocity().length() * GameConstants::AI_OFFSCREEN_PERIOD * dt;
+    return travel > 0 && e->getPosition().distance(e->getGoal()) <= travel + 0.1f;
+}
+
+void AIController::update(float dt) {
+    CUProfileZone("AIController::update");
+    _stats = FrameStats();
+    _frame++;
+    size_t count = _enemies.size();
+    if (_lastUpdate.size() != count) {
+        // stagger the initial slots so reduced-rate enemies do not all fall due on the same frame
+        _lastUpdate.resize(count);
+        for (size_t ii = 0; ii < count; ii++) {
+            _lastUpdate[ii] = _frame - (unsigned int)(ii % GameConstants::AI_OFFSCREEN_PERIOD);
+        }
+        _cursor = 0;
+    }
+    
+    _playerPos = _player->getPosition();
+    // the decisions do not outlive the update, so they live in the frame arena
+    FrameArena::Scope scratch;
+    FrameVector<Decision> decisions;
+    decisions.reserve(count);
+    int budget = GameConstants::AI_UPDATE_BUDGET;
+    size_t start = _cursor;
+    size_t next = _cursor;
+    bool exhausted = false;
+    for (size_t jj = 0; jj < count; jj++) {
+        // walk the enemies from the cursor so that the budget is shared fairly across frames
+        size_t ii = (_cursor + jj) % count;
+        std::shared_ptr<Enemy> enemy = _enemies[ii];
+        // skip AI updates for dying/dead enemies and for dummies
+        if (enemy->isDying() || !enemy->isEnabled()
+            || enemy->getType() == "melee dummy" || enemy->getType() == "ranged dummy") {
+            _stats.skipped++;
+            continue;
+        }
+        switch (getUpdateBand(enemy)) {
+            case UpdateBand::FULL:
+                break;
+            case UpdateBand::PAUSED:
+                enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
+                _lastUpdate[ii] = _frame;
+                _stats.skipped++;
+                continue;
+            case UpdateBand::REDUCED:
+                if (_frame - _lastUpdate[ii] < (unsigned int)GameConstants::AI_OFFSCREEN_PERIOD && !isNearGoal(enemy, dt)) {
+                    _stats.deferred++;
+                    continue;
+                }
+                if (budget <= 0) {
+                    // out of budget: this enemy stays due and the next frame starts with it
+                    if (!exhausted) {
+                        next = ii;
+                        exhausted = true;
+                    }
+                    _stats.deferred++;
+                    continue;
+                }
+                budget--;
+                break;
+        }
+        _lastUpdate[ii] = _frame;
+        _stats.updated++;
+        decisions.emplace_back();
+        gather(decisions.back(), enemy, ii);
+    }
+    _cursor = exhausted ? next : (count > 0 ? (_cursor + 1) % count : 0);
+    // the scan wrapped around at the cursor, which moves every frame, so rotate the
+    // decisions back into enemy order (the indices below the cursor come last)
+    auto wrap = std::partition_point(decisions.begin(), decisions.end(),
+                                     [start](const Decision& d) { return d.index >= start; });
+    std::rotate(decisions.begin(), wrap, decisions.end());
+    
+    // decisions only read the grid and raycast against the world, which is not stepped until fixedUpdate
+    auto body = [this, &decisions](size_t begin, size_t end) {
+        CUProfileZone("AIController::decide");
+        for (size_t ii = begin; ii < end; ii++) {
+            decide(decisions[ii], _random[decisions[ii].index]);
+        }
+    };
+    if (_workers != nullptr) {
+        _workers->parallelFor(decisions.size(), GameConstants::AI_TASK_GRAIN, body);
+    }
+    else {
+        body(0, decisions.size());
+    }
+    
+    // apply in enemy order so that physics and sounds see the same sequence as the serial update
+    for (size_t ii = 0; ii < decisions.size(); ii++) {
+        apply(decisions[ii]);
+    }
 }
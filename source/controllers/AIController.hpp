@@ -13,6 +13,8 @@
 
 #include <cugl/cugl.h>
 #include <stdio.h>
+#include <random>
+#include "../models/Enemy.hpp"
 
 
 class Player;
@@ -26,6 +28,102 @@ class LevelModel;
 class LevelGrid;
 
 class AIController {
+public:
+    /**
+     * The rate at which the scheduler updates a given enemy.
+     */
+    enum class UpdateBand : int {
+        /** on screen or close to the player: updated every frame */
+        FULL,
+        /** off screen: updated every `AI_OFFSCREEN_PERIOD` frames, subject to the frame budget */
+        REDUCED,
+        /** idle and beyond the activation range: not updated at all */
+        PAUSED
+    };
+    
+    /**
+     * The number of enemies handled by each branch of the scheduler in a single frame.
+     */
+    struct FrameStats {
+        /** enemies whose state and movement were updated */
+        int updated = 0;
+        /** reduced-rate enemies that were not due or did not fit in the frame budget */
+        int deferred = 0;
+        /** enemies that were paused, dying, disabled or dummies */
+        int skipped = 0;
+    };
+    
+    /**
+     * The working state of a single enemy update.
+     *
+     * The update runs in three phases. The inputs are gathered from the enemy
+     * on the main thread, the decision is computed from this struct alone
+     * (possibly on a worker thread), and the outputs are then applied to the
+     * enemy and its physics body on the main thread. Nothing in the decision
+     * phase touches the enemy or writes to the physics world.
+     */
+    struct Decision {
+#pragma mark Inputs
+        /** the enemy being updated */
+        std::shared_ptr<Enemy> enemy;
+        /** the index of the enemy in the level, which selects its random stream */
+        size_t index = 0;
+        /** the patrol path of the enemy (owned by the enemy) */
+        const std::vector<cugl::Vec2>* path = nullptr;
+        /** whether the enemy is a sentry (otherwise a patroller when `patrols` is set) */
+        bool sentry = false;
+        /** whether the enemy follows a patrol route */
+        bool patrols = false;
+        /** whether the enemy is the boss */
+        bool boss = false;
+        /** the boss is charging or starting a storm and must stand still */
+        bool storm = false;
+        /** whether the enemy still has health */
+        bool alive = false;
+        /** whether the enemy is taking damage */
+        bool hit = false;
+        /** whether the enemy has recovered from the knockback of its last hit */
+        bool recovered = false;
+        /** whether the sentry rotation cooldown has elapsed */
+        bool sentryReady = false;
+        /** whether the attack animation is still playing */
+        bool attacking = false;
+        /** whether the stun animation is still playing */
+        bool stunned = false;
+        /** whether a ranged enemy is aiming at the player */
+        bool aiming = false;
+        /** the sight, proximity and attack ranges and the movement speed of the enemy */
+        float sightRange = 0;
+        float proximityRange = 0;
+        float attackRange = 0;
+        float moveSpeed = 0;
+        /** the position of the enemy at the start of the frame (or its goal once snapped) */
+        cugl::Vec2 position;
+        
+#pragma mark Inputs and Outputs
+        /** the behavior state, facing direction, goal, aggro location and patrol progress of the enemy */
+        Enemy::BehaviorState state = Enemy::BehaviorState::DEFAULT;
+        cugl::Vec2 facing;
+        cugl::Vec2 goal;
+        cugl::Vec2 aggroLoc;
+        int pathIndex = 0;
+        bool aligned = false;
+        bool playerInSight = false;
+        
+#pragma mark Outputs
+        /** the facing direction was changed */
+        bool turned = false;
+        /** the linear velocity was changed */
+        bool moved = false;
+        cugl::Vec2 velocity;
+        /** the enemy snapped onto `position` */
+        bool snapped = false;
+        /** the sentry rotation cooldown must restart */
+        bool resetSentry = false;
+        /** the enemy noticed the player and should play its aggro sound */
+        bool aggro = false;
+    };
+    
 private:
     /** the game world */
     std::shared_ptr<cugl::physics2::ObstacleWorld> _world;
@@ -38,6 +136,66 @@ private:
     
     /** the level grid */
     std::shared_ptr<LevelGrid> _grid;
+    
+#pragma mark Scheduling
+    /** the visible region of the level, in physics coordinates */
+    cugl::Rect _viewBounds;
+    /** the number of frames run by the scheduler since `init` */
+    unsigned int _frame;
+    /** the frame at which each enemy (by index) was last updated */
+    std::vector<unsigned int> _lastUpdate;
+    /** the enemy index at which the next round-robin pass over reduced-rate enemies starts */
+    size_t _cursor;
+    /** the scheduler counts for the most recent frame */
+    FrameStats _stats;
+    
+#pragma mark Parallel Update
+    /** the worker threads for the decision phase (nullptr if updating serially) */
+    std::shared_ptr<cugl::ThreadPool> _workers;
+    /** the number of worker threads (-1 until set, for the default) */
+    int _threads;
+    /** the random stream of each enemy (by index), so results do not depend on the update order */
+    std::vector<std::minstd_rand> _random;
+    /** the player position at the start of the frame */
+    cugl::Vec2 _playerPos;
+    
+    /**
+     * @return the update band of the given enemy based on its distance to the player and the view
+     */
+    UpdateBand getUpdateBand(const std::shared_ptr<Enemy>& e);
+    
+    /**
+     * @return whether the enemy would pass its movement goal if it were not updated for a full off-screen period of `dt`-second frames
+     */
+    bool isNearGoal(const std::shared_ptr<Enemy>& e, float dt);
+    
+    /**
+     * Copies the state the decision phase needs out of the enemy
+     */
+    void gather(Decision& d, const std::shared_ptr<Enemy>& enemy, size_t index);
+    
+    /**
+     * Runs the state transitions and movement logic for a single enemy.
+     *
+     * This only reads the level grid and raycasts against the physics world, so
+     * decisions for different enemies may run at the same time.
+     */
+    void decide(Decision& d, std::minstd_rand& random) const;
+    
+    /**
+     * Writes the outcome of a decision back to the enemy and its physics body
+     */
+    void apply(const Decision& d);
+    
+    /**
+     * Faces the enemy towards the target and moves it there at its movement speed
+     */
+    void steer(Decision& d, cugl::Vec2 target) const;
+    
+    /**
+     * Snaps the enemy onto its goal and stops it
+     */
+    void snap(Decision& d) const;
 
 public:
 #pragma mark -
@@ -46,7 +204,7 @@ public:
     /**
      * Default Constructor
     */
-    AIController(){}
+    AIController() : _frame(0), _cursor(0), _threads(-1) {}
 
     /**
      * Initializes the controller for the given level
@@ -63,27 +221,73 @@ public:
     
     /**
      * Returns a 0,0 vector if the enemy does not have line of sight to the player.
-     * Else, returns a unit vector from enemy to player.
+     * Else, returns the point where the sight ray meets the player.
      *
+     * Updates whether the player is in sight and, if so, the aggro location of the decision.
      */
-    cugl::Vec2 lineOfSight(std::shared_ptr<Enemy> e, std::shared_ptr<Player> p);
+    cugl::Vec2 lineOfSight(Decision& d) const;
     
     /**
-     * Returns the first node along the path toward the goal
+     * Returns the first node along the path from start toward the goal
      */
-    cugl::Vec2 moveToGoal(std::shared_ptr<Enemy> e, cugl::Vec2 goal);
+    cugl::Vec2 moveToGoal(cugl::Vec2 start, cugl::Vec2 goal) const;
     
     /**
      * Changes an enemy's behavior state
      */
-    void changeState(std::shared_ptr<Enemy> e, std::shared_ptr<Player> p);
+    void changeState(Decision& d) const;
     
     /**
-     * TODO: document this function
      * Updates locations and states for all enemies
+     *
+     * Enemies are not all updated every frame. Enemies that are on screen or near
+     * the player run at full rate, off-screen enemies run every `AI_OFFSCREEN_PERIOD`
+     * frames in round-robin slots (at most `AI_UPDATE_BUDGET` of them per frame),
+     * and idle enemies beyond `AI_ACTIVATION_RANGE` are paused.
+     *
+     * The selected enemies decide in parallel on `AI_WORKER_THREADS` worker threads
+     * (plus the calling thread), and the results are applied in enemy order. Each
+     * enemy draws from its own random stream, so the outcome is the same for any
+     * number of threads, including the serial path.
     */
     void update(float dt);
     
+    /**
+     * Sets the number of worker threads used for enemy decisions.
+     *
+     * The setting is kept by later calls to `init`. Until it is set, `init`
+     * uses `AI_WORKER_THREADS`.
+     *
+     * @param threads the number of worker threads (0 to update serially)
+     */
+    void setWorkerThreads(int threads);
+    
+    /**
+     * Sets the visible region of the level used to classify on-screen enemies.
+     *
+     * @param bounds the camera view in physics coordinates
+     */
+    void setViewBounds(const cugl::Rect& bounds) { _viewBounds = bounds; }
+    
+    /**
+     * @return the number of enemies updated, deferred and skipped in the last frame
+     */
+    const FrameStats& getFrameStats() const { return _stats; }
+    
+    /**
+     * Returns the next value of the random stream of the given enemy, without drawing it.
+     *
+     * Two streams with the same next value are at the same position, so this
+     * compares the draws of two runs.
+     *
+     * @param index the index of the enemy in the level
+     *
+     * @return the next value of the random stream of the given enemy
+     */
+    unsigned int peekRandom(size_t index) const {
+        std::minstd_rand copy = _random[index];
+        return (unsigned int)copy();
+    }
 };
     
     
@@ -4,15 +4,35 @@
 //
 
 #include "AudioController.hpp"
+#include "../utility/GameRandom.hpp"
 #include <stdio.h>
-#include <ctime>
+#include <algorithm>
+#include <cmath>
+
+/** How far beyond the camera view a cue can be heard, as a fraction of the view size */
+#define VOICE_FALLOFF   0.5f
 
 using namespace cugl;
 
+/** The voice cap of each category, indexed by priority */
+static const Uint32 VOICE_CAPS[AudioController::PRIORITY_COUNT] = {
+    2,  // AMBIENT
+    8,  // ENEMY
+    4,  // BOSS
+    8,  // PLAYER
+};
+
 #pragma mark -
 #pragma mark Static member variables
 
 std::shared_ptr<cugl::AssetManager> AudioController::_assets;
+std::vector<AudioController::CueData> AudioController::_cues;
+std::vector<AudioController::Voice> AudioController::_voices;
+Rect AudioController::_view;
+Uint32 AudioController::_frame = 0;
+AudioController::VoiceStats AudioController::_stats;
+AudioController::VoiceStats AudioController::_lastStats;
+Uint64 AudioController::_underruns = 0;
 std::string AudioController::_currTrack;
 bool AudioController::_looping;
 float AudioController::_master;
@@ -32,7 +52,6 @@ void AudioController::init(std::shared_ptr<cugl::AssetManager> assets, SaveData:
     _bgm = p.BGMvol / 10.0;
     _looping = false;
     _currTrack = "";
-    std::srand(std::time(0));
 }
         
 #pragma mark -
@@ -44,6 +63,7 @@ void AudioController::init(std::shared_ptr<cugl::AssetManager> assets, SaveData:
      * @param  key2  the reference key for the sound effect
      */
 void AudioController::playCollisionFX(const std::string key1, const std::string key2){
+    if (isSilent()) return;
     std::string uniqueKey = key1+key2;
     if (!AudioEngine::get()->isActive(uniqueKey)) {
         if(key1 == "player" && key2.substr(0,4)=="wall"){
@@ -53,198 +73,302 @@ void AudioController::playCollisionFX(const std::string key1, const std::string
     }
 }
     
-    /**
-     * Plays sound associated with player action.
-     *
-     * @param  action  the action key for the player
-     */
-void AudioController::playPlayerFX(const std::string action){
-    if (!AudioEngine::get()->isActive(action+"player")) {
-        std::shared_ptr<Sound> source; // TODO: might be bad to create a <Sound> instead of <AudioSample>
-        bool loop = false;
-        if (action == "attackHit") {
-            int randn = std::rand() % 3 + 1;
-            source = _assets->get<Sound>("playerAttack" + std::to_string(randn));
-        }
-        else if (action == "attackHitPower") {
-            source = _assets->get<Sound>("playerAttackPower");
-        }
-        else if (action == "drawBow") {
-            source = _assets->get<Sound>("bowDraw");
-        }
-        else if (action == "loopBow") {
-            source = _assets->get<Sound>("bowCharge");
-            loop = true;
-        }
-        else if (action == "shootBow") {
-            source = _assets->get<Sound>("bowFire");
-        }
-        else if (action == "parry") {
-            source = _assets->get<Sound>("parryMelee");
-        }
-        else if (action == "damaged") {
-            source = _assets->get<Sound>("playerDmg");
-        }
-        else if (action == "dash") {
-            source = _assets->get<Sound>("dash");
-        }
-        else if (action == "projOnHit") { 
-            source = _assets->get<Sound>("projOnHit");
-        }
-        else {
-            CULogError("player sound action not found");
+/** The static description of a cue */
+struct CueInfo {
+    /** the cue described */
+    AudioController::Cue cue;
+    /** the key of the voice of the cue */
+    const char* voice;
+    /** the asset name (the base name if there are variants) */
+    const char* asset;
+    /** the number of variants, named asset1..assetN (0 for the asset itself) */
+    Uint32 variants;
+    /** whether the cue loops */
+    bool loop;
+    /** the cue plays with a chance of 1 in this */
+    Uint32 chance;
+    /** the priority (and voice category) of the cue */
+    AudioController::Priority priority;
+};
+
+/** The cue table, resolved by loadCues */
+static const CueInfo CUE_INFO[] = {
+    { AudioController::PLAYER_ATTACK,         "attackHitplayer",      "playerAttack",       3, false, 1,   AudioController::PLAYER },
+    { AudioController::PLAYER_ATTACK_POWER,   "attackHitPowerplayer", "playerAttackPower",  0, false, 1,   AudioController::PLAYER },
+    { AudioController::PLAYER_DRAW_BOW,       "drawBowplayer",        "bowDraw",            0, false, 1,   AudioController::PLAYER },
+    { AudioController::PLAYER_LOOP_BOW,       "loopBowplayer",        "bowCharge",          0, true,  1, AudioController::PLAYER },
+    { AudioController::PLAYER_SHOOT_BOW,      "shootBowplayer",       "bowFire",            0, false, 1,   AudioController::PLAYER },
+    { AudioController::PLAYER_PARRY,          "parryplayer",          "parryMelee",         0, false, 1,   AudioController::PLAYER },
+    { AudioController::PLAYER_DAMAGED,        "damagedplayer",        "playerDmg",          0, false, 1,   AudioController::PLAYER },
+    { AudioController::PLAYER_DASH,           "dashplayer",           "dash",               0, false, 1,   AudioController::PLAYER },
+    { AudioController::PLAYER_PROJ_HIT,       "projOnHitplayer",      "projOnHit",          0, false, 1,   AudioController::PLAYER },
+    { AudioController::ENEMY_ATTACK,          "attack",               "enemyAttack",        6, false, 1,   AudioController::ENEMY },
+    { AudioController::CASTER_ATTACK,         "casterAttack",         "casterAttack",       3, false, 1,   AudioController::ENEMY },
+    { AudioController::TANK_ATTACK,           "tankAttack",           "tankAttack",         0, false, 1,   AudioController::ENEMY },
+    { AudioController::BOSS_ATTACK,           "bossAttack",           "bossAttack",         3, false, 1,   AudioController::BOSS },
+    { AudioController::BOSS_STORM,            "bossStorm",            "bossStorm",          0, false, 1,   AudioController::BOSS },
+    { AudioController::SLIME_EXPLODE,         "slimeExplode",         "slimeExplode",       0, false, 1,   AudioController::ENEMY },
+    { AudioController::BOSS_DEATH,            "bossDeath",            "bossDeath",          0, false, 1,   AudioController::BOSS },
+    { AudioController::CASTER_DEATH,          "casterDeath",          "casterDeath",        3, false, 1,   AudioController::ENEMY },
+    { AudioController::ALIEN_DEATH,           "alienDeath",           "alienDeath",         4, false, 1,   AudioController::ENEMY },
+    { AudioController::CASTER_DAMAGED,        "damaged",              "casterDamaged",      2, false, 1,   AudioController::ENEMY },
+    { AudioController::TANK_DAMAGED,          "damaged",              "tankHitNoArmor",     0, false, 1,   AudioController::ENEMY },
+    { AudioController::TANK_DAMAGED_ARMORED,  "damaged",              "tankHitArmored",     0, false, 1,   AudioController::ENEMY },
+    { AudioController::BOSS_DAMAGED,          "damaged",              "bossDamaged",        3, false, 1,   AudioController::BOSS },
+    { AudioController::ALIEN_DAMAGED,         "damaged",              "alienImpact",        0, false, 1,   AudioController::ENEMY },
+    { AudioController::CASTER_AGGRO,          "casterAggro",          "casterAggro",        2, false, 1,   AudioController::ENEMY },
+    { AudioController::TANK_AGGRO,            "tankAggro",            "tankAggro",          2, false, 1,   AudioController::ENEMY },
+    { AudioController::BOSS_AGGRO,            "bossAggro",            "bossAggro",          2, false, 1,   AudioController::BOSS },
+    { AudioController::ENEMY_AGGRO,           "enemyAggro",           "enemyAggro",         4, false, 1,   AudioController::ENEMY },
+    { AudioController::UI_CLICK,              "menuClickui",          "menuClick",          0, false, 1,   AudioController::PLAYER },
+    { AudioController::UI_UPGRADE,            "upgradeui",            "upgrade",            0, false, 1,   AudioController::PLAYER },
+    { AudioController::UI_HEALTH,             "healthui",             "upgrade",            0, false, 1,   AudioController::PLAYER },
+    { AudioController::UI_ENVIRONMENT,        "environmentui",        "env",                4, false, 500, AudioController::AMBIENT },
+};
+
+static_assert(sizeof(CUE_INFO)/sizeof(CUE_INFO[0]) == AudioController::CUE_COUNT, "every cue needs an entry");
+
+/**
+ * Resolves the cue table from the loaded assets.
+ */
+void AudioController::loadCues(){
+    if (_assets == nullptr) return;
+    _cues.clear();
+    _cues.resize(CUE_COUNT);
+    // Voices beyond the engine slots evict each other, so this is the most we track
+    if (AudioEngine::get() != nullptr) {
+        _voices.reserve(AudioEngine::get()->getCapacity());
+    }
+    for (const CueInfo& info : CUE_INFO){
+        CueData& data = _cues[info.cue];
+        data.voice = info.voice;
+        data.loop = info.loop;
+        data.chance = info.chance;
+        data.priority = info.priority;
+        if (info.variants == 0){
+            data.sounds.push_back(_assets->get<Sound>(info.asset));
+        }
+        for (Uint32 ii = 1; ii <= info.variants; ii++){
+            data.sounds.push_back(_assets->get<Sound>(info.asset + std::to_string(ii)));
+        }
+        for (const std::shared_ptr<Sound>& sound : data.sounds){
+            if (sound == nullptr){
+                CULogError("missing sound for cue '%s'", info.voice);
+                data.sounds.clear();
+                break;
+            }
         }
-        AudioEngine::get()->play(action+"player", source, loop, source->getVolume() * _master * _sfx);
     }
 }
 
-void AudioController::onEnemyProjImpact(const std::string enemyType) {
-    if (!AudioEngine::get()->isActive(enemyType+"proj")) {
-        std::shared_ptr<Sound> source;
-        if (enemyType == "caster") {
-        source = _assets->get<Sound>("casterImpact");
-        }
-        else if (enemyType == "lizard") {
-            source = _assets->get<Sound>("rlizardImpact");
-        }
-        else if (enemyType == "boss") {
-            source = _assets->get<Sound>("bossImpact");
-        }
+/**
+ * Logs the memory used by each loaded sample, and as float data.
+ */
+void AudioController::logMemoryReport(){
+    if (_assets == nullptr) return;
+    std::shared_ptr<BaseLoader> loader = _assets->access<Sound>();
+    std::vector<std::string> keys = loader->keys();
+    std::sort(keys.begin(), keys.end());
+    size_t total = 0;
+    size_t floats = 0;
+    static const char* FORMATS[] = { "float", "int16", "adpcm" };
+    for (const std::string& key : keys){
+        std::shared_ptr<AudioSample> sample = std::dynamic_pointer_cast<AudioSample>(_assets->get<Sound>(key));
+        if (sample == nullptr) continue;
+        size_t bytes = sample->getMemoryUsage();
+        size_t before = sample->isStreamed() ? 0 : sample->getFloatSize();
+        CULog("sound %-24s %-6s %8zu bytes (%zu as float)", key.c_str(),
+              sample->isStreamed() ? "stream" : FORMATS[(int)sample->getFormat()], bytes, before);
+        total += bytes;
+        floats += before;
     }
+    CULog("sound memory %zu KB (%zu KB as float)", total/1024, floats/1024);
 }
 
 /**
- * Clears sound associated with player action.
+ * Plays the given cue at the given attenuation.
  *
- * @param  action  the action key for the player
+ * @param cue       the sound effect cue
+ * @param instance  the instance of the voice
+ * @param gain      the distance attenuation of the cue, in [0,1]
  */
-void AudioController::clearPlayerFX(const std::string action){
-    if (AudioEngine::get()->isActive(action+"player")) {
-        AudioEngine::get()->clear(action+"player");
+void AudioController::playVoice(Cue cue, Uint32 instance, float gain){
+    if (isSilent() || _cues.empty()) return;
+    CueData& data = _cues[cue];
+    if (data.sounds.empty()) return;
+    if (instance >= data.handles.size()){
+        data.handles.resize(instance+1, UINT32_MAX);
     }
-}
-    
-    /**
-     * Plays sound associated with action of enemy type.
-     *
-     * @param  action  the action key for the enemy
-     * @param  key  the reference key for the enemy type
-     */
-void AudioController::playEnemyFX(const std::string action, const std::string key){
-    if (!AudioEngine::get()->isActive(action+key)) {
-        std::shared_ptr<Sound> source;
-        if (action == "attack") {
-            int randn = std::rand() % 6 + 1;
-            source = _assets->get<Sound>("enemyAttack" + std::to_string(randn));
-        }
-        else if (action == "death") {
-            if (key == "boss enemy") {
-                source = _assets->get<Sound>("bossDeath");
-            } else if (key == "mage alien") {
-                int randn = std::rand() % 3 + 1;
-                source = _assets->get<Sound>("casterDeath" + std::to_string(randn));
-            } else {
-                int randn = std::rand() % 4 + 1;
-                source = _assets->get<Sound>("alienDeath" + std::to_string(randn));
-            }
-        }
-        else if (action == "casterAttack") {
-            int randn = std::rand() % 3 + 1;
-            source = _assets->get<Sound>("casterAttack" + std::to_string(randn));
-        }
-        else if (action == "tankAttack") {
-            source = _assets->get<Sound>("tankAttack");
-        }
-        else if (action == "bossAttack") {
-            int randn = std::rand() % 3 + 1;
-            source = _assets->get<Sound>("bossAttack" + std::to_string(randn));
-        }
-        else if (action == "bossStorm") {
-            source = _assets->get<Sound>("bossStorm");
-        }
-        else if (action == "slimeExplode") {
-            source = _assets->get<Sound>("slimeExplode");
-        }
-        else {
-            CULogError("player sound action not found");
-        }
-        AudioEngine::get()->play(action+key, source, false, source->getVolume() * _master * _sfx);
+    Uint32& handle = data.handles[instance];
+    AudioEngine* engine = AudioEngine::get();
+    if (handle == UINT32_MAX){
+        // cues sharing a voice share its handles, since the key is the same
+        handle = engine->getHandle(data.voice + std::to_string(instance));
+    }
+    if (engine->isActive(handle)) return;
+    if (data.chance > 1 && GameRandom::nextInt(GameRandom::AUDIO, (int)data.chance) != 0) return;
+    if (gain <= 0 || !reserveVoice(data.priority, gain)){
+        _stats.culled++;
+        return;
+    }
+    const std::shared_ptr<Sound>& source = data.sounds.size() == 1 ? data.sounds[0] :
+        data.sounds[GameRandom::nextInt(GameRandom::AUDIO, (int)data.sounds.size())];
+    if (engine->play(handle, source, data.loop, source->getVolume() * _master * _sfx * gain)){
+        _voices.push_back({ handle, data.priority, gain, _frame });
+    }
+    else {
+        _stats.culled++;
     }
 }
 
-void AudioController::playDamagedEnemy(const std::string enemyType, const std::string key) {
-    std::shared_ptr<Sound> source;
-    if (!AudioEngine::get()->isActive("damaged"+key)) {
-        if (enemyType == "mage alien") {
-            int randn = std::rand() % 2 + 1;
-            source = _assets->get<Sound>("casterDamaged" + std::to_string(randn));
-        } else if (enemyType == "tank enemy stunned") {
-            source = _assets->get<Sound>("tankHitNoArmor");
-        } else if (enemyType == "tank enemy") {
-            source = _assets->get<Sound>("tankHitArmored");
-        } else if (enemyType == "boss enemy") {
-            int randn = std::rand() % 3 + 1;
-            source = _assets->get<Sound>("bossDamaged" + std::to_string(randn));
-        } else {
-            source = _assets->get<Sound>("alienImpact");
+/**
+ * Makes room for a voice of the given priority, stealing one if necessary.
+ *
+ * @param priority  the priority of the new voice
+ * @param gain      the distance attenuation of the new voice
+ *
+ * @return true if the new voice may play
+ */
+bool AudioController::reserveVoice(Priority priority, float gain){
+    pruneVoices();
+    Uint32 count = 0;
+    for (const Voice& voice : _voices){
+        if (voice.priority == priority) count++;
+    }
+    bool categoryFull = count >= VOICE_CAPS[priority];
+    if (!categoryFull && AudioEngine::get()->getAvailableSlots() > 0){
+        return true;
+    }
+    // a full category steals from itself, a full engine from any category up to this one
+    int victim = -1;
+    for (int ii = 0; ii < (int)_voices.size(); ii++){
+        const Voice& voice = _voices[ii];
+        if (categoryFull ? voice.priority != priority : voice.priority > priority) continue;
+        if (victim < 0) {
+            victim = ii;
+            continue;
+        }
+        const Voice& best = _voices[victim];
+        if (voice.priority != best.priority ? voice.priority < best.priority :
+            voice.gain != best.gain ? voice.gain < best.gain : voice.started < best.started){
+            victim = ii;
         }
-        AudioEngine::get()->play("damaged"+key, source, false, source->getVolume() * _master * _sfx);
     }
+    if (victim < 0 || (_voices[victim].priority == priority && _voices[victim].gain > gain)){
+        return false;
+    }
+    // the slot must be free now, or the play that follows finds none
+    AudioEngine::get()->evict(_voices[victim].handle);
+    _voices.erase(_voices.begin() + victim);
+    _stats.stolen++;
+    return true;
 }
 
-void AudioController::playAggroEnemy(const std::string enemyType) {
-    std::shared_ptr<Sound> source;
-    if (!AudioEngine::get()->isActive("aggro"+enemyType)) {
-        int randn = std::rand() % 2 + 1;
-        if (enemyType == "mage alien") {
-            source = _assets->get<Sound>("casterAggro" + std::to_string(randn));
-        } else if (enemyType == "tank enemy") {
-            source = _assets->get<Sound>("tankAggro" + std::to_string(randn));
-        } else if (enemyType == "boss enemy") {
-            source = _assets->get<Sound>("bossAggro" + std::to_string(randn));
-        } else if (enemyType != "exploding alien") {
-            int randn = std::rand() % 4 + 1;
-            source = _assets->get<Sound>("enemyAggro" + std::to_string(randn));
-        } else {
-            return;
-        }
-        AudioEngine::get()->play("aggro"+enemyType, source, false, source->getVolume() * _master * _sfx);
+/**
+ * Forgets the voices that are no longer playing.
+ */
+void AudioController::pruneVoices(){
+    AudioEngine* engine = AudioEngine::get();
+    _voices.erase(std::remove_if(_voices.begin(), _voices.end(), [engine](const Voice& voice){
+        return !engine->isActive(voice.handle);
+    }), _voices.end());
+}
+
+float AudioController::getAttenuation(const Vec2& position){
+    if (_view.size.width <= 0 || _view.size.height <= 0) return 1.0f;
+    float dx = std::max(std::max(_view.getMinX() - position.x, position.x - _view.getMaxX()), 0.0f);
+    float dy = std::max(std::max(_view.getMinY() - position.y, position.y - _view.getMaxY()), 0.0f);
+    if (dx == 0 && dy == 0) return 1.0f;
+    float range = VOICE_FALLOFF * std::max(_view.size.width, _view.size.height);
+    float distance = std::sqrt(dx*dx + dy*dy);
+    return distance >= range ? 0.0f : 1.0f - distance/range;
+}
+
+/**
+ * Starts a new frame of the voice manager.
+ *
+ * @param view  the camera view in physics coordinates
+ */
+void AudioController::update(const Rect& view){
+    _view = view;
+    if (!isSilent()) pruneVoices();
+    _stats.active = (Uint32)_voices.size();
+    _lastStats = _stats;
+    _stats = VoiceStats();
+    _frame++;
+    // music is decoded on a worker; a gap means it fell behind the audio thread
+    Uint64 underruns = audio::AudioPlayer::getAllUnderruns();
+    if (underruns != _underruns){
+        CUWarn("Music stream underran %llu time(s)", (unsigned long long)(underruns-_underruns));
+        _underruns = underruns;
     }
 }
 
+std::string AudioController::getVoiceReport(){
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "voices %u active, %u culled, %u stolen, %llu music underruns",
+             _lastStats.active, _lastStats.culled, _lastStats.stolen, (unsigned long long)_underruns);
+    return buffer;
+}
+
 /**
- * Plays sound associated with player action.
+ * Stops the voice of the given cue.
  *
- * @param  action  the action key for the player
+ * @param cue       the sound effect cue
+ * @param instance  the instance of the voice (such as the enemy index)
  */
-void AudioController::playUiFX(const std::string action){
-    if (!AudioEngine::get()->isActive(action+"ui")) {
-        if (action == "menuClick") {
-            auto source = _assets->get<Sound>("menuClick");
-            AudioEngine::get()->play(action+"ui", source, false, source->getVolume() * _master * _sfx);
+void AudioController::clear(Cue cue, Uint32 instance){
+    if (isSilent() || _cues.empty()) return;
+    const CueData& data = _cues[cue];
+    if (instance < data.handles.size() && data.handles[instance] != UINT32_MAX){
+        AudioEngine::get()->clear(data.handles[instance]);
+    }
+}
+
+AudioController::Cue AudioController::getDeathCue(const std::string& enemyType){
+    if (enemyType == "boss enemy") return BOSS_DEATH;
+    if (enemyType == "mage alien") return CASTER_DEATH;
+    return ALIEN_DEATH;
+}
+
+AudioController::Cue AudioController::getDamagedCue(const std::string& enemyType, bool stunned){
+    if (enemyType == "mage alien") return CASTER_DAMAGED;
+    if (enemyType == "tank enemy") return stunned ? TANK_DAMAGED : TANK_DAMAGED_ARMORED;
+    if (enemyType == "boss enemy") return BOSS_DAMAGED;
+    return ALIEN_DAMAGED;
+}
+
+AudioController::Cue AudioController::getAggroCue(const std::string& enemyType){
+    if (enemyType == "mage alien") return CASTER_AGGRO;
+    if (enemyType == "tank enemy") return TANK_AGGRO;
+    if (enemyType == "boss enemy") return BOSS_AGGRO;
+    if (enemyType == "exploding alien") return CUE_COUNT;
+    return ENEMY_AGGRO;
+}
+
+void AudioController::onEnemyProjImpact(const std::string enemyType) {
+    if (isSilent()) return;
+    if (!AudioEngine::get()->isActive(enemyType+"proj")) {
+        std::shared_ptr<Sound> source;
+        if (enemyType == "caster") {
+        source = _assets->get<Sound>("casterImpact");
         }
-        else if (action == "upgrade" || action == "health") {
-            auto source = _assets->get<Sound>("upgrade");
-            AudioEngine::get()->play(action+"ui", source, false, source->getVolume() * _master * _sfx);
+        else if (enemyType == "lizard") {
+            source = _assets->get<Sound>("rlizardImpact");
         }
-        else if (action == "environment") {
-            int randn = std::rand();
-            if (randn % 500 == 0) {
-                randn = randn % 4 + 1;
-                auto source = _assets->get<Sound>("env" + std::to_string(randn));
-                AudioEngine::get()->play(action+"ui", source, false, source->getVolume() * _master * _sfx);
-            }
+        else if (enemyType == "boss") {
+            source = _assets->get<Sound>("bossImpact");
         }
-
     }
 }
-    
+
     /**
      * Plays music associated with scene.
      *
      * @param  key1  the reference key for the event
      */
 void AudioController::updateMusic(const std::string key, float fade) {
+    if (isSilent()) return;
     std::shared_ptr<AudioQueue> m = AudioEngine::get()->getMusicQueue();
     std::shared_ptr<Sound> source;
     bool loop = false;
@@ -2,6 +2,18 @@
 //  AudioController.hpp
 //  RS
 //
+//  Sound effects are triggered by cue. The cue table is resolved once the assets are
+//  loaded: each cue holds its sound variants and the engine handles of its voice, so
+//  triggering a sound on the hot path does no string work.
+//
+//  Every cue has a priority, which is also its voice category. Each category has a cap
+//  on its voices, and a cue played at a position is attenuated (or culled) by its
+//  distance from the camera view. When a category or the engine is full, the quietest
+//  (then oldest) voice of the same or a lower priority is stolen, if the new cue is
+//  not quieter than it.
+//
+//  Version: 10/18/26
+//
 
 #ifndef AudioController_hpp
 #define AudioController_hpp
@@ -11,7 +23,112 @@
 #include "../utility/SaveData.hpp"
 
 class AudioController {
+public:
+    /** The sound effect cues */
+    enum Cue {
+        PLAYER_ATTACK = 0,
+        PLAYER_ATTACK_POWER,
+        PLAYER_DRAW_BOW,
+        PLAYER_LOOP_BOW,
+        PLAYER_SHOOT_BOW,
+        PLAYER_PARRY,
+        PLAYER_DAMAGED,
+        PLAYER_DASH,
+        PLAYER_PROJ_HIT,
+        /** the instance of an enemy cue is the index of the enemy */
+        ENEMY_ATTACK,
+        CASTER_ATTACK,
+        TANK_ATTACK,
+        BOSS_ATTACK,
+        BOSS_STORM,
+        SLIME_EXPLODE,
+        BOSS_DEATH,
+        CASTER_DEATH,
+        ALIEN_DEATH,
+        /** the damaged cues share a voice, so an enemy makes one damage sound at a time */
+        CASTER_DAMAGED,
+        TANK_DAMAGED,
+        TANK_DAMAGED_ARMORED,
+        BOSS_DAMAGED,
+        ALIEN_DAMAGED,
+        CASTER_AGGRO,
+        TANK_AGGRO,
+        BOSS_AGGRO,
+        ENEMY_AGGRO,
+        UI_CLICK,
+        UI_UPGRADE,
+        UI_HEALTH,
+        /** ambient sounds, played at random */
+        UI_ENVIRONMENT,
+        /** the number of cues */
+        CUE_COUNT
+    };
+
+    /** The priorities of the cues, highest last. The priority is also the voice category */
+    enum Priority {
+        AMBIENT = 0,
+        ENEMY,
+        BOSS,
+        /** the player and the interface */
+        PLAYER,
+        /** the number of priorities */
+        PRIORITY_COUNT
+    };
+
+    /** The voice counts of a frame */
+    struct VoiceStats {
+        /** the voices playing at the end of the frame */
+        Uint32 active = 0;
+        /** the cues dropped as inaudible or for lack of a voice */
+        Uint32 culled = 0;
+        /** the voices stopped to make room for another cue */
+        Uint32 stolen = 0;
+    };
+
 protected:
+    /** The resolved data of a cue */
+    struct CueData {
+        /** the sound variants of the cue (one is picked at random) */
+        std::vector<std::shared_ptr<cugl::Sound>> sounds;
+        /** the key of the voice of the cue, without the instance */
+        std::string voice;
+        /** the engine handle of each instance (UINT32_MAX until first used) */
+        std::vector<Uint32> handles;
+        /** whether the cue loops */
+        bool loop = false;
+        /** the cue plays with a chance of 1 in this (1 to always play) */
+        Uint32 chance = 1;
+        /** the priority (and voice category) of the cue */
+        Priority priority = PLAYER;
+    };
+
+    /** A voice started by this controller */
+    struct Voice {
+        /** the engine handle of the voice */
+        Uint32 handle;
+        /** the priority of the cue playing */
+        Priority priority;
+        /** the distance attenuation of the cue, in [0,1] */
+        float gain;
+        /** the frame the voice started */
+        Uint32 started;
+    };
+
+    /** The cue table, indexed by cue */
+    static std::vector<CueData> _cues;
+    /** The voices that may still be playing */
+    static std::vector<Voice> _voices;
+    /** The camera view in physics coordinates (empty if cues are not culled) */
+    static cugl::Rect _view;
+    /** The number of the current frame */
+    static Uint32 _frame;
+    /** The voice counts of the current frame */
+    static VoiceStats _stats;
+    /** The voice counts of the last frame */
+    static VoiceStats _lastStats;
+    /** The number of music underruns already reported */
+    static Uint64 _underruns;
+
     /** The asset manager for this audio controller. */
     static std::shared_ptr<cugl::AssetManager> _assets;
     
@@ -26,6 +143,37 @@ protected:
      * Default Constructor
     */
     AudioController(){}
+
+    /**
+     * Plays the given cue at the given attenuation.
+     *
+     * @param cue       the sound effect cue
+     * @param instance  the instance of the voice
+     * @param gain      the distance attenuation of the cue, in [0,1]
+     */
+    static void playVoice(Cue cue, Uint32 instance, float gain);
+
+    /**
+     * Makes room for a voice of the given priority, stealing one if necessary.
+     *
+     * @param priority  the priority of the new voice
+     * @param gain      the distance attenuation of the new voice
+     *
+     * @return true if the new voice may play
+     */
+    static bool reserveVoice(Priority priority, float gain);
+
+    /**
+     * Forgets the voices that are no longer playing.
+     */
+    static void pruneVoices();
+
+    /**
+     * @param position  a position in physics coordinates
+     *
+     * @return the attenuation of a cue at the position, 0 if it is inaudible
+     */
+    static float getAttenuation(const cugl::Vec2& position);
     
 public:
 #pragma mark -
@@ -39,7 +187,55 @@ public:
     /**
      * @note should only be called once and remove reference to assets.
      */
-    static void dispose(){ _assets = nullptr; }
+    static void dispose(){ _assets = nullptr; _cues.clear(); _voices.clear(); }
+
+    /**
+     * Resolves the cue table from the loaded assets.
+     *
+     * This must be called once the assets have finished loading. Cues played
+     * before then are dropped.
+     */
+    static void loadCues();
+
+    /**
+     * Logs the memory used by each loaded sample, and as float data.
+     *
+     * Samples may be stored as 16-bit PCM or ADPCM (see "format" in
+     * assets.json), so this shows what the compact formats save.
+     */
+    static void logMemoryReport();
+    
+    /**
+     * Returns true if sounds are currently dropped.
+     *
+     * This is the case before {@link #init} and after {@link #dispose}, or
+     * when there is no audio engine. It lets the gameplay code run without
+     * any audio (e.g. in the headless runner).
+     */
+    static bool isSilent() { return _assets == nullptr || cugl::AudioEngine::get() == nullptr; }
+
+    /**
+     * Starts a new frame of the voice manager.
+     *
+     * This should be called once a frame by the game scene, before any cue
+     * is played that frame.
+     *
+     * @param view  the camera view in physics coordinates
+     */
+    static void update(const cugl::Rect& view);
+
+    /**
+     * @return the voice counts of the last frame
+     */
+    static const VoiceStats& getVoiceStats() { return _lastStats; }
+
+    /**
+     * Returns the voice counts and music underruns as a line of text for the
+     * debug overlay.
+     *
+     * @return the voice counts as a line of text for the debug overlay
+     */
+    static std::string getVoiceReport();
 
 #pragma mark -
 #pragma mark audio
@@ -90,56 +286,61 @@ public:
     static void playCollisionFX(const std::string key1, const std::string key2);
     
     /**
-     * Plays sound associated with player action.
+     * Plays the given cue, unless the instance is already playing its voice.
      *
-     * @param  action  the action key for the player
+     * @param cue       the sound effect cue
+     * @param instance  the instance of the voice (such as the enemy index)
      */
-    static void playPlayerFX(const std::string action);
-    
+    static void play(Cue cue, Uint32 instance = 0) { playVoice(cue, instance, 1.0f); }
+
     /**
-     * Plays sound associated with player action.
+     * Plays the given cue at a position in the world.
+     *
+     * The cue is attenuated by its distance from the camera view, and culled
+     * if it is too far away to hear.
      *
-     * @param  action  the action key for the player
+     * @param cue       the sound effect cue
+     * @param instance  the instance of the voice (such as the enemy index)
+     * @param position  the source of the sound, in physics coordinates
      */
-    static void clearPlayerFX(const std::string action);
-    
+    static void play(Cue cue, Uint32 instance, const cugl::Vec2& position) {
+        playVoice(cue, instance, getAttenuation(position));
+    }
+
     /**
-     * Plays sound associated with action of eney type.
+     * Stops the voice of the given cue.
      *
-     * @param  action  the action key for the enemy
-     * @param  key  the reference key for the enemy type
+     * @param cue       the sound effect cue
+     * @param instance  the instance of the voice (such as the enemy index)
      */
-    static void playEnemyFX(const std::string action, const std::string key);
-    
+    static void clear(Cue cue, Uint32 instance = 0);
+
     /**
-     * Plays sound associated when enemy takes damage
+     * @param enemyType the type of the enemy
      *
-     * @param  action  the action key for the enemy
-     * @param  key  the reference key for the enemy type
+     * @return the cue of the death of the given enemy type
      */
-    static void playDamagedEnemy(const std::string enemyType, const std::string key);
-    
+    static Cue getDeathCue(const std::string& enemyType);
+
     /**
-     * Plays sound associated when enemy takes aggro
+     * @param enemyType the type of the enemy
+     * @param stunned   whether the enemy is stunned
      *
-     * @param  action  the action key for the enemy
-     * @param  key  the reference key for the enemy type
+     * @return the cue of the given enemy type taking damage
      */
-    static void playAggroEnemy(const std::string enemyType);
-    
+    static Cue getDamagedCue(const std::string& enemyType, bool stunned);
+
     /**
-     * Plays sound associated with projectile impact of enemy type.
+     * @param enemyType the type of the enemy
+     *
+     * @return the aggro cue of the given enemy type (CUE_COUNT if it has none)
      */
-    
-    static void onEnemyProjImpact(const std::string enemyType);
-    
+    static Cue getAggroCue(const std::string& enemyType);
+
     /**
-     * Plays sound associated with UI actions.
-     *
-     * @param  action  the action key for the enemy
-     * @param  key  the reference key for the enemy type
+     * Plays sound associated with projectile impact of enemy type.
      */
-    static void playUiFX(const std::string action);
+    static void onEnemyProjImpact(const std::string enemyType);
     
     /**
      * Plays music associated with scene.
@@ -54,7 +54,7 @@ void CollisionController::beginContact(b2Contact* contact){
     std::shared_ptr<SemiCircleHitbox> meleeHitbox = player->getMeleeHitbox();
     intptr_t aptr = reinterpret_cast<intptr_t>(meleeHitbox.get());
     intptr_t pptr = reinterpret_cast<intptr_t>(player.get());
-    std::vector<std::shared_ptr<Enemy>> enemies = _level->getEnemies();
+    const std::vector<std::shared_ptr<Enemy>>& enemies = _level->getEnemies();
     int enemyIndex = 0;
     for (auto it = enemies.begin(); it != enemies.end(); ++it) {
         if ((*it)->isEnabled() && (*it)->getHealth() > 0) {
@@ -70,8 +70,7 @@ void CollisionController::beginContact(b2Contact* contact){
                 if (player->getMeleeHitbox()->hits(eptr, ang)){
                     if (!player->isComboStrike()) (*it)->hit(dir, false, player->getMeleeDamage());
                     else (*it)->hit(dir, false, player->getMeleeDamage() * GameConstants::COMBO_DMG_MUL, GameConstants::KNOCKBACK_PWR_ATK);
-                    std::string stunInfo = (*it)->isStunned() && (*it)->getType() == "tank alien"? " stun" : "";
-                    AudioController::playDamagedEnemy((*it)->getType() + stunInfo, std::to_string(enemyIndex));
+                    AudioController::play(AudioController::getDamagedCue((*it)->getType(), (*it)->isStunned()), enemyIndex, (*it)->getPosition());
                     //CULog("Hit an enemy!");
                     if (meleeHitbox->hitCount() == 1){
                         // the hitbox is active and this is the first hit of the frame
@@ -84,7 +83,7 @@ void CollisionController::beginContact(b2Contact* contact){
             }
 
             //player ranged attack
-            for (std::shared_ptr<Projectile> p : _level->getProjectiles()) {
+            for (const std::shared_ptr<Projectile>& p : _level->getProjectiles()) {
                 intptr_t projptr = reinterpret_cast<intptr_t>(p.get());
                 if ((body1->GetUserData().pointer == projptr && body2->GetUserData().pointer == eptr) ||
                     (body1->GetUserData().pointer == eptr && body2->GetUserData().pointer == projptr)) {
@@ -94,8 +93,8 @@ void CollisionController::beginContact(b2Contact* contact){
                         (*it)->hit(((*it)->getPosition() - p->getPosition()).getNormalization(), true, p->getDamage(), knockback);
                         //CULog("Shot an enemy!");
                         p->setExploding();
-                        AudioController::playPlayerFX("projOnHit");
-                        AudioController::playDamagedEnemy((*it)->getType(), std::to_string(enemyIndex));
+                        AudioController::play(AudioController::PLAYER_PROJ_HIT);
+                        AudioController::play(AudioController::getDamagedCue((*it)->getType(), false), enemyIndex, (*it)->getPosition());
                     }
                 }
             }
@@ -103,13 +102,13 @@ void CollisionController::beginContact(b2Contact* contact){
         enemyIndex++;
     }
     //health packs
-    for (std::shared_ptr<HealthPack> h : _level->getHealthPacks()) {
+    for (const std::shared_ptr<HealthPack>& h : _level->getHealthPacks()) {
         intptr_t hptr = reinterpret_cast<intptr_t>(h.get());
         if ((body1->GetUserData().pointer == hptr && body2->GetUserData().pointer == pptr) ||
             (body1->GetUserData().pointer == pptr && body2->GetUserData().pointer == hptr)) {
             //don't pick up the health pack if at full hp
             if (player->getHP() < player->getMaxHP()) {
-                AudioController::playUiFX("health");
+                AudioController::play(AudioController::UI_HEALTH);
                 float maxHP = player->getMaxHP();
                 float newHP = player->getHP() + maxHP * GameConstants::HEALTHPACK_HEAL_AMT;
                 if (newHP > maxHP) newHP = maxHP;
@@ -144,24 +143,24 @@ void CollisionController::beginContact(b2Contact* contact){
                 Vec2 dir = player->getPosition() * player->getDrawScale() - (*it)->getPosition() * (*it)->getDrawScale();
                 dir.normalize();
                 float ang = acos(dir.dot(Vec2::UNIT_X));
-                if ((*it)->getType() == "exploding alien") AudioController::playEnemyFX("slimeExplode", std::to_string(enemyIndex));
+                if ((*it)->getType() == "exploding alien") AudioController::play(AudioController::SLIME_EXPLODE, enemyIndex, (*it)->getPosition());
                 if (player->getPosition().y * player->getDrawScale().y < (*it)->getPosition().y * (*it)->getDrawScale().y) ang = 2 * M_PI - ang;
                 if (attack->hits(pptr, ang)){
                     if (player->isParrying() && melee != nullptr) {
                         //successful parry
                         melee->setStunned(player->getStunWindow());
                         player->playParryEffect();
-                        AudioController::playPlayerFX("parry");
+                        AudioController::play(AudioController::PLAYER_PARRY);
                     }
                     else if (player->isParrying() && boss != nullptr) {
                         //successful parry
                         boss->setStunned(player->getStunWindow());
                         player->playParryEffect();
-                        AudioController::playPlayerFX("parry");
+                        AudioController::play(AudioController::PLAYER_PARRY);
                     }
                     else {
                         player->hit(dir, (*it)->getDamage());
-                        AudioController::playPlayerFX("damaged");
+                        AudioController::play(AudioController::PLAYER_DAMAGED);
                         //CULog("Player took damage!");
                     }
                 }
@@ -184,7 +183,7 @@ void CollisionController::beginContact(b2Contact* contact){
                     dir.normalize();
                     float ang = acos(dir.dot(Vec2::UNIT_X));
                     if (player->getPosition().y * player->getDrawScale().y < (*it)->getPosition().y * (*it)->getDrawScale().y) ang = 2 * M_PI - ang;
-                    AudioController::playPlayerFX("damaged");
+                    AudioController::play(AudioController::PLAYER_DAMAGED);
                     player->hit(dir, (*it)->getDamage());
                     //CULog("Player took damage!");
                 }
@@ -192,7 +191,7 @@ void CollisionController::beginContact(b2Contact* contact){
         }
     }
     // enemy ranged attack and projectile-wall collisions
-    for (std::shared_ptr<Projectile> p : _level->getProjectiles()) {
+    for (const std::shared_ptr<Projectile>& p : _level->getProjectiles()) {
         intptr_t projptr = reinterpret_cast<intptr_t>(p.get());
         if ((body1->GetUserData().pointer == projptr && body2->GetUserData().pointer == pptr) ||
             (body1->GetUserData().pointer == pptr && body2->GetUserData().pointer == projptr)) {
@@ -208,7 +207,7 @@ void CollisionController::beginContact(b2Contact* contact){
                 else player->playParryEffect();
             }
         }
-        for (std::shared_ptr<Wall> w : _level->getWalls()) {
+        for (const std::shared_ptr<Wall>& w : _level->getWalls()) {
             intptr_t wptr = reinterpret_cast<intptr_t>(w.get());
             if ((body1->GetUserData().pointer == projptr && body2->GetUserData().pointer == wptr) ||
                 (body1->GetUserData().pointer == wptr && body2->GetUserData().pointer == projptr)) {
@@ -219,7 +218,7 @@ void CollisionController::beginContact(b2Contact* contact){
     }
     
     // player and end-of-level energy sensor collision
-    for (std::shared_ptr<EnergyWall> ewall : _level->getEnergyWalls()) {
+    for (const std::shared_ptr<EnergyWall>& ewall : _level->getEnergyWalls()) {
         intptr_t wallptr = reinterpret_cast<intptr_t>(ewall.get());
         if ((body1->GetUserData().pointer == pptr && body2->GetUserData().pointer == wallptr) ||
             (body1->GetUserData().pointer == wallptr && body2->GetUserData().pointer == pptr)) {
@@ -282,7 +281,7 @@ void CollisionController::beforeSolve(b2Contact* contact, const b2Manifold* oldM
     b2Body* body2 = contact->GetFixtureB()->GetBody();
 
     intptr_t pptr = reinterpret_cast<intptr_t>(_level->getPlayer().get());
-    std::vector<std::shared_ptr<Enemy>> enemies = _level->getEnemies();
+    const std::vector<std::shared_ptr<Enemy>>& enemies = _level->getEnemies();
     for (auto it = enemies.begin(); it != enemies.end(); ++it) {
         intptr_t eptr = reinterpret_cast<intptr_t>((*it).get());
         if ((body1->GetUserData().pointer == pptr && body2->GetUserData().pointer == eptr) ||
@@ -320,7 +319,7 @@ void CollisionController::beforeSolve(b2Contact* contact, const b2Manifold* oldM
         if (body1->GetUserData().pointer == eptr ||body2->GetUserData().pointer == eptr)
             if (!(*it)->isEnabled()) contact->SetEnabled(false);
     }
-    for (std::shared_ptr<Projectile> p : _level->getProjectiles()) {
+    for (const std::shared_ptr<Projectile>& p : _level->getProjectiles()) {
         intptr_t projptr = reinterpret_cast<intptr_t>(p.get());
         if ((body1->GetUserData().pointer == projptr && body2->GetUserData().pointer == pptr) ||
             (body1->GetUserData().pointer == pptr && body2->GetUserData().pointer == projptr)) {
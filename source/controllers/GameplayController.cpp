@@ -0,0 +1,216 @@
+#include "GameplayController.hpp"
+#include "AudioController.hpp"
+#include "../models/LevelModel.hpp"
+#include "../models/Player.hpp"
+#include "../models/Enemy.hpp"
+#include "../models/MeleeEnemy.hpp"
+#include "../models/RangedEnemy.hpp"
+#include "../models/BossEnemy.hpp"
+#include "../models/ExplodingAlien.hpp"
+#include "../models/Projectile.hpp"
+#include "../models/HealthPack.hpp"
+#include "../models/Wall.hpp"
+#include "../utility/GameRandom.hpp"
+
+void GameplayController::reset(){
+    _hitPause.setMaxCount(GameConstants::HIT_PAUSE_FRAMES + 3);
+    _hitPause.setCount(0);
+}
+
+bool GameplayController::clearRoom(const std::shared_ptr<LevelModel>& level, bool& fought){
+    // game not won or lost, check if any enemies active
+    int activeCount = 0;
+    int initialCount = 0;
+    const auto& enemies = level->getEnemies();
+    for (auto it = enemies.begin(); it != enemies.end(); ++it) {
+        if (!(*it)->isDefeated()) {
+            activeCount += 1;
+        }
+        if ((*it)->getMaxHealth() > 0){
+            initialCount += 1;
+        }
+    }
+    fought = initialCount > 0;
+    if (activeCount > 0){
+        return false;
+    }
+    const auto& energyWalls = level->getEnergyWalls();
+    for (auto it = energyWalls.begin(); it != energyWalls.end(); ++it) {
+        (*it)->deactivate();
+    }
+    return true;
+}
+
+bool GameplayController::updateHitPause(bool combo){
+    if (combo && _hitPause.isZero()){
+        _hitPause.reset();
+    }
+    if (!_hitPause.isZero()){
+        _hitPause.decrement();
+        if (_hitPause.getCount() <= GameConstants::HIT_PAUSE_FRAMES){
+            return true; // this gives the vague "lag" effect
+        }
+    }
+    return false;
+}
+
+void GameplayController::update(const std::shared_ptr<LevelModel>& level, float dt){
+    auto player = level->getPlayer();
+    // enemy attacks
+    int enemyIndex = 0;
+    const std::vector<std::shared_ptr<Enemy>>& enemies = level->getEnemies();
+    for (auto it = enemies.begin(); it != enemies.end(); ++it) {
+        auto enemy = *it;
+        if (!enemy->isEnabled() || enemy->isDying()) continue;
+        if (enemy->getHealth() <= 0) {
+            //drop health pack
+            AudioController::play(AudioController::getDeathCue(enemy->getType()), 0, enemy->getPosition());
+            if (!enemy->_dropped && GameRandom::nextInt(GameRandom::COMBAT, 100) < GameConstants::HEALTHPACK_DROP_RATE) {
+                auto healthpack = HealthPack::alloc(enemy->getPosition(), _assets);
+                healthpack->setDrawScale(level->getDrawScale());
+                level->addHealthPack(healthpack);
+            }
+
+            if (enemy->getType() == "melee lizard" ||
+                enemy->getType() == "tank enemy" ||
+                enemy->getType() == "boss enemy") {
+                std::shared_ptr<MeleeEnemy> m = std::dynamic_pointer_cast<MeleeEnemy>(enemy);
+                m->getAttack()->setEnabled(false);
+            }
+
+            if (enemy->isEnabled() && !enemy->isDying()) { 
+                enemy->setDying(); 
+                // this also disables the hurtbox, whose fixtures are on the collider body
+                // (attacks ignore an enemy without health anyway)
+                enemy->getCollider()->setEnabled(false);
+                enemy->getColliderShadow()->setEnabled(false);
+            }
+            enemy->_dropped = true;
+        }
+        if (enemy->getType() == "melee lizard" ||
+            enemy->getType() == "tank enemy" ||
+            enemy->getType() == "boss enemy") {
+            std::shared_ptr<MeleeEnemy> m = std::dynamic_pointer_cast<MeleeEnemy>(enemy);
+            if (m->isStunned()){
+                enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
+                m->getAttack()->setEnabled(false);
+            }
+        }
+        if (enemy->isEnabled() && !enemy->isDying() && enemy->getHealth() > 0) {
+            // boss performs its second attack if already attacking
+            if (enemy->getType() == "boss enemy") {
+                std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(enemy);
+                if (boss->secondAttack()) {
+                    boss->attack2(_assets);
+                    boss->setAttacking2();
+                    continue;
+                }
+            }
+            // enemy can only begin an attack if not stunned and within range of player and can see them
+            bool canBeginNewAttack = enemy->canBeginNewAttack();
+            if (enemy->getType() == "exploding alien"){
+                auto explode = std::dynamic_pointer_cast<ExplodingAlien>(enemy);
+                if (canBeginNewAttack && enemy->getPosition().distance(player->getPosition()) <= enemy->getAttackRange() && enemy->getPlayerInSight()) {
+                    if (explode->canExplode()) {
+                        explode->setAttacking();
+                    } else {
+                        explode->updateWindup(true);
+                    }
+                } else {
+                    explode->updateWindup(false);
+                }
+                continue;
+            }
+            if (canBeginNewAttack && enemy->getPosition().distance(player->getPosition()) <= enemy->getAttackRange() && enemy->getPlayerInSight()) {
+                if (enemy->getType() == "melee lizard" ||
+                    enemy->getType() == "tank enemy" ||
+                    enemy->getType() == "boss enemy") {
+                    enemy->attack(level, _assets);
+                    if (enemy->getType() == "melee lizard") {
+                        AudioController::play(AudioController::ENEMY_ATTACK, enemyIndex, enemy->getPosition());
+                    }
+                    else {
+                        AudioController::play(enemy->getType() == "tank enemy" ? AudioController::TANK_ATTACK : AudioController::BOSS_ATTACK, enemyIndex, enemy->getPosition());
+                    }
+                }
+                enemy->setAttacking();
+            }
+            if (enemy->isAttacking()) {
+                if (enemy->getType() == "ranged lizard" ||
+                    enemy->getType() == "mage alien") {
+                    std::shared_ptr<RangedEnemy> r = std::dynamic_pointer_cast<RangedEnemy>(enemy);
+                    if (r->getCharged()) {
+                        enemy->attack(level, _assets);
+                        AudioController::play(enemy->getType() == "mage alien" ? AudioController::CASTER_ATTACK : AudioController::ENEMY_ATTACK, enemyIndex, enemy->getPosition());
+                    }
+                }
+            }
+            if (enemy->getType() == "boss enemy") {
+                std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(enemy);
+                if (boss->getStormState() == BossEnemy::StormState::CHARGED) {
+                    boss->summonStorm(level, _assets);
+                    AudioController::play(AudioController::BOSS_STORM, enemyIndex, enemy->getPosition());
+                }
+            }
+        }
+        enemyIndex++;
+    }
+
+    // component updates
+    for (auto it = enemies.begin(); it != enemies.end(); ++it) {
+        std::shared_ptr<MeleeEnemy> m;
+        if ((*it)->getType() == "melee lizard" || (*it)->getType() == "tank enemy"
+            || (*it)->getType() == "boss enemy") {
+            m = std::dynamic_pointer_cast<MeleeEnemy>(*it);
+            m->updateCounters();
+        }
+        else {
+            (*it)->updateCounters();
+        }
+        if ((*it)->getType() == "boss enemy") {
+            std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(*it);
+            boss->_stormTimer.decrement();
+        }
+    }
+    // removal erases from the lists, so only advance past the items that are kept
+    const std::vector<std::shared_ptr<Projectile>>& projs = level->getProjectiles();
+    for (size_t ii = 0; ii < projs.size(); ) {
+        std::shared_ptr<Projectile> proj = projs[ii];
+        proj->updateAnimation(dt);
+        if (proj->isCompleted()) level->delProjectile(proj);
+        else ii++;
+    }
+
+    const std::vector<std::shared_ptr<HealthPack>>& hps = level->getHealthPacks();
+    for (size_t ii = 0; ii < hps.size(); ) {
+        std::shared_ptr<HealthPack> hp = hps[ii];
+        hp->updateAnimation(dt);
+        if (hp->_delMark) level->delHealthPack(hp);
+        else ii++;
+    }
+    
+    // update every animation in game objects
+    for (auto& gameobject : level->getDynamicObjects()){
+        gameobject->updateAnimation(dt);
+    }
+    
+    player->update(dt); // updates counters, hitboxes
+}
+
+void GameplayController::syncPositions(const std::shared_ptr<LevelModel>& level){
+    const auto& enemies = level->getEnemies();
+    for (auto it = enemies.begin(); it != enemies.end(); ++it){
+        auto e = *it;
+        e->syncPositions();
+        if (e->getType() == "melee lizard"
+            || e->getType() == "tank enemy"
+            || e->getType() == "boss enemy") {
+            std::shared_ptr<MeleeEnemy> m = std::dynamic_pointer_cast<MeleeEnemy>(e);
+            m->getAttack()->setPosition(e->getPosition().add(0, 64 / e->getDrawScale().y)); //64 is half of the enemy pixel height
+        }
+    }
+    level->getPlayer()->syncPositions();
+
+    const auto& projs = level->getProjectiles();
+    for (auto it = projs.begin(); it != projs.end(); ++it) (*it)->syncPositions();
+}
@@ -0,0 +1,100 @@
+//
+//  GameplayController.hpp
+//
+//  This controller runs the part of a frame that changes the game state but does not
+//  need the renderer or the scene graph: clearing the room, the hit pause, enemy deaths
+//  and health pack drops, enemy attacks, the component counters, projectiles, health
+//  packs, animations and the position sync after each physics step. It is shared by the
+//  GameScene and the headless runner, so that a recorded session plays out the same way
+//  in both.
+//
+//  Version: 10/18/26
+//
+
+#ifndef __GAMEPLAY_CONTROLLER_HPP__
+#define __GAMEPLAY_CONTROLLER_HPP__
+#include <cugl/cugl.h>
+#include "../models/Counter.hpp"
+#include "../models/GameConstants.hpp"
+
+using namespace cugl;
+
+class LevelModel;
+
+/**
+ * The motivation to separate this out of GameScene is to let the enemies
+ * attack and die without the renderer and scene graph.
+ */
+class GameplayController {
+
+private:
+
+    /** reference to assets directory */
+    std::shared_ptr<AssetManager> _assets;
+    /** a counter for the number of frames to apply a hit-pause effect (for combo hit) */
+    Counter _hitPause;
+
+public:
+
+    /**
+     * loads the necessary assets for the controller
+     */
+    void setAssets(const std::shared_ptr<AssetManager>& assets) { _assets = assets; }
+
+    /**
+     * Resets the controller for a new room.
+     */
+    void reset();
+
+    /**
+     * Opens the energy walls of the given level if every enemy is defeated.
+     *
+     * @param level     the current level
+     * @param fought    set to whether the level had any enemies to defeat
+     *
+     * @return true if every enemy is defeated
+     */
+    bool clearRoom(const std::shared_ptr<LevelModel>& level, bool& fought);
+
+    /**
+     * Advances the hit pause, starting it on a combo hit.
+     *
+     * The frames of a hit pause skip the player input, the AI and {@link #update}.
+     *
+     * @param combo whether the player landed a combo hit since the last frame
+     *
+     * @return true if this frame is paused
+     */
+    bool updateHitPause(bool combo);
+
+    /**
+     * @return true if the physics steps of this frame are paused
+     */
+    bool isHitPaused() {
+        return !_hitPause.isZero() && _hitPause.getCount() <= GameConstants::HIT_PAUSE_FRAMES;
+    }
+
+    /**
+     * Updates the objects of the given level after the AI has moved the enemies.
+     *
+     * Enemies that ran out of health start dying (and may drop a health pack),
+     * the rest begin or continue their attacks. Then the counters and animations
+     * of every object (and the player) advance, and finished projectiles and
+     * used health packs are removed.
+     *
+     * @param level the level to update
+     * @param dt    the time of this frame in seconds
+     */
+    void update(const std::shared_ptr<LevelModel>& level, float dt);
+
+    /**
+     * Syncs the secondary bodies of the given level with a physics step.
+     *
+     * This moves the shadows, hitboxes and projectiles to their colliders.
+     *
+     * @param level the level that was stepped
+     */
+    void syncPositions(const std::shared_ptr<LevelModel>& level);
+};
+
+#endif /* __GAMEPLAY_CONTROLLER_HPP__ */
@@ -10,6 +10,22 @@ using namespace cugl;
 #define DEBUG_KEY KeyCode::Q
 /** The key for exitting the game */
 #define EXIT_KEY  KeyCode::ESCAPE
+/** The key for starting and saving an input recording */
+#define RECORD_KEY  KeyCode::K
+/** The key for replaying the last input recording */
+#define REPLAY_KEY  KeyCode::L
+
+/** The flags of a recorded frame, one bit per gameplay input */
+enum RecordFlag : Uint16 {
+    ATTACK_PRESSED  = 1 << 0,
+    ATTACK_DOWN     = 1 << 1,
+    ATTACK_RELEASED = 1 << 2,
+    DODGE_PRESSED   = 1 << 3,
+    PARRY_PRESSED   = 1 << 4,
+    PARRY_DOWN      = 1 << 5,
+    PARRY_RELEASED  = 1 << 6,
+    SWAP_PRESSED    = 1 << 7
+};
 
 /** How far we must swipe (in pixels) in any direction for a dodge gesture*/
 const int DODGE_SWIPE_LENGTH = 100;
@@ -30,7 +46,12 @@ const u_long DOUBLE_TAP_TIME_GAP = 200;
 
 
 InputController::InputController() :
-_active(false)
+_active(false),
+_mode(Mode::LIVE),
+_frames(0),
+_stepsPending(false),
+_replayDelta(0),
+_replaySteps(0)
 {
      clear();
 }
@@ -87,6 +108,16 @@ bool InputController::init(std::function<bool(Vec2)> preprocesser) {
 #pragma mark Input Detection
 
 void InputController::update(float dt) {
+    poll(dt);
+    if (_mode == Mode::RECORDING){
+        writeFrame(dt);
+    }
+    else if (_mode == Mode::REPLAYING){
+        readFrame();
+    }
+}
+
+void InputController::poll(float dt) {
 
     if (!_active){
         return;
@@ -101,6 +132,8 @@ void InputController::update(float dt) {
     _keyReset  = keys->keyPressed(RESET_KEY);
     _keyDebug  = keys->keyPressed(DEBUG_KEY);
     _keyExit   = keys->keyPressed(EXIT_KEY);
+    _keyRecord = keys->keyPressed(RECORD_KEY);
+    _keyReplay = keys->keyPressed(REPLAY_KEY);
 
     // reset attack direction
     _keyAttackDir.setZero(); // useful for changing direction of a charging attack
@@ -183,6 +216,8 @@ void InputController::update(float dt) {
     _parryDown = _keyParryDown;
     _parryReleased = _keyParryReleased;
     _swapPressed = _keySwap;
+    _recordPressed = _keyRecord;
+    _replayPressed = _keyReplay;
     
     _moveDir.set(_keyMoveDir).normalize();
     // attackdir and dodgedir are functions of the current facing direction so they are not set directly here
@@ -201,6 +236,8 @@ void InputController::update(float dt) {
     _keyDebug = false;
     _keyExit = false;
     _keySwap = false;
+    _keyRecord = false;
+    _keyReplay = false;
 #endif
 }
 
@@ -217,6 +254,8 @@ void InputController::clear() {
     _parryDown = false;
     _parryReleased = false;
     _swapPressed = false;
+    _recordPressed = false;
+    _replayPressed = false;
     _moveDir.setZero();
     _dodgeDir.setZero();
     _attackDir.setZero();
@@ -233,6 +272,8 @@ void InputController::clear() {
     _keyDebug = false;
     _keyExit = false;
     _keySwap = false;
+    _keyRecord = false;
+    _keyReplay = false;
     _keyMoveDir.setZero();
     _keyDodgeDir.setZero();
     _keyAttackDir.setZero();
@@ -245,6 +286,108 @@ void InputController::clear() {
     rangedMode = false;
 }
 
+#pragma mark -
+#pragma mark Recording and Replay
+
+void InputController::startRecording() {
+    _mode = Mode::RECORDING;
+    _recorder.reset();
+    _recorder.writeUint32(0); // frame count, rewritten when the recording stops
+    _frames = 0;
+    _stepsPending = false;
+}
+
+std::vector<std::byte> InputController::stopRecording() {
+    if (_mode != Mode::RECORDING){
+        return std::vector<std::byte>();
+    }
+    if (_stepsPending){
+        _recorder.writeUint16(0);
+        _stepsPending = false;
+    }
+    _recorder.rewriteFirstUint32(_frames);
+    std::vector<std::byte> result = _recorder.serialize();
+    _recorder.reset();
+    _mode = Mode::LIVE;
+    return result;
+}
+
+bool InputController::startReplay(const std::vector<std::byte>& frames) {
+    if (_mode == Mode::RECORDING){
+        stopRecording();
+    }
+    _replayer.receive(frames);
+    _frames = _replayer.readUint32();
+    _replayDelta = 0;
+    _replaySteps = 0;
+    _mode = _frames > 0 ? Mode::REPLAYING : Mode::LIVE;
+    return _frames > 0;
+}
+
+void InputController::stopReplay() {
+    if (_mode == Mode::REPLAYING){
+        _mode = Mode::LIVE;
+        _replayer.reset();
+        _frames = 0;
+        clear();
+    }
+}
+
+void InputController::endFrame(Uint32 steps) {
+    if (_mode == Mode::RECORDING && _stepsPending){
+        _recorder.writeUint16((Uint16)steps);
+        _stepsPending = false;
+    }
+}
+
+void InputController::writeFrame(float dt) {
+    if (_stepsPending){
+        // the last frame was never ended, so it took no steps
+        _recorder.writeUint16(0);
+    }
+    Uint16 flags = 0;
+    flags |= _attackPressed  ? ATTACK_PRESSED  : 0;
+    flags |= _attackDown     ? ATTACK_DOWN     : 0;
+    flags |= _attackReleased ? ATTACK_RELEASED : 0;
+    flags |= _dodgePressed   ? DODGE_PRESSED   : 0;
+    flags |= _parryPressed   ? PARRY_PRESSED   : 0;
+    flags |= _parryDown      ? PARRY_DOWN      : 0;
+    flags |= _parryReleased  ? PARRY_RELEASED  : 0;
+    flags |= _swapPressed    ? SWAP_PRESSED    : 0;
+    _recorder.writeUint16(flags);
+    _recorder.writeFloat(_moveDir.x);
+    _recorder.writeFloat(_moveDir.y);
+    _recorder.writeFloat(_keyAttackDir.x);
+    _recorder.writeFloat(_keyAttackDir.y);
+    _recorder.writeFloat(dt);
+    _stepsPending = true;
+    _frames++;
+}
+
+void InputController::readFrame() {
+    if (_frames == 0){
+        stopReplay();
+        return;
+    }
+    _frames--;
+    Uint16 flags = _replayer.readUint16();
+    _attackPressed  = flags & ATTACK_PRESSED;
+    _attackDown     = flags & ATTACK_DOWN;
+    _attackReleased = flags & ATTACK_RELEASED;
+    _dodgePressed   = flags & DODGE_PRESSED;
+    _parryPressed   = flags & PARRY_PRESSED;
+    _parryDown      = flags & PARRY_DOWN;
+    _parryReleased  = flags & PARRY_RELEASED;
+    _swapPressed    = flags & SWAP_PRESSED;
+    _resetPressed   = false;
+    _moveDir.x = _replayer.readFloat();
+    _moveDir.y = _replayer.readFloat();
+    _keyAttackDir.x = _replayer.readFloat();
+    _keyAttackDir.y = _replayer.readFloat();
+    _replayDelta = _replayer.readFloat();
+    _replaySteps = _replayer.readUint16();
+}
+
 #pragma mark -
 #pragma mark Results
 
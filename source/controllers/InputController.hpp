@@ -10,6 +10,8 @@
 #ifndef __INPUT_CONTROLLER_H__
 #define __INPUT_CONTROLLER_H__
 #include <cugl/cugl.h>
+#include <cugl/physics2/net/CULWSerializer.h>
+#include <cugl/physics2/net/CULWDeserializer.h>
 
 using namespace cugl;
 
@@ -73,11 +75,44 @@ private:
         TapData tap;
     };
     
+    /**
+     * The source of the gameplay inputs.
+     */
+    enum class Mode {
+        /** inputs come from the devices */
+        LIVE,
+        /** inputs come from the devices and are written to the recording */
+        RECORDING,
+        /** inputs come from a recording */
+        REPLAYING
+    };
+    
     /**
      * initialize gesture data based on event timestamp, position, id, etc.
      */
     void initGestureDataFromEvent(GestureData& data, const TouchEvent& event);
     
+    /**
+     * Polls the devices and updates the abstraction layer.
+     *
+     * @param dt    the time since the last update
+     */
+    void poll(float dt);
+    
+    /**
+     * Writes the gameplay inputs of this frame to the recording.
+     *
+     * @param dt    the time since the last update
+     */
+    void writeFrame(float dt);
+    
+    /**
+     * Replaces the gameplay inputs of this frame with the next recorded frame.
+     *
+     * The replay stops when there are no more frames.
+     */
+    void readFrame();
+    
 #pragma mark -
 #pragma mark Touch Callbacks
     /**
@@ -165,6 +200,27 @@ private:
     bool inverted;
     /** the minimum pixel distance threshold for drags*/
     float _dragRadius = 50.0f;
+    
+    // RECORDING SUPPORT
+    
+    /** Whether the record key was pressed */
+    bool _keyRecord;
+    /** Whether the replay key was pressed */
+    bool _keyReplay;
+    /** the source of the gameplay inputs */
+    Mode _mode;
+    /** the recorded frames (the first Uint32 is the frame count) */
+    physics2::net::LWSerializer _recorder;
+    /** the frames being replayed */
+    physics2::net::LWDeserializer _replayer;
+    /** the number of recorded frames, or the number of frames left to replay */
+    Uint32 _frames;
+    /** whether the fixed steps of the last recorded frame are still to be written */
+    bool _stepsPending;
+    /** the time step of the current replayed frame */
+    float _replayDelta;
+    /** the number of fixed steps of the current replayed frame */
+    Uint32 _replaySteps;
 
 protected:
     
@@ -193,6 +249,10 @@ protected:
     bool _parryReleased;
     /** Whether the weapon swap action was chosen */
     bool _swapPressed;
+    /** Whether the record toggle was chosen */
+    bool _recordPressed;
+    /** Whether the replay toggle was chosen */
+    bool _replayPressed;
     /** unit direction of the attack*/
     Vec2 _attackDir;
     /** unit vector direction of movement */
@@ -260,6 +320,10 @@ public:
      * This method also gathers the delta difference in the touches. Depending on
      * the OS, we may see multiple updates of the same touch in a single animation
      * frame, so we need to accumulate all of the data together.
+     *
+     * When recording, the gameplay inputs are appended to the recording. When
+     * replaying, they are replaced by the next recorded frame (the debug, exit,
+     * record and replay toggles are still read from the devices).
      */
     void update(float dt);
 
@@ -290,6 +354,78 @@ public:
      */
     void setMinDragRadius(float r){ _dragRadius = r; }
     
+#pragma mark -
+#pragma mark Recording and Replay
+    
+    /**
+     * Starts recording the gameplay inputs of every frame.
+     *
+     * Each call to {@link #update} records one frame, and each call to
+     * {@link #endFrame} records the number of fixed steps of that frame.
+     * Any previous recording is discarded.
+     */
+    void startRecording();
+    
+    /**
+     * Stops recording and returns the recorded frames.
+     *
+     * @return the recorded frames, to be passed to {@link #startReplay}
+     */
+    std::vector<std::byte> stopRecording();
+    
+    /**
+     * Starts replaying the given recording.
+     *
+     * Any recording in progress is discarded. The replay stops by itself after
+     * the last recorded frame.
+     *
+     * @param frames    the frames returned by {@link #stopRecording}
+     *
+     * @return true if the recording has any frames
+     */
+    bool startReplay(const std::vector<std::byte>& frames);
+    
+    /**
+     * Stops the replay and clears the replayed inputs.
+     */
+    void stopReplay();
+    
+    /**
+     * @return whether the gameplay inputs are being recorded
+     */
+    bool isRecording() const { return _mode == Mode::RECORDING; }
+    
+    /**
+     * @return whether the gameplay inputs come from a recording
+     */
+    bool isReplaying() const { return _mode == Mode::REPLAYING; }
+    
+    /**
+     * Records the number of fixed steps taken since the last update.
+     *
+     * The fixed steps per frame depend on the wall clock, so they must be
+     * recorded for the replay to take the same steps. This does nothing when
+     * not recording.
+     *
+     * @param steps the number of fixed steps of this frame
+     */
+    void endFrame(Uint32 steps);
+    
+    /**
+     * @return the number of recorded frames, or the number of frames left to replay
+     */
+    Uint32 getFrameCount() const { return _frames; }
+    
+    /**
+     * @return the recorded time step of the current replayed frame
+     */
+    float getReplayDelta() const { return _replayDelta; }
+    
+    /**
+     * @return the recorded number of fixed steps of the current replayed frame
+     */
+    Uint32 getReplaySteps() const { return _replaySteps; }
+    
 #pragma mark -
 #pragma mark Input Results
     
@@ -375,6 +511,20 @@ public:
      */
     bool didSwap() const { return _swapPressed; }
     
+    /**
+     * Returns true if the record toggle was pressed.
+     *
+     * @return true if the record toggle was pressed.
+     */
+    bool didRecord() const { return _recordPressed; }
+    
+    /**
+     * Returns true if the replay toggle was pressed.
+     *
+     * @return true if the replay toggle was pressed.
+     */
+    bool didReplay() const { return _replayPressed; }
+    
 #pragma mark -
 #pragma mark Input Results (Mobile Only)
     
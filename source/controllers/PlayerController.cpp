@@ -0,0 +1,136 @@
+#include "PlayerController.hpp"
+#include "AudioController.hpp"
+#include "../models/LevelModel.hpp"
+#include "../models/Player.hpp"
+#include "../models/Projectile.hpp"
+#include "../models/GameConstants.hpp"
+
+void PlayerController::update(InputController& input, const std::shared_ptr<LevelModel>& level){
+    std::shared_ptr<Player> player = level->getPlayer();
+    Vec2 moveForce = input.getMoveDirection();
+    
+    if (player->isDodging() && player->getCollider()->isBullet()){
+        player->getCollider()->setBullet(false);
+    }
+    
+    // set player direction
+    if (moveForce.length() > 0 && !player->isDodging() && !player->isAttacking()){
+        player->setFacingDir(moveForce);
+    }
+
+    // Priority order: Dodge, Attack/Shoot, Parry
+    // Only read inputs when player is idle, preparing a shot or waiting to parry
+    if (player->isIdle() || player->isRangedAttackActive() || player->isBlocking()) {
+        if (input.didDodge() && player->canDodge()) {
+            // player->dodgeCD.reset(); // reset cooldown
+            //dodge
+            auto force = input.getDodgeDirection(player->getFacingDir());
+            if (force.length() == 0) force = player->getFacingDir().getNormalization();
+            Vec2 velocity = force * GameConstants::PLAYER_DODGE_SPEED;
+            player->getCollider()->setLinearVelocity(velocity);
+            player->getCollider()->setBullet(true);
+            player->setFacingDir(force);
+            player->setDodging();
+            player->reduceStamina();
+            AudioController::play(AudioController::PLAYER_DASH);
+        }
+        else if (!player->isRecovering()){
+            //for now, give middle precedence to attack
+            if (input.didAttack()) {
+                Vec2 direction = Vec2::ZERO;
+                float ang = 0;
+                switch(player->getWeapon()){
+                case Player::Weapon::MELEE:
+                        if (player->canMeleeAttack()){
+                            direction = input.getAttackDirection(player->getFacingDir());
+                            ang = acos(direction.dot(Vec2::UNIT_X));
+                            if (direction.y < 0) {
+                                // handle downwards case, rotate counterclockwise by PI rads and add extra angle
+                                ang = M_PI + acos(direction.rotate(M_PI).dot(Vec2::UNIT_X));
+                            }
+                            player->enableMeleeAttack(ang);
+                            player->animateAttack();
+                            player->resetAttackCooldown();
+                            !player->isComboStrike() ? AudioController::play(AudioController::PLAYER_ATTACK) : AudioController::play(AudioController::PLAYER_ATTACK_POWER);
+                        }
+                        break;
+                case Player::Weapon::RANGED:
+                        AudioController::play(AudioController::PLAYER_LOOP_BOW);
+                        player->animateCharge();
+                        player->getCollider()->setLinearVelocity(Vec2::ZERO);
+                        break;
+                }
+            }
+            else if (input.didCharge()) {
+                Vec2 direction = input.getAttackDirection(player->getFacingDir());
+                if (player->getWeapon() == Player::Weapon::RANGED && player->isRangedAttackActive()) {
+                    // this lets you rotate the player while holding the bow in charge mode
+                    player->setFacingDir(direction);
+                }
+            }
+            else if (input.didShoot() && player->getWeapon() == Player::Weapon::RANGED) {
+                AudioController::clear(AudioController::PLAYER_LOOP_BOW);
+                AudioController::play(AudioController::PLAYER_SHOOT_BOW);
+                Vec2 direction = Vec2::ZERO;
+                float ang = 0;
+                if (player->isRangedAttackActive()) {
+                    //ranged attack
+                    direction = input.getAttackDirection(player->getFacingDir());
+                    ang = acos(direction.dot(Vec2::UNIT_X));
+                    if (direction.y < 0) {
+                        // handle downwards case, rotate counterclockwise by PI rads and add extra angle
+                        ang = M_PI + acos(direction.rotate(M_PI).dot(Vec2::UNIT_X));
+                    }
+                    std::shared_ptr<Projectile> p = Projectile::playerAlloc(player->getPosition().add(0, 64 / player->getDrawScale().y), player->getBowDamage(), player->isCharged(), ang, _assets);
+                    p->setDrawScale(player->getDrawScale());
+                    level->addProjectile(p);
+                    player->animateShot();
+                }
+                else player->animateDefault();
+
+            }
+            //give lowest precendence to parry. only allow it with the melee weapon
+            else if (input.didParry() && player->getWeapon() == Player::Weapon::MELEE) {
+                player->animateParryStart();
+            }
+            else if (input.didParryRelease() && player->getWeapon() == Player::Weapon::MELEE) {
+                if (player->isBlocking()) {
+                    //CULog("parried");
+                    player->animateParry();
+                }
+                else player->animateDefault();
+            }
+        }
+    }
+    
+    // the duration of the knockback applied onto the player is part of the iframe counter.
+    // only allow the player to change their velocity after the knockback frames
+    if (player->getIframes() < GameConstants::PLAYER_IFRAME - GameConstants::PLAYER_INCOMING_KB_FRAMES){
+        //stay still while parrying or blocking or recovering
+        if (player->isParrying() || player->isBlocking() || player->isRecovering()){
+            player->getCollider()->setLinearVelocity(Vec2::ZERO);
+        }
+        else if (!player->isDodging()){
+            switch (player->getWeapon()) {
+                case Player::Weapon::MELEE:
+                    if (player->isAttacking()) player->getCollider()->setLinearVelocity(moveForce * GameConstants::PLAYER_ATK_MOVE_SPEED);
+                    else player->getCollider()->setLinearVelocity(moveForce * GameConstants::PLAYER_MOVE_SPEED);
+                    break;
+                case Player::Weapon::RANGED:
+                    //with the ranged weapon, dont move while attacking
+                    if (player->isAttacking()) player->getCollider()->setLinearVelocity(Vec2::ZERO);
+                    else player->getCollider()->setLinearVelocity(moveForce * GameConstants::PLAYER_MOVE_SPEED);
+                    break;
+            }
+        }
+    }
+    
+    // TODO: could remove, this is PC-only
+    if (input.didSwap()){
+        if (player->isIdle() || player->isDodging()){
+            //other states are weapon-dependent, so don't allow swapping while in them
+            player->swapWeapon();
+            input.swapControlMode(); // must do for mobile controls
+        }
+    }
+}
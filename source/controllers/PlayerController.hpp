@@ -0,0 +1,48 @@
+//
+//  PlayerController.hpp
+//
+//  This controller turns the (live or replayed) input of a frame into player actions:
+//  dodging, attacking, shooting, parrying, moving and swapping weapons. It is shared by
+//  the GameScene and the headless runner, so that a recorded session plays out the
+//  same way in both.
+//
+//  Version: 10/18/26
+//
+
+#ifndef __PLAYER_CONTROLLER_HPP__
+#define __PLAYER_CONTROLLER_HPP__
+#include <cugl/cugl.h>
+#include "InputController.hpp"
+
+using namespace cugl;
+
+class LevelModel;
+
+/**
+ * The motivation to separate this out of GameScene is to let the player's
+ * response to input run without the renderer and scene graph.
+ */
+class PlayerController {
+
+private:
+
+    /** reference to assets directory */
+    std::shared_ptr<AssetManager> _assets;
+
+public:
+
+    /**
+     * loads the necessary assets for the controller
+     */
+    void setAssets(const std::shared_ptr<AssetManager>& assets) { _assets = assets; }
+
+    /**
+     * Applies the input of this frame to the player of the given level.
+     *
+     * @param input the input of this frame
+     * @param level the level containing the player
+     */
+    void update(InputController& input, const std::shared_ptr<LevelModel>& level);
+};
+
+#endif /* __PLAYER_CONTROLLER_HPP__ */
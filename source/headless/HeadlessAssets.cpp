@@ -0,0 +1,152 @@
+//
+//  HeadlessAssets.cpp
+//  RS
+//
+//  Version: 10/18/26
+//
+
+#include "HeadlessAssets.hpp"
+
+#pragma mark -
+#pragma mark Stub Loaders
+
+/**
+ * A json loader reading files relative to a fixed root.
+ *
+ * The standard loader reads relative to the application asset directory,
+ * which does not exist without an Application.
+ */
+class RootJsonLoader : public Loader<JsonValue> {
+protected:
+    /** The asset root */
+    std::string _root;
+
+    bool read(const std::string key, const std::string source,
+              LoaderCallback callback, bool async) override {
+        if (_assets.find(key) != _assets.end()) {
+            return false;
+        }
+        std::shared_ptr<JsonReader> reader = JsonReader::alloc(_root+source);
+        std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+        if (json != nullptr) {
+            _assets[key] = json;
+        } else {
+            CULogError("Could not read json '%s'", source.c_str());
+        }
+        if (callback != nullptr) {
+            callback(key, json != nullptr);
+        }
+        return json != nullptr;
+    }
+
+    bool read(const std::shared_ptr<JsonValue>& json,
+              LoaderCallback callback, bool async) override {
+        return read(json->key(), json->asString(""), callback, async);
+    }
+
+public:
+    RootJsonLoader(const std::string root) : _root(root) { _jsonKey = "jsons"; _priority = 0; }
+};
+
+/**
+ * A texture loader creating empty textures.
+ *
+ * The textures have no GPU storage and a size of zero, which is enough for
+ * the sprite sheets and animations of the game objects.
+ */
+class StubTextureLoader : public Loader<Texture> {
+protected:
+    bool read(const std::string key, const std::string source,
+              LoaderCallback callback, bool async) override {
+        if (_assets.find(key) == _assets.end()) {
+            _assets[key] = std::make_shared<Texture>();
+        }
+        if (callback != nullptr) {
+            callback(key, true);
+        }
+        return true;
+    }
+
+    bool read(const std::shared_ptr<JsonValue>& json,
+              LoaderCallback callback, bool async) override {
+        return read(json->key(), "", callback, async);
+    }
+
+public:
+    StubTextureLoader() { _jsonKey = "textures"; _priority = 0; }
+};
+
+#pragma mark -
+#pragma mark Assets
+
+std::string HeadlessAssets::normalize(const std::string root) {
+    std::string result = root;
+    if (!result.empty() && result.back() != '/' && result.back() != '\\') {
+        result.push_back('/');
+    }
+    return result;
+}
+
+std::shared_ptr<AssetManager> HeadlessAssets::alloc(const std::string root) {
+    std::string base = normalize(root);
+    std::shared_ptr<AssetManager> assets = AssetManager::alloc();
+    if (assets == nullptr) {
+        return nullptr;
+    }
+    assets->attach<JsonValue>(std::make_shared<RootJsonLoader>(base)->getHook());
+    assets->attach<Texture>(std::make_shared<StubTextureLoader>()->getHook());
+
+    // the same directories as App::onStartup, minus the scene graphs
+    bool success = loadDirectory(assets, base, "json/assets.json");
+    success = loadDirectory(assets, base, "json/scenes/textures.json") && success;
+    success = loadDirectory(assets, base, "json/assets-tileset.json") && success;
+    if (!success || assets->get<JsonValue>("constants") == nullptr) {
+        CULogError("Could not load the assets in '%s'", base.c_str());
+        assets->dispose();
+        return nullptr;
+    }
+    return assets;
+}
+
+bool HeadlessAssets::loadDirectory(const std::shared_ptr<AssetManager>& assets,
+                                   const std::string root, const std::string file) {
+    std::shared_ptr<JsonReader> reader = JsonReader::alloc(root+file);
+    std::shared_ptr<JsonValue> json = (reader == nullptr ? nullptr : reader->readJson());
+    if (json == nullptr) {
+        CULogError("Could not read asset directory '%s'", file.c_str());
+        return false;
+    }
+    // only keep the categories with a (stub) loader
+    std::shared_ptr<JsonValue> directory = JsonValue::allocObject();
+    for (const char* category : {"jsons", "textures"}) {
+        std::shared_ptr<JsonValue> child = json->get(category);
+        if (child != nullptr) {
+            json->removeChild(category);
+            directory->appendChild(category, child);
+        }
+    }
+    return directory->size() == 0 || assets->loadDirectory(directory);
+}
+
+std::vector<std::string> HeadlessAssets::getLevelKeys(const std::shared_ptr<AssetManager>& assets,
+                                                      const std::string root) {
+    std::vector<std::string> result;
+    std::shared_ptr<JsonValue> jsons = nullptr;
+    std::shared_ptr<JsonReader> reader = JsonReader::alloc(normalize(root)+"json/assets.json");
+    if (reader != nullptr) {
+        std::shared_ptr<JsonValue> json = reader->readJson();
+        jsons = json == nullptr ? nullptr : json->get("jsons");
+    }
+    if (jsons == nullptr || assets == nullptr) {
+        return result;
+    }
+    // Tiled maps have layers; Tiled tilesets do not
+    for (int ii = 0; ii < jsons->size(); ii++) {
+        std::string key = jsons->get(ii)->key();
+        std::shared_ptr<JsonValue> json = assets->get<JsonValue>(key);
+        if (json != nullptr && json->has("tiledversion") && json->has("layers")) {
+            result.push_back(key);
+        }
+    }
+    return result;
+}
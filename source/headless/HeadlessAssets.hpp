@@ -0,0 +1,75 @@
+//
+//  HeadlessAssets.hpp
+//  RS
+//
+//  The assets of the console tools (the headless runner and the benchmarks). These
+//  tools have no Application, window or GPU, so the asset manager only reads the json
+//  assets, relative to an explicit root, and textures are empty stubs.
+//
+//  Version: 10/18/26
+//
+
+#ifndef __HEADLESS_ASSETS_HPP__
+#define __HEADLESS_ASSETS_HPP__
+
+#include <cugl/cugl.h>
+#include <string>
+#include <vector>
+
+using namespace cugl;
+
+/**
+ a static class creating the asset manager of the console tools
+ */
+class HeadlessAssets {
+private:
+    /** prevents allocation of this class */
+    HeadlessAssets(){}
+
+    /**
+     * Loads the json and texture categories of the given asset directory.
+     *
+     * @param assets    the asset manager
+     * @param root      the asset root (ending with a separator)
+     * @param file      the asset directory file, relative to the asset root
+     *
+     * @return true if the directory was loaded
+     */
+    static bool loadDirectory(const std::shared_ptr<AssetManager>& assets,
+                              const std::string root, const std::string file);
+
+public:
+    /**
+     * Returns the given asset root with a trailing separator.
+     *
+     * @param root  the asset root
+     *
+     * @return the given asset root with a trailing separator.
+     */
+    static std::string normalize(const std::string root);
+
+    /**
+     * Returns an asset manager with the json and (stub) texture assets of the game.
+     *
+     * The root is the directory containing json/assets.json (the install
+     * directory of the cmake build).
+     *
+     * @param root  the asset root
+     *
+     * @return an asset manager with the game assets (or nullptr on failure)
+     */
+    static std::shared_ptr<AssetManager> alloc(const std::string root);
+
+    /**
+     * Returns the keys of every Tiled map in assets.json, in level order.
+     *
+     * @param assets    the asset manager returned by {@link #alloc}
+     * @param root      the asset root
+     *
+     * @return the keys of every Tiled map in assets.json, in level order.
+     */
+    static std::vector<std::string> getLevelKeys(const std::shared_ptr<AssetManager>& assets,
+                                                 const std::string root);
+};
+
+#endif /* __HEADLESS_ASSETS_HPP__ */
@@ -0,0 +1,421 @@
+//
+//  HeadlessRunner.cpp
+//  RS
+//
+//  Version: 10/18/26
+//
+
+#include "HeadlessRunner.hpp"
+#include "HeadlessAssets.hpp"
+#include "../models/LevelModel.hpp"
+#include "../models/Player.hpp"
+#include "../models/Enemy.hpp"
+#include "../models/GameConstants.hpp"
+#include "../utility/GameRandom.hpp"
+#include "../utility/AllocationTracker.hpp"
+#include "../utility/FrameArena.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#pragma mark -
+#pragma mark Results
+
+/** The frames at the start of a run that may allocate (caches and pools filling up) */
+#define ALLOC_WARMUP_FRAMES 60
+
+/** Converts a duration between steady clock points to milliseconds */
+static double millis(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end-start).count();
+}
+
+/** The names of the phases, in order */
+static const char* PHASE_NAMES[HeadlessRunner::Phase::COUNT] = {
+    "input", "ai", "gameplay", "physics", "collision", "sync"
+};
+
+std::string HeadlessRunner::Result::getHeader() {
+    std::stringstream ss;
+    ss << "level    frames enemies alive bodies  load_ms  mean_ms    p50    p99    max";
+    for (int ii = 0; ii < COUNT; ii++) {
+        ss << " " << std::string(9-std::min<size_t>(9, strlen(PHASE_NAMES[ii])), ' ') << PHASE_NAMES[ii];
+    }
+    ss << " allocs/f  bytes/f alloc_fr spawn_fr";
+    return ss.str();
+}
+
+std::string HeadlessRunner::Result::toString() const {
+    char buffer[256];
+    std::stringstream ss;
+    snprintf(buffer, sizeof(buffer), "%-8s %6d %7d %5d %6d %8.2f %8.4f %6.3f %6.3f %6.3f",
+             level.c_str(), frames, enemies, survivors, bodies, loadMs, meanMs, medianMs, p99Ms, maxMs);
+    ss << buffer;
+    for (int ii = 0; ii < COUNT; ii++) {
+        snprintf(buffer, sizeof(buffer), " %9.4f", phaseMs[ii]);
+        ss << buffer;
+    }
+    snprintf(buffer, sizeof(buffer), " %8.1f %8.0f %8d %8d", allocsPerFrame, bytesPerFrame, allocFrames, spawnFrames);
+    ss << buffer;
+    return ss.str();
+}
+
+std::shared_ptr<JsonValue> HeadlessRunner::Result::toJson() const {
+    std::shared_ptr<JsonValue> json = JsonValue::allocObject();
+    json->appendValue("level", level);
+    json->appendValue("frames", (long)frames);
+    json->appendValue("enemies", (long)enemies);
+    json->appendValue("survivors", (long)survivors);
+    json->appendValue("bodies", (long)bodies);
+    json->appendValue("load_ms", loadMs);
+    json->appendValue("mean_ms", meanMs);
+    json->appendValue("median_ms", medianMs);
+    json->appendValue("p99_ms", p99Ms);
+    json->appendValue("max_ms", maxMs);
+    std::shared_ptr<JsonValue> phases = JsonValue::allocObject();
+    for (int ii = 0; ii < COUNT; ii++) {
+        phases->appendValue(PHASE_NAMES[ii], phaseMs[ii]);
+    }
+    json->appendChild("phase_ms", phases);
+    json->appendValue("allocs_per_frame", allocsPerFrame);
+    json->appendValue("bytes_per_frame", bytesPerFrame);
+    json->appendValue("alloc_frames", (long)allocFrames);
+    json->appendValue("spawn_frames", (long)spawnFrames);
+    json->appendValue("max_frame_allocs", (long)maxFrameAllocs);
+    return json;
+}
+
+#pragma mark -
+#pragma mark Constructors
+
+void HeadlessRunner::dispose() {
+    _level = nullptr;
+    if (_assets != nullptr) {
+        _assets->dispose();
+        _assets = nullptr;
+    }
+}
+
+bool HeadlessRunner::init(const std::string root) {
+    _root = HeadlessAssets::normalize(root);
+    _assets = HeadlessAssets::alloc(_root);
+    if (_assets == nullptr) {
+        return false;
+    }
+    _parser.loadTilesets(_assets);
+    return true;
+}
+
+std::vector<std::string> HeadlessRunner::getLevelKeys() const {
+    return HeadlessAssets::getLevelKeys(_assets, _root);
+}
+
+#pragma mark -
+#pragma mark Simulation
+
+bool HeadlessRunner::loadLevel(const std::string key, const SaveData::Data* start) {
+    std::shared_ptr<JsonValue> map = _assets->get<JsonValue>(key);
+    if (map == nullptr) {
+        CULogError("No level '%s' in assets.json", key.c_str());
+        return false;
+    }
+    _level = LevelModel::alloc(_assets->get<JsonValue>("constants"), _parser.parseTiled(map));
+    if (_level == nullptr) {
+        return false;
+    }
+    _level->setAssets(_assets);
+    // the draw scale of the default 1024x576 window, as in GameScene::setLevel
+    float scale = 1024/_level->getViewBounds().width;
+    _level->setDrawScale(Vec2(scale, scale));
+
+    _AIController.init(_level);
+    _collisionController.setLevel(_level);
+    _collisionController.setAssets(_assets);
+    _playerController.setAssets(_assets);
+    _gameplayController.setAssets(_assets);
+    _gameplayController.reset();
+    _cleared = false;
+    
+    // the player stats, as in GameScene::setLevel
+    if (start != nullptr) {
+        auto p = _level->getPlayer();
+        p->setMaxHPLevel(start->hpLvl);
+        p->setMeleeLevel(start->atkLvl);
+        p->setMeleeSpeedLevel(start->atkSpLvl);
+        p->setBowLevel(start->rangedLvl);
+        p->setBlockLevel(start->defLvl);
+        p->setArmorLevel(start->defLvl);
+        p->setStunLevel(start->parryLvl);
+        p->setDodgeLevel(start->dashLvl);
+        p->setHP(start->hp);
+        p->setWeapon(static_cast<Player::Weapon>(start->weapon));
+    }
+
+    // wrap the collision callbacks so that their time can be separated from the step
+    auto world = _level->getWorld();
+    auto begin = world->onBeginContact;
+    auto end = world->onEndContact;
+    auto solve = world->beforeSolve;
+    world->onBeginContact = [this, begin](b2Contact* contact) {
+        auto start = std::chrono::steady_clock::now();
+        begin(contact);
+        _collisionNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count();
+    };
+    world->onEndContact = [this, end](b2Contact* contact) {
+        auto start = std::chrono::steady_clock::now();
+        end(contact);
+        _collisionNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count();
+    };
+    world->beforeSolve = [this, solve](b2Contact* contact, const b2Manifold* oldManifold) {
+        auto start = std::chrono::steady_clock::now();
+        solve(contact, oldManifold);
+        _collisionNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count();
+    };
+    return true;
+}
+
+void HeadlessRunner::processScriptedInput() {
+    auto player = _level->getPlayer();
+    std::shared_ptr<Enemy> target = nullptr;
+    float best = INFINITY;
+    for (auto& enemy : _level->getEnemies()) {
+        if (enemy->isEnabled() && enemy->getHealth() > 0) {
+            float dist = enemy->getPosition().distanceSquared(player->getPosition());
+            if (dist < best) {
+                best = dist;
+                target = enemy;
+            }
+        }
+    }
+
+    Vec2 move = Vec2::ZERO;
+    if (target != nullptr) {
+        move = (target->getPosition()-player->getPosition()).getNormalization();
+        if (std::sqrt(best) <= GameConstants::PLAYER_MELEE_ATK_RANGE && player->canMeleeAttack() &&
+            (player->isIdle() || player->isAttacking())) {
+            float ang = atan2(move.y, move.x);
+            if (ang < 0) {
+                ang += 2*M_PI;
+            }
+            player->enableMeleeAttack(ang);
+            player->animateAttack();
+            player->resetAttackCooldown();
+        }
+    }
+    if (move.length() > 0 && !player->isAttacking()) {
+        player->setFacingDir(move);
+    }
+    float speed = player->isAttacking() ? GameConstants::PLAYER_ATK_MOVE_SPEED : GameConstants::PLAYER_MOVE_SPEED;
+    player->getCollider()->setLinearVelocity(move*speed);
+}
+
+HeadlessRunner::Result HeadlessRunner::run(const std::string key, int frames, float step, Uint64 seed) {
+    GameRandom::seed(seed);
+    return simulate(key, frames, step, nullptr);
+}
+
+HeadlessRunner::Result HeadlessRunner::replay(const Replay& replay) {
+    GameRandom::seed(replay.seed);
+    if (!_input.startReplay(replay.input)) {
+        Result result;
+        result.level = replay.getLevelKey();
+        return result;
+    }
+    Result result = simulate(replay.getLevelKey(), (int)_input.getFrameCount(), replay.step, &replay.start);
+    if (result.frames > 0 && !replay.end.empty()) {
+        result.mismatch = Replay::compareState(replay.end, result.state);
+    }
+    return result;
+}
+
+std::vector<double> HeadlessRunner::getFrameState() const {
+    std::vector<double> state;
+    state.push_back(GameRandom::peek(GameRandom::COMBAT));
+    const auto& enemies = _level->getEnemies();
+    for (size_t ii = 0; ii < enemies.size(); ii++) {
+        state.push_back(enemies[ii]->getPosition().x);
+        state.push_back(enemies[ii]->getPosition().y);
+        state.push_back((double)enemies[ii]->getBehaviorState());
+        state.push_back(_AIController.peekRandom(ii));
+    }
+    return state;
+}
+
+std::string HeadlessRunner::checkDeterminism(const std::string key, int frames, float step, Uint64 seed, int threads) {
+    std::vector<std::vector<double>> serial, parallel;
+    serial.reserve(frames);
+    parallel.reserve(frames);
+    _AIController.setWorkerThreads(0);
+    _trace = &serial;
+    Result first = run(key, frames, step, seed);
+    _AIController.setWorkerThreads(threads);
+    _trace = &parallel;
+    Result second = run(key, frames, step, seed);
+    _trace = nullptr;
+    _AIController.setWorkerThreads(GameConstants::AI_WORKER_THREADS);
+    if (first.frames == 0 || second.frames == 0) {
+        return "could not simulate " + key;
+    }
+
+    static const char* FIELDS[] = {"x", "y", "state", "ai random"};
+    for (size_t frame = 0; frame < serial.size() && frame < parallel.size(); frame++) {
+        const std::vector<double>& a = serial[frame];
+        const std::vector<double>& b = parallel[frame];
+        for (size_t ii = 0; ii < a.size() && ii < b.size(); ii++) {
+            if (a[ii] != b[ii]) {
+                std::string field = ii == 0 ? "combat random" : "enemy " + std::to_string((ii-1)/4) + " " + FIELDS[(ii-1) % 4];
+                char buffer[256];
+                snprintf(buffer, sizeof(buffer), "frame %zu: %s is %.9g serially, %.9g with %d threads",
+                         frame, field.c_str(), a[ii], b[ii], threads);
+                return buffer;
+            }
+        }
+    }
+    if (serial.size() != parallel.size()) {
+        return "the runs have " + std::to_string(serial.size()) + " and " + std::to_string(parallel.size()) + " frames";
+    }
+    return "";
+}
+
+HeadlessRunner::Result HeadlessRunner::simulate(const std::string key, int frames, float step, const SaveData::Data* save) {
+    Result result;
+    result.level = key;
+    bool replaying = _input.isReplaying();
+
+    auto start = std::chrono::steady_clock::now();
+    if (!loadLevel(key, save)) {
+        return result;
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.loadMs = millis(start, end);
+    result.enemies = (int)_level->getEnemies().size();
+    result.bodies = _level->getWorld()->getWorld()->GetBodyCount();
+
+    std::vector<double> times;
+    times.reserve(frames);
+    double phases[COUNT] = {0};
+    Size view = _level->getViewBounds();
+    Uint64 allocs = 0;
+    Uint64 bytes = 0;
+    // the loading is not part of the first frame
+    AllocationTracker::endFrame();
+    for (int frame = 0; frame < frames; frame++) {
+        // as at the top of GameScene::preUpdate
+        FrameArena::reset();
+        // a new projectile or health pack allocates its object and obstacle by design
+        size_t objects = _level->getProjectiles().size()+_level->getHealthPacks().size();
+        auto t0 = std::chrono::steady_clock::now();
+        int steps = 1;
+        float dt = step;
+        if (replaying) {
+            _input.update(0);
+            if (!_input.isReplaying()) {
+                frames = frame;
+                break;
+            }
+            steps = (int)_input.getReplaySteps();
+            dt = _input.getReplayDelta();
+        }
+
+        // the order of GameScene::preUpdate: clear the room, then pause or take the input
+        auto player = _level->getPlayer();
+        bool alive = player->getHP() > 0;
+        if (!_cleared && alive) {
+            bool fought = false;
+            _cleared = _gameplayController.clearRoom(_level, fought);
+        }
+        bool paused = _gameplayController.updateHitPause(_collisionController.isComboContact());
+        if (!paused) {
+            if (!alive) {
+                player->getCollider()->setLinearVelocity(Vec2::ZERO);
+            } else if (replaying) {
+                _playerController.update(_input, _level);
+            } else {
+                processScriptedInput();
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        // the camera follows the player exactly
+        if (!paused) {
+            Vec2 center = player->getPosition();
+            _AIController.setViewBounds(Rect(center-view/2, view));
+            _AIController.update(dt);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        if (!paused) {
+            _gameplayController.update(_level, dt);
+        }
+        auto t3 = std::chrono::steady_clock::now();
+
+        // a replayed frame takes the recorded number of steps (possibly none)
+        _collisionNanos = 0;
+        double sync = 0;
+        for (int ii = 0; ii < steps; ii++) {
+            // as in GameScene::simulate, a dead player stops the world
+            if (player->getHP() == 0 || _gameplayController.isHitPaused()) {
+                break;
+            }
+            _level->getWorld()->update(step);
+            auto before = std::chrono::steady_clock::now();
+            _gameplayController.syncPositions(_level);
+            sync += millis(before, std::chrono::steady_clock::now());
+        }
+        auto t4 = std::chrono::steady_clock::now();
+
+        double collision = _collisionNanos/1000000.0;
+        phases[INPUT] += millis(t0, t1);
+        phases[AI] += millis(t1, t2);
+        phases[GAMEPLAY] += millis(t2, t3);
+        phases[PHYSICS] += millis(t3, t4)-collision-sync;
+        phases[COLLISION] += collision;
+        phases[SYNC] += sync;
+        times.push_back(millis(t0, t4));
+        if (_trace != nullptr) {
+            AllocationTracker::Ignore ignore;
+            _trace->push_back(getFrameState());
+        }
+
+        AllocationTracker::endFrame();
+        AllocationTracker::Counters counters = AllocationTracker::getLastFrame();
+        allocs += counters.allocs;
+        bytes += counters.bytes;
+        bool spawned = _level->getProjectiles().size()+_level->getHealthPacks().size() > objects;
+        if (frame >= ALLOC_WARMUP_FRAMES && counters.allocs > 0 && spawned) {
+            result.spawnFrames++;
+        } else if (frame >= ALLOC_WARMUP_FRAMES && counters.allocs > 0) {
+            result.allocFrames++;
+            if (counters.allocs > result.maxFrameAllocs) {
+                AllocationTracker::Ignore ignore;
+                result.maxFrameAllocs = counters.allocs;
+                result.maxFrameReport = "frame " + std::to_string(frame) + ": " + AllocationTracker::getFrameReport();
+            }
+        }
+    }
+    _input.stopReplay();
+
+    result.frames = frames;
+    result.state = Replay::getState(_level);
+    for (auto& enemy : _level->getEnemies()) {
+        result.survivors += enemy->getHealth() > 0 ? 1 : 0;
+    }
+    if (frames > 0) {
+        double total = 0;
+        for (double time : times) {
+            total += time;
+        }
+        result.meanMs = total/frames;
+        std::sort(times.begin(), times.end());
+        result.medianMs = times[frames/2];
+        result.p99Ms = times[std::min(frames-1, (int)(frames*0.99))];
+        result.maxMs = times.back();
+        for (int ii = 0; ii < COUNT; ii++) {
+            result.phaseMs[ii] = phases[ii]/frames;
+        }
+        result.allocsPerFrame = (double)allocs/frames;
+        result.bytesPerFrame = (double)bytes/frames;
+    }
+
+    _level = nullptr;
+    return result;
+}
@@ -0,0 +1,282 @@
+//
+//  HeadlessRunner.hpp
+//  RS
+//
+//  This class runs the gameplay simulation without a window, GPU or audio device,
+//  so that AI, collision and physics performance can be measured on build machines.
+//
+//  Levels are loaded through the same parser and level model as the game. The asset
+//  manager only reads the json assets; textures are empty stubs and sounds are skipped
+//  (see AudioController::isSilent). Each frame steps the AI, the enemy attacks and
+//  object updates (the GameplayController shared with GameScene), the physics world
+//  (which runs the collision callbacks) and the position sync at a fixed step, with a
+//  scripted player that walks towards the nearest enemy and attacks it.
+//
+//  A replay recorded in the game can drive the player instead. The room is started from
+//  the recorded save data and seed, and each frame uses the recorded input, time step
+//  and number of fixed steps. The run fails unless the player and the enemies end in
+//  the recorded state.
+//
+//  The determinism check runs a level twice with the same seed, once with serial AI
+//  decisions and once with AI worker threads, and compares the enemy positions, behavior
+//  states and random streams after every frame.
+//
+//  Heap allocations are counted per frame (see AllocationTracker). After a warm-up, a
+//  frame of the fight should not allocate at all, unless it spawns a projectile or a
+//  health pack, and --check-allocs fails the run when it does.
+//
+//  Version: 10/18/26
+//
+
+#ifndef __HEADLESS_RUNNER_HPP__
+#define __HEADLESS_RUNNER_HPP__
+
+#include <cugl/cugl.h>
+#include <string>
+#include <vector>
+#include "../controllers/AIController.hpp"
+#include "../controllers/CollisionController.hpp"
+#include "../controllers/InputController.hpp"
+#include "../controllers/PlayerController.hpp"
+#include "../controllers/GameplayController.hpp"
+#include "../utility/LevelParser.hpp"
+#include "../utility/Replay.hpp"
+
+using namespace cugl;
+
+class LevelModel;
+
+class HeadlessRunner {
+public:
+    /** The timed phases of a simulated frame */
+    enum Phase {
+        /** scripted or replayed player input */
+        INPUT = 0,
+        /** AIController::update */
+        AI,
+        /** GameplayController::update (enemy attacks and deaths, counters, animations) */
+        GAMEPLAY,
+        /** ObstacleWorld::update, excluding the collision callbacks */
+        PHYSICS,
+        /** the CollisionController callbacks invoked during the physics step */
+        COLLISION,
+        /** syncing the shadows, hitboxes and projectiles with the physics bodies */
+        SYNC,
+        /** the number of phases */
+        COUNT
+    };
+
+    /** The measurements of a single level run */
+    struct Result {
+        /** the level key in assets.json */
+        std::string level;
+        /** the number of simulated frames */
+        int frames = 0;
+        /** the number of enemies in the level */
+        int enemies = 0;
+        /** the number of enemies alive at the end of the run */
+        int survivors = 0;
+        /** the number of physics bodies after loading */
+        int bodies = 0;
+        /** the time to parse and build the level, in milliseconds */
+        double loadMs = 0;
+        /** the mean frame time in milliseconds */
+        double meanMs = 0;
+        /** the median frame time in milliseconds */
+        double medianMs = 0;
+        /** the 99th percentile frame time in milliseconds */
+        double p99Ms = 0;
+        /** the worst frame time in milliseconds */
+        double maxMs = 0;
+        /** the mean time per frame of each phase, in milliseconds */
+        double phaseMs[COUNT] = {0};
+        /** the mean number of heap allocations per frame */
+        double allocsPerFrame = 0;
+        /** the mean number of bytes allocated per frame */
+        double bytesPerFrame = 0;
+        /** the number of frames after the warm-up that allocated without spawning anything */
+        int allocFrames = 0;
+        /** the number of frames after the warm-up that allocated while spawning projectiles or health packs */
+        int spawnFrames = 0;
+        /** the most heap allocations in a single frame after the warm-up */
+        Uint64 maxFrameAllocs = 0;
+        /** the allocation report of that frame (empty if no frame allocated) */
+        std::string maxFrameReport;
+        /** the state of the player and the enemies at the end (see Replay::getState) */
+        std::vector<float> state;
+        /** how that state differs from the end of the recording (replays only, empty if it matches) */
+        std::string mismatch;
+
+        /**
+         * Returns the column names matching {@link #toString}.
+         *
+         * @return the column names matching {@link #toString}.
+         */
+        static std::string getHeader();
+
+        /**
+         * Returns the measurements as a single row of text.
+         *
+         * @return the measurements as a single row of text.
+         */
+        std::string toString() const;
+
+        /**
+         * Returns the measurements as a JSON object.
+         *
+         * @return the measurements as a JSON object.
+         */
+        std::shared_ptr<JsonValue> toJson() const;
+    };
+
+protected:
+    /** The json and (stub) texture assets */
+    std::shared_ptr<AssetManager> _assets;
+    /** The root of the asset directory */
+    std::string _root;
+    /** The parser shared by all levels */
+    LevelParser _parser;
+    /** The level being simulated */
+    std::shared_ptr<LevelModel> _level;
+    /** The controller moving the enemies */
+    AIController _AIController;
+    /** The controller resolving collisions */
+    CollisionController _collisionController;
+    /** The replayed input (never polls a device) */
+    InputController _input;
+    /** The controller applying the replayed input */
+    PlayerController _playerController;
+    /** The controller for the enemy attacks and object updates */
+    GameplayController _gameplayController;
+    /** The time spent in collision callbacks during the current step, in nanoseconds */
+    Uint64 _collisionNanos;
+    /** Whether every enemy of the level is defeated (and the energy walls are open) */
+    bool _cleared;
+    /** The state after each frame (see getFrameState), or nullptr if not recorded */
+    std::vector<std::vector<double>>* _trace;
+
+    /**
+     * Parses and builds the level for the given key.
+     *
+     * @param key   the level key in assets.json
+     * @param start the save data to apply to the player (or nullptr for none)
+     *
+     * @return true if the level was built
+     */
+    bool loadLevel(const std::string key, const SaveData::Data* start);
+
+    /**
+     * Applies the scripted player input for this frame.
+     *
+     * The player walks towards the nearest living enemy and attacks it when
+     * in melee range.
+     */
+    void processScriptedInput();
+    
+    /**
+     * Returns the state of the level that the AI threads must not change.
+     *
+     * The state is the next value of the combat stream, followed by the
+     * position, behavior state and next AI random value of each enemy.
+     *
+     * @return the state of the level that the AI threads must not change
+     */
+    std::vector<double> getFrameState() const;
+
+    /**
+     * Simulates the given level, which must be seeded.
+     *
+     * If replaying, the input controller must already be replaying and the
+     * simulation ends with the replay.
+     *
+     * @param key       the level key in assets.json
+     * @param frames    the number of frames to simulate (an upper bound when replaying)
+     * @param step      the fixed time step in seconds
+     * @param start     the save data to apply to the player (replays only)
+     *
+     * @return the measurements of the run (with no frames on failure)
+     */
+    Result simulate(const std::string key, int frames, float step, const SaveData::Data* start);
+
+public:
+    /**
+     * Creates a runner with no assets.
+     */
+    HeadlessRunner() : _collisionNanos(0), _cleared(false), _trace(nullptr) {}
+
+    /**
+     * Disposes of all resources in this runner.
+     */
+    ~HeadlessRunner() { dispose(); }
+
+    /**
+     * Disposes of all resources in this runner.
+     */
+    void dispose();
+
+    /**
+     * Initializes the runner with the given asset root.
+     *
+     * The root is the directory containing json/assets.json (the install
+     * directory of the cmake build).
+     *
+     * @param root  the asset root
+     *
+     * @return true if the assets were loaded
+     */
+    bool init(const std::string root);
+
+    /**
+     * Returns the keys of every Tiled map in assets.json, in level order.
+     *
+     * @return the keys of every Tiled map in assets.json, in level order.
+     */
+    std::vector<std::string> getLevelKeys() const;
+    
+    /**
+     * Simulates the given level as fast as possible.
+     *
+     * The random streams are reseeded before the level is loaded, so runs
+     * with the same seed are identical.
+     *
+     * @param key       the level key in assets.json
+     * @param frames    the number of frames to simulate
+     * @param step      the fixed time step in seconds
+     * @param seed      the random seed
+     *
+     * @return the measurements of the run (with no frames on failure)
+     */
+    Result run(const std::string key, int frames, float step, Uint64 seed);
+    
+    /**
+     * Simulates the room of the given replay as fast as possible.
+     *
+     * The room is started from the recorded save data and seed, and every
+     * frame uses the recorded input, time step and number of fixed steps.
+     * The state at the end is compared with the state saved in the recording.
+     *
+     * @param replay    the recorded room
+     *
+     * @return the measurements of the run (with no frames on failure)
+     */
+    Result replay(const Replay& replay);
+
+    /**
+     * Checks that the AI worker threads do not change the simulation.
+     *
+     * The level is simulated twice with the same seed, first with serial AI
+     * decisions and then with the given number of worker threads. The runs
+     * must agree after every frame.
+     *
+     * @param key       the level key in assets.json
+     * @param frames    the number of frames to simulate
+     * @param step      the fixed time step in seconds
+     * @param seed      the random seed
+     * @param threads   the number of AI worker threads of the second run
+     *
+     * @return the first difference between the runs (empty if they agree)
+     */
+    std::string checkDeterminism(const std::string key, int frames, float step, Uint64 seed, int threads);
+};
+
+#endif /* __HEADLESS_RUNNER_HPP__ */
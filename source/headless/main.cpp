@@ -0,0 +1,190 @@
+//
+//  main.cpp
+//  RS
+//
+//  The entry point of the headless runner. It simulates every level in assets.json
+//  (or the levels given on the command line) and prints the timings of each one.
+//  With --replay, it simulates the room of a replay recorded in the game instead, and
+//  fails unless the player and the enemies end in the recorded state.
+//  With --check-allocs, the run fails if any frame after the warm-up allocates heap
+//  memory without spawning a projectile or health pack. With --check-determinism N,
+//  each level runs twice with the same seed, with serial AI decisions and with N AI
+//  worker threads, and the run fails unless the enemies agree after every frame. With
+//  --check-trace, it exports two profile zones 1 µs apart and fails unless they read
+//  back 1 µs apart.
+//
+//  Usage: headless [--assets DIR] [--frames N] [--seed S] [--replay FILE] [--json FILE] [--check-allocs] [--check-determinism N] [--check-trace] [level ...]
+//
+//  Version: 10/18/26
+//
+#define SDL_MAIN_HANDLED
+#include "HeadlessRunner.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+using namespace cugl;
+
+/** The default number of simulated frames per level (one minute at 60 fps) */
+#define DEFAULT_FRAMES  3600
+/** The fixed time step of the game */
+#define FIXED_STEP      (1.0f/60.0f)
+
+/**
+ * Returns true if two zones 1 µs apart survive a Chrome trace round trip.
+ *
+ * @return true if two zones 1 µs apart survive a Chrome trace round trip
+ */
+static bool verifyTrace() {
+    // late enough that a float of the absolute time could not tell them apart
+    Uint64 start = Profiler::now();
+    Profiler::ThreadLog* log = Profiler::local();
+    Profiler::record(log, {"check/first", start, start+500, 0});
+    Profiler::record(log, {"check/second", start+1000, start+1500, 0});
+
+    std::string path = (std::filesystem::temp_directory_path()/"rs-trace-check.json").string();
+    if (!Profiler::exportTrace(path)) {
+        std::cerr << "Could not write " << path << "\n";
+        return false;
+    }
+    std::shared_ptr<JsonReader> reader = JsonReader::alloc(path);
+    std::shared_ptr<JsonValue> json = reader == nullptr ? nullptr : reader->readJson();
+    std::shared_ptr<JsonValue> events = json == nullptr ? nullptr : json->get("traceEvents");
+    double first = -1, second = -1, duration = -1;
+    for (int ii = 0; events != nullptr && ii < events->size(); ii++) {
+        std::shared_ptr<JsonValue> event = events->get(ii);
+        if (event->getString("name") == "check/first") {
+            first = event->getDouble("ts");
+            duration = event->getDouble("dur");
+        } else if (event->getString("name") == "check/second") {
+            second = event->getDouble("ts");
+        }
+    }
+    std::filesystem::remove(path);
+    if (first < 0 || second < 0 || std::abs(second-first-1.0) > 1e-6 || std::abs(duration-0.5) > 1e-6) {
+        std::cerr << "Trace zones read back at " << first << " and " << second << " us (duration " << duration << " us)\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char * argv[]) {
+    std::string root;
+    std::string output;
+    int frames = DEFAULT_FRAMES;
+    Uint64 seed = 0;
+    std::string replayFile;
+    bool checkAllocs = false;
+    bool checkTrace = false;
+    int checkThreads = 0;
+    std::vector<std::string> levels;
+    for (int ii = 1; ii < argc; ii++) {
+        std::string arg = argv[ii];
+        if (arg == "--assets" && ii+1 < argc) {
+            root = argv[++ii];
+        } else if (arg == "--frames" && ii+1 < argc) {
+            frames = std::atoi(argv[++ii]);
+        } else if (arg == "--seed" && ii+1 < argc) {
+            seed = std::strtoull(argv[++ii], nullptr, 10);
+        } else if (arg == "--replay" && ii+1 < argc) {
+            replayFile = argv[++ii];
+        } else if (arg == "--json" && ii+1 < argc) {
+            output = argv[++ii];
+        } else if (arg == "--check-allocs") {
+            checkAllocs = true;
+        } else if (arg == "--check-determinism" && ii+1 < argc) {
+            checkThreads = std::atoi(argv[++ii]);
+        } else if (arg == "--check-trace") {
+            checkTrace = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "usage: " << argv[0] << " [--assets DIR] [--frames N] [--seed S] [--replay FILE] [--json FILE] [--check-allocs] [--check-determinism N] [--check-trace] [level ...]\n";
+            return 1;
+        } else {
+            levels.push_back(arg);
+        }
+    }
+
+    if (checkTrace) {
+        return verifyTrace() ? 0 : 1;
+    }
+
+    // the cmake build copies the assets next to the executable
+    if (root.empty()) {
+        char* base = SDL_GetBasePath();
+        root = base == nullptr ? "" : base;
+        SDL_free(base);
+    }
+
+    HeadlessRunner runner;
+    if (!runner.init(root)) {
+        return 1;
+    }
+    std::shared_ptr<Replay> replay = nullptr;
+    if (!replayFile.empty()) {
+        replay = Replay::load(replayFile);
+        if (replay == nullptr) {
+            std::cerr << "Could not read replay " << replayFile << "\n";
+            return 1;
+        }
+    } else if (levels.empty()) {
+        levels = runner.getLevelKeys();
+    }
+
+    if (checkThreads > 0) {
+        bool deterministic = true;
+        for (auto& level : levels) {
+            std::string difference = runner.checkDeterminism(level, frames, FIXED_STEP, seed, checkThreads);
+            if (difference.empty()) {
+                std::cout << level << ": deterministic with " << checkThreads << " AI threads\n";
+            } else {
+                std::cerr << level << ": " << difference << "\n";
+                deterministic = false;
+            }
+        }
+        return deterministic ? 0 : 1;
+    }
+
+    std::shared_ptr<JsonValue> report = JsonValue::allocArray();
+    std::cout << HeadlessRunner::Result::getHeader() << "\n";
+    bool success = true;
+    if (replay != nullptr) {
+        HeadlessRunner::Result result = runner.replay(*replay);
+        if (result.frames == 0) {
+            std::cerr << "Failed to replay " << result.level << "\n";
+            success = false;
+        } else {
+            std::cout << result.toString() << "\n";
+            report->appendChild(result.toJson());
+        }
+        if (!result.mismatch.empty()) {
+            std::cerr << "Replay of " << result.level << " diverged from the recording: " << result.mismatch << "\n";
+            success = false;
+        }
+    }
+    for (auto& level : levels) {
+        HeadlessRunner::Result result = runner.run(level, frames, FIXED_STEP, seed);
+        if (result.frames == 0) {
+            std::cerr << "Failed to simulate " << level << "\n";
+            success = false;
+            continue;
+        }
+        std::cout << result.toString() << "\n";
+        report->appendChild(result.toJson());
+        if (checkAllocs && result.allocFrames > 0) {
+            std::cerr << level << " allocated in " << result.allocFrames << " steady-state frames, worst " << result.maxFrameReport << "\n";
+            success = false;
+        }
+    }
+
+    if (!output.empty()) {
+        std::shared_ptr<JsonWriter> writer = JsonWriter::alloc(output);
+        if (writer == nullptr) {
+            std::cerr << "Could not write " << output << "\n";
+            return 1;
+        }
+        writer->writeJson(report);
+        writer->close();
+    }
+    return success ? 0 : 1;
+}
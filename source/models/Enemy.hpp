@@ -235,7 +235,7 @@ public:
     /**
      * Gets this enemy's patrol path.
      */
-    std::vector<cugl::Vec2> getPath() const { return _path; }
+    const std::vector<cugl::Vec2>& getPath() const { return _path; }
     
     /**
      * Sets this enemy's patrol path.
@@ -62,6 +62,16 @@ float GameConstants::TANK_ENEMY_DR = 0.1f;
 
 float GameConstants::STUN_DMG_BONUS = 2.34f; // previously 1.6
 
+#pragma mark -
+#pragma mark AI Scheduling
+
+float GameConstants::AI_FULL_RATE_RANGE = 10.0f; // must exceed the sight range so aggro is never delayed
+float GameConstants::AI_ACTIVATION_RANGE = 16.0f;
+int GameConstants::AI_OFFSCREEN_PERIOD = 4;
+int GameConstants::AI_UPDATE_BUDGET = 6;
+int GameConstants::AI_WORKER_THREADS = 3;
+int GameConstants::AI_TASK_GRAIN = 2;
+
 #pragma mark -
 #pragma mark Slime Constants
 
@@ -84,6 +84,21 @@ public:
     /** the bonus damage multiplier applied to stunned enemies */
     static float STUN_DMG_BONUS;
 
+#pragma mark -
+#pragma mark AI Scheduling
+    /** enemies within this distance of the player (or on screen) are updated every frame */
+    static float AI_FULL_RATE_RANGE;
+    /** idle enemies (sentries and patrollers) beyond this distance from the player are paused */
+    static float AI_ACTIVATION_RANGE;
+    /** the number of frames between updates of an off-screen enemy */
+    static int AI_OFFSCREEN_PERIOD;
+    /** the maximum number of reduced-rate enemy updates to run in a single frame */
+    static int AI_UPDATE_BUDGET;
+    /** the number of worker threads deciding enemy updates alongside the main thread (0 to update serially) */
+    static int AI_WORKER_THREADS;
+    /** the number of enemy decisions handed to a worker thread at a time */
+    static int AI_TASK_GRAIN;
+
 #pragma mark -
 #pragma mark Slime Constants
     /** the number of game frames before explosion for slime */
@@ -6,6 +6,7 @@
 //
 
 #include "GameObject.hpp"
+#include "../components/Collider.hpp"
 
 GameObject::GameObject(){
     _tint = Color4::WHITE;
@@ -44,6 +45,7 @@ void GameObject::setEnabled(bool value){
         _colliderShadow->setEnabled(_enabled);
         _colliderShadow->getDebugNode()->setVisible(_enabled);
     }
+    // the sensor fixtures are on the collider body, so they are enabled with the collider; this only keeps the flag
     if (_sensor != nullptr){
         _sensor->setEnabled(_enabled);
         _sensor->getDebugNode()->setVisible(_enabled);
@@ -56,13 +58,15 @@ void GameObject::syncPositions(){
         pos = _collider->getPosition();
         _position = pos - _colliderOffset;
     }
-    if (_colliderShadow != nullptr){
+    // a resting shadow is left alone so that it can sleep and does not trigger a contact search every step
+    if (_colliderShadow != nullptr && _colliderShadow->getPosition() != pos){
         _colliderShadow->setPosition(pos);
         _colliderShadow->setAwake(true);
     }
-    if (_sensor != nullptr){
+    // the sensor fixtures ride on the collider body, so only its debug wireframe needs to follow
+    if (_sensor != nullptr && _sensor->hasDebug()){
         _sensor->setPosition(pos + _sensorOffset);
-        _sensor->setAwake(true);
+        _sensor->update(0);
     }
 }
 
@@ -77,9 +81,9 @@ void GameObject::addObstaclesToWorld(std::shared_ptr<physics2::ObstacleWorld> wo
         _colliderShadow->getBody()->GetUserData().pointer = reinterpret_cast<intptr_t>(this);
     }
     if (_sensor != nullptr){
-        world->addObstacle(_sensor);
-        _sensor->getBody()->GetUserData().pointer = reinterpret_cast<intptr_t>(this);
+        // the sensor becomes extra fixtures on the collider body (which already carries this object as user data)
         _sensorOffset.set(_sensor->getPosition() - _collider->getPosition());
+        Collider::attachFixtures(world, _collider, _sensor);
     }
 }
 
@@ -90,9 +94,7 @@ void GameObject::removeObstaclesFromWorld(std::shared_ptr<physics2::ObstacleWorl
     if (_colliderShadow != nullptr){
         world->removeObstacle(_colliderShadow);
     }
-    if (_sensor != nullptr){
-        world->removeObstacle(_sensor);
-    }
+    // the sensor fixtures are destroyed with the collider body
 }
 
 void GameObject::setDebugNode(const std::shared_ptr<scene2::SceneNode> &debugNode){
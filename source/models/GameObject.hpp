@@ -42,7 +42,12 @@ protected:
     /** this component is used to make this gameobject an obstacle to other gameobjects while allowing normal physics simulation */
     std::shared_ptr<cugl::physics2::Obstacle> _colliderShadow;
     
-    /** collision sensor (can be used for damage detection, opacity adjustments) */
+    /**
+     * collision sensor (can be used for damage detection, opacity adjustments)
+     *
+     * The sensor does not get a body of its own. Its shape is attached to the collider body as extra fixtures when the
+     * object is added to the world, so this obstacle only holds the shape and the debug wireframe.
+     */
     std::shared_ptr<cugl::physics2::Obstacle> _sensor;
     
     /** offset between collider and sensor position */
@@ -129,6 +134,8 @@ public:
     
     /**
      * @return reference to the collision sensor (can be used for damage detection, opacity adjustments)
+     *
+     * Note: the sensor has no Box2D body; its fixtures belong to the body of the collider.
      */
     virtual std::shared_ptr<cugl::physics2::Obstacle> getSensor(){
         return _sensor;
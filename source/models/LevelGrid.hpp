@@ -47,6 +47,16 @@ public:
      */
     int getNode(Vec2 tileIndex);
     
+    /**
+     * @return the number of tiles across the grid
+     */
+    int getWidth() const { return _width; }
+    
+    /**
+     * @return the number of tiles along the grid
+     */
+    int getHeight() const { return _height; }
+    
     /**
      * sets value `val` at the given tile (tx,ty)
      */
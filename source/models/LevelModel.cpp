@@ -20,7 +20,7 @@
 #include "GameObject.hpp"
 #include "CollisionConstants.hpp"
 #include "GameConstants.hpp"
-#include <random>
+#include "../utility/GameRandom.hpp"
 #include "../components/Collider.hpp"
 
 #pragma mark -
@@ -37,8 +37,6 @@ _debugNode(nullptr),
 _exiting(false)
 {
 	_bounds.size.set(1.0f, 1.0f);
-    generator = std::mt19937(std::random_device()());
-    distribution = std::uniform_real_distribution<double>(0.0, 1.0);
 }
 
 /**
@@ -80,11 +78,15 @@ void LevelModel::setDrawScale(Vec2 scale) {
 }
 
 void LevelModel::render(const std::shared_ptr<cugl::SpriteBatch>& batch, Rect camRect){
+    // each group is its own sort layer, so a deferred batch keeps the groups in this order
+    Uint8 layer = 0;
     for (int ii = 0; ii < _tileLayers.size(); ii++){
+        batch->setSortKey(layer++, 0);
         _tileLayers[ii]->draw(batch, camRect);
     }
     
     // indicators should be drawn between tile layers and objects
+    batch->setSortKey(layer++, 0);
     if (_player->isEnabled() && _player->isRangedAttackActive()){
         _player->drawRangeIndicator(batch, _world);
     }
@@ -94,6 +96,7 @@ void LevelModel::render(const std::shared_ptr<cugl::SpriteBatch>& batch, Rect ca
         [](const std::shared_ptr<GameObject>& a, const std::shared_ptr<GameObject>& b) {
             return (*a) < (*b);
         });
+    batch->setSortKey(layer++, 0);
     for (auto it = _dynamicObjects.begin(); it != _dynamicObjects.end(); it++){
         if ((*it)->isEnabled()){
             (*it)->draw(batch);
@@ -114,6 +117,7 @@ void LevelModel::render(const std::shared_ptr<cugl::SpriteBatch>& batch, Rect ca
             boss->getStormHitbox()->getDebugNode()->setVisible(boss->getStormHitbox()->isEnabled());
         }
     }
+    batch->setSortKey(layer++, 0);
     for (int ii = 0; ii < _projectiles.size(); ii++) {
         _projectiles[ii]->draw(batch);
         _projectiles[ii]->getCollider()->getDebugNode()->setVisible(_projectiles[ii]->isEnabled());
@@ -348,7 +352,7 @@ bool LevelModel::loadGameComponent(const std::shared_ptr<JsonValue> constants, c
     else if (objectClass == CLASS_RANDOM){
         auto cdf = json->get(CDF_FIELD)->asFloatArray();
         if (cdf.size() > 0){
-            float probability = distribution(generator);
+            float probability = GameRandom::nextFloat(GameRandom::LEVEL);
             for (int i = 0; i < cdf.size(); i++){
                 if (cdf[i] >= probability){
                     // get i-th component, load it
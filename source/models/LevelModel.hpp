@@ -96,11 +96,6 @@ protected:
     /** whether the player is exiting the level*/
     bool _exiting;
     
-    /** the random number generator */
-    std::mt19937 generator;
-    /** the random number distribution (uniform distribution) */
-    std::uniform_real_distribution<double> distribution;
-    
     /** the name of the soundtrack to play for this level */
     std::string _musicName;
 
@@ -122,45 +122,37 @@ void Player::drawRangeIndicator(const std::shared_ptr<SpriteBatch>& batch, const
     Vec2 rayEnd = getPosition() + rayLength * getFacingDir();
     float frac = 1;
     Vec2 loc = rayEnd;
-    std::function<float(b2Fixture*, const Vec2, const Vec2, float)> callback
-        = [&frac, &loc](b2Fixture* fixture, const Vec2 point, const Vec2 normal, float fraction) {
-        if (fixture->GetFilterData().categoryBits == CATEGORY_TALL_WALL) {
-            if (fraction < frac){
-                frac = fraction;
-                loc = point;
-            }
-            return fraction;
+    // only tall walls reach the callback
+    auto callback = [&frac, &loc](b2Fixture* fixture, const Vec2 point, const Vec2 normal, float fraction) {
+        if (fraction < frac){
+            frac = fraction;
+            loc = point;
         }
-        else return -1.0f;
+        return fraction;
         };
-    world->rayCast(callback, getPosition(), rayEnd);
+    world->rayCast(callback, getPosition(), rayEnd, CATEGORY_TALL_WALL);
+    // the arrow reaches the first tall wall, or its full length if there is none
+    float length = GameConstants::PROJ_DIST_P + GameConstants::PROJ_SIZE_P_HALF;
     if (abs(frac-1)>0.01) {
-        float dist = getPosition().distance(loc);
-        if (dist >= GameConstants::PROJ_SIZE_P_HALF) {
-            std::vector<Vec2> vec = std::vector<Vec2>();
-            vec.push_back(Vec2(0, GameConstants::PROJ_SIZE_P_HALF / 2));
-            vec.push_back(Vec2(0, -GameConstants::PROJ_SIZE_P_HALF / 2));
-            vec.push_back(Vec2(dist - GameConstants::PROJ_SIZE_P_HALF, -GameConstants::PROJ_SIZE_P_HALF / 2));
-            vec.push_back(Vec2(dist, 0));
-            vec.push_back(Vec2(dist - GameConstants::PROJ_SIZE_P_HALF, GameConstants::PROJ_SIZE_P_HALF / 2));
-            EarclipTriangulator et = EarclipTriangulator(vec);
-            et.calculate();
-            Poly2 poly = et.getPolygon();
-            batch->draw(nullptr, Color4(0, 0, 0, 90), poly, Vec2::ZERO, t);
+        length = getPosition().distance(loc);
+        if (length < GameConstants::PROJ_SIZE_P_HALF) {
+            return;
         }
     }
-    else {
-        std::vector<Vec2> vec = std::vector<Vec2>();
-        vec.push_back(Vec2(0, GameConstants::PROJ_SIZE_P_HALF / 2));
-        vec.push_back(Vec2(0, -GameConstants::PROJ_SIZE_P_HALF / 2));
-        vec.push_back(Vec2(GameConstants::PROJ_DIST_P, -GameConstants::PROJ_SIZE_P_HALF / 2));
-        vec.push_back(Vec2(GameConstants::PROJ_DIST_P + GameConstants::PROJ_SIZE_P_HALF, 0));
-        vec.push_back(Vec2(GameConstants::PROJ_DIST_P, GameConstants::PROJ_SIZE_P_HALF / 2));
-        EarclipTriangulator et = EarclipTriangulator(vec);
-        et.calculate();
-        Poly2 poly = et.getPolygon();
-        batch->draw(nullptr, Color4(0, 0, 0, 90), poly, Vec2::ZERO, t);
+    // the arrow is convex, so a fan triangulates it (and the buffers are reused every frame)
+    float half = GameConstants::PROJ_SIZE_P_HALF / 2;
+    float head = length - GameConstants::PROJ_SIZE_P_HALF;
+    std::vector<Vec2>& vertices = _rangeIndicator.vertices;
+    vertices.resize(5);
+    vertices[0].set(0, half);
+    vertices[1].set(0, -half);
+    vertices[2].set(head, -half);
+    vertices[3].set(length, 0);
+    vertices[4].set(head, half);
+    if (_rangeIndicator.indices.size() != 9) {
+        _rangeIndicator.indices = { 0, 1, 2, 0, 2, 3, 0, 3, 4 };
     }
+    batch->draw(nullptr, Color4(0, 0, 0, 90), _rangeIndicator, Vec2::ZERO, t);
 }
 
 void Player::drawEffect(const std::shared_ptr<cugl::SpriteBatch>& batch, const std::shared_ptr<Animation>& effect, float ang, float scale) {
@@ -104,6 +104,8 @@ protected:
     Weapon _weapon;
     /** player state */
     State _state;
+    /** the arrow of the range indicator, reshaped every frame that it is drawn */
+    Poly2 _rangeIndicator;
 
     /** counter that is active while the player takes damage */
     Counter _iframeCounter;
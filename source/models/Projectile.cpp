@@ -1,4 +1,5 @@
 #include "Projectile.hpp"
+#include "../utility/FrameArena.hpp"
 #include <cmath>
 
 bool Projectile::playerInit(Vec2 pos, float damage, bool charged, float ang, const std::shared_ptr<AssetManager>& assets) {
@@ -13,15 +14,17 @@ bool Projectile::playerInit(Vec2 pos, float damage, bool charged, float ang, con
     _isFullyCharged = charged;
     _origin = "player";
 
-    //init hitbox
-    std::vector<Vec2> v;
+    //init hitbox (the outlines are only needed to triangulate the hitbox and its shadow)
+    FrameArena::Scope scratch;
+    FrameVector<Vec2> v;
+    v.reserve(4);
     //halve the height because of iso perspective
     v.push_back(pos+Vec2(0, GameConstants::PROJ_SIZE_P_HALF/2));
     v.push_back(pos+Vec2(-GameConstants::PROJ_SIZE_P_HALF, 0));
     v.push_back(pos+Vec2(0, -GameConstants::PROJ_SIZE_P_HALF/2));
     v.push_back(pos+Vec2(GameConstants::PROJ_SIZE_P_HALF, 0));
     EarclipTriangulator et;
-    et.set(v);
+    et.set(v.data(), v.size());
     et.calculate();
     Poly2 poly = et.getPolygon();
     std::shared_ptr<physics2::PolygonObstacle> obs = physics2::PolygonObstacle::allocWithAnchor(poly, Vec2(0.5f,0.5f));
@@ -44,7 +47,7 @@ bool Projectile::playerInit(Vec2 pos, float damage, bool charged, float ang, con
     v.push_back(pos + Vec2(0, -GameConstants::PROJ_SIZE_P_HALF / 2 * GameConstants::PROJ_SHADOW_SCALE));
     v.push_back(pos + Vec2(GameConstants::PROJ_SIZE_P_HALF * GameConstants::PROJ_SHADOW_SCALE, 0));
     et.clear();
-    et.set(v);
+    et.set(v.data(), v.size());
     et.calculate();
     poly = et.getPolygon();
     std::shared_ptr<physics2::PolygonObstacle> shadow = physics2::PolygonObstacle::allocWithAnchor(poly, Vec2(0.5f, 0.5f));
@@ -33,10 +33,10 @@ bool DeathScene::init(const std::shared_ptr<cugl::AssetManager> &assets){
     _main = std::dynamic_pointer_cast<scene2::Button>(_assets->get<scene2::SceneNode>("death_dead_selection_main_menu"));
     // program the buttons
     _restart->addListener([this](const std::string& name, bool down) {
-        if (down) { _choice = Choice::RESTART; AudioController::playUiFX("menuClick");}
+        if (down) { _choice = Choice::RESTART; AudioController::play(AudioController::UI_CLICK);}
     });
     _main->addListener([this](const std::string& name, bool down) {
-        if (down) { _choice = Choice::MAIN_MENU; AudioController::playUiFX("menuClick");}
+        if (down) { _choice = Choice::MAIN_MENU; AudioController::play(AudioController::UI_CLICK);}
     });
     
     // add an overlay layer to separate game background from UI
@@ -45,7 +45,7 @@ bool GameRenderer::init(const std::shared_ptr<AssetManager>& assets){
         if (down){
             _paused=true;
             hideJoysticks();
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         }
     });
     
@@ -66,6 +66,13 @@ bool GameRenderer::init(const std::shared_ptr<AssetManager>& assets){
     _dashNowEffect = Animation::alloc(SpriteSheet::alloc(_assets->get<Texture>("dash_ready"), 3, 2), 1.0f, true);
     _dashNowEffect->start();
     
+    // the buttons and bars rarely change, so they are drawn from cached render targets
+    // (the status node is not cached as a whole, as the dash icon animates every frame)
+    _pauseButton->setCached(true);
+    _swapButton->setCached(true);
+    _hpBar->setCached(true);
+    _stamina->setCached(true);
+    
     // readjust scene to screen
     scene->setContentSize(dimen);
     scene->doLayout(); // Repositions the HUD
@@ -199,12 +206,22 @@ void GameRenderer::update(float dt){
 }
 
 void GameRenderer::render(const std::shared_ptr<SpriteBatch> &batch){
+    CUProfileZone("GameRenderer::render");
     auto player = _level->getPlayer();
-    _hpBar->setProgress(player->getHP() / (float) player->getMaxHP());
-    _stamina->setProgress(player->getStamina() / GameConstants::PLAYER_STAMINA);
+    // only touch the bars on a change, as that invalidates their caches
+    float hp = player->getHP() / (float) player->getMaxHP();
+    if (hp != _hpBar->getProgress()){
+        _hpBar->setProgress(hp);
+    }
+    float stamina = player->getStamina() / GameConstants::PLAYER_STAMINA;
+    if (stamina != _stamina->getProgress()){
+        _stamina->setProgress(stamina);
+    }
     
     // using game camera, render the game
     if (_gameCam != nullptr){
+        // the level is drawn sorted by layer, so tilesets and sprites batch together
+        batch->setDeferred(true);
         batch->begin(_gameCam->getCombined());
         Size viewSize = (1/_gameCam->getZoom()) * _gameCam->getViewport().size;
         Vec2 camPos = _gameCam->getPosition();
@@ -213,6 +230,7 @@ void GameRenderer::render(const std::shared_ptr<SpriteBatch> &batch){
             _level->render(batch, camRect);
         }
         batch->end();
+        batch->setDeferred(false);
     }
     Scene2::render(batch);  // call base method to render scene nodes
 }
@@ -24,18 +24,22 @@
 #include "../models/ExplodingAlien.hpp"
 #include "../models/Wall.hpp"
 #include "../models/HealthPack.hpp"
+#include "../models/CollisionConstants.hpp"
 #include <box2d/b2_world.h>
 #include <box2d/b2_contact.h>
 #include <box2d/b2_collision.h>
 #include <array>
 
-#include <ctime>
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <array>
 #include "../components/Animation.hpp"
 #include "../utility/SaveData.hpp"
+#include "../utility/GameRandom.hpp"
+#include "../utility/Replay.hpp"
+#include "../utility/AllocationTracker.hpp"
+#include "../utility/FrameArena.hpp"
 using namespace cugl;
 
 #pragma mark -
@@ -47,6 +51,16 @@ using namespace cugl;
 
 /** The key for the font reference */
 #define PRIMARY_FONT        "retro"
+/** The key for the debug overlay font */
+#define DEBUG_FONT          "robotoRegular16"
+/** The file (in the save directory) receiving the physics statistics in debug mode */
+#define PHYSICS_STATS_FILE  "physics_stats.csv"
+/** The file (in the save directory) receiving the profiler trace when debug mode is turned off */
+#define PROFILE_TRACE_FILE  "frame_trace.json"
+/** The file (in the save directory) with the last input recording */
+#define REPLAY_FILE         "replay.bin"
+/** The file (in the save directory) receiving the profiler trace of a finished replay */
+#define REPLAY_TRACE_FILE   "replay_trace.json"
 
 /** The message to display on a level reset */
 #define RESET_MESSAGE       "Resetting"
@@ -57,7 +71,9 @@ using namespace cugl;
 #pragma mark Constructors
 
 GameScene::GameScene() : Scene2(),
-_complete(false), _defeat(false), _debug(false){}
+_complete(false), _defeat(false), _debug(false),
+_sessionSeed(0), _roomCount(0), _roomSeed(0), _fixedSteps(0),
+_recordRequested(false), _replayRequested(false){}
 
 
 bool GameScene::init(const std::shared_ptr<AssetManager>& assets) {
@@ -69,7 +85,9 @@ bool GameScene::init(const std::shared_ptr<AssetManager>& assets) {
         return false;
     }
     
-    srand((uint32) time(NULL));
+    // every room derives its seed from the session seed (see setLevel)
+    _sessionSeed = GameRandom::makeSeed();
+    _roomCount = 0;
 
     // initalize controllers with the assets
     _assets = assets;
@@ -85,6 +103,8 @@ bool GameScene::init(const std::shared_ptr<AssetManager>& assets) {
     _input.setMinDragRadius(_gameRenderer.getJoystickScreenRadius() / 4);
     activateInputs(false);
     _collisionController.setAssets(_assets);
+    _playerController.setAssets(_assets);
+    _gameplayController.setAssets(_assets);
     
     CameraController::CameraConfig config;
     config.speed = GameConstants::GAME_CAMERA_SPEED;
@@ -125,6 +145,16 @@ bool GameScene::init(const std::shared_ptr<AssetManager>& assets) {
     _deadEffectNode = std::dynamic_pointer_cast<scene2::SpriteNode>(_assets->get<scene2::SceneNode>("gameplay_dead_effect"));
     _deadEffectAnimation = scene2::Animate::alloc(0,_deadEffectNode->getSpan()-1, 1.2f);
     
+    // the physics statistics overlay sits in the top left corner in debug mode
+    _statsLabel = scene2::Label::allocWithTextBox(Size(420, 540), "", _assets->get<Font>(DEBUG_FONT));
+    _statsLabel->setAnchor(Vec2::ANCHOR_TOP_LEFT);
+    _statsLabel->setPosition(Vec2(10, _effectsScene.getSize().height - 10));
+    _statsLabel->setHorizontalAlignment(HorizontalAlign::LEFT);
+    _statsLabel->setVerticalAlignment(VerticalAlign::TOP);
+    _statsLabel->setForeground(Color4::WHITE);
+    _statsLabel->setVisible(false);
+    _effectsScene.addChild(_statsLabel);
+    
     _levelTransition.init(assets);
     _levelTransition.setInitialColor(Color4(255, 255, 255, 0));
     _levelTransition.setFadeIn(GameConstants::TRANSITION_FADE_IN_TIME);
@@ -181,12 +211,16 @@ bool GameScene::init(const std::shared_ptr<AssetManager>& assets) {
     setComplete(false);
     setDefeat(false);
     _exitCode = NONE;
-    hitPauseCounter.setMaxCount(GameConstants::HIT_PAUSE_FRAMES + 3);
     Application::get()->setClearColor(Color4("#c9a68c"));
     return true;
 }
 
 void GameScene::dispose() {
+    if (_statsWriter != nullptr) {
+        _statsWriter->close();
+        _statsWriter = nullptr;
+    }
+    _statsLabel = nullptr;
     _input.dispose();
     _debugNode = nullptr;
     _level = nullptr;
@@ -196,6 +230,29 @@ void GameScene::dispose() {
     Scene2::dispose();
 }
 
+void GameScene::setDebug(bool value){
+    _debug = value;
+    _level->showDebug(value);
+    _level->getWorld()->setStatsEnabled(value);
+    _statsLabel->setVisible(value);
+    // the CSV stays open across levels until debug mode is turned off
+    if (value && _statsWriter == nullptr) {
+        _statsWriter = TextWriter::alloc(Application::get()->getSaveDirectory() + PHYSICS_STATS_FILE);
+        if (_statsWriter != nullptr) {
+            _statsWriter->writeLine(physics2::ObstacleWorld::Stats::getCSVHeader());
+        }
+    }
+    else if (!value && _statsWriter != nullptr) {
+        _statsWriter->close();
+        _statsWriter = nullptr;
+    }
+#if CU_PROFILING
+    if (!value) {
+        Profiler::exportTrace(Application::get()->getSaveDirectory() + PROFILE_TRACE_FILE);
+    }
+#endif
+}
+
 void GameScene::activateTutorial(int level){
     _levelTransition.setActive(false);
     setTutorialActive(true);
@@ -223,6 +280,21 @@ void GameScene::restart(){
 }
 
 void GameScene::setLevel(SaveData::Data saveData){
+    setLevel(saveData, GameRandom::mix(_sessionSeed, _roomCount++));
+}
+
+void GameScene::setLevel(SaveData::Data saveData, Uint64 seed){
+    // a recording or replay covers a single room
+    if (_input.isRecording()){
+        saveRecording();
+    }
+    _input.stopReplay();
+    _replay = nullptr;
+    _roomSeed = seed;
+    _roomStart = saveData;
+    GameRandom::seed(seed);
+    _gameplayController.reset();
+    
     _debugNode->removeAllChildren();
     std::string levelToParse;
     auto level = saveData.level;
@@ -282,7 +354,7 @@ void GameScene::setLevel(SaveData::Data saveData){
             _upgrades.updateScene({upgradeOptions[idx1], upgradeOptions[idx2]});
         }
         // turn off the energy walls first
-        auto energyWalls = _level->getEnergyWalls();
+        const auto& energyWalls = _level->getEnergyWalls();
         for (auto it = energyWalls.begin(); it != energyWalls.end(); ++it) {
             (*it)->deactivate();
         }
@@ -301,8 +373,8 @@ void GameScene::setLevel(SaveData::Data saveData){
     });
     
     // hide effect nodes
-    _actionManager.remove(AREA_CLEAR_KEY);
-    _actionManager.remove(DEAD_EFFECT_KEY);
+    _actionManager.remove(_areaClearAction);
+    _actionManager.remove(_deadEffectAction);
     _areaClearNode->setVisible(false);
     _deadEffectNode->setVisible(false);
 }
@@ -314,13 +386,16 @@ std::array<Upgradeable, 7> GameScene::getPlayerUpgrades(std::shared_ptr<Player>
 }
 
 std::pair<std::pair<int,int>, std::pair<int,int>> GameScene::generateUpgradeIndices(std::shared_ptr<Player> player){
-    std::vector<int> options;
-    std::vector<int> levels;
+    FrameArena::Scope scratch;
+    FrameVector<int> options;
+    FrameVector<int> levels;
+    options.reserve(7);
+    levels.reserve(7);
     if (player != nullptr){
         // first find the stats that can be upgraded
         std::array<Upgradeable, 7> upgradeOptions = getPlayerUpgrades(player);
         for (int i = 0; i < 7; i++){
-            Upgradeable u = upgradeOptions[i];
+            Upgradeable& u = upgradeOptions[i];
             if (!u.isMaxLevel()){
                 options.push_back(i);
                 levels.push_back(std::min(u.getCurrentLevel() + 1, u.getMaxLevel()));
@@ -341,16 +416,16 @@ std::pair<std::pair<int,int>, std::pair<int,int>> GameScene::generateUpgradeIndi
         }
     }
     else {
-        options = {0, 1, 2, 3, 4, 5, 6};
-        levels = {1, 1, 1, 1, 1, 1, 1};
+        options.assign({0, 1, 2, 3, 4, 5, 6});
+        levels.assign({1, 1, 1, 1, 1, 1, 1});
     }
     int opt1 = 0;
     int opt2 = 1;
     if (options.size() > 2){
-        opt1 = std::rand() % options.size();
-        opt2 = std::rand() % options.size();
+        opt1 = GameRandom::nextInt(GameRandom::UPGRADES, (int)options.size());
+        opt2 = GameRandom::nextInt(GameRandom::UPGRADES, (int)options.size());
         while (opt2==opt1){
-            opt2 = std::rand() % options.size();
+            opt2 = GameRandom::nextInt(GameRandom::UPGRADES, (int)options.size());
         }
     }
     std::pair<int, int> random1(options[opt1], levels[opt1]);
@@ -386,156 +461,74 @@ std::string GameScene::getLevelKey(int level){
 #pragma mark Physics Handling
 
 void GameScene::processPlayerInput(){
+    CUProfileZone("GameScene::processPlayerInput");
     std::shared_ptr<Player> player = _level->getPlayer();
-    Vec2 moveForce = _input.getMoveDirection();
-        
+    
 #ifdef CU_TOUCH_SCREEN
     if (player->isRangedAttackActive()){
         _gameRenderer.updateAimJoystick(_input.isCombatActive(), _input.getInitCombatLocation(), _input.getCombatTouchLocation());
     }
     _gameRenderer.updateMoveJoystick(_input.isMotionActive(), _input.getInitTouchLocation(), _input.getTouchLocation());
 #endif
-    
-    if (player->isDodging() && player->getCollider()->isBullet()){
-        player->getCollider()->setBullet(false);
-    }
-    
-    // set player direction
-    if (moveForce.length() > 0 && !player->isDodging() && !player->isAttacking()){
-        player->setFacingDir(moveForce);
-    }
-
-    // Priority order: Dodge, Attack/Shoot, Parry
-    // Only read inputs when player is idle, preparing a shot or waiting to parry
-    if (player->isIdle() || player->isRangedAttackActive() || player->isBlocking()) {
-        if (_input.didDodge() && player->canDodge()) {
-            // player->dodgeCD.reset(); // reset cooldown
-            //dodge
-            auto force = _input.getDodgeDirection(player->getFacingDir());
-            if (force.length() == 0) force = player->getFacingDir().getNormalization();
-            Vec2 velocity = force * GameConstants::PLAYER_DODGE_SPEED;
-            player->getCollider()->setLinearVelocity(velocity);
-            player->getCollider()->setBullet(true);
-            player->setFacingDir(force);
-            player->setDodging();
-            player->reduceStamina();
-            AudioController::playPlayerFX("dash");
-        }
-        else if (!player->isRecovering()){
-            //for now, give middle precedence to attack
-            if (_input.didAttack()) {
-                Vec2 direction = Vec2::ZERO;
-                float ang = 0;
-                switch(player->getWeapon()){
-                case Player::Weapon::MELEE:
-                        if (player->canMeleeAttack()){
-                            direction = _input.getAttackDirection(player->getFacingDir());
-                            ang = acos(direction.dot(Vec2::UNIT_X));
-                            if (direction.y < 0) {
-                                // handle downwards case, rotate counterclockwise by PI rads and add extra angle
-                                ang = M_PI + acos(direction.rotate(M_PI).dot(Vec2::UNIT_X));
-                            }
-                            player->enableMeleeAttack(ang);
-                            player->animateAttack();
-                            player->resetAttackCooldown();
-                            !player->isComboStrike() ? AudioController::playPlayerFX("attackHit") : AudioController::playPlayerFX("attackHitPower");
-                        }
-                        break;
-                case Player::Weapon::RANGED:
-                        AudioController::playPlayerFX("loopBow");
-                        player->animateCharge();
-                        player->getCollider()->setLinearVelocity(Vec2::ZERO);
-                        break;
-                }
-            }
-            else if (_input.didCharge()) {
-                Vec2 direction = _input.getAttackDirection(player->getFacingDir());
-                if (player->getWeapon() == Player::Weapon::RANGED && player->isRangedAttackActive()) {
-                    // this lets you rotate the player while holding the bow in charge mode
-                    player->setFacingDir(direction);
-                }
-            }
-            else if (_input.didShoot() && player->getWeapon() == Player::Weapon::RANGED) {
-                AudioController::clearPlayerFX("loopBow");
-                AudioController::playPlayerFX("shootBow");
-                Vec2 direction = Vec2::ZERO;
-                float ang = 0;
-                if (player->isRangedAttackActive()) {
-                    //ranged attack
-                    direction = _input.getAttackDirection(player->getFacingDir());
-                    ang = acos(direction.dot(Vec2::UNIT_X));
-                    if (direction.y < 0) {
-                        // handle downwards case, rotate counterclockwise by PI rads and add extra angle
-                        ang = M_PI + acos(direction.rotate(M_PI).dot(Vec2::UNIT_X));
-                    }
-                    std::shared_ptr<Projectile> p = Projectile::playerAlloc(player->getPosition().add(0, 64 / player->getDrawScale().y), player->getBowDamage(), player->isCharged(), ang, _assets);
-                    p->setDrawScale(Vec2(_scale, _scale));
-                    _level->addProjectile(p);
-                    player->animateShot();
-                }
-                else player->animateDefault();
-
-            }
-            //give lowest precendence to parry. only allow it with the melee weapon
-            else if (_input.didParry() && player->getWeapon() == Player::Weapon::MELEE) {
-                player->animateParryStart();
-            }
-            else if (_input.didParryRelease() && player->getWeapon() == Player::Weapon::MELEE) {
-                if (player->isBlocking()) {
-                    //CULog("parried");
-                    player->animateParry();
-                }
-                else player->animateDefault();
-            }
-        }
-    }
+    _playerController.update(_input, _level);
     
     // disable the swap button based on player state (for anything requiring the weapon to maintain the same)
     if (!player->isMeleeAttacking()){
         // melee attack is usually fast, does not require visual button lock
         _gameRenderer.setSwapButtonActive(player->isIdle() || player->isDodging());
     }
-    
-    // the duration of the knockback applied onto the player is part of the iframe counter.
-    // only allow the player to change their velocity after the knockback frames
-    if (player->getIframes() < GameConstants::PLAYER_IFRAME - GameConstants::PLAYER_INCOMING_KB_FRAMES){
-        //stay still while parrying or blocking or recovering
-        if (player->isParrying() || player->isBlocking() || player->isRecovering()){
-            player->getCollider()->setLinearVelocity(Vec2::ZERO);
-        }
-        else if (!player->isDodging()){
-            switch (player->getWeapon()) {
-                case Player::Weapon::MELEE:
-                    if (player->isAttacking()) player->getCollider()->setLinearVelocity(moveForce * GameConstants::PLAYER_ATK_MOVE_SPEED);
-                    else player->getCollider()->setLinearVelocity(moveForce * GameConstants::PLAYER_MOVE_SPEED);
-                    break;
-                case Player::Weapon::RANGED:
-                    //with the ranged weapon, dont move while attacking
-                    if (player->isAttacking()) player->getCollider()->setLinearVelocity(Vec2::ZERO);
-                    else player->getCollider()->setLinearVelocity(moveForce * GameConstants::PLAYER_MOVE_SPEED);
-                    break;
-            }
-        }
-    }
-    
-    // TODO: could remove, this is PC-only
-    if (_input.didSwap()){
-        if (player->isIdle() || player->isDodging()){
-            //other states are weapon-dependent, so don't allow swapping while in them
-            player->swapWeapon();
-            _input.swapControlMode(); // must do for mobile controls
-        }
-    }
 }
 
 void GameScene::preUpdate(float dt) {
+    CUProfileZone("GameScene::preUpdate");
+    // nothing allocated from the arena survives into the next frame
+    FrameArena::reset();
     if (_level == nullptr) {
         return;
     }
-    
-    _input.update(dt);
+    // the AI scheduler and the voice culling need the camera view in physics coordinates
+    auto camera = std::dynamic_pointer_cast<OrthographicCamera>(getCamera());
+    Size viewSize = (1/camera->getZoom()) * camera->getViewport().size;
+    Vec2 camPos = camera->getPosition();
+    Rect view((camPos - viewSize/2)/_scale, viewSize/_scale);
+    AudioController::update(view);
+    
+    {
+        CUProfileZone("InputController::update");
+        bool replaying = _input.isReplaying();
+        _input.update(dt);
+        if (_input.isReplaying()) {
+            // the recorded frame time, so that every update matches the recording
+            dt = _input.getReplayDelta();
+        }
+        else if (replaying) {
+            // the state after the last replayed frame, as the recording saved it
+            std::string difference = Replay::compareState(_replay->end, Replay::getState(_level));
+            if (_replay->end.empty()) {
+                CULog("Replay finished");
+            }
+            else if (difference.empty()) {
+                CULog("Replay finished in the recorded state");
+            }
+            else {
+                CULogError("Replay diverged from the recording: %s", difference.c_str());
+            }
+            _replay = nullptr;
+#if CU_PROFILING
+            Profiler::exportTrace(Application::get()->getSaveDirectory() + REPLAY_TRACE_FILE);
+#endif
+        }
+    }
     
     // Process the toggled key commands
+    if (_input.didRecord()) {
+        // the room restarts at the end of the frame, so no untracked step runs before the first recorded frame
+        if (_input.isRecording()) saveRecording();
+        else _recordRequested = true;
+    }
+    if (_input.didReplay()) {
+        _replayRequested = true;
+    }
     if (_input.didDebug()) {
         //CULog("debug toggled");
         setDebug(!isDebug());
@@ -553,35 +546,49 @@ void GameScene::preUpdate(float dt) {
         return;
     }
     
+    if (isDebug()) {
+        // the overlay itself allocates, so it is left out of the counts it reports
+        AllocationTracker::Ignore ignore;
+        const physics2::ObstacleWorld::Stats& stats = getPhysicsStats();
+        std::stringstream ss;
+        ss.precision(2);
+        ss << std::fixed;
+        ss << "step " << stats.stepTime << " ms (collide " << stats.profile.collide << ", solve " << stats.profile.solve;
+        ss << ", toi " << stats.profile.solveTOI << ", broadphase " << stats.profile.broadphase << ")\n";
+        ss << "bodies " << stats.bodies << " (" << stats.awakeBodies << " awake), contacts " << stats.touching << "/" << stats.contacts;
+        ss << ", proxies " << stats.proxies << "\n";
+        ss << "raycasts " << stats.raycasts << ", queries " << stats.queries << ", " << stats.queryTime << " ms\n";
+        // the counts by category are indexed by bit position
+        auto bit = [](uint16 category) { int ii = 0; while (!(category & (1 << ii))) ii++; return ii; };
+        ss << "enemy bodies " << stats.bodiesByCategory[bit(CATEGORY_ENEMY)];
+        ss << ", enemy contacts " << stats.contactsByCategory[bit(CATEGORY_ENEMY)];
+        ss << ", wall proxies " << stats.proxiesByCategory[bit(CATEGORY_SHORT_WALL)] + stats.proxiesByCategory[bit(CATEGORY_TALL_WALL)];
+        ss << "\n" << AllocationTracker::getFrameReport();
+        ss << "\n" << FrameArena::getReport();
+        ss << "\n" << AudioController::getVoiceReport();
+        ss << "\ndraws " << _renderStats.calls << ", vertices " << _renderStats.vertices;
+        ss << ", uploaded " << _renderStats.bytes/1024 << " KB, respecs " << _renderStats.respecs;
+        ss << "\nnode cache hits " << scene2::SceneNode::getCacheHits() << ", misses " << scene2::SceneNode::getCacheMisses();
+#if CU_PROFILING
+        ss << "\n" << Profiler::getFrameReport();
+#endif
+        _statsLabel->setText(ss.str());
+    }
+    
     // update the effects that appears on screen for clearing room / dying
     _actionManager.update(dt);
-    _areaClearNode->setVisible(_actionManager.isActive(AREA_CLEAR_KEY));
-    _deadEffectNode->setVisible(_actionManager.isActive(DEAD_EFFECT_KEY));
+    _areaClearNode->setVisible(_actionManager.isActive(_areaClearAction));
+    _deadEffectNode->setVisible(_actionManager.isActive(_deadEffectAction));
     
     if (!isComplete() && !isDefeat()){
-        // game not won or lost, check if any enemies active
-        int activeCount = 0;
-        int initialCount = 0;
-        auto enemies = _level->getEnemies();
-        for (auto it = enemies.begin(); it != enemies.end(); ++it) {
-            if (!(*it)->isDefeated()) {
-                activeCount += 1;
-            }
-            if ((*it)->getMaxHealth() > 0){
-                initialCount += 1;
-            }
-        }
         // player finishes current level
-        if (activeCount == 0){
+        bool fought = false;
+        if (_gameplayController.clearRoom(_level, fought)){
             setComplete(true);
-            auto energyWalls = _level->getEnergyWalls();
-            for (auto it = energyWalls.begin(); it != energyWalls.end(); ++it) {
-                (*it)->deactivate();
-            }
-            if (initialCount > 0){
+            if (fought){
                 // no more enemies remain, but there were enemies initially
-                _actionManager.remove(AREA_CLEAR_KEY);
-                _actionManager.activate(AREA_CLEAR_KEY, _areaClearAnimation, _areaClearNode);
+                _actionManager.remove(_areaClearAction);
+                _areaClearAction = _actionManager.activate(_areaClearAnimation, _areaClearNode);
                 AudioController::updateMusic("strand", 1.0f);
             }
         }
@@ -595,15 +602,15 @@ void GameScene::preUpdate(float dt) {
             setComplete(false);
             _levelTransition.setActive(false);
             // start playing dead effect, stop the area clear if we happen to have cleared the room and got killed by a flying projectile
-            _actionManager.remove(AREA_CLEAR_KEY);
-            _actionManager.remove(DEAD_EFFECT_KEY);
-            _actionManager.activate(DEAD_EFFECT_KEY, _deadEffectAnimation, _deadEffectNode);
+            _actionManager.remove(_areaClearAction);
+            _actionManager.remove(_deadEffectAction);
+            _deadEffectAction = _actionManager.activate(_deadEffectAnimation, _deadEffectNode);
         }
     }
     
     // player sees dead effect and is then shown the dead screen when effect is finished
     if (isDefeat()){
-        if (!_actionManager.isActive(DEAD_EFFECT_KEY)){
+        if (!_actionManager.isActive(_deadEffectAction)){
             // the dead effect is no longer active, so send player to dead screen (and disable player)
             _level->getPlayer()->setEnabled(false);
             _exitCode = DEATH;
@@ -625,21 +632,15 @@ void GameScene::preUpdate(float dt) {
     }
     
     
-    if (_collisionController.isComboContact() && hitPauseCounter.isZero()){
-        hitPauseCounter.reset();
-    }
-    if (!hitPauseCounter.isZero()){
-        hitPauseCounter.decrement();
-        if (hitPauseCounter.getCount() <= GameConstants::HIT_PAUSE_FRAMES){
-            return; // this gives the vague "lag" effect
-        }
+    if (_gameplayController.updateHitPause(_collisionController.isComboContact())){
+        return; // this gives the vague "lag" effect
     }
 
 #pragma mark - handle player input
 
     if (!isDefeat()){
         processPlayerInput();
-        AudioController::playUiFX("environment");
+        AudioController::play(AudioController::UI_ENVIRONMENT);
     }
     else {
         // make sure to stop player from moving
@@ -648,141 +649,10 @@ void GameScene::preUpdate(float dt) {
 
 #pragma mark - Enemy AI
     auto player = _level->getPlayer();
+    // the AI scheduler runs on-screen enemies at full rate
+    _AIController.setViewBounds(view);
     _AIController.update(dt);
-    // enemy attacks
-    int enemyIndex = 0;
-    std::vector<std::shared_ptr<Enemy>> enemies = _level->getEnemies();
-    for (auto it = enemies.begin(); it != enemies.end(); ++it) {
-        auto enemy = *it;
-        if (!enemy->isEnabled() || enemy->isDying()) continue;
-        if (enemy->getHealth() <= 0) {
-            //drop health pack
-            AudioController::playEnemyFX("death", enemy->getType());
-            if (!enemy->_dropped && rand() % 100 < GameConstants::HEALTHPACK_DROP_RATE) {
-                auto healthpack = HealthPack::alloc(enemy->getPosition(), _assets);
-                healthpack->setDrawScale(Vec2(_scale, _scale));
-                _level->addHealthPack(healthpack);
-            }
-
-            if (enemy->getType() == "melee lizard" ||
-                enemy->getType() == "tank enemy" ||
-                enemy->getType() == "boss enemy") {
-                std::shared_ptr<MeleeEnemy> m = std::dynamic_pointer_cast<MeleeEnemy>(enemy);
-                m->getAttack()->setEnabled(false);
-            }
-
-            if (enemy->isEnabled() && !enemy->isDying()) { 
-                enemy->setDying(); 
-                enemy->getCollider()->setEnabled(false);
-                enemy->getColliderShadow()->setEnabled(false);
-            }
-            enemy->_dropped = true;
-        }
-        if (enemy->getType() == "melee lizard" ||
-            enemy->getType() == "tank enemy" ||
-            enemy->getType() == "boss enemy") {
-            std::shared_ptr<MeleeEnemy> m = std::dynamic_pointer_cast<MeleeEnemy>(enemy);
-            if (m->isStunned()){
-                enemy->getCollider()->setLinearVelocity(Vec2::ZERO);
-                m->getAttack()->setEnabled(false);
-            }
-        }
-        if (enemy->isEnabled() && !enemy->isDying() && enemy->getHealth() > 0) {
-            // boss performs its second attack if already attacking
-            if (enemy->getType() == "boss enemy") {
-                std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(enemy);
-                if (boss->secondAttack()) {
-                    boss->attack2(_assets);
-                    boss->setAttacking2();
-                    continue;
-                }
-            }
-            // enemy can only begin an attack if not stunned and within range of player and can see them
-            bool canBeginNewAttack = enemy->canBeginNewAttack();
-            if (enemy->getType() == "exploding alien"){
-                auto explode = std::dynamic_pointer_cast<ExplodingAlien>(enemy);
-                if (canBeginNewAttack && enemy->getPosition().distance(player->getPosition()) <= enemy->getAttackRange() && enemy->getPlayerInSight()) {
-                    if (explode->canExplode()) {
-                        explode->setAttacking();
-                    } else {
-                        explode->updateWindup(true);
-                    }
-                } else {
-                    explode->updateWindup(false);
-                }
-                continue;
-            }
-            if (canBeginNewAttack && enemy->getPosition().distance(player->getPosition()) <= enemy->getAttackRange() && enemy->getPlayerInSight()) {
-                if (enemy->getType() == "melee lizard" ||
-                    enemy->getType() == "tank enemy" ||
-                    enemy->getType() == "boss enemy") {
-                    enemy->attack(_level, _assets);
-                    if (enemy->getType() == "melee lizard") {
-                        AudioController::playEnemyFX("attack", std::to_string(enemyIndex));
-                    }
-                    else {
-                        std::string s = enemy->getType() == "tank enemy" ? "tank" : "boss";
-                        AudioController::playEnemyFX(s + "Attack", std::to_string(enemyIndex));
-                    }
-                }
-                enemy->setAttacking();
-            }
-            if (enemy->isAttacking()) {
-                if (enemy->getType() == "ranged lizard" ||
-                    enemy->getType() == "mage alien") {
-                    std::shared_ptr<RangedEnemy> r = std::dynamic_pointer_cast<RangedEnemy>(enemy);
-                    if (r->getCharged()) {
-                        enemy->attack(_level, _assets);
-                        AudioController::playEnemyFX((enemy->getType() == "mage alien" ? "casterAttack" : "attack"), std::to_string(enemyIndex));
-                    }
-                }
-            }
-            if (enemy->getType() == "boss enemy") {
-                std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(enemy);
-                if (boss->getStormState() == BossEnemy::StormState::CHARGED) {
-                    boss->summonStorm(_level, _assets);
-                    AudioController::playEnemyFX("bossStorm", std::to_string(enemyIndex));
-                }
-            }
-        }
-        enemyIndex++;
-    }
-
-#pragma mark - Component Updates
-    
-    for (auto it = enemies.begin(); it != enemies.end(); ++it) {
-        std::shared_ptr<MeleeEnemy> m;
-        if ((*it)->getType() == "melee lizard" || (*it)->getType() == "tank enemy"
-            || (*it)->getType() == "boss enemy") {
-            m = std::dynamic_pointer_cast<MeleeEnemy>(*it);
-            m->updateCounters();
-        }
-        else {
-            (*it)->updateCounters();
-        }
-        if ((*it)->getType() == "boss enemy") {
-            std::shared_ptr<BossEnemy> boss = std::dynamic_pointer_cast<BossEnemy>(*it);
-            boss->_stormTimer.decrement();
-        }
-    }
-    std::vector<std::shared_ptr<Projectile>> projs = _level->getProjectiles();
-    for (auto it = projs.begin(); it != projs.end(); ++it) {
-        (*it)->updateAnimation(dt);
-        if ((*it)->isCompleted()) _level->delProjectile((*it));
-    }
-
-    std::vector<std::shared_ptr<HealthPack>> hps = _level->getHealthPacks();
-    for (auto it = hps.begin(); it != hps.end(); ++it) {
-        (*it)->updateAnimation(dt);
-        if ((*it)->_delMark) _level->delHealthPack((*it));
-    }
-    
-    // update every animation in game objects
-    for (auto& gameobject : _level->getDynamicObjects()){
-        gameobject->updateAnimation(dt);
-    }
-    
-    player->update(dt); // updates counters, hitboxes
+    _gameplayController.update(_level, dt);
     _levelTransition.update(dt); // does nothing when not active
     _gameRenderer.update(dt);
     
@@ -857,6 +727,16 @@ void GameScene::preUpdate(float dt) {
 
 
 void GameScene::fixedUpdate(float step) {
+    CUProfileZone("GameScene::fixedUpdate");
+    if (_input.isReplaying()){
+        // replays take the recorded steps in postUpdate instead
+        return;
+    }
+    _fixedSteps++;
+    simulate(step);
+}
+
+void GameScene::simulate(float step) {
     if (_level != nullptr){
         auto player = _level->getPlayer();
         if (player->getHP() == 0){
@@ -872,28 +752,16 @@ void GameScene::fixedUpdate(float step) {
         
         _camController.update(step);
         
-        if (!hitPauseCounter.isZero()){
-            if (hitPauseCounter.getCount() <= GameConstants::HIT_PAUSE_FRAMES){
-                return; // this gives the vague "lag" effect (quitting physics update)
-            }
+        if (_gameplayController.isHitPaused()){
+            return; // this gives the vague "lag" effect (quitting physics update)
         }
         
         _level->getWorld()->update(step);     // Turn the physics engine crank.
-        auto enemies = _level->getEnemies();
-        for (auto it = enemies.begin(); it != enemies.end(); ++it){
-            auto e = *it;
-            e->syncPositions();
-            if (e->getType() == "melee lizard"
-                || e->getType() == "tank enemy"
-                || e->getType() == "boss enemy") {
-                std::shared_ptr<MeleeEnemy> m = std::dynamic_pointer_cast<MeleeEnemy>(e);
-                m->getAttack()->setPosition(e->getPosition().add(0, 64 / e->getDrawScale().y)); //64 is half of the enemy pixel height
-            }
+        if (_statsWriter != nullptr) {
+            _statsWriter->writeLine(getPhysicsStats().toCSV());
         }
-        player->syncPositions();
-
-        auto projs = _level->getProjectiles();
-        for (auto it = projs.begin(); it != projs.end(); ++it) (*it)->syncPositions();
+        CUProfileZone("GameScene::syncPositions");
+        _gameplayController.syncPositions(_level);
     }
 }
 
@@ -901,6 +769,68 @@ void GameScene::fixedUpdate(float step) {
 void GameScene::postUpdate(float remain) {
     // TODO: possibly apply interpolation.
     // We will need more data structures for this
+    
+    // the number of fixed steps depends on the wall clock, so recordings store it
+    if (_input.isRecording()) {
+        _input.endFrame(_fixedSteps);
+    }
+    else if (_input.isReplaying()) {
+        // the step of the recording, which need not be the step of this run
+        for (Uint32 ii = 0; ii < _input.getReplaySteps(); ii++) {
+            simulate(_replay->step);
+        }
+    }
+    _fixedSteps = 0;
+    
+    if (_replayRequested) {
+        startReplay();
+    }
+    else if (_recordRequested && _level != nullptr) {
+        startRecording();
+    }
+    _replayRequested = false;
+    _recordRequested = false;
+}
+
+#pragma mark -
+#pragma mark Recording and Replay
+
+void GameScene::startRecording() {
+    setLevel(_roomStart, _roomSeed);
+    _input.startRecording();
+    CULog("Recording %s", getLevelKey(_levelNumber).c_str());
+}
+
+void GameScene::saveRecording() {
+    Replay replay;
+    replay.seed = _roomSeed;
+    replay.step = Application::get()->getFixedStep()/1000000.0f;
+    replay.tutorial = _isTutorial;
+    replay.start = _roomStart;
+    replay.input = _input.stopRecording();
+    if (_level != nullptr) {
+        replay.end = Replay::getState(_level);
+    }
+    std::string path = Application::get()->getSaveDirectory() + REPLAY_FILE;
+    if (replay.save(path)) {
+        CULog("Saved replay of %s to %s", replay.getLevelKey().c_str(), path.c_str());
+    }
+}
+
+bool GameScene::startReplay() {
+    std::shared_ptr<Replay> replay = Replay::load(Application::get()->getSaveDirectory() + REPLAY_FILE);
+    if (replay == nullptr) {
+        return false;
+    }
+    _levelTransition.setActive(false);
+    setTutorialActive(replay->tutorial);
+    setLevel(replay->start, replay->seed);
+    if (!_input.startReplay(replay->input)) {
+        return false;
+    }
+    _replay = replay;
+    CULog("Replaying %s", replay->getLevelKey().c_str());
+    return true;
 }
 
 /**
@@ -934,6 +864,8 @@ void GameScene::setActive(bool value){
 }
 
 void GameScene::render(const std::shared_ptr<SpriteBatch> &batch){
+    CUProfileZone("GameScene::render");
+    _renderStats = batch->getFrameStats();
     _gameRenderer.render(batch);
     _effectsScene.render(batch);
     if (_upgrades.isActive()){
@@ -21,6 +21,8 @@
 #include "../controllers/CameraController.hpp"
 #include "../controllers/InputController.hpp"
 #include "../controllers/CollisionController.hpp"
+#include "../controllers/PlayerController.hpp"
+#include "../controllers/GameplayController.hpp"
 #include "../models/LevelModel.hpp"
 #include "GameRenderer.hpp"
 #include "../utility/LevelParser.hpp"
@@ -30,6 +32,7 @@
 #include "UpgradesScene.hpp"
 #include "GestureScene.hpp"
 #include "../utility/SaveData.hpp"
+#include "../utility/Replay.hpp"
 
 /**
  * This class is the primary gameplay constroller for the demo.
@@ -71,6 +74,10 @@ protected:
     CameraController _camController;
     /** Controller for handling collisions */
     CollisionController _collisionController;
+    /** Controller turning input into player actions */
+    PlayerController _playerController;
+    /** Controller for the enemy attacks and the object updates shared with the headless runner */
+    GameplayController _gameplayController;
 
 #pragma mark Scenes
     /** custom renderer for this scene */
@@ -103,16 +110,22 @@ protected:
     std::shared_ptr<scene2::SpriteNode> _areaClearNode;
     /** the node which renders the dead effect */
     std::shared_ptr<scene2::SpriteNode> _deadEffectNode;
+    /** the debug overlay with the physics statistics */
+    std::shared_ptr<scene2::Label> _statsLabel;
+    /** the CSV file receiving the physics statistics of every step (debug mode only) */
+    std::shared_ptr<TextWriter> _statsWriter;
+    /** the sprite batch counters of the last frame drawn, for the debug overlay */
+    SpriteBatch::FrameStats _renderStats;
 
 #pragma mark Scene Animation
     /** animation manager */
     scene2::ActionManager _actionManager;
-    /** the key to the area clear effect to monitor updates */
-    const std::string AREA_CLEAR_KEY = "area_clear";
+    /** the handle of the area clear effect to monitor updates */
+    scene2::ActionManager::Handle _areaClearAction = scene2::ActionManager::NONE;
     /** the action corresponding to the area clear animation*/
     std::shared_ptr<scene2::Animate> _areaClearAnimation;
-    /** the key to the dead  effect to monitor updates */
-    const std::string DEAD_EFFECT_KEY = "dead_effect";
+    /** the handle of the dead effect to monitor updates */
+    scene2::ActionManager::Handle _deadEffectAction = scene2::ActionManager::NONE;
     /** the action corresponding to the dead effect pop-up animation*/
     std::shared_ptr<scene2::Animate> _deadEffectAnimation;
     
@@ -140,17 +153,59 @@ protected:
     bool _defeat;
     /** Whether or not debug mode is active */
     bool _debug;
-    /** a counter for the number of frames to apply a hit-pause effect (for combo hit) */
-    Counter hitPauseCounter;
     /** The screen transitioning code */
     ExitCode _exitCode;
     
+#pragma mark Recording and Replay
+    /** the seed of this session, from which the seed of each room is derived */
+    Uint64 _sessionSeed;
+    /** the number of rooms started in this session */
+    Uint64 _roomCount;
+    /** the seed of the random streams at the start of the current room */
+    Uint64 _roomSeed;
+    /** the save data the current room was started from */
+    SaveData::Data _roomStart;
+    /** the number of fixed steps since the last call to preUpdate */
+    Uint32 _fixedSteps;
+    /** whether to restart the room and record it at the end of this frame */
+    bool _recordRequested;
+    /** whether to start the saved replay at the end of this frame */
+    bool _replayRequested;
+    /** the replay being played (nullptr if not replaying) */
+    std::shared_ptr<Replay> _replay;
+    
 #pragma mark Internal Update Function Helpers
     /**
      * handles player inputs and updates relevant HUD components.
      */
     void processPlayerInput();
     
+    /**
+     * steps the camera and the physics world, and syncs the game objects with the world.
+     *
+     * @param step  the fixed time step
+     */
+    void simulate(float step);
+    
+    /**
+     * Restarts the current room (with the seed it started with) and records the input.
+     *
+     * The recording is saved when the record key is pressed again or the room ends.
+     */
+    void startRecording();
+    
+    /**
+     * Saves the input recorded since {@link #startRecording} to the save directory.
+     */
+    void saveRecording();
+    
+    /**
+     * Loads the saved recording and replays its room.
+     *
+     * @return true if the replay was started
+     */
+    bool startReplay();
+    
 public:
 #pragma mark -
 #pragma mark Constructors
@@ -205,11 +260,20 @@ public:
     /**
      * Sets whether debug mode is active.
      *
-     * If true, all objects will display their physics bodies.
+     * If true, all objects will display their physics bodies, the physics
+     * statistics are shown on screen, and each physics step is appended to
+     * the statistics CSV file in the save directory.
      *
      * @param value whether debug mode is active.
      */
-    void setDebug(bool value) { _debug = value; _level->showDebug(value); }
+    void setDebug(bool value);
+    
+    /**
+     * Returns the statistics of the most recent physics step.
+     *
+     * The statistics are only gathered in debug mode.
+     */
+    const physics2::ObstacleWorld::Stats& getPhysicsStats() const { return _level->getWorld()->getStats(); }
     
     /**
      * Returns a reference to the game renderer
@@ -383,9 +447,19 @@ public:
     
     /**
      * sets the active level to load with the given save data
+     *
+     * The random streams are seeded with the next room seed of this session.
      */
     void setLevel(SaveData::Data saveData);
     
+    /**
+     * sets the active level to load with the given save data and random seed
+     *
+     * A room started with the same data and seed plays out identically for the
+     * same inputs. Any input recording or replay in progress ends.
+     */
+    void setLevel(SaveData::Data saveData, Uint64 seed);
+    
     /**
      * returns the asset key for the given level
      */
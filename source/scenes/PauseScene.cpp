@@ -62,7 +62,7 @@ bool PauseScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
                 _choice = Choice::BACK;
                 resetPauseMenuPosition();
             }
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         }
     });
     _resume->addListener([this](const std::string& name, bool down) {
@@ -74,13 +74,13 @@ bool PauseScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             });
             _translateAction->setDuration(TRANSLATE_UP_DURATION);
             _actionManager.activate(TRANSLATE_KEY, _translateAction, _pauseMenuNode, EasingFunction::quadOut);
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         }
     });
     _settings->addListener([this](const std::string& name, bool down) {
         if (down) {
             _choice = Choice::SETTINGS;
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         }
     });
 
@@ -88,14 +88,14 @@ bool PauseScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
         if (down) {
             _confirmationScene.setActive(false);
             _confirmBack->setDown(false);
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         }
     });
     _confirmConfirm->addListener([this](const std::string& name, bool down) {
         if (down) {
             _choice = Choice::BACK;
             resetPauseMenuPosition();
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         }
     });
     
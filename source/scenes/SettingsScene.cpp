@@ -98,7 +98,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             _choice = Choice::CLOSE;
             SaveData::savePreferences(_prefs);
             //CULog("closing (settings screen)");
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         }
     });
     _volDown->addListener([this](const std::string& name, bool down) {
@@ -108,7 +108,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             std::string key = "vol_front" + (_prefs.vol == 0 ? "" : "_" + std::to_string(_prefs.vol));
             _volBar->getChildByName(key)->setVisible(false);
             //CULog("master volume down (settings screen)");
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
             AudioController::changeMasterVolume(-0.1);
             AudioController::updateMusic(AudioController::getCurrTrack(), 0);
         }
@@ -120,7 +120,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             std::string key = "vol_front" + (_prefs.vol - 1 == 0 ? "" : "_" + std::to_string(_prefs.vol - 1));
             _volBar->getChildByName(key)->setVisible(true);
             //CULog("master volume up (settings screen)");
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
             AudioController::changeMasterVolume(0.1);
             AudioController::updateMusic(AudioController::getCurrTrack(), 0);
         }
@@ -132,7 +132,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             std::string key = "vol_front" + (_prefs.SFXvol == 0 ? "" : "_" + std::to_string(_prefs.SFXvol));
             _sfxBar->getChildByName(key)->setVisible(false);
             //CULog("sfx volume down (settings screen)");
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
             AudioController::changeSFXVolume(-0.1);
         }
     });
@@ -143,7 +143,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             std::string key = "vol_front" + (_prefs.SFXvol - 1 == 0 ? "" : "_" + std::to_string(_prefs.SFXvol - 1));
             _sfxBar->getChildByName(key)->setVisible(true);
             //CULog("sfx volume up (settings screen)");
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
             AudioController::changeSFXVolume(0.1);
         }
     });
@@ -154,7 +154,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             std::string key = "vol_front" + (_prefs.BGMvol == 0 ? "" : "_" + std::to_string(_prefs.BGMvol));
             _musicBar->getChildByName(key)->setVisible(false);
             //CULog("music volume down (settings screen)");
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
             AudioController::changeBGMVolume(-0.1);
             AudioController::updateMusic(AudioController::getCurrTrack(), 0);
         }
@@ -166,7 +166,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             std::string key = "vol_front" + (_prefs.BGMvol - 1 == 0 ? "" : "_" + std::to_string(_prefs.BGMvol - 1));
             _musicBar->getChildByName(key)->setVisible(true);
             //CULog("music volume up (settings screen)");
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
             AudioController::changeBGMVolume(0.1);
             AudioController::updateMusic(AudioController::getCurrTrack(), 0);
         }
@@ -175,7 +175,7 @@ bool SettingsScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
         _choice = Choice::INVERT;
         _prefs.inverted = !_prefs.inverted;
         //CULog("swapping bow aiming mode (settings screen)");
-        AudioController::playUiFX("menuClick");
+        AudioController::play(AudioController::UI_CLICK);
     });
 
     // add an overlay layer to separate game background from UI
@@ -59,11 +59,11 @@ bool TitleScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
 
     // attach listeners
 
-    scene2::Button::Listener newGameListener = [this](std::string name, bool down){ _choice = NEW; AudioController::playUiFX("menuClick");};
-    scene2::Button::Listener newGame2Listener = [this](std::string name, bool down){ _confirmationScene.setActive(true); _newGame2->setDown(false); AudioController::playUiFX("menuClick");};
-    auto tutorialListener = [this](std::string name, bool down){ _choice = TUTORIAL; AudioController::playUiFX("menuClick"); };
-    auto settingsListener = [this](std::string name, bool down){ _choice = SETTINGS; AudioController::playUiFX("menuClick"); };
-    auto continueListener = [this](std::string name, bool down){ _choice = CONTINUE; AudioController::playUiFX("menuClick"); };
+    scene2::Button::Listener newGameListener = [this](std::string name, bool down){ _choice = NEW; AudioController::play(AudioController::UI_CLICK);};
+    scene2::Button::Listener newGame2Listener = [this](std::string name, bool down){ _confirmationScene.setActive(true); _newGame2->setDown(false); AudioController::play(AudioController::UI_CLICK);};
+    auto tutorialListener = [this](std::string name, bool down){ _choice = TUTORIAL; AudioController::play(AudioController::UI_CLICK); };
+    auto settingsListener = [this](std::string name, bool down){ _choice = SETTINGS; AudioController::play(AudioController::UI_CLICK); };
+    auto continueListener = [this](std::string name, bool down){ _choice = CONTINUE; AudioController::play(AudioController::UI_CLICK); };
     auto backListener = [this](std::string name, bool down){ _confirmationScene.setActive(false); _back2->setDown(false);};
     
     _newGame->addListener(newGameListener);
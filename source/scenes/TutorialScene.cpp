@@ -46,14 +46,14 @@ bool TutorialScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     _screenshotParry = assets->get<Texture>("screenshotParry");
     
     // attach listeners
-    auto backListener = [this](std::string name, bool down){ _choice = BACK; _selectedLevel=1; AudioController::playUiFX("menuClick");};
+    auto backListener = [this](std::string name, bool down){ _choice = BACK; _selectedLevel=1; AudioController::play(AudioController::UI_CLICK);};
     //if user exits tutorial screen, reset to first option
-    auto playListener = [this](std::string name, bool down){ _choice = LEVEL; AudioController::playUiFX("menuClick");};
+    auto playListener = [this](std::string name, bool down){ _choice = LEVEL; AudioController::play(AudioController::UI_CLICK);};
     //if they play a level, same level should be selected
     auto level1Listener = [this](std::string name, bool down){
         if (down) {
             if (_selectedLevel!=1) {
-                AudioController::playUiFX("menuClick");
+                AudioController::play(AudioController::UI_CLICK);
                 _selectedLevel = 1;
             }
             
@@ -69,7 +69,7 @@ bool TutorialScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     auto level2Listener = [this](std::string name, bool down){
         if (down) {
             if (_selectedLevel!=2) {
-                AudioController::playUiFX("menuClick");
+                AudioController::play(AudioController::UI_CLICK);
                 _selectedLevel = 2;
             }
             
@@ -85,7 +85,7 @@ bool TutorialScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     auto level3Listener = [this](std::string name, bool down){
         if (down) {
             if (_selectedLevel!=3) {
-                AudioController::playUiFX("menuClick");
+                AudioController::play(AudioController::UI_CLICK);
                 _selectedLevel = 3;
             }
 
@@ -101,7 +101,7 @@ bool TutorialScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     auto level4Listener = [this](std::string name, bool down){
         if (down) {
             if (_selectedLevel!=4) {
-                AudioController::playUiFX("menuClick");
+                AudioController::play(AudioController::UI_CLICK);
                 _selectedLevel = 4;
             }
 
@@ -80,12 +80,16 @@ bool UpgradesScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
     _confirm1->setVisible(false);
     _confirm2->setVisible(false);
     
+    // the choice cards only change when an option is displayed, so they are drawn cached
+    _option1->setCached(true);
+    _option2->setCached(true);
+    
     _confirm1->addListener([this](const std::string& name, bool down) {
         if (down) {
             _upgrade = _displayedAttribute1.first;
             _level = _displayedAttribute1.second;
             _selectedUpgrade = true;
-            AudioController::playUiFX("upgrade");
+            AudioController::play(AudioController::UI_UPGRADE);
         }
     });
     _confirm2->addListener([this](const std::string& name, bool down) {
@@ -93,7 +97,7 @@ bool UpgradesScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             _upgrade = _displayedAttribute2.first;
             _level = _displayedAttribute2.second;
             _selectedUpgrade = true;
-            AudioController::playUiFX("upgrade");
+            AudioController::play(AudioController::UI_UPGRADE);
         }
     });
     
@@ -108,7 +112,7 @@ bool UpgradesScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             _option1->setToggle(true);
             _confirm1->setVisible(true);
             _confirm1->activate();
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         } else{
             _confirm1->setVisible(false);
             _confirm1->deactivate();
@@ -124,7 +128,7 @@ bool UpgradesScene::init(const std::shared_ptr<cugl::AssetManager>& assets) {
             _option2->setToggle(true);
             _confirm2->setVisible(true);
             _confirm2->activate();
-            AudioController::playUiFX("menuClick");
+            AudioController::play(AudioController::UI_CLICK);
         } else{
             _confirm2->setVisible(false);
             _confirm2->deactivate();
@@ -34,10 +34,10 @@ bool WinScene::init(const std::shared_ptr<cugl::AssetManager> &assets){
     _main = std::dynamic_pointer_cast<scene2::Button>(_assets->get<scene2::SceneNode>("win_dead_selection_main_menu"));
     // program the buttons
     _restart->addListener([this](const std::string& name, bool down) {
-        if (down) { _choice = Choice::RESTART; AudioController::playUiFX("menuClick");}
+        if (down) { _choice = Choice::RESTART; AudioController::play(AudioController::UI_CLICK);}
     });
     _main->addListener([this](const std::string& name, bool down) {
-        if (down) { _choice = Choice::MAIN_MENU; AudioController::playUiFX("menuClick");}
+        if (down) { _choice = Choice::MAIN_MENU; AudioController::play(AudioController::UI_CLICK);}
     });
     
     addChild(scene);
@@ -0,0 +1,259 @@
+//
+//  AllocationTracker.cpp
+//  RS
+//
+//  Version: 10/18/26
+//
+
+#include "AllocationTracker.hpp"
+#include <cugl/util/CUProfiler.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+/** The number of profile zones that can be told apart in a frame */
+#define MAX_SITES   128
+/** The site of allocations outside any profile zone */
+#define NO_ZONE     "(no zone)"
+
+#pragma mark -
+#pragma mark Counters
+
+// These are all constant initialized, so they work for allocations before main
+
+/** The counts since the program started */
+static std::atomic<Uint64> totalAllocs(0);
+static std::atomic<Uint64> totalBytes(0);
+static std::atomic<Uint64> totalFrees(0);
+/** The counts of the current frame */
+static std::atomic<Uint64> frameAllocs(0);
+static std::atomic<Uint64> frameBytes(0);
+static std::atomic<Uint64> frameFrees(0);
+/** The counts of the last complete frame */
+static std::atomic<Uint64> lastAllocs(0);
+static std::atomic<Uint64> lastBytes(0);
+static std::atomic<Uint64> lastFrees(0);
+/** The number of open Ignore scopes on this thread */
+static thread_local int ignoreDepth = 0;
+
+#if CU_PROFILING
+/** The allocations of a profile zone in the current frame */
+struct SiteSlot {
+    /** the zone name (never changes once set) */
+    std::atomic<const char*> name;
+    /** the number of allocations */
+    std::atomic<Uint64> allocs;
+    /** the number of bytes allocated */
+    std::atomic<Uint64> bytes;
+};
+
+/** The open-addressed table of sites, keyed by the zone name pointer */
+static SiteSlot siteSlots[MAX_SITES];
+/** The sites of the last complete frame, most allocations first */
+static AllocationTracker::Site lastSites[MAX_SITES];
+/** The number of sites of the last complete frame */
+static size_t lastSiteCount = 0;
+/** The lock for the last frame sites */
+static std::mutex siteMutex;
+
+/**
+ * Returns the slot of the given zone, claiming a free one if necessary.
+ *
+ * @return the slot of the given zone (or nullptr if the table is full)
+ */
+static SiteSlot* findSite(const char* name) {
+    size_t hash = (size_t)((reinterpret_cast<uintptr_t>(name) >> 3) * 2654435761u);
+    for (size_t probe = 0; probe < MAX_SITES; probe++) {
+        SiteSlot* slot = siteSlots + (hash+probe) % MAX_SITES;
+        const char* current = slot->name.load(std::memory_order_acquire);
+        if (current == name) {
+            return slot;
+        }
+        if (current == nullptr) {
+            if (slot->name.compare_exchange_strong(current, name, std::memory_order_acq_rel) || current == name) {
+                return slot;
+            }
+        }
+    }
+    return nullptr;
+}
+#endif
+
+#pragma mark -
+#pragma mark Allocation Hooks
+
+// Aligned allocations (C++17 align_val_t) keep the library versions and are not counted
+
+void* operator new(std::size_t size) {
+    AllocationTracker::recordAlloc(size);
+    void* ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    AllocationTracker::recordAlloc(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        AllocationTracker::recordFree();
+        std::free(ptr);
+    }
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t size) noexcept {
+    operator delete(ptr);
+}
+
+#pragma mark -
+#pragma mark Tracking
+
+AllocationTracker::Ignore::Ignore() {
+    ignoreDepth++;
+}
+
+AllocationTracker::Ignore::~Ignore() {
+    ignoreDepth--;
+}
+
+void AllocationTracker::recordAlloc(size_t size) {
+    if (ignoreDepth > 0) {
+        return;
+    }
+    totalAllocs.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(size, std::memory_order_relaxed);
+    frameAllocs.fetch_add(1, std::memory_order_relaxed);
+    frameBytes.fetch_add(size, std::memory_order_relaxed);
+#if CU_PROFILING
+    const char* zone = cugl::Profiler::getCurrentZone();
+    SiteSlot* slot = findSite(zone == nullptr ? NO_ZONE : zone);
+    if (slot != nullptr) {
+        slot->allocs.fetch_add(1, std::memory_order_relaxed);
+        slot->bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+#endif
+}
+
+void AllocationTracker::recordFree() {
+    if (ignoreDepth > 0) {
+        return;
+    }
+    totalFrees.fetch_add(1, std::memory_order_relaxed);
+    frameFrees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationTracker::endFrame() {
+    lastAllocs = frameAllocs.exchange(0, std::memory_order_relaxed);
+    lastBytes = frameBytes.exchange(0, std::memory_order_relaxed);
+    lastFrees = frameFrees.exchange(0, std::memory_order_relaxed);
+#if CU_PROFILING
+    std::lock_guard<std::mutex> lock(siteMutex);
+    lastSiteCount = 0;
+    for (size_t ii = 0; ii < MAX_SITES; ii++) {
+        const char* name = siteSlots[ii].name.load(std::memory_order_acquire);
+        if (name == nullptr) {
+            continue;
+        }
+        Uint64 allocs = siteSlots[ii].allocs.exchange(0, std::memory_order_relaxed);
+        Uint64 bytes = siteSlots[ii].bytes.exchange(0, std::memory_order_relaxed);
+        if (allocs > 0) {
+            Site& site = lastSites[lastSiteCount++];
+            site.name = name;
+            site.allocs = allocs;
+            site.bytes = bytes;
+        }
+    }
+    std::sort(lastSites, lastSites+lastSiteCount, [](const Site& a, const Site& b) {
+        return a.allocs > b.allocs;
+    });
+#endif
+}
+
+#pragma mark -
+#pragma mark Accessors
+
+AllocationTracker::Counters AllocationTracker::getTotals() {
+    Counters result;
+    result.allocs = totalAllocs.load(std::memory_order_relaxed);
+    result.bytes = totalBytes.load(std::memory_order_relaxed);
+    result.frees = totalFrees.load(std::memory_order_relaxed);
+    return result;
+}
+
+AllocationTracker::Counters AllocationTracker::getCurrentFrame() {
+    Counters result;
+    result.allocs = frameAllocs.load(std::memory_order_relaxed);
+    result.bytes = frameBytes.load(std::memory_order_relaxed);
+    result.frees = frameFrees.load(std::memory_order_relaxed);
+    return result;
+}
+
+AllocationTracker::Counters AllocationTracker::getLastFrame() {
+    Counters result;
+    result.allocs = lastAllocs.load(std::memory_order_relaxed);
+    result.bytes = lastBytes.load(std::memory_order_relaxed);
+    result.frees = lastFrees.load(std::memory_order_relaxed);
+    return result;
+}
+
+bool AllocationTracker::hasSites() {
+    return CU_PROFILING;
+}
+
+size_t AllocationTracker::getLastFrameSites(Site* sites, size_t max) {
+#if CU_PROFILING
+    std::lock_guard<std::mutex> lock(siteMutex);
+    size_t count = std::min(max, lastSiteCount);
+    std::copy(lastSites, lastSites+count, sites);
+    return count;
+#else
+    return 0;
+#endif
+}
+
+std::string AllocationTracker::getFrameReport(size_t maxSites) {
+    char buffer[256];
+    Counters frame = getLastFrame();
+    snprintf(buffer, sizeof(buffer), "allocs %llu (%llu bytes), frees %llu",
+             (unsigned long long)frame.allocs, (unsigned long long)frame.bytes, (unsigned long long)frame.frees);
+    std::string result = buffer;
+    Site sites[MAX_SITES];
+    size_t count = getLastFrameSites(sites, std::min<size_t>(maxSites, MAX_SITES));
+    for (size_t ii = 0; ii < count; ii++) {
+        snprintf(buffer, sizeof(buffer), "\n  %-36s %6llu %9llu B", sites[ii].name,
+                 (unsigned long long)sites[ii].allocs, (unsigned long long)sites[ii].bytes);
+        result += buffer;
+    }
+    return result;
+}
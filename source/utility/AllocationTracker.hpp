@@ -0,0 +1,140 @@
+//
+//  AllocationTracker.hpp
+//  RS
+//
+//  Counts the heap allocations of the game. This file replaces the global operator
+//  new and delete, so every allocation made through them (on any thread) is counted.
+//  The counts are split into frames by endFrame, which the App calls once per frame
+//  (and the headless runner once per simulated frame), so the debug overlay can show
+//  how much the last frame allocated.
+//
+//  In profiling builds (see CUProfiler.h), each allocation is also attributed to the
+//  innermost profile zone open on its thread. This is the call site of the allocation
+//  at the granularity of the zones, which is enough to find the code responsible.
+//  Add a CUProfileZone to narrow a site down.
+//
+//  Version: 10/18/26
+//
+
+#ifndef AllocationTracker_hpp
+#define AllocationTracker_hpp
+
+#include <cugl/cugl.h>
+#include <string>
+
+/**
+ a static class counting the heap allocations of every frame
+ */
+class AllocationTracker {
+public:
+    /** The allocation counts of a period */
+    struct Counters {
+        /** the number of allocations */
+        Uint64 allocs = 0;
+        /** the number of bytes allocated */
+        Uint64 bytes = 0;
+        /** the number of deallocations */
+        Uint64 frees = 0;
+    };
+
+    /** The allocations of a profile zone in the last frame */
+    struct Site {
+        /** the zone name ("(no zone)" for allocations outside any zone) */
+        const char* name = nullptr;
+        /** the number of allocations */
+        Uint64 allocs = 0;
+        /** the number of bytes allocated */
+        Uint64 bytes = 0;
+    };
+
+    /**
+     * Excludes the allocations of the calling thread while in scope.
+     *
+     * Use this for diagnostics, such as the debug overlay, so that they do
+     * not show up in the counts they display.
+     */
+    class Ignore {
+    public:
+        /** Starts ignoring the allocations of the calling thread */
+        Ignore();
+        /** Stops ignoring the allocations of the calling thread */
+        ~Ignore();
+        Ignore(const Ignore&) = delete;
+        Ignore& operator=(const Ignore&) = delete;
+    };
+
+private:
+    /** prevents allocation of this class */
+    AllocationTracker(){}
+
+public:
+    /**
+     * Records an allocation of the given size.
+     *
+     * This is called by the allocation hooks, and must not allocate.
+     *
+     * @param size  the number of bytes allocated
+     */
+    static void recordAlloc(size_t size);
+
+    /**
+     * Records a deallocation.
+     *
+     * This is called by the allocation hooks, and must not allocate.
+     */
+    static void recordFree();
+
+    /**
+     * Ends the current frame.
+     *
+     * The counts of the frame become the last frame counts, and the counts
+     * of a new frame start at zero.
+     */
+    static void endFrame();
+
+    /**
+     * @return the counts since the program started
+     */
+    static Counters getTotals();
+
+    /**
+     * @return the counts of the current (incomplete) frame
+     */
+    static Counters getCurrentFrame();
+
+    /**
+     * @return the counts of the last complete frame
+     */
+    static Counters getLastFrame();
+
+    /**
+     * Returns true if allocations are attributed to profile zones.
+     *
+     * @return true if allocations are attributed to profile zones.
+     */
+    static bool hasSites();
+
+    /**
+     * Copies the sites of the last complete frame, most allocations first.
+     *
+     * @param sites the array to copy into
+     * @param max   the size of the array
+     *
+     * @return the number of sites copied
+     */
+    static size_t getLastFrameSites(Site* sites, size_t max);
+
+    /**
+     * Returns a text summary of the last complete frame.
+     *
+     * The summary lists the counts of the frame, followed by the sites with
+     * the most allocations (in profiling builds).
+     *
+     * @param maxSites  the maximum number of sites to list
+     *
+     * @return a text summary of the last complete frame.
+     */
+    static std::string getFrameReport(size_t maxSites = 6);
+};
+
+#endif /* AllocationTracker_hpp */
@@ -0,0 +1,79 @@
+//
+//  FrameArena.cpp
+//  RS
+//
+//  Version: 10/18/26
+//
+
+#include "FrameArena.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+/** The initial size of the arena in bytes */
+#define FRAME_ARENA_CAPACITY    (64*1024)
+/** The number of overflow allocations a frame can hold without growing the list */
+#define FRAME_ARENA_OVERFLOWS   16
+
+std::byte* FrameArena::_memory = nullptr;
+size_t FrameArena::_capacity = 0;
+size_t FrameArena::_used = 0;
+std::vector<void*> FrameArena::_overflow;
+size_t FrameArena::_overflowBytes = 0;
+size_t FrameArena::_highWater = 0;
+size_t FrameArena::_lastUsed = 0;
+
+void* FrameArena::alloc(size_t size, size_t align){
+    if (_memory == nullptr){
+        _capacity = FRAME_ARENA_CAPACITY;
+        _memory = static_cast<std::byte*>(std::malloc(_capacity));
+        _overflow.reserve(FRAME_ARENA_OVERFLOWS);
+    }
+    size_t start = (_used + align - 1) & ~(align - 1);
+    if (start + size <= _capacity){
+        _used = start + size;
+        return _memory + start;
+    }
+    // malloc aligns to max_align_t, which covers every type in the game
+    void* block = std::malloc(size ? size : 1);
+    if (block == nullptr){
+        throw std::bad_alloc();
+    }
+    _overflow.push_back(block);
+    _overflowBytes += size;
+    return block;
+}
+
+void FrameArena::reset(){
+    _lastUsed = _used + _overflowBytes;
+    _highWater = std::max(_highWater, _lastUsed);
+    if (!_overflow.empty()){
+        for (void* block : _overflow){
+            std::free(block);
+        }
+        _overflow.clear();
+        // grow with room to spare, so the arena settles after a few frames
+        std::free(_memory);
+        _capacity = std::max(2*_capacity, _highWater + _highWater/2);
+        _memory = static_cast<std::byte*>(std::malloc(_capacity));
+        CULog("Frame arena grown to %zu bytes", _capacity);
+    }
+    _used = 0;
+    _overflowBytes = 0;
+}
+
+void FrameArena::dispose(){
+    reset();
+    std::free(_memory);
+    _memory = nullptr;
+    _capacity = 0;
+    _highWater = 0;
+    _lastUsed = 0;
+}
+
+std::string FrameArena::getReport(){
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "frame arena %zu KB of %zu KB (peak %zu KB)",
+             _lastUsed/1024, _capacity/1024, _highWater/1024);
+    return buffer;
+}
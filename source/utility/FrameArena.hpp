@@ -0,0 +1,167 @@
+//
+//  FrameArena.hpp
+//  RS
+//
+//  A linear (bump) allocator for data that does not outlive a frame. Allocating is a
+//  pointer increment and nothing is freed individually; the whole arena is released at
+//  once by reset, which GameScene calls at the top of preUpdate. A Scope releases the
+//  allocations made within it early, so a helper can use scratch space without holding
+//  on to it for the rest of the frame.
+//
+//  FrameAllocator adapts the arena to the standard containers. Reserve the capacity up
+//  front, as a growing container leaves its old buffers in the arena until the reset.
+//
+//  The arena belongs to the main thread. AIController::update keeps the decisions of a
+//  frame in it (the workers only fill in the elements), but the path searches of the
+//  workers keep their own scratch (see AIController::moveToGoal).
+//
+//  Version: 10/18/26
+//
+
+#ifndef FrameArena_hpp
+#define FrameArena_hpp
+
+#include <cugl/cugl.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ a static class holding the per-frame linear allocator
+ */
+class FrameArena {
+public:
+    /**
+     * A scope of scratch allocations.
+     *
+     * The allocations made while the scope is open are released when it closes.
+     * Scopes may nest, but must close in the reverse order they were opened.
+     */
+    class Scope {
+    private:
+        /** the number of arena bytes in use when the scope opened */
+        size_t _mark;
+
+    public:
+        Scope() : _mark(FrameArena::_used) {}
+        ~Scope() { FrameArena::rewind(_mark); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+private:
+    /** prevents allocation of this class */
+    FrameArena(){}
+
+    /** the memory of the arena */
+    static std::byte* _memory;
+    /** the size of the memory in bytes */
+    static size_t _capacity;
+    /** the number of bytes in use this frame */
+    static size_t _used;
+    /** the allocations that did not fit this frame, released by the next reset */
+    static std::vector<void*> _overflow;
+    /** the number of bytes of the overflow allocations */
+    static size_t _overflowBytes;
+    /** the most bytes used in a single frame */
+    static size_t _highWater;
+    /** the number of bytes used in the last frame */
+    static size_t _lastUsed;
+
+    /**
+     * Releases every allocation made after the given mark.
+     *
+     * Overflow allocations are kept until the next reset.
+     *
+     * @param mark  the number of arena bytes in use to return to
+     */
+    static void rewind(size_t mark) { _used = mark < _used ? mark : _used; }
+
+public:
+    /**
+     * Returns a block of the given size from the arena.
+     *
+     * The block is valid until the next reset (or until the enclosing scope
+     * closes). If the arena is full, the block comes from the heap instead
+     * and the next reset grows the arena.
+     *
+     * @param size  the size of the block in bytes
+     * @param align the alignment of the block (a power of two)
+     *
+     * @return a block of the given size from the arena
+     */
+    static void* alloc(size_t size, size_t align = alignof(std::max_align_t));
+
+    /**
+     * Releases every allocation of the frame.
+     *
+     * If the frame overflowed the arena, the arena grows to fit it. This is
+     * the only time the arena allocates from the heap after the first frame.
+     */
+    static void reset();
+
+    /**
+     * Releases the memory of the arena.
+     */
+    static void dispose();
+
+    /**
+     * @return the size of the arena in bytes
+     */
+    static size_t getCapacity() { return _capacity; }
+
+    /**
+     * @return the number of bytes allocated so far this frame
+     */
+    static size_t getUsed() { return _used+_overflowBytes; }
+
+    /**
+     * @return the number of bytes allocated in the last frame
+     */
+    static size_t getLastUsed() { return _lastUsed; }
+
+    /**
+     * @return the most bytes allocated in a single frame
+     */
+    static size_t getHighWater() { return _highWater; }
+
+    /**
+     * Returns the arena usage as a line of text for the debug overlay.
+     *
+     * @return the arena usage as a line of text for the debug overlay
+     */
+    static std::string getReport();
+};
+
+/**
+ * An allocator drawing from the frame arena, for the standard containers.
+ *
+ * Deallocation does nothing, since the arena is released all at once.
+ */
+template <typename T>
+class FrameAllocator {
+public:
+    typedef T value_type;
+
+    FrameAllocator() noexcept {}
+
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(FrameArena::alloc(n*sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) { return false; }
+
+/** a vector whose storage lives in the frame arena */
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif /* FrameArena_hpp */
@@ -0,0 +1,34 @@
+//
+//  GameRandom.cpp
+//  RS
+//
+//  Version: 10/18/26
+//
+
+#include "GameRandom.hpp"
+#include <chrono>
+
+Uint64 GameRandom::_seed = 0;
+std::mt19937 GameRandom::_streams[GameRandom::COUNT];
+
+void GameRandom::seed(Uint64 seed){
+    _seed = seed;
+    for (int ii = 0; ii < COUNT; ii++){
+        std::seed_seq seq{(Uint32)seed, (Uint32)(seed >> 32), (Uint32)ii};
+        _streams[ii].seed(seq);
+    }
+}
+
+Uint64 GameRandom::mix(Uint64 seed, Uint64 salt){
+    // splitmix64 finalizer
+    Uint64 z = seed + 0x9e3779b97f4a7c15ULL*(salt+1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+Uint64 GameRandom::makeSeed(){
+    Uint64 time = (Uint64)std::chrono::system_clock::now().time_since_epoch().count();
+    Uint64 device = std::random_device()();
+    return mix(time, device);
+}
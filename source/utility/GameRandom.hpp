@@ -0,0 +1,118 @@
+//
+//  GameRandom.hpp
+//  RS
+//
+//  The seeded random streams of the game. Each system draws from its own stream, so
+//  that (for example) an extra sound effect cannot change the upgrades that are offered.
+//  Reseeding all streams at the start of a room makes the room repeatable, which is
+//  what input replays rely on.
+//
+//  The streams avoid the standard distributions, whose output is implementation
+//  defined, so a seed gives the same numbers on every platform.
+//
+//  Version: 10/18/26
+//
+
+#ifndef GameRandom_hpp
+#define GameRandom_hpp
+
+#include <cugl/cugl.h>
+#include <random>
+
+/**
+ a static class holding the random streams of each game system
+ */
+class GameRandom {
+public:
+    /** The independent random streams */
+    enum Stream {
+        /** the randomized layers of a level */
+        LEVEL = 0,
+        /** the seeds of the enemy decision streams */
+        AI,
+        /** combat outcomes, such as health pack drops */
+        COMBAT,
+        /** the upgrades offered in upgrade rooms */
+        UPGRADES,
+        /** sound effect variations (never affects gameplay) */
+        AUDIO,
+        /** the number of streams */
+        COUNT
+    };
+
+private:
+    /** prevents allocation of this class */
+    GameRandom(){}
+
+    /** the seed of the streams */
+    static Uint64 _seed;
+    /** the generator of each stream */
+    static std::mt19937 _streams[COUNT];
+
+public:
+    /**
+     * Reseeds every stream from the given seed.
+     *
+     * Each stream is seeded with the seed and its own index, so the streams
+     * are independent of each other.
+     *
+     * @param seed  the seed of the streams
+     */
+    static void seed(Uint64 seed);
+
+    /**
+     * @return the seed of the streams
+     */
+    static Uint64 getSeed() { return _seed; }
+
+    /**
+     * Returns a seed combining the given seed with a salt.
+     *
+     * This is used to derive the seed of a room from the seed of a session.
+     *
+     * @param seed  the base seed
+     * @param salt  the value to mix into the seed
+     *
+     * @return a seed combining the given seed with a salt.
+     */
+    static Uint64 mix(Uint64 seed, Uint64 salt);
+
+    /**
+     * @return a seed from the system clock and entropy source
+     */
+    static Uint64 makeSeed();
+
+    /**
+     * @return a uniformly random 32-bit value from the given stream
+     */
+    static Uint32 next(Stream stream) { return _streams[stream](); }
+    /**
+     * Returns the next value of the given stream, without drawing it.
+     *
+     * Two streams with the same next value are at the same position, so this
+     * compares the draws of two runs. It copies the generator, so it is slow.
+     *
+     * @return the next value of the given stream
+     */
+    static Uint32 peek(Stream stream) {
+        std::mt19937 copy = _streams[stream];
+        return copy();
+    }
+
+    /**
+     * @return a random integer in [0, n) from the given stream
+     */
+    static int nextInt(Stream stream, int n) {
+        return n <= 0 ? 0 : (int)(_streams[stream]() % (Uint32)n);
+    }
+
+    /**
+     * @return a random float in [0, 1) from the given stream
+     */
+    static float nextFloat(Stream stream) {
+        // 24 bits fill the float mantissa exactly
+        return (_streams[stream]() >> 8) * (1.0f/16777216.0f);
+    }
+};
+
+#endif /* GameRandom_hpp */
@@ -0,0 +1,176 @@
+//
+//  Replay.cpp
+//  RS
+//
+//  Version: 10/18/26
+//
+
+#include "Replay.hpp"
+#include "../models/LevelModel.hpp"
+#include "../models/Player.hpp"
+#include "../models/Enemy.hpp"
+#include <cugl/physics2/net/CULWSerializer.h>
+#include <cugl/physics2/net/CULWDeserializer.h>
+
+/** Identifies a replay file ("RSRP") */
+#define REPLAY_MAGIC    0x52535250
+/** The version of the replay format */
+#define REPLAY_VERSION  3
+/** The bytes of the file size, magic, version and header size */
+#define REPLAY_PREFIX   16
+/** The bytes of a replay header without the end state */
+#define REPLAY_HEADER   91
+/** The number of values in the state of the player or of an enemy */
+#define STATE_SIZE      3
+
+using namespace cugl;
+using namespace cugl::physics2::net;
+
+std::string Replay::getLevelKey() const {
+    if (start.isUpgradeRoom){
+        return "upgrades";
+    }
+    return (tutorial ? "tutorial" : "level") + std::to_string(start.level);
+}
+
+bool Replay::save(const std::string file) const {
+    // [file size][magic][version][header size][header fields][input frames]
+    Uint32 header = REPLAY_HEADER + (Uint32)(end.size()*sizeof(float));
+    LWSerializer serializer;
+    serializer.writeUint32(0);
+    serializer.writeUint32(REPLAY_MAGIC);
+    serializer.writeUint32(REPLAY_VERSION);
+    serializer.writeUint32(header);
+    serializer.writeUint64(seed);
+    serializer.writeFloat(step);
+    serializer.writeBool(tutorial);
+    serializer.writeSint32(start.level);
+    serializer.writeFloat(start.hp);
+    serializer.writeSint32(start.weapon);
+    serializer.writeSint32(start.hpLvl);
+    serializer.writeSint32(start.atkLvl);
+    serializer.writeSint32(start.atkSpLvl);
+    serializer.writeSint32(start.rangedLvl);
+    serializer.writeSint32(start.defLvl);
+    serializer.writeSint32(start.parryLvl);
+    serializer.writeSint32(start.dashLvl);
+    serializer.writeBool(start.isUpgradeRoom);
+    serializer.writeBool(start.upgradeAvailable);
+    serializer.writeSint32(start.upgradeOpt1);
+    serializer.writeSint32(start.upgradeOpt1Level);
+    serializer.writeSint32(start.upgradeOpt2);
+    serializer.writeSint32(start.upgradeOpt2Level);
+    serializer.writeUint32((Uint32)end.size());
+    for (float value : end){
+        serializer.writeFloat(value);
+    }
+    CUAssertLog(serializer.serialize().size() == header, "Replay header is %zu bytes, not %u",
+                serializer.serialize().size(), header);
+    serializer.writeByteVector(input);
+    serializer.rewriteFirstUint32((Uint32)serializer.serialize().size());
+
+    std::shared_ptr<BinaryWriter> writer = BinaryWriter::alloc(file);
+    if (writer == nullptr){
+        return false;
+    }
+    const std::vector<std::byte>& data = serializer.serialize();
+    writer->write(reinterpret_cast<const Uint8*>(data.data()), data.size());
+    writer->close();
+    return true;
+}
+
+std::shared_ptr<Replay> Replay::load(const std::string file){
+    std::shared_ptr<BinaryReader> reader = BinaryReader::alloc(file);
+    if (reader == nullptr){
+        return nullptr;
+    }
+    std::vector<std::byte> data;
+    Uint8 buffer[4096];
+    while (reader->ready()){
+        size_t amount = reader->read(buffer, sizeof(buffer));
+        const std::byte* bytes = reinterpret_cast<const std::byte*>(buffer);
+        data.insert(data.end(), bytes, bytes+amount);
+    }
+    reader->close();
+
+    // the deserializer does not check that a value fits, so the sizes are checked first
+    if (data.size() < REPLAY_PREFIX){
+        CULogError("'%s' is not a replay", file.c_str());
+        return nullptr;
+    }
+    LWDeserializer deserializer;
+    deserializer.receive(data);
+    Uint32 size = deserializer.readUint32();
+    Uint32 magic = deserializer.readUint32();
+    Uint32 version = deserializer.readUint32();
+    Uint32 header = deserializer.readUint32();
+    if (size != data.size() || magic != REPLAY_MAGIC || version != REPLAY_VERSION ||
+        header < REPLAY_HEADER || header > size || (header-REPLAY_HEADER) % sizeof(float) != 0){
+        CULogError("'%s' is not a replay", file.c_str());
+        return nullptr;
+    }
+    std::shared_ptr<Replay> replay = std::make_shared<Replay>();
+    replay->seed = deserializer.readUint64();
+    replay->step = deserializer.readFloat();
+    replay->tutorial = deserializer.readBool();
+    replay->start.level = deserializer.readSint32();
+    replay->start.hp = deserializer.readFloat();
+    replay->start.weapon = deserializer.readSint32();
+    replay->start.hpLvl = deserializer.readSint32();
+    replay->start.atkLvl = deserializer.readSint32();
+    replay->start.atkSpLvl = deserializer.readSint32();
+    replay->start.rangedLvl = deserializer.readSint32();
+    replay->start.defLvl = deserializer.readSint32();
+    replay->start.parryLvl = deserializer.readSint32();
+    replay->start.dashLvl = deserializer.readSint32();
+    replay->start.isUpgradeRoom = deserializer.readBool();
+    replay->start.upgradeAvailable = deserializer.readBool();
+    replay->start.upgradeOpt1 = deserializer.readSint32();
+    replay->start.upgradeOpt1Level = deserializer.readSint32();
+    replay->start.upgradeOpt2 = deserializer.readSint32();
+    replay->start.upgradeOpt2Level = deserializer.readSint32();
+    Uint32 count = deserializer.readUint32();
+    if (count != (header-REPLAY_HEADER)/sizeof(float)){
+        CULogError("'%s' is not a replay", file.c_str());
+        return nullptr;
+    }
+    replay->end.reserve(count);
+    for (Uint32 ii = 0; ii < count; ii++){
+        replay->end.push_back(deserializer.readFloat());
+    }
+    replay->input.assign(data.begin()+header, data.end());
+    return replay;
+}
+
+std::vector<float> Replay::getState(const std::shared_ptr<LevelModel>& level){
+    std::vector<float> state;
+    auto player = level->getPlayer();
+    state.push_back(player->getPosition().x);
+    state.push_back(player->getPosition().y);
+    state.push_back(player->getHP());
+    for (auto& enemy : level->getEnemies()){
+        state.push_back(enemy->getPosition().x);
+        state.push_back(enemy->getPosition().y);
+        state.push_back(enemy->getHealth());
+    }
+    return state;
+}
+
+std::string Replay::compareState(const std::vector<float>& expected, const std::vector<float>& actual){
+    if (expected.size() != actual.size()){
+        return "expected " + std::to_string(expected.size()/STATE_SIZE-1) + " enemies, found " + std::to_string(actual.size()/STATE_SIZE-1);
+    }
+    static const char* FIELDS[STATE_SIZE] = {"x", "y", "health"};
+    for (size_t ii = 0; ii < expected.size(); ii++){
+        if (expected[ii] != actual[ii]){
+            size_t index = ii/STATE_SIZE;
+            std::string name = index == 0 ? "player" : "enemy " + std::to_string(index-1);
+            // enough digits to tell any two floats apart
+            char buffer[128];
+            snprintf(buffer, sizeof(buffer), "%s %s is %.9g, expected %.9g",
+                     name.c_str(), FIELDS[ii % STATE_SIZE], actual[ii], expected[ii]);
+            return buffer;
+        }
+    }
+    return "";
+}
@@ -0,0 +1,89 @@
+//
+//  Replay.hpp
+//  RS
+//
+//  A recorded room. A replay holds the seed of the random streams, the save data the
+//  room was started from and the recorded input frames. Starting the room from the
+//  same data and seed and feeding it the same inputs repeats the session exactly
+//  (on the same build), so a replay can reproduce a slow frame under the profiler or
+//  in the headless runner. The state of the player and the enemies at the end of the
+//  recording is saved too, so that both can check that the replay ended the same way.
+//
+//  Version: 10/18/26
+//
+
+#ifndef Replay_hpp
+#define Replay_hpp
+
+#include <cugl/cugl.h>
+#include "SaveData.hpp"
+
+class LevelModel;
+
+/**
+ a recorded room that can be saved to and loaded from a file
+ */
+class Replay {
+public:
+    /** the seed of the random streams when the room started */
+    Uint64 seed = 0;
+    /** the fixed time step of the physics world, in seconds */
+    float step = 1.0f/60.0f;
+    /** whether the room is a tutorial level */
+    bool tutorial = false;
+    /** the save data the room was started from */
+    SaveData::Data start;
+    /** the input frames recorded by the InputController */
+    std::vector<std::byte> input;
+    /** the state of the room when the recording ended (see getState) */
+    std::vector<float> end;
+
+    /**
+     * @return the key of the room's level in assets.json
+     */
+    std::string getLevelKey() const;
+
+    /**
+     * Writes this replay to the given file.
+     *
+     * @param file  the path of the file
+     *
+     * @return true if the file was written
+     */
+    bool save(const std::string file) const;
+
+    /**
+     * Returns the replay read from the given file.
+     *
+     * @param file  the path of the file
+     *
+     * @return the replay read from the given file (or nullptr if it is not a replay)
+     */
+    static std::shared_ptr<Replay> load(const std::string file);
+
+    /**
+     * Returns the state of the player and the enemies of the given level.
+     *
+     * The state is the position and health of the player, followed by the
+     * position and health of each enemy.
+     *
+     * @param level the level of the room
+     *
+     * @return the state of the player and the enemies of the given level
+     */
+    static std::vector<float> getState(const std::shared_ptr<LevelModel>& level);
+
+    /**
+     * Returns the first difference between two room states.
+     *
+     * The states must match exactly, as a replay repeats every computation.
+     *
+     * @param expected  the state at the end of the recording
+     * @param actual    the state at the end of the replay
+     *
+     * @return the first difference between two room states (empty if they match)
+     */
+    static std::string compareState(const std::vector<float>& expected, const std::vector<float>& actual);
+};
+
+#endif /* Replay_hpp */